@@ -0,0 +1,93 @@
+/**
+ * @file calibration.hpp
+ * @brief On-line frame calibration class definition.
+ */
+
+#ifndef DEF_CALIBRATION_HPP
+#define DEF_CALIBRATION_HPP
+
+#include "image.hpp"
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/** @brief Fixed-point position of the flat-field gains: a gain of 1.0 is stored as 256. */
+#define CALIBRATION_GAIN_SHIFT  (8u)
+/** @brief Dark level above the mean dark level from which a pixel is hot. */
+#define CALIBRATION_HOT_LEVEL   (24u)
+
+/**
+ * @brief Corrects the raw frames with master dark and flat frames.
+ * @details The masters are 8-bit PGM frames, usually the mean of a recorded sequence
+ *          (see the @p mean format of @p cwis_convert): the dark frame is taken with the
+ *          shutter closed, the flat frame under uniform illumination.
+ *
+ *          Loading the masters precomputes a fixed-point gain per pixel (the mean flat
+ *          response over the pixel response) and a sparse list of defective pixels: hot
+ *          pixels of the dark frame, and pixels of the flat frame responding less than half
+ *          or more than twice the mean. @ref apply() then corrects a frame in place in one
+ *          pass (AVX2 or SSE2 when available): saturating dark subtraction, then gain. The
+ *          defective pixels are finally replaced by the mean of their nearest valid
+ *          neighbours in the row.
+ */
+class Calibration {
+
+    public:
+        /**
+         * @brief Creates an identity calibration for frames of the given size.
+         */
+        Calibration(unsigned int width, unsigned int height);
+
+        ~Calibration();
+
+        /**
+         * @brief Loads the master frames.
+         * @param[in]   dark    Master dark frame, or @p NULL for no dark subtraction.
+         * @param[in]   flat    Master flat frame, or @p NULL for no flat fielding.
+         * @returns @p false if a master does not have the size of the frames.
+         */
+        bool load(const Image *dark, const Image *flat);
+
+        /**
+         * @brief Loads the master frames from PGM files.
+         * @param[in]   darkFile    Master dark frame, or an empty string.
+         * @param[in]   flatFile    Master flat frame, or an empty string.
+         * @returns @p false if a file cannot be read or does not have the size of the frames.
+         */
+        bool load(const std::string &darkFile, const std::string &flatFile);
+
+        /**
+         * @brief Corrects a frame in place.
+         * @returns @p false if the frame does not have the calibration size.
+         */
+        bool apply(Image *image) const;
+
+        /** @brief Returns the number of defective pixels replaced in each frame. */
+        size_t getNbOfDefects(void) const;
+
+    private:
+        /** @brief Defective pixel and the valid pixels replacing it. */
+        typedef struct {
+            uint32_t index;
+            uint32_t left;
+            uint32_t right;
+        }Defect_s;
+
+        unsigned int m_width;
+        unsigned int m_height;
+
+        /** @brief Dark level of each pixel. */
+        unsigned char *m_dark;
+        /** @brief Gain of each pixel, see @ref CALIBRATION_GAIN_SHIFT. */
+        uint16_t *m_gain;
+        std::vector<Defect_s> m_defects;
+
+        /** @brief Indicates that the processor supports AVX2. */
+        bool m_avx2;
+
+        /** @brief Builds the defect list from a map of the defective pixels. */
+        void listDefects(const std::vector<bool> &defective);
+};
+
+#endif  /* DEF_CALIBRATION_HPP */
@@ -11,6 +11,25 @@
 #include "image.hpp"
 #include "ring_buffer.hpp"
 
+#include <stdint.h>
+
+/**
+ * @brief Frames completed since the previous delivery, in acquisition order. 
+ */
+typedef struct {
+    /** @brief Ring buffer slots holding the frames. */
+    char **buffers; 
+    /** @brief Camera sequence number of each frame. */
+    uint64_t *sequences; 
+    /** @brief Number of frames. */
+    unsigned int count; 
+    /** @brief Frames lost by the camera before this batch: sequence numbers never delivered. */
+    uint64_t lost; 
+}FrameBatch_s; 
+
+/** @brief Acquisition callback, called once per camera wakeup. */
+typedef void (*FrameCallback_t)(const FrameBatch_s *batch); 
+
 /**
  * @brief Abstract camera class. 
  * @details The @p Camera class represents the camera interface for the CWIS experiment. 
@@ -22,8 +41,16 @@ class Camera {
     public: 
         /**
          * @brief Starts continuous image acquisition.
+         * @details The frames completed between two wakeups of the acquisition thread
+         *          are handed to @p callback at once, see @ref FrameBatch_s. 
+         */
+        virtual void start(RingBuffer *ringBuffer, FrameCallback_t callback = NULL)  = 0;
+
+        /**
+         * @brief Sets up everything needed by @ref start(), without starting the acquisition. 
+         * @details A following @ref start() with the same parameters only starts the capture. 
          */
-        virtual void start(RingBuffer *ringBuffer, void (*callback)(char *) = NULL)  = 0;
+        virtual void prepare(RingBuffer *ringBuffer, FrameCallback_t callback = NULL) = 0;
 
         virtual void stop(void) = 0; 
 
@@ -32,6 +59,13 @@ class Camera {
          */ 
         virtual void capture(Image *i) = 0; 
 
+        /**
+         * @brief Acquires @p count images, at least @p interval seconds apart. 
+         * @details The camera is configured once for the whole burst. 
+         *          The trigger time of each image is written in @p timestamps, if not @p NULL. 
+         */
+        virtual void captureBurst(Image **images, unsigned int count, double interval, double *timestamps) = 0; 
+
         /**
          * @brief Sets the framerate of the camera.  
          */
@@ -41,6 +75,15 @@ class Camera {
             return this->m_framerate; 
         }
 
+        /**
+         * @brief Returns the number of frames lost by the live acquisition. 
+         * @details Frames overwritten in the ring before they could be delivered, detected
+         *          from the gaps in the camera sequence numbers. 
+         */
+        uint64_t getLostFrames(void) const {
+            return __atomic_load_n(&this->m_lostFrames, __ATOMIC_RELAXED); 
+        }
+
         /**
          * @brief Sets the area of interest of the camera. 
          */
@@ -66,9 +109,13 @@ class Camera {
         /** @brief Pointer to the ring buffer currently used for image acquisition. */
         RingBuffer *m_ringBuffer;
         /** @brief User callback function called at each acquisition event. */
-        void (*m_userCallback)(char *); 
+        FrameCallback_t m_userCallback; 
+        /** @brief Number of frames lost by the live acquisition. */
+        uint64_t m_lostFrames; 
         /** @brief Indicates if the camera is already running. */
         bool m_running; 
+        /** @brief Indicates that the acquisition buffers and handlers are set up. */
+        bool m_prepared; 
 };
 
 
@@ -0,0 +1,103 @@
+/**
+ * @file command_scheduler.hpp
+ * @brief Timed command scheduler class definition.
+ */
+
+#ifndef DEF_COMMAND_SCHEDULER_HPP
+#define DEF_COMMAND_SCHEDULER_HPP
+
+#include <pthread.h>
+#include <time.h>
+#include <vector>
+
+/** @brief Real-time priority of the scheduler thread (SCHED_FIFO). */
+#define SCHEDULER_PRIORITY      (80)
+/** @brief The last part of the wait before a deadline is spent spinning, in seconds. */
+#define SCHEDULER_SPIN          (0.0002)
+/** @brief Longest sleep, in seconds, so that UTC clock steps are noticed. */
+#define SCHEDULER_MAX_SLEEP     (1.0)
+
+/**
+ * @brief Executes orders at an absolute time. 
+ * @details Each order carries a deadline on @p CLOCK_MONOTONIC or on the UTC clock 
+ *          (@p CLOCK_REALTIME). The scheduler thread sleeps on a timerfd, calls the 
+ *          preparation function a configurable lead time before the deadline (buffer 
+ *          registration, ring sizing...), then sleeps again until just before the deadline 
+ *          and spins on the order clock for the last @ref SCHEDULER_SPIN seconds, so that 
+ *          the execution function runs within a few microseconds of the deadline. 
+ *
+ *          The thread runs with the @p SCHED_FIFO policy when the process is allowed to. 
+ *          Orders whose deadline has passed are prepared and executed right away. 
+ */
+class CommandScheduler {
+
+    public:
+        /**
+         * @brief Starts the scheduler thread. 
+         * @param[in]   prepare     Function preparing an order, called @p leadTime before the deadline. 
+         * @param[in]   execute     Function executing an order, called at the deadline. 
+         * @param[in]   leadTime    Time given to the preparation, in seconds. 
+         */
+        CommandScheduler(void (*prepare)(char), void (*execute)(char), double leadTime); 
+
+        /**
+         * @brief Stops the scheduler thread. Pending orders are dropped. 
+         */
+        ~CommandScheduler(); 
+
+        /**
+         * @brief Schedules an order. 
+         * @param[in]   order   Order to execute. 
+         * @param[in]   clock   @p CLOCK_MONOTONIC or @p CLOCK_REALTIME. 
+         * @param[in]   time    Deadline on @p clock, in seconds. 
+         * @returns @p false if the clock is not supported. 
+         */
+        bool schedule(char order, clockid_t clock, double time); 
+
+        /** @brief Returns the number of orders waiting for their deadline. */
+        size_t getPending(void); 
+
+        /** @brief Returns how late the last order was executed, in seconds. */
+        double getLastLateness(void); 
+
+        /**
+         * @brief Parses a timed order. 
+         * @details The syntax is @p \@M:<seconds>:<order> for a @p CLOCK_MONOTONIC deadline, 
+         *          or @p \@U:<seconds>:<order> for a UTC deadline (seconds since the Epoch). 
+         * @returns @p false if the command is not a valid timed order. 
+         */
+        static bool parse(const char *command, int size, char *order, clockid_t *clock, double *time); 
+
+    private:
+        /** @brief Scheduled order. */
+        typedef struct {
+            char order; 
+            clockid_t clock; 
+            double time; 
+            bool prepared; 
+        }Entry_s; 
+
+        void (*m_prepare)(char); 
+        void (*m_execute)(char); 
+        double m_leadTime; 
+        double m_lastLateness; 
+
+        std::vector<Entry_s> m_entries; 
+
+        /** @brief Absolute CLOCK_MONOTONIC timer the thread sleeps on. */
+        int m_timer; 
+        pthread_t m_thread; 
+        pthread_mutex_t m_lock; 
+        bool m_stop; 
+
+        /** @brief Arms the timer at a CLOCK_MONOTONIC time: 0 wakes the thread up now, a negative time disarms it. */
+        void arm(double time); 
+        /** @brief Converts a deadline to CLOCK_MONOTONIC. */
+        static double toMonotonic(const Entry_s &entry); 
+        /** @brief Reads a clock, in seconds. */
+        static double now(clockid_t clock); 
+
+        static void * thread(void *arg); 
+}; 
+
+#endif  /* DEF_COMMAND_SCHEDULER_HPP */
@@ -0,0 +1,151 @@
+/**
+ * @file compressed_ring.hpp
+ * @brief Compressed frame ring class definition.
+ */
+
+#ifndef DEF_COMPRESSED_RING_HPP
+#define DEF_COMPRESSED_RING_HPP
+
+#include "image.hpp"
+#include "frame_codec.hpp"
+
+#include <pthread.h>
+#include <deque>
+#include <vector>
+
+/**
+ * @brief Second-tier ring holding compressed frames.
+ * @details Frames leaving the acquisition @ref RingBuffer are compressed with the
+ *          @ref FrameCodec and stored in a single arena locked in RAM. The arena is
+ *          managed as a circular log of variable-size blocks: a new frame is appended
+ *          after the most recent one and evicts the oldest frames if there is no room left.
+ *          Any frame still held by the ring can be decompressed on demand.
+ *
+ *          A single thread may push frames, while other threads pop or read them.
+ *          Frame numbers are expected to increase from one push to the next. The readers
+ *          copy the compressed frame and decompress it without holding the ring lock, so
+ *          that a push from the acquisition thread never waits for a decompression.
+ */
+class CompressedRing {
+
+    public:
+        /**
+         * @brief Allocates a compressed ring.
+         * @param[in]   capacity    Size of the compressed frame arena, in bytes.
+         * @note The arena is locked in RAM, see @ref Image.
+         */
+        CompressedRing(size_t capacity);
+
+        /**
+         * @brief Frees and unlocks the arena.
+         */
+        ~CompressedRing();
+
+        /**
+         * @brief Compresses an image and appends it to the ring.
+         * @details The oldest frames are evicted if the compressed image does not fit
+         *          in the free space of the arena.
+         * @param[in]   image   Image to compress. Only read during the call.
+         * @param[in]   frame   Frame number of the image.
+         * @returns @p false if the compressed image is larger than the whole arena.
+         */
+        bool push(const Image *image, unsigned int frame);
+
+        /**
+         * @brief Removes the oldest frame from the ring and decompresses it.
+         * @details Waits for a frame to be available, unless the ring was closed.
+         * @param[out]  image   Image receiving the frame. Must have the size of the stored frame.
+         * @param[out]  frame   Frame number of the image.
+         * @returns @p false if the ring is empty and closed.
+         * @see close()
+         */
+        bool pop(Image *image, unsigned int *frame);
+
+        /**
+         * @brief Decompresses a frame without removing it from the ring.
+         * @param[in]   frame   Number of the frame to retrieve.
+         * @param[out]  image   Image receiving the frame. Must have the size of the stored frame.
+         * @returns @p false if the frame is not held by the ring anymore.
+         */
+        bool get(unsigned int frame, Image *image);
+
+        /**
+         * @brief Wakes up the threads waiting in @ref pop().
+         * @details Remaining frames can still be popped, but @ref pop() does not wait
+         *          for new frames anymore.
+         */
+        void close(void);
+
+        /** @brief Returns the number of frames held by the ring. */
+        size_t getCount(void);
+
+        /** @brief Returns the size of the arena, in bytes. */
+        size_t getCapacity(void) const;
+
+        /** @brief Returns the number of arena bytes used by compressed frames. */
+        size_t getUsedBytes(void);
+
+        /** @brief Returns the number of frames evicted before being popped. */
+        unsigned long getEvicted(void);
+
+        /**
+         * @brief Returns the compression ratio of the frames held by the ring.
+         * @returns Raw size divided by compressed size, or 0 if the ring is empty.
+         */
+        double getCompressionRatio(void);
+
+    private:
+        /** @brief Location of a compressed frame in the arena. */
+        typedef struct {
+            unsigned int frame;
+            unsigned int width;
+            unsigned int height;
+            size_t offset;
+            size_t size;
+        }Entry_s;
+
+        /** @brief Compressed frame arena. */
+        unsigned char *m_arena;
+        /** @brief Size of the arena, in bytes. */
+        size_t m_capacity;
+        /** @brief Offset of the end of the most recent block. */
+        size_t m_head;
+        /** @brief Number of arena bytes used by compressed frames. */
+        size_t m_used;
+        /** @brief Raw size of the frames held by the ring, in bytes. */
+        size_t m_raw;
+        /** @brief Number of frames evicted before being popped. */
+        unsigned long m_evicted;
+        /** @brief Indicates that @ref pop() must not wait for new frames. */
+        bool m_closed;
+
+        /** @brief Compressed frames, from the oldest to the most recent. */
+        std::deque<Entry_s> m_entries;
+
+        /** @brief Codec used by the producer thread. */
+        FrameCodec m_encoder;
+        /** @brief Codec used by the consumer threads, under @ref m_decodeLock. */
+        FrameCodec m_decoder;
+        /** @brief Compression output buffer. */
+        unsigned char *m_scratch;
+        /** @brief Size of the compression output buffer, in bytes. */
+        size_t m_scratchSize;
+
+        pthread_mutex_t m_lock;
+        pthread_cond_t  m_available;
+        /** @brief Serializes the consumers on @ref m_decoder, never held with @ref m_lock. */
+        pthread_mutex_t m_decodeLock;
+
+        /** @brief Reserves @p size bytes in the arena, evicting old frames. Called under @ref m_lock. */
+        size_t allocate(size_t size);
+        /** @brief Drops the oldest frame. Called under @ref m_lock. */
+        void evictOldest(void);
+        /** @brief Orders the entries by frame number. */
+        static bool isBefore(const Entry_s &entry, unsigned int frame);
+        /** @brief Copies the compressed data of @p entry. Called under @ref m_lock. */
+        void copy(const Entry_s &entry, std::vector<unsigned char> &data) const;
+        /** @brief Decompresses a copied frame into @p image. Called without @ref m_lock. */
+        bool decode(const Entry_s &entry, const std::vector<unsigned char> &data, Image *image);
+};
+
+#endif  /* DEF_COMPRESSED_RING_HPP */
@@ -0,0 +1,71 @@
+/**
+ * @file compression_controller.hpp
+ * @brief Adaptive compression level controller class definition.
+ */
+
+#ifndef DEF_COMPRESSION_CONTROLLER_HPP
+#define DEF_COMPRESSION_CONTROLLER_HPP
+
+#include <pthread.h>
+
+/** @brief Buffer occupancy above which the compression level is lowered. */
+#define COMPRESSION_HIGH_WATERMARK      (0.5)
+/** @brief Buffer occupancy above which the fastest level is used at once. */
+#define COMPRESSION_CRITICAL_WATERMARK  (0.75)
+/** @brief Buffer occupancy below which the compression level may be raised. */
+#define COMPRESSION_LOW_WATERMARK       (0.1)
+/** @brief Number of consecutive frames below the low watermark before raising the level. */
+#define COMPRESSION_RAISE_DELAY         (16u)
+
+/**
+ * @brief Adapts the compression effort to the writers backlog. 
+ * @details The compression level is chosen for each frame from the occupancy of the 
+ *          acquisition buffers, i.e. the fraction of the ring buffer (or of the compressed
+ *          buffer) waiting for the writers. The level drops as soon as the occupancy 
+ *          exceeds the high watermark, straight to the minimum level past the critical
+ *          watermark, so that no frame is lost. It only rises again, one step at a time,
+ *          after the occupancy has stayed below the low watermark for a while. 
+ *
+ *          The level is a zlib compression level. The matching PNG row filters go from
+ *          no filter at the fastest levels to the full row filter heuristic. 
+ *          The controller may be shared by several writer threads. 
+ */
+class CompressionController {
+
+    public:
+        /**
+         * @brief Creates a controller working between the given levels. 
+         * @details The controller starts at the maximum level. 
+         */
+        CompressionController(int minLevel = 1, int maxLevel = 9); 
+
+        ~CompressionController(); 
+
+        /**
+         * @brief Sets the allowed compression levels (zlib levels, 0 to 9). 
+         */
+        void setLimits(int minLevel, int maxLevel); 
+
+        /**
+         * @brief Updates the compression level for a new frame. 
+         * @param[in]   occupancy   Fraction of the acquisition buffers waiting for the writers. 
+         * @returns Compression level to use for the frame. 
+         */
+        int update(double occupancy); 
+
+        /** @brief Returns the current compression level. */
+        int getLevel(void); 
+
+        /** @brief Returns the PNG row filters matching the given compression @p level. */
+        static int getFilters(int level); 
+
+    private:
+        int m_minLevel; 
+        int m_maxLevel; 
+        int m_level; 
+        /** @brief Number of consecutive frames below the low watermark. */
+        unsigned int m_idle; 
+        pthread_mutex_t m_lock; 
+}; 
+
+#endif  /* DEF_COMPRESSION_CONTROLLER_HPP */
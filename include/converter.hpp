@@ -0,0 +1,181 @@
+/**
+ * @file converter.hpp
+ * @brief Offline recording converter class definition.
+ */
+
+#ifndef DEF_CONVERTER_HPP
+#define DEF_CONVERTER_HPP
+
+#include "image.hpp"
+#include "temporal_codec.hpp"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/** @brief Default bound of the input and decoded data held in memory, in bytes. */
+#define CONVERTER_MAX_IN_FLIGHT (256u * 1024u * 1024u)
+/** @brief Maximum number of converter threads. */
+#define CONVERTER_MAX_THREADS   (64u)
+
+/** @brief Recording formats. */
+typedef enum {
+    CONVERT_PGM,        /**< @brief Directory of PGM frames. */
+    CONVERT_PNG,        /**< @brief Directory of PNG frames. */
+    CONVERT_ARCHIVE,    /**< @brief Raw archive: frame number followed by the pixels, for each frame. */
+    CONVERT_MEAN        /**< @brief Single PGM frame, mean of the input frames (calibration masters). */
+}ConvertFormat_e;
+
+/**
+ * @brief Converts a recording from one format to another.
+ * @details The input is either a recording directory (PGM or PNG frames, possibly in shard
+ *          subdirectories), a raw archive file or a temporal stream (see TemporalEncoder). The output is a directory with the same
+ *          layout, or an archive file. The @p mean format averages all the frames into a
+ *          single PGM file instead, to build the master frames of the Calibration class.
+ *
+ *          The frames are shared between the threads in ranges; a thread that runs out of
+ *          work steals half of the largest remaining range. Input files are mapped in memory,
+ *          and the data held at once (mapped inputs and decoded frames) is bounded.
+ *          Frames are written to a temporary file and renamed once complete, so that an
+ *          interrupted conversion resumes where it stopped: frames whose output exists
+ *          (or is already in the output archive) are skipped.
+ */
+class Converter {
+
+    public:
+        /**
+         * @brief Creates a converter.
+         * @param[in]   input       Recording directory, archive or temporal stream file.
+         * @param[in]   output      Output directory, or archive file.
+         * @param[in]   format      Output format.
+         * @param[in]   nbOfThreads Number of threads, 0 to use one per core.
+         * @param[in]   maxInFlight Bound of the data held in memory, in bytes.
+         */
+        Converter(const std::string &input, const std::string &output, ConvertFormat_e format,
+                  unsigned int nbOfThreads = 0, size_t maxInFlight = CONVERTER_MAX_IN_FLIGHT);
+
+        ~Converter();
+
+        /** @brief Sets the frame size of the archives (800x600 by default, temporal streams give their own). */
+        void setGeometry(unsigned int width, unsigned int height);
+
+        /** @brief Sets the PNG compression level (zlib level, -1 for the default). */
+        void setCompression(int level);
+
+        /**
+         * @brief Lists the input frames and skips the ones already converted.
+         * @returns Number of frames to convert, or -1 if the input or output cannot be opened.
+         */
+        long scan(void);
+
+        /** @brief Starts the conversion threads. */
+        void start(void);
+
+        /**
+         * @brief Waits for the end of the conversion.
+         * @details With the @p mean format, the mean frame is written at this point.
+         * @returns Number of frames that could not be converted.
+         */
+        unsigned long wait(void);
+
+        /** @brief Returns the number of frames to convert. */
+        unsigned long getTotal(void) const;
+
+        /** @brief Returns the number of frames converted so far. */
+        unsigned long getDone(void) const;
+
+        /** @brief Returns the number of frames that could not be converted so far. */
+        unsigned long getFailed(void) const;
+
+        /** @brief Returns the number of frames skipped because already converted. */
+        unsigned long getSkipped(void) const;
+
+        /** @brief Returns the number of input bytes read so far. */
+        unsigned long long getBytesRead(void) const;
+
+        /**
+         * @brief Returns the format matching a name (@p pgm, @p png, @p raw or @p mean).
+         * @returns @p false if the name is unknown.
+         */
+        static bool parseFormat(const std::string &name, ConvertFormat_e *format);
+
+    private:
+        /** @brief Frame to convert. */
+        typedef struct {
+            /** @brief Input file, relative to the input directory (empty for archive records). */
+            std::string path;
+            /** @brief Offset of the record in the input archive, index of the frame in a temporal stream. */
+            off_t offset;
+            unsigned int frame;
+        }Item_s;
+
+        /** @brief Range of items owned by a thread. */
+        typedef struct {
+            Converter *converter;
+            size_t begin;
+            size_t end;
+            pthread_mutex_t lock;
+            pthread_t thread;
+            /** @brief Sum of the frames converted by the thread, for the @p mean format. */
+            uint32_t *sum;
+            /** @brief Decoder of the thread, for a temporal stream input. */
+            TemporalDecoder *decoder;
+        }Worker_s;
+
+        std::string m_input;
+        std::string m_output;
+        ConvertFormat_e m_format;
+        unsigned int m_nbOfThreads;
+        unsigned int m_width;
+        unsigned int m_height;
+        int m_level;
+
+        /** @brief The input is an archive file. */
+        bool m_archiveInput;
+        /** @brief The input is a temporal stream, listed by this decoder. */
+        TemporalDecoder *m_stream;
+        int m_inputFd;
+        int m_outputFd;
+
+        std::vector<Item_s> m_items;
+        Worker_s *m_workers;
+
+        /** @brief Bound and current amount of data held in memory. */
+        size_t m_maxInFlight;
+        size_t m_inFlight;
+        pthread_mutex_t m_lock;
+        pthread_cond_t m_released;
+
+        unsigned long m_done;
+        unsigned long m_failed;
+        unsigned long m_skipped;
+        unsigned long long m_bytesRead;
+
+        /** @brief Lists the frame files of an input directory. */
+        void listFiles(const std::string &relative);
+        /** @brief Lists the records of the input archive. */
+        bool listRecords(void);
+        /** @brief Lists the frames already in the output archive, truncating a torn record. */
+        bool listArchived(std::vector<unsigned int> &frames);
+        /** @brief Returns the output path of a frame. */
+        std::string getOutputPath(const Item_s &item) const;
+
+        /** @brief Takes the next item of a worker, stealing from the others if needed. */
+        bool take(unsigned int index, size_t *item);
+        /** @brief Waits until @p size bytes may be held in memory. */
+        void acquire(size_t size);
+        /** @brief Releases memory reserved by @ref acquire(). */
+        void release(size_t size);
+        /** @brief Converts one frame. */
+        bool convert(const Item_s &item, Worker_s *worker);
+        /** @brief Writes a frame in the output format. */
+        bool write(Image *image, const Item_s &item, Worker_s *worker);
+        /** @brief Writes the mean of the frames summed by the threads. */
+        bool writeMean(void);
+
+        /** @brief Conversion thread. */
+        static void * thread(void *arg);
+};
+
+#endif  /* DEF_CONVERTER_HPP */
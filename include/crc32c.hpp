@@ -0,0 +1,33 @@
+/**
+ * @file crc32c.hpp
+ * @brief CRC32C (Castagnoli) checksum functions definition.
+ */
+
+#ifndef DEF_CRC32C_HPP
+#define DEF_CRC32C_HPP
+
+#include <stdint.h>
+#include <stdlib.h>
+
+/**
+ * @brief Updates a CRC32C with the given data.
+ * @details Uses the SSE4.2 @p crc32 instruction when the processor has it (checked at run
+ *          time), on three interleaved streams to hide its latency. Otherwise falls back to
+ *          a slicing-by-8 table implementation.
+ * @param[in]   crc     CRC of the previous data, 0 for the first call.
+ * @param[in]   data    Data to checksum.
+ * @param[in]   size    Size of the data, in bytes.
+ * @returns Updated CRC.
+ */
+uint32_t crc32c(uint32_t crc, const void *data, size_t size);
+
+/**
+ * @brief Combines the CRCs of two consecutive blocks.
+ * @param[in]   crc1    CRC of the first block.
+ * @param[in]   crc2    CRC of the second block.
+ * @param[in]   size2   Size of the second block, in bytes.
+ * @returns CRC of both blocks, as if computed in a single pass.
+ */
+uint32_t crc32cCombine(uint32_t crc1, uint32_t crc2, size_t size2);
+
+#endif  /* DEF_CRC32C_HPP */
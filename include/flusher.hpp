@@ -0,0 +1,112 @@
+/**
+ * @file flusher.hpp
+ * @brief Group commit flusher class definition.
+ */
+
+#ifndef DEF_FLUSHER_HPP
+#define DEF_FLUSHER_HPP
+
+#include "frame_journal.hpp"
+#include "output_directory.hpp"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <vector>
+
+/**
+ * @brief Background flusher committing frame files to the disk by groups.
+ * @details Synchronizing each frame file as soon as it is written would stall the
+ *          writers on every disk access. Writers rather hand their open frame files
+ *          over to the flusher, which synchronizes them by groups, every @p groupSize 
+ *          frames or @p groupDelay milliseconds, whichever comes first: writeback is 
+ *          started on all the files of the group with @p sync_file_range(), then each 
+ *          file is synchronized with @p fdatasync(). The directories are synchronized
+ *          and the frame numbers of the group are appended to the @ref FrameJournal. 
+ *
+ *          At most one group of frames, i.e. @p groupDelay milliseconds of acquisition,
+ *          is lost in a power cut. 
+ */
+class Flusher {
+
+    public:
+        /**
+         * @brief Starts the flusher thread. 
+         * @param[in]   journal     Journal of the committed frames. 
+         * @param[in]   directory   Output directory holding the frame files, synchronized
+         *                          with each group. May be @p NULL. 
+         * @param[in]   groupSize   Number of frames per group. 
+         * @param[in]   groupDelay  Maximum time a frame waits for its commit, in milliseconds. 
+         */
+        Flusher(FrameJournal *journal, OutputDirectory *directory, unsigned int groupSize, unsigned int groupDelay); 
+
+        /**
+         * @brief Commits the pending frames and stops the flusher thread. 
+         */
+        ~Flusher(); 
+
+        /**
+         * @brief Hands a written frame file over to the flusher. 
+         * @details The flusher flushes, synchronizes and closes the stream. A frame is 
+         *          only journaled if all its writes reached the file: a failed frame is 
+         *          counted in @ref getFailed() and left to the journal recovery. 
+         * @param[in]   frame   Frame number. 
+         * @param[in]   fp      Stream of the frame file. 
+         * @param[in]   written @p false if the frame could not be written. 
+         */
+        void add(unsigned int frame, FILE *fp, bool written = true); 
+
+        /**
+         * @brief Commits the pending frames right away and waits for the commit. 
+         */
+        void commit(void); 
+
+        /** @brief Returns the number of committed frames. */
+        unsigned long getCommitted(void); 
+
+        /** @brief Returns the number of frames that could not be written or synchronized. */
+        unsigned long getFailed(void); 
+
+    private:
+        /** @brief Frame file waiting for its commit. */
+        typedef struct {
+            unsigned int frame; 
+            FILE *fp; 
+            bool written; 
+        }Pending_s; 
+
+        FrameJournal *m_journal; 
+        OutputDirectory *m_directory; 
+        unsigned int m_groupSize; 
+        unsigned int m_groupDelay; 
+
+        /** @brief Frames waiting for the next commit. */
+        std::vector<Pending_s> m_pending; 
+        /** @brief Monotonic time of the oldest pending frame, in seconds. */
+        double m_oldest; 
+        /** @brief Number of frames handed over to the flusher. */
+        unsigned long m_added; 
+        /** @brief Number of frames processed by the flusher. */
+        unsigned long m_processed; 
+        /** @brief Number of committed frames. */
+        unsigned long m_committed; 
+        /** @brief Number of frames that could not be written or synchronized. */
+        unsigned long m_failed; 
+        /** @brief Requests an immediate commit. */
+        bool m_flush; 
+        bool m_stop; 
+
+        pthread_t m_thread; 
+        pthread_mutex_t m_lock; 
+        /** @brief Wakes the flusher thread up. */
+        pthread_cond_t m_wakeup; 
+        /** @brief Signals the end of a commit. */
+        pthread_cond_t m_done; 
+
+        /** @brief Synchronizes a group of frames and journals it. */
+        void commitGroup(std::vector<Pending_s> &group); 
+
+        /** @brief Flusher thread. */
+        static void * thread(void *arg); 
+}; 
+
+#endif  /* DEF_FLUSHER_HPP */
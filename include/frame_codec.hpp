@@ -0,0 +1,71 @@
+/**
+ * @file frame_codec.hpp
+ * @brief Fast lossless frame codec class definition.
+ */
+
+#ifndef DEF_FRAME_CODEC_HPP
+#define DEF_FRAME_CODEC_HPP
+
+#include "image.hpp"
+#include <zlib.h>
+
+/**
+ * @brief Fast lossless codec for 8-bit frames.
+ * @details Each frame is optionally delta-filtered (every pixel is replaced by its
+ *          difference with the previous one) and run-length/Huffman coded with zlib at
+ *          its fastest setting. Our frames are mostly dark, so the data is dominated by
+ *          small values and compresses well at a low CPU cost.
+ *          The zlib streams are kept between frames to avoid a costly allocation
+ *          for each frame. A codec object must therefore not be shared between threads.
+ */
+class FrameCodec {
+
+    public:
+        /**
+         * @brief Allocates the compression and decompression streams.
+         */
+        FrameCodec(void);
+
+        /**
+         * @brief Frees the codec streams and scratch buffer.
+         */
+        ~FrameCodec();
+
+        /**
+         * @brief Returns the worst case size of a compressed frame of @p size pixels.
+         */
+        static size_t bound(size_t size);
+
+        /**
+         * @brief Compresses a frame.
+         * @param[in]   src         Frame pixels.
+         * @param[in]   size        Number of pixels in the frame.
+         * @param[out]  dst         Output buffer.
+         * @param[in]   capacity    Size of the output buffer, in bytes.
+         * @returns Size of the compressed frame, in bytes, or 0 if it does not fit in @p dst.
+         * @see bound()
+         */
+        size_t compress(const pixel_t *src, size_t size, unsigned char *dst, size_t capacity);
+
+        /**
+         * @brief Decompresses a frame.
+         * @param[in]   src         Compressed frame.
+         * @param[in]   srcSize     Size of the compressed frame, in bytes.
+         * @param[out]  dst         Frame pixels.
+         * @param[in]   size        Number of pixels in the frame.
+         * @returns @p true if the frame was decompressed and has the expected size.
+         */
+        bool decompress(const unsigned char *src, size_t srcSize, pixel_t *dst, size_t size);
+
+    private:
+        /** @brief Deflate stream, reset for each frame. */
+        z_stream m_deflate;
+        /** @brief Inflate stream, reset for each frame. */
+        z_stream m_inflate;
+        /** @brief Holds the delta-filtered frame before compression. */
+        unsigned char *m_scratch;
+        /** @brief Size of the scratch buffer, in bytes. */
+        size_t m_scratchSize;
+};
+
+#endif  /* DEF_FRAME_CODEC_HPP */
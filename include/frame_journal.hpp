@@ -0,0 +1,86 @@
+/**
+ * @file frame_journal.hpp
+ * @brief Committed frames journal class definition.
+ */
+
+#ifndef DEF_FRAME_JOURNAL_HPP
+#define DEF_FRAME_JOURNAL_HPP
+
+#include <string>
+#include <vector>
+#include <stdlib.h>
+
+/**
+ * @brief Journal of the frames safely stored on disk. 
+ * @details Once a group of frame files has been synchronized to the disk, their
+ *          frame numbers are appended to the journal as a single record, which is 
+ *          synchronized in turn. Each record holds its number of frames, the frame 
+ *          numbers and a CRC. A record torn by a power cut fails its check and is
+ *          truncated when the journal is opened again. 
+ *
+ *          After a crash, @ref recover() compares the content of the output 
+ *          directory with the journal to get rid of partially written frames. 
+ * @see Flusher
+ */
+class FrameJournal {
+
+    public:
+        /**
+         * @brief Opens or creates a journal and loads its records. 
+         * @param[in]   filename    Path of the journal file. 
+         */
+        FrameJournal(const std::string &filename); 
+
+        /**
+         * @brief Closes the journal file. 
+         */
+        ~FrameJournal(); 
+
+        /** @brief Returns @p true if the journal file could be opened. */
+        bool isOpen(void) const; 
+
+        /**
+         * @brief Appends a group of committed frames to the journal. 
+         * @details The record is synchronized to the disk before this function returns. 
+         * @returns @p true if the record was durably written. 
+         */
+        bool append(const unsigned int *frames, size_t count); 
+
+        /** @brief Returns @p true if the given @p frame was committed. */
+        bool isCommitted(unsigned int frame) const; 
+
+        /** @brief Returns the number of committed frames. */
+        size_t getCount(void) const; 
+
+        /**
+         * @brief Returns the number following the highest committed frame. 
+         * @details A new recording in the same directory starts with this frame number
+         *          so that the committed frames are never overwritten. 
+         */
+        unsigned int getNextFrame(void) const; 
+
+        /**
+         * @brief Brings a recording back to a consistent state after a crash. 
+         * @details Frame files of the given @p directory (and of its shard subdirectories)
+         *          that are missing from the journal were being written during the crash. 
+         *          The complete ones are synchronized to the disk and added to the journal, 
+         *          the partial ones are removed. 
+         * @returns Number of partial frames removed. 
+         */
+        unsigned int recover(const std::string &directory); 
+
+    private:
+        /** @brief Journal file descriptor. */
+        int m_fd; 
+        /** @brief Committed frames, in increasing order. */
+        std::vector<unsigned int> m_frames; 
+
+        /** @brief Reads the records and truncates a torn one. */
+        void load(void); 
+        /** @brief Adds a frame to @ref m_frames. */
+        void insert(unsigned int frame); 
+        /** @brief Checks the frame files of a directory. */
+        void recoverDirectory(int dirfd, std::vector<unsigned int> &complete, unsigned int &removed); 
+}; 
+
+#endif  /* DEF_FRAME_JOURNAL_HPP */
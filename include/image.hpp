@@ -7,10 +7,29 @@
 #define DEF_IMAGE_HPP
 
 #include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
 
 /** @brief Modular type for the pixel size. */
 typedef char pixel_t; 
 
+/** @brief Maximum size of a PGM file header, comments included. */
+#define PGM_HEADER_MAX  (4096u)
+
+/** @brief Header of a binary PGM file, see Image::parsePGMHeader(). */
+typedef struct {
+    unsigned int width; 
+    unsigned int height; 
+    /** @brief Maximum pixel value: pixels take two bytes above 255. */
+    unsigned int maxValue; 
+    /** @brief Offset of the pixels in the file, i.e. size of the header. */
+    size_t offset; 
+    /** @brief The header holds the CRC32C comment written by Image::writeToPGM(). */
+    bool hasChecksum; 
+    /** @brief CRC32C of the pixels. */
+    uint32_t checksum; 
+}PGMHeader_s; 
+
 /**
  * @brief Image class.
  * @details This class defines the behaviour of an image object. 
@@ -29,6 +48,14 @@ class Image {
          */
         Image(unsigned int width, unsigned int height);
 
+        /**
+         * @brief Creates an image over an existing buffer. 
+         * @details The buffer is neither freed nor unlocked by the image, it must 
+         *          outlive it. Used to place images in shared memory. 
+         * @param[in]   buffer  Buffer of at least @p width x @p height pixels. 
+         */
+        Image(unsigned int width, unsigned int height, pixel_t *buffer);
+
         /**
          * @brief Returns the image buffer. 
          * @details The image buffer is the memory array allocated by the constructor. 
@@ -57,6 +84,35 @@ class Image {
          */
         void writeToPNG(const char *filename, char *title = NULL);
 
+        /**
+         * @brief Writes the image to an open stream, in the PNG format. 
+         * @param[in]   fp      Stream opened for binary writing. It is not closed. 
+         * @param[in]   title   Title of the PNG file. 
+         * @param[in]   level   zlib compression level, or -1 for the zlib default. 
+         * @param[in]   filters PNG row filters (@p PNG_FILTER_* flags), or -1 for all of them. 
+         * @returns Number of bytes written, 0 on error. 
+         * @see PngEncoder
+         */
+        size_t writeToPNG(FILE *fp, char *title = NULL, int level = -1, int filters = -1);
+
+        /**
+         * @brief Writes the image to a JPEG file, for quick-looks. 
+         * @param[in]   filename    Name of the JPEG file. 
+         * @param[in]   quality     JPEG quality, from 1 to 100. 
+         * @param[in]   scale       Reduction factor, from 1 to 8. 
+         * @returns Number of bytes written, 0 on error. 
+         */
+        size_t writeToJPEG(const char *filename, int quality = 75, unsigned int scale = 1); 
+
+        /**
+         * @brief Writes the image to an open stream, in the JPEG format. 
+         * @param[in]   fp      Stream opened for binary writing. It is not closed. 
+         * @param[in]   quality JPEG quality, from 1 to 100. 
+         * @param[in]   scale   Reduction factor, from 1 to 8. 
+         * @see JpegEncoder
+         */
+        size_t writeToJPEG(FILE *fp, int quality = 75, unsigned int scale = 1); 
+
         /**
          * @brief Writes the image to a PGM file. 
          * @param[in]   filename    Name of the PGM file.   
@@ -64,6 +120,37 @@ class Image {
          */ 
         size_t writeToPGM(const char *filename);
 
+        /**
+         * @brief Writes the image to an open stream, in the PGM format. 
+         * @param[in]   fp      Stream opened for binary writing. It is not closed. 
+         * @returns Number of bytes written. 
+         */
+        size_t writeToPGM(FILE *fp);
+
+        /**
+         * @brief Parses the header of a binary PGM file. 
+         * @details The header is @p P5 followed by the width, height and maximum value, 
+         *          separated by whitespace. A comment runs from a @p # to the end of its 
+         *          line, wherever whitespace is allowed. A single whitespace separates the 
+         *          header from the pixels. 
+         * @param[in]   data    Start of the file. 
+         * @param[in]   size    Number of bytes of @p data. 
+         * @param[out]  header  Header fields. 
+         * @returns @p false if @p data does not start with a whole PGM header. 
+         */
+        static bool parsePGMHeader(const unsigned char *data, size_t size, PGMHeader_s *header); 
+
+        /**
+         * @brief Reads the header of a binary PGM file. 
+         * @details The stream is left at the start of the pixels. Headers longer than 
+         *          @ref PGM_HEADER_MAX bytes are rejected. 
+         * @param[in]   fp      Stream at the start of the file. 
+         * @param[out]  header  Header fields. 
+         * @returns @p false if the stream does not start with a PGM header. 
+         * @see parsePGMHeader()
+         */
+        static bool readPGMHeader(FILE *fp, PGMHeader_s *header); 
+
         /**
          * @brief Specifies if the image is currently being written to disk. 
          * @returns @p true if the image is currently being written. 
@@ -87,6 +174,20 @@ class Image {
     
         /** @brief Indicates if the image buffer is currently being written by a process to persistent memory. */
         bool i_isBeingWritten; 
+
+        /** @brief Indicates that the image allocated its buffer. */
+        bool i_owner; 
+
+        /**
+         * @brief Copies the pixels into another buffer and uses it from then on. 
+         * @details The buffer allocated by the image, if any, is freed. 
+         * @param[in]   buffer  Buffer of at least @p width x @p height pixels, which must 
+         *                      outlive the image. 
+         */
+        void moveTo(pixel_t *buffer); 
+
+        /** @brief Moves its images into a new arena when it is resized. */
+        friend class RingBuffer; 
 };
 
 
@@ -0,0 +1,117 @@
+/**
+ * @file jpeg_encoder.hpp
+ * @brief Grayscale JPEG encoder class definition.
+ */
+
+#ifndef DEF_JPEG_ENCODER_HPP
+#define DEF_JPEG_ENCODER_HPP
+
+#include "image.hpp"
+#include <pthread.h>
+#include <stdint.h>
+
+/** @brief Default JPEG quality, as the IJG scale (1 to 100). */
+#define JPEG_DEFAULT_QUALITY    (75)
+
+/** @brief Largest reduction factor of the quick-looks. */
+#define JPEG_MAX_SCALE          (8u)
+
+/**
+ * @brief Baseline JPEG encoder dedicated to 8-bit grayscale frames.
+ * @details Meant for quick-looks: lossy, but an order of magnitude smaller than a PNG file.
+ *          Each 8x8 block goes through the integer DCT of the IJG library (the slow but
+ *          accurate one) and is quantized with reciprocal multiplications, both eight
+ *          columns at a time with AVX2 when the processor supports it. The coefficients are
+ *          Huffman coded with the standard luminance tables through a 64-bit bit buffer,
+ *          into a memory buffer written with a single call.
+ *          The frame may be reduced first, by averaging @p scale x @p scale blocks.
+ *
+ *          The buffers are kept between frames, an encoder must therefore not be shared
+ *          between threads. @ref getThreadEncoder() gives one to each thread.
+ */
+class JpegEncoder {
+
+    public:
+        JpegEncoder(void);
+
+        ~JpegEncoder();
+
+        /**
+         * @brief Writes a frame to an open stream, in the JPEG format.
+         * @param[in]   fp      Stream opened for binary writing. It is not closed.
+         * @param[in]   pixels  Frame pixels, row after row.
+         * @param[in]   width   Frame width.
+         * @param[in]   height  Frame height.
+         * @param[in]   quality Quality, from 1 to 100 (clamped).
+         * @param[in]   scale   Reduction factor, from 1 to @ref JPEG_MAX_SCALE. Incomplete
+         *                      blocks on the right and bottom edges are dropped.
+         * @returns Number of bytes written, 0 on error.
+         */
+        size_t write(FILE *fp, const pixel_t *pixels, unsigned int width, unsigned int height,
+                     int quality = JPEG_DEFAULT_QUALITY, unsigned int scale = 1);
+
+        /**
+         * @brief Forward DCT of an 8x8 block.
+         * @param[in]   src         Top left pixel of the block.
+         * @param[in]   stride      Distance between two rows of the block, in bytes.
+         * @param[out]  coefficients    Coefficients in natural order, scaled up by 8 as in the
+         *                          IJG library.
+         */
+        static void transform(const unsigned char *src, size_t stride, int32_t coefficients[64]);
+
+        /**
+         * @brief Returns the quantization table of a quality, in natural order.
+         * @param[in]   quality Quality, from 1 to 100 (clamped).
+         * @param[out]  table   Quantizer of each coefficient.
+         */
+        static void getQuantizers(int quality, uint16_t table[64]);
+
+        /**
+         * @brief Returns the encoder of the calling thread.
+         * @details The encoder is created on first use and freed when the thread exits.
+         */
+        static JpegEncoder * getThreadEncoder(void);
+
+    private:
+        /** @brief Reduced frame, and edge blocks padded by repeating the last pixels. */
+        unsigned char *m_samples;
+        size_t m_samplesSize;
+        /** @brief Encoded file. */
+        unsigned char *m_output;
+        size_t m_outputSize;
+        /** @brief Write position in @ref m_output. */
+        size_t m_position;
+
+        /** @brief Bits waiting to be written, the last ones in the least significant bits. */
+        uint64_t m_bits;
+        unsigned int m_nbOfBits;
+
+        /** @brief Quantization table and reciprocals, in natural order. */
+        uint16_t m_quantizers[64];
+        int32_t m_reciprocals[64];
+
+        /** @brief Huffman codes and code lengths of each DC category and AC symbol. */
+        uint16_t m_dcCodes[16];
+        uint8_t m_dcSizes[16];
+        uint16_t m_acCodes[256];
+        uint8_t m_acSizes[256];
+
+        /** @brief Appends bits to the entropy coded data. */
+        inline void putBits(uint32_t bits, unsigned int count);
+        /** @brief Writes the remaining bits, padded with ones. */
+        void flushBits(void);
+        /** @brief Huffman codes a quantized block. */
+        void encodeBlock(const int32_t *block, int *dc);
+        /** @brief Appends the headers: SOI, JFIF, tables and frame and scan headers. */
+        void writeHeaders(unsigned int width, unsigned int height);
+
+        /** @brief Key of the per-thread encoders. */
+        static pthread_key_t s_key;
+        static pthread_once_t s_once;
+        /** @brief Creates @ref s_key. */
+        static void createKey(void);
+        /** @brief Frees the encoder of an exiting thread. */
+        static void destroy(void *encoder);
+};
+
+#endif  /* DEF_JPEG_ENCODER_HPP */
@@ -0,0 +1,122 @@
+/**
+ * @file output_directory.hpp
+ * @brief Frame output directory class definition.
+ */
+
+#ifndef DEF_OUTPUT_DIRECTORY_HPP
+#define DEF_OUTPUT_DIRECTORY_HPP
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string>
+
+/** @brief Number of shard directories kept open at the same time. */
+#define OUTPUT_SHARD_WINDOW     (8u)
+/** @brief Number of shard directories created ahead of the current one. */
+#define OUTPUT_SHARDS_AHEAD     (2u)
+/** @brief Maximum length of a frame file name, relative to the output directory. */
+#define OUTPUT_NAME_MAX         (64u)
+
+/**
+ * @brief Output directory of the acquired frames.
+ * @details Frames are stored in files named after their zero-padded frame number, 
+ *          e.g. @p image0000000042.pgm. Directory lookups and file creations get slower
+ *          as the number of files in a directory grows, so frames can be spread over
+ *          shard subdirectories holding a fixed number of frames each, e.g. 
+ *          @p 000001/image0000010000.pgm with shards of 10000 frames.
+ *
+ *          The output directory and the current shards are kept open and the files are 
+ *          created relative to them with @p openat(). A background thread creates the
+ *          next shards ahead of time, so writers never wait for a directory creation.
+ *          File names are formatted into per-thread buffers, without any allocation. 
+ */
+class OutputDirectory {
+
+    public:
+        /**
+         * @brief Opens the output directory. 
+         * @param[in]   path        Path of the output directory, which must exist. 
+         * @param[in]   extension   Extension of the frame files, without the dot. 
+         * @param[in]   shardSize   Number of frames per shard subdirectory, or 0 to store
+         *                          all the frames in the output directory itself. 
+         */
+        OutputDirectory(const std::string &path, const std::string &extension, unsigned int shardSize = 0u); 
+
+        /**
+         * @brief Stops the shard creation thread and closes the directories. 
+         */
+        ~OutputDirectory(); 
+
+        /** @brief Returns @p true if the output directory could be opened. */
+        bool isOpen(void) const; 
+
+        /** @brief Returns the path of the output directory. */
+        const std::string & getPath(void) const; 
+
+        /** @brief Returns the number of frames per shard, 0 if sharding is disabled. */
+        unsigned int getShardSize(void) const; 
+
+        /**
+         * @brief Returns the name of the file of the given @p frame. 
+         * @details The name is relative to the output directory. It is stored in a buffer
+         *          owned by the calling thread, and overwritten by its next call. 
+         */
+        const char * getFilename(unsigned int frame) const; 
+
+        /**
+         * @brief Creates the file of the given @p frame, truncating any existing one. 
+         * @returns File descriptor opened for writing, or -1 on failure. 
+         */
+        int open(unsigned int frame); 
+
+        /**
+         * @brief Creates the file of the given @p frame as a stream. 
+         * @returns Stream opened for binary writing, or @p NULL on failure. 
+         */
+        FILE * openFile(unsigned int frame); 
+
+        /**
+         * @brief Synchronizes the output directory and its open shards to the disk. 
+         * @details Makes the entries of the newly created frame files durable. 
+         */
+        void sync(void); 
+
+    private:
+        /** @brief Path of the output directory. */
+        std::string m_path; 
+        /** @brief Descriptor of the output directory. */
+        int m_dirfd; 
+        /** @brief File name extension, with its dot. */
+        std::string m_extension; 
+        /** @brief Number of frames per shard (0 if disabled). */
+        unsigned int m_shardSize; 
+
+        /** @brief Descriptors of the open shard directories. */
+        int m_shardFd[OUTPUT_SHARD_WINDOW]; 
+        /** @brief Shard number of each descriptor of @ref m_shardFd. */
+        unsigned int m_shardId[OUTPUT_SHARD_WINDOW]; 
+        /** @brief Number of shards created so far. */
+        unsigned int m_prepared; 
+        /** @brief Last shard the background thread must create. */
+        unsigned int m_target; 
+
+        pthread_t m_thread; 
+        pthread_mutex_t m_lock; 
+        pthread_cond_t m_wakeup; 
+        bool m_stop; 
+
+        /**
+         * @brief Returns a copy of the descriptor of the given shard, creating it if needed. 
+         * @details The copy is closed by the caller. 
+         */
+        int getShard(unsigned int shard); 
+        /** @brief Creates and opens a shard directory. */
+        int createShard(unsigned int shard) const; 
+        /** @brief Stores a shard descriptor in the window. Called under @ref m_lock. */
+        void installShard(unsigned int shard, int fd); 
+
+        /** @brief Shard creation thread. */
+        static void * thread(void *arg); 
+}; 
+
+#endif  /* DEF_OUTPUT_DIRECTORY_HPP */
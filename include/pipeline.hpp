@@ -0,0 +1,322 @@
+/**
+ * @file pipeline.hpp
+ * @brief Frame-processing pipeline class definitions.
+ */
+
+#ifndef DEF_PIPELINE_HPP
+#define DEF_PIPELINE_HPP
+
+#include "image.hpp"
+
+#include <pthread.h>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+/** @brief Name of the pipeline input: the frames submitted by the acquisition. */
+#define PIPELINE_SOURCE         "source"
+/** @brief Default number of frames held by a pipeline, acquired and produced by the stages. */
+#define PIPELINE_CAPACITY       (32u)
+/** @brief Maximum number of pipeline threads. */
+#define PIPELINE_MAX_THREADS    (64u)
+
+/** @brief Frame handed from stage to stage. */
+typedef struct {
+    /** @brief Frame pixels: an acquisition ring slot, or an image created by a stage. */
+    Image *image;
+    /** @brief Frame number. */
+    unsigned int frame;
+    /** @brief Acquisition time, on the monotonic clock. */
+    double timestamp;
+}PipelineFrame_s;
+
+class Pipeline;
+
+/**
+ * @brief Per-thread resources given to the stages.
+ * @details Each pipeline thread owns a context. Its scratch arena gives temporary memory
+ *          for the duration of a single call to @ref PipelineStage::process(), without any
+ *          allocation once the arena has grown to the needs of the stages.
+ */
+class PipelineContext {
+
+    public:
+        PipelineContext(Pipeline *pipeline);
+
+        ~PipelineContext();
+
+        /**
+         * @brief Returns scratch memory, valid until the stage returns.
+         * @details Blocks are 64-byte aligned.
+         */
+        void * allocate(size_t size);
+
+        /**
+         * @brief Returns an image to hand downstream instead of the input frame.
+         * @details The image comes from the pipeline pool and goes back to it once the
+         *          downstream stages are done with it. An image that is not handed
+         *          downstream goes back to the pool when the stage returns.
+         * @returns @p NULL if the pipeline holds too many frames: the stage should drop the frame.
+         */
+        Image * createImage(unsigned int width, unsigned int height);
+
+    private:
+        friend class Pipeline;
+
+        Pipeline *m_pipeline;
+
+        /** @brief Scratch arena and its current use. */
+        unsigned char *m_arena;
+        size_t m_arenaSize;
+        size_t m_used;
+        /** @brief Size requested during the current call, to grow the arena afterwards. */
+        size_t m_requested;
+        /** @brief Blocks allocated beyond the arena during the current call. */
+        std::vector<unsigned char *> m_overflow;
+
+        /** @brief Slots reserved by @ref createImage() during the current call. */
+        std::vector<size_t> m_created;
+
+        /** @brief Frees the scratch memory and grows the arena if it was too small. */
+        void reset(void);
+};
+
+/**
+ * @brief Processing stage of a @ref Pipeline.
+ * @details A stage reads the frames of its input (the acquisition, or another stage)
+ *          and hands its own frames to the stages reading it. It may pass the input frame
+ *          as it is (statistics, storage), modify it in place (calibration, which must
+ *          then be the only reader of its input) or replace it with an image created
+ *          from the context (crop, binning).
+ */
+class PipelineStage {
+
+    public:
+        /**
+         * @param[in]   name    Name of the stage, the input of other stages.
+         * @param[in]   input   Name of the stage read, or @ref PIPELINE_SOURCE.
+         */
+        PipelineStage(const std::string &name, const std::string &input) :
+                m_name(name), m_input(input) {}
+
+        virtual ~PipelineStage() {}
+
+        const std::string & getName(void) const {
+            return this->m_name;
+        }
+
+        const std::string & getInput(void) const {
+            return this->m_input;
+        }
+
+        /**
+         * @brief Processes a frame.
+         * @param[in,out]   frame   Input frame; on return, the frame handed downstream.
+         * @param[in]       context Resources of the calling thread.
+         * @returns @p false to stop the frame here.
+         */
+        virtual bool process(PipelineFrame_s *frame, PipelineContext *context) = 0;
+
+        /** @brief Indicates that the stage modifies the pixels of its input frames. */
+        virtual bool isInPlace(void) const {
+            return false;
+        }
+
+        /**
+         * @brief Indicates that the stage processes a single frame at a time.
+         * @details Serial stages see the frames in the order they reach the stage, which
+         *          is the acquisition order when the stages upstream are serial too.
+         */
+        virtual bool isSerial(void) const {
+            return false;
+        }
+
+        /**
+         * @brief Forgets the previous frames, the next one does not follow them.
+         * @details For instance after a pause, see @ref Pipeline::restart().
+         */
+        virtual void restart(void) {}
+
+    private:
+        std::string m_name;
+        std::string m_input;
+};
+
+/**
+ * @brief Frame-processing pipeline between the acquisition and the storage.
+ * @details The stages form a tree rooted at the acquisition: each stage reads one input
+ *          and any number of stages may read it. The acquisition callback only submits
+ *          the ring slot; the stages run on a pool of threads, so that the processing
+ *          is spread over the cores and never delays the acquisition events.
+ *
+ *          Frames are passed by handle: a ring slot is not copied and stays held until
+ *          every stage reading it (directly or through in-place and pass-through stages)
+ *          is done with it, as with the WriterPool. The number of frames held, including
+ *          the images created by the stages, is bounded by the pipeline capacity.
+ *
+ *          The pipeline can be assembled from a description: each line gives a stage
+ *          type, the stage name, its input and its parameters (@p key=value), e.g.
+ *          @code
+ *          # type      name        input       parameters
+ *          calibrate   corrected   source      dark=dark.pgm
+ *          bin         binned      corrected   factor=4
+ *          store       disk        binned
+ *          @endcode
+ *          Stage types are registered with a factory function.
+ */
+class Pipeline {
+
+    public:
+        /** @brief Parameters of a stage, from its description. */
+        typedef std::map<std::string, std::string> Parameters_t;
+
+        /**
+         * @brief Creates a stage from its description.
+         * @returns @p NULL if the parameters are invalid.
+         */
+        typedef PipelineStage * (*Factory_t)(const std::string &name, const std::string &input,
+                                            const Parameters_t &parameters);
+
+        /**
+         * @brief Starts the pipeline threads.
+         * @param[in]   nbOfThreads Number of threads, 0 to use one per core.
+         * @param[in]   capacity    Maximum number of frames held, acquired or created.
+         */
+        Pipeline(unsigned int nbOfThreads = 0, size_t capacity = PIPELINE_CAPACITY);
+
+        /**
+         * @brief Processes the frames held and stops the threads.
+         * @details The stages are deleted.
+         */
+        ~Pipeline();
+
+        /** @brief Registers a stage type for @ref load(). */
+        void registerType(const std::string &type, Factory_t factory);
+
+        /**
+         * @brief Adds a stage, which the pipeline then owns.
+         * @returns @p false if the name is taken, if the input does not exist or if an
+         *          in-place stage would share its input: the stage is deleted.
+         * @note To be called before the frames are submitted.
+         */
+        bool addStage(PipelineStage *stage);
+
+        /**
+         * @brief Adds the stages of a description file.
+         * @returns @p false on error, see @ref getError().
+         */
+        bool load(const std::string &filename);
+
+        /** @brief Adds the stages of a description. */
+        bool parse(const std::string &description);
+
+        /** @brief Returns the last description or configuration error. */
+        const std::string & getError(void) const;
+
+        /** @brief Returns the number of stages. */
+        unsigned int getNbOfStages(void) const;
+
+        /**
+         * @brief Hands an acquired frame to the stages reading the acquisition.
+         * @returns @p false if the pipeline is full: the frame is not processed.
+         */
+        bool submit(Image *image, unsigned int frame, double timestamp);
+
+        /** @brief Returns @p true if the given ring slot is still held by the pipeline. */
+        bool isPending(const Image *image);
+
+        /** @brief Returns the number of frames held. */
+        size_t getBacklog(void);
+
+        /** @brief Returns the maximum number of frames held. */
+        size_t getCapacity(void) const;
+
+        /** @brief Waits until all the frames are processed. */
+        void drain(void);
+
+        /**
+         * @brief Restarts every stage, the next frame does not follow the previous ones.
+         * @note To be called once drained.
+         */
+        void restart(void);
+
+    private:
+        friend class PipelineContext;
+
+        /** @brief Frame held by the pipeline. */
+        typedef struct {
+            PipelineFrame_s frame;
+            /** @brief Number of stage jobs still to read the frame (0: free slot). */
+            unsigned int references;
+            /** @brief The image comes from the pool. */
+            bool pooled;
+            /** @brief Reserved by @ref PipelineContext::createImage(), not yet handed over. */
+            bool reserved;
+        }Slot_s;
+
+        /** @brief Frame waiting for a stage. */
+        typedef struct {
+            size_t slot;
+            /** @brief Frame as handed by the stage upstream. */
+            PipelineFrame_s frame;
+        }Job_s;
+
+        /** @brief Stage and its pending frames. */
+        typedef struct {
+            PipelineStage *stage;
+            /** @brief Stages reading this one. */
+            std::vector<unsigned int> readers;
+            std::deque<Job_s> queue;
+            unsigned int running;
+        }Stage_s;
+
+        std::vector<Stage_s> m_stages;
+        /** @brief Stages reading the acquisition. */
+        std::vector<unsigned int> m_sourceReaders;
+        std::map<std::string, Factory_t> m_factories;
+        std::string m_error;
+
+        Slot_s *m_slots;
+        size_t m_capacity;
+        size_t m_held;
+        /** @brief Images created by the stages and free again. */
+        std::vector<Image *> m_pool;
+
+        unsigned int m_nbOfThreads;
+        pthread_t *m_threads;
+        PipelineContext **m_contexts;
+        pthread_mutex_t m_lock;
+        /** @brief Signals a queued job, or the end of the pipeline. */
+        pthread_cond_t m_available;
+        /** @brief Signals a released frame. */
+        pthread_cond_t m_released;
+        bool m_stop;
+
+        /** @brief Returns the index of a stage, -1 if it does not exist. */
+        int findStage(const std::string &name) const;
+        /** @brief Returns a free slot, or -1. Called with the lock held. */
+        long reserveSlot(void);
+        /** @brief Queues a frame for the given stages. Called with the lock held. */
+        void dispatch(size_t slot, const PipelineFrame_s &frame, const std::vector<unsigned int> &readers);
+        /** @brief Hands a reserved slot to the given stages. Called with the lock held. */
+        void hand(size_t slot, const PipelineFrame_s &frame, const std::vector<unsigned int> &readers);
+        /** @brief Drops a reference to a slot. Called with the lock held. */
+        void release(size_t slot);
+        /** @brief Frees a slot. Called with the lock held. */
+        void freeSlot(size_t slot);
+        /** @brief Reserves a pooled image for a stage. */
+        Image * createImage(PipelineContext *context, unsigned int width, unsigned int height);
+
+        /** @brief Pipeline thread argument. */
+        typedef struct {
+            Pipeline *pipeline;
+            unsigned int index;
+        }ThreadArg_s;
+        ThreadArg_s *m_args;
+
+        /** @brief Pipeline thread. */
+        static void * thread(void *arg);
+};
+
+#endif  /* DEF_PIPELINE_HPP */
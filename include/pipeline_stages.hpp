@@ -0,0 +1,138 @@
+/**
+ * @file pipeline_stages.hpp
+ * @brief Standard frame-processing pipeline stages.
+ */
+
+#ifndef DEF_PIPELINE_STAGES_HPP
+#define DEF_PIPELINE_STAGES_HPP
+
+#include "pipeline.hpp"
+#include "calibration.hpp"
+#include "temporal_binner.hpp"
+
+/** @brief Default number of frames between two statistics lines. */
+#define STATS_PERIOD    (100u)
+
+/**
+ * @brief Dark and flat correction, in place (type @p calibrate).
+ * @details Parameters: @p dark and @p flat master files, @p width and @p height of the
+ *          frames (800x600 by default).
+ */
+class CalibrationStage : public PipelineStage {
+
+    public:
+        /** @brief Takes ownership of the calibration. */
+        CalibrationStage(const std::string &name, const std::string &input, Calibration *calibration);
+
+        ~CalibrationStage();
+
+        virtual bool process(PipelineFrame_s *frame, PipelineContext *context);
+
+        virtual bool isInPlace(void) const {
+            return true;
+        }
+
+    private:
+        Calibration *m_calibration;
+};
+
+/**
+ * @brief Temporal binning into pooled images (type @p bin).
+ * @details Parameters: @p factor, @p mode (@p mean or @p sum), @p width and @p height.
+ *          A binned frame keeps the number of the last frame of its bin, so that the
+ *          numbers stay unique across the runs appended to a recording.
+ */
+class BinningStage : public PipelineStage {
+
+    public:
+        /** @brief Takes ownership of the binner. */
+        BinningStage(const std::string &name, const std::string &input, TemporalBinner *binner);
+
+        ~BinningStage();
+
+        virtual bool process(PipelineFrame_s *frame, PipelineContext *context);
+
+        /** @brief The bins are made of consecutive frames. */
+        virtual bool isSerial(void) const {
+            return true;
+        }
+
+        /** @brief Drops the frames of the current bin. */
+        virtual void restart(void);
+
+    private:
+        TemporalBinner *m_binner;
+};
+
+/**
+ * @brief Region of interest, copied into pooled images (type @p crop).
+ * @details Parameters: @p x, @p y, @p width and @p height of the region. Frames too small
+ *          for the region are dropped.
+ */
+class CropStage : public PipelineStage {
+
+    public:
+        CropStage(const std::string &name, const std::string &input, unsigned int x, unsigned int y,
+                  unsigned int width, unsigned int height);
+
+        virtual bool process(PipelineFrame_s *frame, PipelineContext *context);
+
+    private:
+        unsigned int m_x;
+        unsigned int m_y;
+        unsigned int m_width;
+        unsigned int m_height;
+};
+
+/**
+ * @brief Frame statistics, the frames pass unchanged (type @p stats).
+ * @details Parameter: @p every, the number of frames between two lines giving the
+ *          minimum, maximum and mean pixel values.
+ */
+class StatsStage : public PipelineStage {
+
+    public:
+        StatsStage(const std::string &name, const std::string &input, unsigned int period);
+
+        ~StatsStage();
+
+        virtual bool process(PipelineFrame_s *frame, PipelineContext *context);
+
+        /** @brief Returns the statistics of the last frame processed. */
+        void getLast(unsigned int *min, unsigned int *max, double *mean) const;
+
+    private:
+        unsigned int m_period;
+        /** @brief Frames are processed by several threads at once. */
+        mutable pthread_mutex_t m_lock;
+        unsigned int m_min;
+        unsigned int m_max;
+        double m_mean;
+};
+
+/**
+ * @brief Hands the frames to a function, the frames pass unchanged.
+ * @details Storage and archive outputs of the application.
+ */
+class SinkStage : public PipelineStage {
+
+    public:
+        /** @param[in] serial  The function is called for one frame at a time, in the order they reach the stage. */
+        SinkStage(const std::string &name, const std::string &input, void (*sink)(Image *, unsigned int),
+                  bool serial = false);
+
+        virtual bool process(PipelineFrame_s *frame, PipelineContext *context);
+
+        virtual bool isSerial(void) const {
+            return this->m_serial;
+        }
+
+    private:
+        void (*m_sink)(Image *, unsigned int);
+        bool m_serial;
+};
+
+/** @brief Registers the @p calibrate, @p bin, @p crop and @p stats stage types. */
+void registerStandardStages(Pipeline *pipeline);
+
+#endif  /* DEF_PIPELINE_STAGES_HPP */
@@ -6,18 +6,38 @@
 #ifndef DEF_TX_PIPE_HPP
 #define DEF_TX_PIPE_HPP
 
-#include <fstream>
 #include <string>
 
+/**
+ * @brief Writing end of a named pipe. 
+ * @details In blocking mode, the pipe is opened by the constructor, which waits for 
+ *          a reader, and @ref send() writes all the data. 
+ *          In non-blocking mode, the pipe is created if needed and opened once a reader 
+ *          is present, and @ref send() only writes what the pipe can take right away. 
+ *          A reader that goes away is detected and waited for again. 
+ */
 class TXPipe {
     public: 
-        TXPipe(const std::string &pipefile); 
+        TXPipe(const std::string &pipefile, bool nonBlocking = false); 
         ~TXPipe();
 
-        void send(const char *data, int dataSize);
+        /**
+         * @brief Sends data through the pipe. 
+         * @returns Number of bytes written (possibly less than @p dataSize in non-blocking mode), 
+         *          or -1 if there is no reader. 
+         */
+        int send(const char *data, int dataSize);
+
+        /** @brief Returns @p true if the pipe is open. */
+        bool isConnected(void) const; 
+
     private:
-        std::filebuf *m_pipe; 
+        std::string m_pipefile; 
+        int m_fd; 
+        bool m_nonBlocking; 
+
+        /** @brief Opens the pipe if it is not open yet. */
+        bool connect(void); 
 };
 
 #endif  /* DEF_TX_PIPE_HPP */
-
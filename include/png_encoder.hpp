@@ -0,0 +1,121 @@
+/**
+ * @file png_encoder.hpp
+ * @brief Grayscale PNG encoder class definition.
+ */
+
+#ifndef DEF_PNG_ENCODER_HPP
+#define DEF_PNG_ENCODER_HPP
+
+#include "image.hpp"
+#include <zlib.h>
+#include <pthread.h>
+#include <stdint.h>
+
+/**
+ * @brief Type of the private chunk holding the CRC32C of the frame pixels.
+ * @details Ancillary, private and safe to copy: other PNG readers ignore it.
+ */
+#define PNG_CHECKSUM_CHUNK  "crCc"
+
+/** @brief PNG filter types, as stored in front of each filtered row. */
+typedef enum {
+    PNG_ROW_NONE  = 0,
+    PNG_ROW_SUB   = 1,
+    PNG_ROW_UP    = 2,
+    PNG_ROW_AVG   = 3,
+    PNG_ROW_PAETH = 4
+}PngRowFilter_e;
+
+/**
+ * @brief PNG encoder dedicated to 8-bit grayscale frames.
+ * @details Our frames are always 8-bit grayscale: this encoder skips the generic libpng
+ *          machinery. The rows are filtered straight from the frame buffer (with SSE2 when
+ *          available), the filter of each row being the allowed one giving the smallest sum
+ *          of absolute values, as libpng does. The whole filtered image is then compressed
+ *          with a single zlib call (run-length coding at the fast levels), and the chunks
+ *          and their CRCs are written directly.
+ *          The output is a standard PNG file. The CRC32C of the raw pixels is stored in
+ *          a private chunk (@ref PNG_CHECKSUM_CHUNK), before the image data.
+ *
+ *          The zlib stream and buffers are kept between frames, an encoder must therefore
+ *          not be shared between threads. @ref getThreadEncoder() gives one to each thread.
+ */
+class PngEncoder {
+
+    public:
+        /**
+         * @brief Allocates the compression stream.
+         */
+        PngEncoder(void);
+
+        /**
+         * @brief Frees the compression stream and buffers.
+         */
+        ~PngEncoder();
+
+        /**
+         * @brief Writes a frame to an open stream, in the PNG format.
+         * @param[in]   fp      Stream opened for binary writing. It is not closed.
+         * @param[in]   pixels  Frame pixels, row after row.
+         * @param[in]   width   Frame width.
+         * @param[in]   height  Frame height.
+         * @param[in]   level   zlib compression level, or -1 for the zlib default.
+         * @param[in]   filters Allowed row filters (@p PNG_FILTER_* flags), or -1 for all of them.
+         * @param[in]   title   Title of the PNG file, or @p NULL.
+         * @returns Number of bytes written, 0 on error.
+         */
+        size_t write(FILE *fp, const pixel_t *pixels, unsigned int width, unsigned int height,
+                     int level = -1, int filters = -1, const char *title = NULL);
+
+        /** @brief Returns the CRC32C of the pixels of the last written frame. */
+        uint32_t getChecksum(void) const;
+
+        /**
+         * @brief Filters a row.
+         * @param[in]   type        Filter to apply.
+         * @param[in]   row         Row to filter.
+         * @param[in]   previous    Previous row of the image, a row of zeros for the first row.
+         * @param[in]   width       Number of pixels in the row.
+         * @param[out]  dst         Filtered row, @p width bytes (without the filter type).
+         * @returns Sum of the absolute values of the filtered bytes, taken as signed.
+         */
+        static unsigned long filterRow(PngRowFilter_e type, const unsigned char *row,
+                                       const unsigned char *previous, size_t width, unsigned char *dst);
+
+        /**
+         * @brief Returns the encoder of the calling thread.
+         * @details The encoder is created on first use and freed when the thread exits.
+         */
+        static PngEncoder * getThreadEncoder(void);
+
+    private:
+        /** @brief Deflate stream, reset for each frame. */
+        z_stream m_deflate;
+        /** @brief Filtered image, each row preceded by its filter type. */
+        unsigned char *m_filtered;
+        size_t m_filteredSize;
+        /** @brief Compressed image data. */
+        unsigned char *m_compressed;
+        size_t m_compressedSize;
+        /** @brief One row per filter, to pick the best one. */
+        unsigned char *m_candidates;
+        /** @brief Row of zeros, used as the row above the first one. */
+        unsigned char *m_zero;
+        /** @brief Width of the candidate rows. */
+        size_t m_rowSize;
+        /** @brief CRC32C of the last frame. */
+        uint32_t m_checksum;
+
+        /** @brief Writes a chunk: length, type, data and CRC. */
+        static size_t writeChunk(FILE *fp, const char *type, const unsigned char *data, size_t size);
+
+        /** @brief Key of the per-thread encoders. */
+        static pthread_key_t s_key;
+        static pthread_once_t s_once;
+        /** @brief Creates @ref s_key. */
+        static void createKey(void);
+        /** @brief Frees the encoder of an exiting thread. */
+        static void destroy(void *encoder);
+};
+
+#endif  /* DEF_PNG_ENCODER_HPP */
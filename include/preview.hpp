@@ -0,0 +1,120 @@
+/**
+ * @file preview.hpp
+ * @brief Live preview class definition.
+ */
+
+#ifndef DEF_PREVIEW_HPP
+#define DEF_PREVIEW_HPP
+
+#include "image.hpp"
+#include <pthread.h>
+#include <string>
+
+/**
+ * @brief Low-rate downsampled live preview of the acquisition. 
+ * @details The acquisition path only records the address of the latest frame with
+ *          @ref offer(), a single atomic store. A preview thread wakes up at the preview
+ *          rate, downsamples the latest frame with a vectorized box filter and publishes
+ *          the result in a latest-frame-wins slot. Viewers read the slot with @ref read(), 
+ *          without ever touching the acquisition ring buffer. The slot is protected by
+ *          a sequence lock: readers retry if the preview thread published meanwhile. 
+ *
+ *          The preview can also be written to a PGM file, replaced atomically at each
+ *          update, for external viewers. 
+ * @note The frame is read from its ring slot, which may be overwritten by the camera
+ *       during the downsampling if the ring is very small. This only affects the preview. 
+ */
+class Preview {
+
+    public:
+        /**
+         * @brief Starts the preview thread. 
+         * @param[in]   width       Width of the acquired frames. 
+         * @param[in]   height      Height of the acquired frames. 
+         * @param[in]   factor      Downsampling factor: 2, 4 or 8. 
+         * @param[in]   rate        Preview rate, in frames per second. 
+         * @param[in]   filename    PGM file updated with each preview, or an empty string. 
+         */
+        Preview(unsigned int width, unsigned int height, unsigned int factor, double rate, 
+                const std::string &filename = ""); 
+
+        /**
+         * @brief Stops the preview thread. 
+         */
+        ~Preview(); 
+
+        /**
+         * @brief Records the latest acquired frame. 
+         * @details Called by the acquisition path for every frame: this is only an atomic store. 
+         * @see clear()
+         */
+        void offer(const Image *image) {
+            __atomic_store_n(&this->m_latest, image, __ATOMIC_RELEASE); 
+        }
+
+        /**
+         * @brief Forgets the latest frame. 
+         * @details Waits for the preview in progress, if any. Must be called once the 
+         *          acquisition is stopped, before the ring buffer is resized or released. 
+         */
+        void clear(void); 
+
+        /** @brief Returns the width of the preview. */
+        unsigned int getWidth(void) const; 
+
+        /** @brief Returns the height of the preview. */
+        unsigned int getHeight(void) const; 
+
+        /**
+         * @brief Copies the latest preview. 
+         * @param[out]  dst     Buffer of @ref getWidth() x @ref getHeight() bytes. 
+         * @returns Number of the preview (starting at 1), or 0 if no preview was published yet. 
+         */
+        unsigned long read(unsigned char *dst) const; 
+
+        /**
+         * @brief Downsamples a frame with a box filter. 
+         * @details Each output pixel is the rounded mean of a @p factor x @p factor block. 
+         *          Incomplete blocks on the right and bottom edges are dropped. 
+         * @param[in]   src     Source frame. 
+         * @param[in]   width   Width of the source frame. 
+         * @param[in]   height  Height of the source frame. 
+         * @param[in]   factor  Downsampling factor: 2, 4 or 8. 
+         * @param[out]  dst     Output buffer of (width / factor) x (height / factor) bytes. 
+         */
+        static void downsample(const unsigned char *src, unsigned int width, unsigned int height, 
+                               unsigned int factor, unsigned char *dst); 
+
+    private:
+        unsigned int m_width; 
+        unsigned int m_height; 
+        unsigned int m_factor; 
+        /** @brief Time between two previews, in seconds. */
+        double m_period; 
+        std::string m_filename; 
+
+        /** @brief Latest acquired frame. */
+        const Image *m_latest; 
+
+        /** @brief Published preview. */
+        unsigned char *m_slot; 
+        /** @brief Preview being computed. */
+        unsigned char *m_scratch; 
+        /** @brief Sequence lock: odd while the slot is being updated. */
+        unsigned long m_sequence; 
+
+        pthread_t m_thread; 
+        pthread_mutex_t m_lock; 
+        pthread_cond_t m_wakeup; 
+        bool m_stop; 
+
+        /** @brief Publishes the scratch preview in the slot. */
+        void publish(void); 
+        /** @brief Writes the scratch preview to the preview file. */
+        void writeFile(void) const; 
+
+        /** @brief Preview thread. */
+        static void * thread(void *arg); 
+}; 
+
+#endif  /* DEF_PREVIEW_HPP */
@@ -0,0 +1,84 @@
+/**
+ * @file recording_verifier.hpp
+ * @brief Recording integrity verifier class definition.
+ */
+
+#ifndef DEF_RECORDING_VERIFIER_HPP
+#define DEF_RECORDING_VERIFIER_HPP
+
+#include <pthread.h>
+#include <string>
+#include <vector>
+
+/** @brief Result of the check of a frame file. */
+typedef enum {
+    VERIFY_OK,          /**< @brief The pixels match the stored checksum. */
+    VERIFY_CORRUPT,     /**< @brief The file cannot be decoded or the pixels do not match. */
+    VERIFY_UNCHECKED    /**< @brief The file holds no checksum. */
+}VerifyResult_e;
+
+/**
+ * @brief Checks the frames of a recording against their checksums.
+ * @details Each frame file holds the CRC32C of its pixels: in a private chunk for PNG
+ *          files, in the header comment for PGM files. The verifier decodes every frame
+ *          of a directory (and of its shard subdirectories), in parallel on all cores,
+ *          and compares the checksums.
+ */
+class RecordingVerifier {
+
+    public:
+        /**
+         * @brief Creates a verifier for the given recording.
+         * @param[in]   directory   Output directory of the recording.
+         * @param[in]   nbOfThreads Number of threads, 0 to use one per core.
+         */
+        RecordingVerifier(const std::string &directory, unsigned int nbOfThreads = 0);
+
+        ~RecordingVerifier();
+
+        /**
+         * @brief Checks every frame of the recording.
+         * @returns Number of corrupt frames.
+         */
+        unsigned int verify(void);
+
+        /** @brief Returns the number of frames matching their checksum. */
+        unsigned int getValid(void) const;
+
+        /** @brief Returns the number of frames without a checksum. */
+        unsigned int getUnchecked(void) const;
+
+        /** @brief Returns the paths of the corrupt frames, sorted. */
+        const std::vector<std::string> & getCorrupt(void) const;
+
+        /**
+         * @brief Checks a single frame file.
+         * @param[in]   path    Path of a PNG or PGM frame file.
+         */
+        static VerifyResult_e verifyFile(const std::string &path);
+
+    private:
+        std::string m_directory;
+        unsigned int m_nbOfThreads;
+
+        /** @brief Frame files of the recording. */
+        std::vector<std::string> m_files;
+        /** @brief Index of the next file to check. */
+        size_t m_next;
+
+        unsigned int m_valid;
+        unsigned int m_unchecked;
+        std::vector<std::string> m_corrupt;
+        pthread_mutex_t m_lock;
+
+        /** @brief Lists the frame files of a directory and of its shards. */
+        void listFiles(const std::string &directory);
+        /** @brief Checking thread. */
+        static void * thread(void *arg);
+        /** @brief Checks a PNG frame. */
+        static VerifyResult_e verifyPNG(FILE *fp);
+        /** @brief Checks a PGM frame. */
+        static VerifyResult_e verifyPGM(FILE *fp);
+};
+
+#endif  /* DEF_RECORDING_VERIFIER_HPP */
@@ -7,8 +7,12 @@
 #define DEF_RING_BUFFER_HPP
 
 #include "image.hpp"
+#include "shared_ring.hpp"
 #include <map>
 
+/** @brief Maximum number of threads locking the ring buffer memory. */
+#define RING_BUFFER_MAX_THREADS     (8u)
+
 /**
  * @brief Ring buffer for image acquisition.
  * @details A ring buffer is a circular buffer holding image memory objects
@@ -22,11 +26,23 @@ class RingBuffer {
          * @brief Builds a ring buffer of the given size. 
          * @details Allocates memory for the given number of images and sets
          *          the mapping between image buffers and the Image objects.
+         *          The images share a single arena, faulted in and locked in RAM by 
+         *          several threads in parallel: the kernel zeroes the pages on all cores. 
          * @param[in]   nbOfImages  Number of images in the ring buffer. 
+         * @param[in]   nbOfThreads Number of threads locking the arena, or 0 for one per 
+         *                          core (at most @ref RING_BUFFER_MAX_THREADS). 
          * @note Allocated memory is freed in @ref ~RingBuffer().
          * @see ~RingBuffer()
          */
-        RingBuffer(unsigned int width, unsigned int height, size_t nbOfImages); 
+        RingBuffer(unsigned int width, unsigned int height, size_t nbOfImages, unsigned int nbOfThreads = 0); 
+
+        /**
+         * @brief Builds a ring buffer over the frames of a shared memory ring. 
+         * @details The images use the shared memory directly, so that other processes 
+         *          see the acquired frames without any copy. 
+         * @param[in]   shared  Shared memory ring. Must outlive the ring buffer. 
+         */
+        RingBuffer(SharedRing *shared); 
 
         /**
          * @brief Tears down a ring buffer object.
@@ -36,6 +52,21 @@ class RingBuffer {
 
         /** @brief Returns the number of images in the ring buffer. */
 	    size_t getSize(void) const;
+
+        /** @brief Returns the size of the locked arena holding the images, in bytes. */
+        size_t getArenaSize(void) const; 
+
+        /**
+         * @brief Changes the number of images in the ring buffer. 
+         * @details Images are added or removed at the end of the ring buffer, 
+         *          the other images are kept along with their content. The images 
+         *          move into a new arena of the new size, locked as in the constructor, 
+         *          and the old arena is released.
+         * @param[in]   nbOfImages  New number of images in the ring buffer. 
+         * @warning Must not be called during an acquisition. 
+         * @note A ring buffer in shared memory cannot be resized. 
+         */
+        void resize(size_t nbOfImages);
    
         Image * at(const size_t index) const;
         Image * getImageFromBuffer(char * const buffer) const; 
@@ -50,6 +81,32 @@ class RingBuffer {
         size_t m_size;
         unsigned int m_width; 
         unsigned int m_height; 
+        /** @brief Shared memory holding the images, or @p NULL. */
+        SharedRing *m_shared; 
+        /** @brief Memory holding the images, or @p NULL. */
+        unsigned char *m_arena; 
+        size_t m_arenaSize; 
+        /** @brief Number of threads locking an arena. */
+        unsigned int m_nbOfThreads; 
+
+        /** @brief Part of the arena locked by a thread. */
+        typedef struct {
+            unsigned char *start; 
+            size_t size; 
+        }Chunk_s; 
+
+        /** @brief Returns the page-aligned size of an image in the arena. */
+        size_t getStride(void) const; 
+
+        /**
+         * @brief Maps an arena for @p nbOfImages images, faulted in and locked in parallel. 
+         * @param[out]  size    Size of the arena, in bytes. 
+         * @returns The arena, or @p NULL if it could not be mapped. 
+         */
+        unsigned char * createArena(size_t nbOfImages, size_t *size) const; 
+
+        /** @brief Faults in and locks a chunk of the arena. */
+        static void * lockChunk(void *arg); 
 
         /** @brief Maps an image buffer address to its corresponding Image object. */
         std::map<char * const, Image *> m_bufferToImage; 
@@ -0,0 +1,98 @@
+/**
+ * @file ring_sizer.hpp
+ * @brief Automatic ring buffer sizing class definition.
+ */
+
+#ifndef DEF_RING_SIZER_HPP
+#define DEF_RING_SIZER_HPP
+
+#include <string>
+#include <stdlib.h>
+
+/** @brief Minimum number of images in an automatically sized ring buffer. */
+#define RING_SIZER_MIN_SIZE     (3u)
+
+/**
+ * @brief Computes the size of the acquisition ring buffer.
+ * @details The ring buffer must hold every frame acquired while the previous ones
+ *          are being written to disk. Its size therefore depends on the frame rate,
+ *          on the write latency of the output directory, measured with a short
+ *          calibration write synchronized to the disk, and on the duration of the disk
+ *          stalls it should absorb (burst tolerance). The result is bounded by the memory
+ *          budget: the amount of memory the process may still lock (@p RLIMIT_MEMLOCK)
+ *          and the free memory of the system. A resized ring is locked before the current
+ *          one is released (see RingBuffer::resize()), so the current ring stays counted
+ *          as used; it is kept as is when the budget cannot hold the new one.
+ *
+ *          Each call to @ref computeSize() reads the memory budget again, so the
+ *          ring buffer may be resized between two acquisition runs.
+ * @see RingBuffer::resize()
+ */
+class RingSizer {
+
+    public:
+        /**
+         * @brief Creates a sizer for frames of the given @p width and @p height.
+         */
+        RingSizer(unsigned int width, unsigned int height);
+
+        /**
+         * @brief Measures the write latency of the given @p directory.
+         * @details Writes @p nbOfWrites frames in @p directory, as the acquisition would,
+         *          then removes them. Each write is synchronized to the disk before it is
+         *          timed, so that the page cache does not hide the disk latency. The worst
+         *          latency is kept.
+         * @returns Measured write latency, in seconds, or a negative value if a frame
+         *          could not be written.
+         */
+        double calibrate(const std::string &directory, unsigned int nbOfWrites = 8u);
+
+        /** @brief Sets the write latency of a frame, in seconds. */
+        void setWriteLatency(double latency);
+
+        /** @brief Returns the write latency of a frame, in seconds. */
+        double getWriteLatency(void) const;
+
+        /** @brief Sets the acquisition frame rate, in frames per second. */
+        void setFramerate(double framerate);
+
+        /** @brief Sets the duration of the disk stalls to absorb, in seconds. */
+        void setBurstTolerance(double tolerance);
+
+        /**
+         * @brief Forces the memory budget.
+         * @param[in]   budget  Memory budget in bytes, or 0 to compute it from the system limits.
+         */
+        void setMemoryBudget(size_t budget);
+
+        /**
+         * @brief Returns the memory budget of the ring buffer, in bytes.
+         * @details Unless forced, this is the smallest of the memory the process may still
+         *          lock and of half of the available memory.
+         */
+        size_t getMemoryBudget(void) const;
+
+        /**
+         * @brief Returns the number of images the ring buffer should hold.
+         * @details The ring must hold the frames acquired during a write and a disk stall,
+         *          plus one frame being acquired and one frame being written.
+         *          The result lies between @ref RING_SIZER_MIN_SIZE and the memory budget,
+         *          unless the current ring is kept because a new one would not fit.
+         * @param[in]   currentSize Number of images of the current ring buffer, 0 if none.
+         */
+        size_t computeSize(size_t currentSize = 0) const;
+
+    private:
+        unsigned int m_width;
+        unsigned int m_height;
+        /** @brief Acquisition frame rate, in frames per second. */
+        double m_framerate;
+        /** @brief Write latency of a frame, in seconds. */
+        double m_writeLatency;
+        /** @brief Duration of the disk stalls to absorb, in seconds. */
+        double m_burstTolerance;
+        /** @brief Forced memory budget, in bytes (0 if automatic). */
+        size_t m_memoryBudget;
+};
+
+#endif  /* DEF_RING_SIZER_HPP */
@@ -7,11 +7,53 @@
 #define DEF_I2C_BUS_HPP
 
 #include <string>
+#include <termios.h>
+#include <sys/types.h>
 
+/**
+ * @brief Serial link to the on-board computer. 
+ * @details The tty is opened in raw mode (8N1, no flow control, no echo) and in 
+ *          non-blocking mode: reads return whatever is available, see @ref RXThread
+ *          for the reception. 
+ */
 class I2CBus {
     public: 
-        I2CBus(std::string tty); 
+        /**
+         * @brief Opens and configures a tty. 
+         * @param[in]   tty         Device name, such as "/dev/ttyS0". 
+         * @param[in]   baudrate    Line speed, as a termios constant. 
+         */
+        I2CBus(std::string tty, speed_t baudrate = B115200); 
+
+        /**
+         * @brief Closes the tty. 
+         */
         ~I2CBus(); 
+
+        /** @brief Returns @p true if the tty is open. */
+        bool isOpen(void) const; 
+
+        /** @brief Returns the tty file descriptor. */
+        int getFd(void) const; 
+
+        /**
+         * @brief Reads the available bytes, without waiting. 
+         * @returns Number of bytes read, 0 if none is available, or -1 on error. 
+         */
+        ssize_t read(unsigned char *data, size_t size); 
+
+        /**
+         * @brief Writes bytes, waiting for room in the output queue if needed. 
+         * @returns Number of bytes written, or -1 on error. 
+         */
+        ssize_t write(const unsigned char *data, size_t size); 
+
+    private:
+        int m_fd; 
+
+        /* The tty is owned by a single object */
+        I2CBus(const I2CBus &); 
+        I2CBus & operator=(const I2CBus &); 
 };
 
 #endif  /* DEF_I2C_BUS_HPP */
@@ -7,15 +7,98 @@
 #define DEF_RX_THREAD_HPP
 
 #include "serial/i2c_bus.hpp"
+#include <pthread.h>
 
+/** @brief Start of frame marker. */
+#define RX_FRAME_START          (0x7E)
+/** @brief Maximum size of a command, in bytes. */
+#define RX_FRAME_MAX_PAYLOAD    (255u)
+/** @brief Frame bytes around the command: start marker, length and checksum. */
+#define RX_FRAME_OVERHEAD       (3u)
+/** @brief Size of the reception ring, in bytes (a power of 2). */
+#define RX_RING_SIZE            (4096u)
+
+/**
+ * @brief Command reception from the serial link. 
+ * @details Commands are framed as follows: 
+ *          | Start (0x7E) | Length (1..255) | Command | CRC-8 of length and command | 
+ *
+ *          The thread sleeps in @p epoll until bytes arrive, then reads everything 
+ *          available into a fixed ring and decodes every complete frame, so a burst of 
+ *          commands costs a single wakeup. Each command is passed to the callback, which 
+ *          has the same signature as the @ref RXPipe one. 
+ *
+ *          Bytes stay in the ring until they are part of a valid frame: a frame with a bad 
+ *          length or checksum, for instance from a start marker in line noise, only drops 
+ *          its start marker and the decoder scans again from the next byte, so that a false 
+ *          length cannot swallow the commands behind it. While a frame is incomplete, a 
+ *          complete valid frame further in the ring also reveals a false start. 
+ */
 class RXThread {
     public: 
-        RXThread(I2CBus bus); 
+        /**
+         * @brief Creates a reception thread, see @ref start(). 
+         * @param[in]   bus         Serial link. Must outlive the thread. 
+         * @param[in]   rxCallback  Function called with each command and its size. 
+         */
+        RXThread(I2CBus *bus, void (*rxCallback)(char *, int)); 
         ~RXThread();
 
+        void start(void); 
+        void stop(void); 
+
+        /** @brief Returns the number of valid commands received. */
+        unsigned long getFrames(void) const; 
+
+        /** @brief Returns the number of frames dropped for a bad length or checksum. */
+        unsigned long getErrors(void) const; 
+
+        /**
+         * @brief Frames a command, for the sending side. 
+         * @param[in]   command     Command bytes. 
+         * @param[in]   size        Size of the command, from 1 to @ref RX_FRAME_MAX_PAYLOAD. 
+         * @param[out]  frame       Buffer of @p size + @ref RX_FRAME_OVERHEAD bytes. 
+         * @returns Size of the frame, or 0 if the command size is invalid. 
+         */
+        static size_t encode(const char *command, size_t size, unsigned char *frame); 
+
+        /** @brief Computes the CRC-8 (polynomial 0x07) of @p data. */
+        static unsigned char checksum(const unsigned char *data, size_t size, unsigned char crc = 0); 
+
     private: 
-        I2CBus m_bus; 
+        I2CBus *m_bus; 
+        void (*m_callback)(char *, int); 
+
+        /** @brief Reception ring. */
+        unsigned char m_ring[RX_RING_SIZE]; 
+        /** @brief Number of bytes written in the ring since the start. */
+        size_t m_head; 
+        /** @brief Number of bytes decoded since the start. */
+        size_t m_tail; 
+
+        /** @brief Command of the last frame checked. */
+        unsigned char m_command[RX_FRAME_MAX_PAYLOAD + 1]; 
+
+        unsigned long m_frames; 
+        unsigned long m_errors; 
+
+        int m_epoll; 
+        /** @brief Wakes the thread up to stop it. */
+        int m_stopEvent; 
+        pthread_t m_rxThread; 
+        bool m_running; 
+
+        /** @brief Reads the available bytes into the ring. @returns @p false on error. */
+        bool fill(void); 
+        /** @brief Decodes the bytes of the ring and dispatches the commands. */
+        void decode(void); 
+        /**
+         * @brief Checks the frame starting at a ring position, and copies its command. 
+         * @returns Size of the frame if it is valid, 0 if it is incomplete, -1 if it is invalid. 
+         */
+        int checkFrame(size_t position); 
+
+        static void * thread(void *arg); 
 };
 
 #endif  /* DEF_RX_THREAD_HPP */
-
@@ -0,0 +1,179 @@
+/**
+ * @file shared_ring.hpp
+ * @brief Shared-memory frame ring class definition.
+ */
+
+#ifndef DEF_SHARED_RING_HPP
+#define DEF_SHARED_RING_HPP
+
+#include "image.hpp"
+#include <stdint.h>
+#include <string>
+
+/** @brief Identifies a CWIS shared frame ring ("CWIS"). */
+#define SHARED_RING_MAGIC       (0x43574953u)
+/** @brief Version of the shared memory layout. */
+#define SHARED_RING_VERSION     (1u)
+/** 
+ * @brief Minimum number of slots ahead of the latest frame marked as being written. 
+ * @details The camera fills the next slot as soon as a frame is complete, before the 
+ *          acquisition callback runs: the slots the camera may reach before the next 
+ *          callback are marked beforehand. The camera may complete several frames between 
+ *          two callbacks, see @ref SharedRing::extendGuard(). 
+ */
+#define SHARED_RING_GUARD       (2u)
+
+/**
+ * @brief Shared memory header, at offset 0 (one cache line). 
+ * @details Fixed-size fields only: the layout is shared with processes built separately. 
+ */
+typedef struct {
+    uint32_t magic; 
+    uint32_t version; 
+    uint32_t width; 
+    uint32_t height; 
+    uint32_t nbOfSlots; 
+    uint32_t guard; 
+    /** @brief Distance between two frames, in bytes (a multiple of the page size). */
+    uint64_t slotStride; 
+    /** @brief Offset of the first frame, in bytes. */
+    uint64_t dataOffset; 
+    /** @brief Slot of the latest frame. */
+    uint64_t latestSlot; 
+    /** @brief Number of frames published so far. */
+    uint64_t published; 
+    uint64_t reserved; 
+}SharedRingHeader_s; 
+
+/**
+ * @brief Control block of a slot, one cache line each, following the header. 
+ * @details @p sequence is a sequence lock: it is odd while the slot may be written by 
+ *          the camera, and changes every time the slot is reused. 
+ */
+typedef struct {
+    uint64_t sequence; 
+    uint64_t frame; 
+    /** @brief CLOCK_MONOTONIC time of the frame publication, in nanoseconds. */
+    uint64_t timestamp; 
+    uint64_t reserved[5]; 
+}SharedSlot_s; 
+
+/**
+ * @brief Acquisition ring buffer arena in POSIX shared memory. 
+ * @details The acquisition process creates the shared memory object and the @ref RingBuffer
+ *          images are placed directly in it, so that the camera writes the frames there.
+ *          Other processes attach to the object by name and read the frames in place: 
+ *          the producer never copies a frame nor takes a lock for them. 
+ *
+ *          Readers use the per-slot sequence lock: 
+ *          @code
+ *          size_t slot; 
+ *          if(ring.getLatest(&slot)) {
+ *              uint64_t sequence = ring.beginRead(slot); 
+ *              ... process ring.getSlot(slot) ... 
+ *              if(sequence == 0 || !ring.endRead(slot, sequence)) {
+ *                  ... torn frame, discard the result ... 
+ *              }
+ *          }
+ *          @endcode
+ */
+class SharedRing {
+
+    public:
+        /**
+         * @brief Creates the shared memory object of a producer. 
+         * @details A stale object of the same name is replaced. The memory is locked in RAM. 
+         * @param[in]   name        POSIX shared memory name, such as "/cwis_frames". 
+         * @param[in]   width       Width of the frames. 
+         * @param[in]   height      Height of the frames. 
+         * @param[in]   nbOfSlots   Number of frames. 
+         */
+        SharedRing(const std::string &name, unsigned int width, unsigned int height, size_t nbOfSlots); 
+
+        /**
+         * @brief Attaches a reader to an existing shared memory object, read-only. 
+         * @param[in]   name        POSIX shared memory name. 
+         */
+        SharedRing(const std::string &name); 
+
+        /**
+         * @brief Unmaps the shared memory. The producer also removes the object name. 
+         */
+        ~SharedRing(); 
+
+        /** @brief Returns @p true if the shared memory is mapped and valid. */
+        bool isOpen(void) const; 
+
+        unsigned int getWidth(void) const; 
+        unsigned int getHeight(void) const; 
+        /** @brief Returns the number of frames in the ring. */
+        size_t getNbOfSlots(void) const; 
+
+        /** @brief Returns the pixels of the frame at @p index. */
+        pixel_t * getSlot(size_t index) const; 
+
+        /**
+         * @brief Publishes a complete frame. Producer only. 
+         * @details Lock-free and copy-free: only updates the control blocks. 
+         * @param[in]   buffer  Frame buffer, as returned by @ref getSlot(). 
+         * @param[in]   frame   Frame number. 
+         */
+        void publish(const pixel_t *buffer, uint64_t frame); 
+
+        /**
+         * @brief Widens the slots marked as being written ahead of the latest frame. Producer only. 
+         * @details To be called with the number of frames delivered by a callback, plus one: 
+         *          the camera may run as far ahead before the next callback. The guard only 
+         *          grows, up to all the slots but the latest one. 
+         */
+        void extendGuard(size_t guard); 
+
+        /** @brief Returns the number of slots marked as being written ahead of the latest frame. */
+        size_t getGuard(void) const; 
+
+        /**
+         * @brief Returns the slot of the latest frame. 
+         * @returns @p false if no frame was published yet. 
+         */
+        bool getLatest(size_t *index) const; 
+
+        /**
+         * @brief Starts reading a slot. 
+         * @returns Sequence to pass to @ref endRead(), or 0 if the slot is being written. 
+         */
+        uint64_t beginRead(size_t index) const; 
+
+        /** @brief Returns the frame number of a slot, valid between @ref beginRead() and @ref endRead(). */
+        uint64_t getFrame(size_t index) const; 
+
+        /**
+         * @brief Ends reading a slot. 
+         * @returns @p false if the slot was reused meanwhile: what was read may be torn. 
+         */
+        bool endRead(size_t index, uint64_t sequence) const; 
+
+        /**
+         * @brief Copies the latest frame, retrying on torn reads. 
+         * @param[out]  dst     Buffer of @ref getWidth() x @ref getHeight() pixels. 
+         * @param[out]  frame   Frame number of the copied frame. 
+         * @returns @p false if no frame could be copied. 
+         */
+        bool readLatest(pixel_t *dst, uint64_t *frame) const; 
+
+    private:
+        std::string m_name; 
+        /** @brief Indicates that this object created the shared memory. */
+        bool m_owner; 
+        unsigned char *m_base; 
+        size_t m_mappedSize; 
+
+        SharedRingHeader_s *m_header; 
+        SharedSlot_s *m_slots; 
+
+        /** @brief Marks a slot as being written. Producer only. */
+        void markWriting(size_t index); 
+        /** @brief Maps the shared memory object. */
+        bool map(int fd, size_t size, bool writable); 
+}; 
+
+#endif  /* DEF_SHARED_RING_HPP */
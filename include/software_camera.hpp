@@ -0,0 +1,89 @@
+/**
+ * @file software_camera.hpp
+ * @brief Software frame source class definition.
+ * @addtogroup cameras
+ * @{
+ */
+
+#ifndef DEF_SOFTWARE_CAMERA_HPP
+#define DEF_SOFTWARE_CAMERA_HPP
+
+#include "camera.hpp"
+
+#include <pthread.h>
+
+/** @brief Number of distinct synthetic frames, cycled through by the source. */
+#define SOFTWARE_CAMERA_NB_PATTERNS     (8u)
+
+/**
+ * @brief Camera producing synthetic frames, for benchmarks and tests without the hardware.
+ * @details The live acquisition behaves as the uEye camera: each frame is written in the
+ *          next ring buffer slot, whether or not the previous frame of that slot was stored,
+ *          then the callback is called from the acquisition thread with a batch holding the
+ *          frame. The frames are paced on the monotonic clock; the frame rate may be changed
+ *          during the acquisition. When the callback takes longer than a frame period, the
+ *          frames due in the meantime are lost: their sequence numbers are skipped.
+ *
+ *          The synthetic frames are a smooth scene with sensor noise, so that their
+ *          compression costs about as much as the real frames.
+ */
+class SoftwareCamera: public Camera {
+
+    public:
+        SoftwareCamera(unsigned int width = 800u, unsigned int height = 600u);
+
+        virtual ~SoftwareCamera();
+
+        virtual void start(RingBuffer *ringBuffer, FrameCallback_t callback = NULL);
+
+        virtual void prepare(RingBuffer *ringBuffer, FrameCallback_t callback = NULL);
+
+        virtual void stop(void);
+
+        /**
+         * @brief Writes the next synthetic frame in @p i.
+         * @throws CameraException during the live acquisition or if the image size differs.
+         */
+        virtual void capture(Image *i);
+
+        virtual void captureBurst(Image **images, unsigned int count, double interval, double *timestamps);
+
+        /**
+         * @brief Sets the live acquisition frame rate.
+         * @details Takes effect from the next frame, even during the acquisition.
+         */
+        virtual double setFramerate(double framerate);
+
+        /** @brief The synthetic frames always fill the ring buffer images. */
+        virtual void setAreaOfInterest(int x, int y, int width, int height);
+
+        virtual void displayInfo(void);
+
+        /** @brief Returns the number of frames produced by the live acquisition. */
+        unsigned long getFrameCount(void) const;
+
+    private:
+        unsigned int m_width;
+        unsigned int m_height;
+
+        /** @brief Synthetic frames. */
+        unsigned char *m_patterns;
+        unsigned int m_nextPattern;
+
+        /** @brief Time between two frames in seconds, 0 for back to back. Read by the acquisition thread. */
+        double m_livePeriod;
+        unsigned long m_frameCount;
+
+        pthread_t m_thread;
+        bool m_stop;
+
+        /** @brief Copies the next synthetic frame into @p pixels. */
+        void produce(pixel_t *pixels);
+
+        /** @brief Live acquisition thread. */
+        static void * thread(void *arg);
+};
+
+#endif  /* DEF_SOFTWARE_CAMERA_HPP */
+
+/** @} */
@@ -0,0 +1,139 @@
+/**
+ * @file telemetry.hpp
+ * @brief Telemetry publisher class definition.
+ */
+
+#ifndef DEF_TELEMETRY_HPP
+#define DEF_TELEMETRY_HPP
+
+#include "pipes/tx_pipe.hpp"
+#include <pthread.h>
+#include <stdint.h>
+#include <string>
+
+/** @brief Identifies a telemetry record ("CWTM"). */
+#define TELEMETRY_MAGIC         (0x4D545743u)
+/** @brief Version of the telemetry record layout. */
+#define TELEMETRY_VERSION       (1u)
+/** @brief Number of latency histogram bins: 4 bins per octave of microseconds. */
+#define TELEMETRY_LATENCY_BINS  (128u)
+
+/**
+ * @brief Binary status record sent over the telemetry pipe. 
+ * @details Fixed layout, native byte order, naturally aligned fields, no padding. The CRC-32 covers every 
+ *          preceding byte of the record. Latencies are frame write durations over 
+ *          the last period, in microseconds (upper bound of the histogram bin). 
+ */
+typedef struct __attribute__((packed)) {
+    uint32_t magic; 
+    uint16_t version; 
+    uint16_t size; 
+    uint32_t sequence; 
+    uint32_t ringSize; 
+    /** @brief CLOCK_MONOTONIC time of the record, in nanoseconds. */
+    uint64_t timestamp; 
+    uint64_t framesAcquired; 
+    uint64_t framesStored; 
+    uint64_t framesDropped; 
+    /** @brief Free space available in the output directory, in bytes. */
+    uint64_t diskFree; 
+    /** @brief Buffer occupancy, in per mille. */
+    uint32_t ringOccupancy; 
+    uint32_t writerBacklog; 
+    uint32_t latencyP50; 
+    uint32_t latencyP90; 
+    uint32_t latencyP99; 
+    uint32_t latencyMax; 
+    uint32_t crc; 
+}TelemetryRecord_s; 
+
+/**
+ * @brief Periodic telemetry publisher. 
+ * @details Acquisition and writer threads only update counters with atomic operations. 
+ *          A publisher thread samples them at a fixed period and sends a record through 
+ *          a non-blocking @ref TXPipe. If the pipe is full, unsent records are replaced by 
+ *          the most recent one, so a slow or absent reader never delays anything but 
+ *          the publisher. A partially sent record is always completed first, so that 
+ *          the reader never loses the record framing. 
+ */
+class Telemetry {
+
+    public:
+        /**
+         * @brief Starts the publisher thread. 
+         * @param[in]   pipefile    Named pipe, created if needed. 
+         * @param[in]   period      Time between two records, in milliseconds. 
+         * @param[in]   directory   Output directory, for the free disk space. 
+         */
+        Telemetry(const std::string &pipefile, unsigned int period, const std::string &directory); 
+
+        /**
+         * @brief Stops the publisher thread. 
+         */
+        ~Telemetry(); 
+
+        /** @brief Counts an acquired frame. */
+        void frameAcquired(void); 
+
+        /**
+         * @brief Counts a stored frame. 
+         * @param[in]   latency     Write duration, in seconds. 
+         */
+        void frameStored(double latency); 
+
+        /** @brief Counts dropped frames, lost by the camera or the buffers. */
+        void frameDropped(uint32_t count = 1u); 
+
+        /**
+         * @brief Updates the buffer gauges. 
+         * @param[in]   ringSize    Size of the ring buffer, in images. 
+         * @param[in]   occupancy   Buffer occupancy, from 0 to 1. 
+         * @param[in]   backlog     Number of frames waiting to be written. 
+         */
+        void setBuffers(size_t ringSize, double occupancy, size_t backlog); 
+
+        /**
+         * @brief Fills a record with the current counters. 
+         * @details Also computes the latency percentiles and resets the latency histogram. 
+         */
+        void sample(TelemetryRecord_s *record); 
+
+        /** @brief Returns the number of records that could not be sent in time. */
+        unsigned long getCoalesced(void) const; 
+
+    private:
+        TXPipe *m_pipe; 
+        unsigned int m_period; 
+        std::string m_directory; 
+
+        uint64_t m_acquired; 
+        uint64_t m_stored; 
+        uint64_t m_dropped; 
+        uint32_t m_ringSize; 
+        uint32_t m_occupancy; 
+        uint32_t m_backlog; 
+        uint32_t m_sequence; 
+        /** @brief Write latency histogram since the last record. */
+        unsigned long m_latencies[TELEMETRY_LATENCY_BINS]; 
+
+        /** @brief Record being sent. */
+        TelemetryRecord_s m_pending; 
+        /** @brief Number of bytes of @ref m_pending already sent. */
+        size_t m_sent; 
+        unsigned long m_coalesced; 
+
+        pthread_t m_thread; 
+        pthread_mutex_t m_lock; 
+        pthread_cond_t m_wakeup; 
+        bool m_stop; 
+
+        /** @brief Sends as much of the pending record as the pipe takes. */
+        void flush(void); 
+        /** @brief Returns the upper bound of a latency bin, in microseconds. */
+        static uint32_t getBinLimit(unsigned int bin); 
+
+        /** @brief Publisher thread. */
+        static void * thread(void *arg); 
+}; 
+
+#endif  /* DEF_TELEMETRY_HPP */
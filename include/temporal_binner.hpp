@@ -0,0 +1,123 @@
+/**
+ * @file temporal_binner.hpp
+ * @brief Temporal binning class definition.
+ */
+
+#ifndef DEF_TEMPORAL_BINNER_HPP
+#define DEF_TEMPORAL_BINNER_HPP
+
+#include "image.hpp"
+#include <stdint.h>
+
+/** @brief Largest binning factor: the sum of 257 8-bit frames fits in 16 bits. */
+#define BINNER_MAX_FACTOR   (257u)
+/** @brief Default number of output frames used in turn. */
+#define BINNER_NB_OUTPUTS   (4u)
+
+/** @brief Value of the binned frames. */
+typedef enum {
+    BINNING_MEAN,   /**< @brief Mean of the frames, rounded. */
+    BINNING_SUM     /**< @brief Sum of the frames, saturated to 255 (faint signals). */
+}BinningMode_e;
+
+/**
+ * @brief Adds consecutive frames into one output frame.
+ * @details For slow phenomena acquired at a high frame rate: every @p N frames of the
+ *          acquisition give a single output frame, the mean (or the saturated sum) of the
+ *          @p N frames. The frames are added into a 16-bit accumulator (AVX2 or SSE2 when
+ *          available), so that binning keeps up with the acquisition on a single core.
+ *
+ *          The binning factor may be changed at any time from another thread: the new
+ *          factor applies from the next output frame. The output frames are used in turn,
+ *          an output frame is overwritten @p nbOfOutputs bins after it was returned, unless
+ *          @ref setPendingCheck() tells which ones are still in use.
+ */
+class TemporalBinner {
+
+    public:
+        /**
+         * @brief Creates a binner.
+         * @param[in]   width       Frame width.
+         * @param[in]   height      Frame height.
+         * @param[in]   factor      Number of frames per output frame, 1 to @ref BINNER_MAX_FACTOR.
+         * @param[in]   mode        Value of the output frames.
+         * @param[in]   nbOfOutputs Number of output frames used in turn.
+         */
+        TemporalBinner(unsigned int width, unsigned int height, unsigned int factor,
+                       BinningMode_e mode = BINNING_MEAN, unsigned int nbOfOutputs = BINNER_NB_OUTPUTS);
+
+        ~TemporalBinner();
+
+        /**
+         * @brief Changes the binning factor, from the next output frame.
+         * @returns @p false if the factor is out of range.
+         */
+        bool setFactor(unsigned int factor);
+
+        /** @brief Returns the binning factor. */
+        unsigned int getFactor(void) const;
+
+        /**
+         * @brief Drops the frames of the current bin.
+         * @details May be called from another thread, for instance when the acquisition
+         *          pauses: the next frame starts a new bin.
+         */
+        void restart(void);
+
+        /**
+         * @brief Sets the function telling if an output frame is still in use.
+         * @details The outputs still in use are skipped. If all of them are, the bin is
+         *          dropped, see @ref getDropped().
+         */
+        void setPendingCheck(bool (*isPending)(const Image *output));
+
+        /**
+         * @brief Adds a frame to the current bin.
+         * @returns The output frame once the bin is complete, @p NULL otherwise.
+         */
+        Image * add(const Image *frame);
+
+        /** @brief Returns the number of complete bins dropped for want of a free output frame. */
+        unsigned long getDropped(void) const;
+
+        /**
+         * @brief Adds a frame to the current bin, without writing the output frame.
+         * @details For callers providing their own output frames: once the bin is complete,
+         *          @ref getBin() writes it until the next frame is pushed.
+         * @returns @p true once the bin is complete.
+         */
+        bool push(const Image *frame);
+
+        /**
+         * @brief Writes the last complete bin.
+         * @returns @p false if the output frame does not have the binning size.
+         */
+        bool getBin(Image *output) const;
+
+    private:
+        unsigned int m_width;
+        unsigned int m_height;
+        BinningMode_e m_mode;
+
+        /** @brief Factor requested, and factor of the current bin. */
+        unsigned int m_factor;
+        unsigned int m_binFactor;
+        /** @brief Number of frames in the current bin. */
+        unsigned int m_count;
+        /** @brief Set by @ref restart(), cleared by the next frame. */
+        bool m_restart;
+
+        /** @brief Sum of the frames of the current bin. */
+        uint16_t *m_sum;
+
+        Image **m_outputs;
+        unsigned int m_nbOfOutputs;
+        unsigned int m_next;
+        bool (*m_isPending)(const Image *output);
+        unsigned long m_dropped;
+
+        /** @brief Indicates that the processor supports AVX2. */
+        bool m_avx2;
+};
+
+#endif  /* DEF_TEMPORAL_BINNER_HPP */
@@ -0,0 +1,173 @@
+/**
+ * @file temporal_codec.hpp
+ * @brief Lossless inter-frame codec class definitions.
+ */
+
+#ifndef DEF_TEMPORAL_CODEC_HPP
+#define DEF_TEMPORAL_CODEC_HPP
+
+#include "image.hpp"
+#include "frame_codec.hpp"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <string>
+#include <vector>
+
+/** @brief Identifies a temporal stream file ("CWTD"). */
+#define TEMPORAL_MAGIC          (0x44545743u)
+/** @brief Version of the stream format. */
+#define TEMPORAL_VERSION        (1u)
+/** @brief Default number of frames from one keyframe to the next. */
+#define TEMPORAL_KEY_INTERVAL   (32u)
+
+/** @brief Coding of a frame in a temporal stream. */
+typedef enum {
+    TEMPORAL_KEYFRAME = 0,  /**< @brief Frame coded on its own. */
+    TEMPORAL_RESIDUAL = 1   /**< @brief Difference with the previous frame of the stream. */
+}TemporalFrameType_e;
+
+/** @brief Frame record of a temporal stream, as listed by @ref TemporalDecoder. */
+typedef struct {
+    /** @brief Offset of the record in the stream file. */
+    off_t offset;
+    uint32_t frame;
+    uint32_t type;
+    /** @brief Size of the coded frame, after the record header. */
+    uint32_t size;
+    /** @brief CRC32C of the decoded pixels. */
+    uint32_t crc;
+}TemporalRecord_s;
+
+/**
+ * @brief Writes frames into a temporal stream file.
+ * @details Consecutive frames of a recording are nearly identical: every @p keyInterval
+ *          frames a keyframe is coded on its own, the frames in between are coded as their
+ *          difference with the previous frame (computed with AVX2 or SSE2 when available).
+ *          Both are entropy coded with the @ref FrameCodec. A frame is thus decoded from
+ *          at most @p keyInterval records.
+ *
+ *          The file starts with a header giving the frame size and the key interval,
+ *          followed by one record per frame: frame number, coding, coded size and CRC32C
+ *          of the pixels, then the coded frame. Opening an existing stream of the same
+ *          frame size appends to it, after dropping a record torn by an interruption.
+ *
+ *          The frames are coded in the order of the calls to @ref add(), which may come
+ *          from several threads: frames given in acquisition order compress best.
+ */
+class TemporalEncoder {
+
+    public:
+        /**
+         * @param[in]   width       Frame width.
+         * @param[in]   height      Frame height.
+         * @param[in]   keyInterval Number of frames from one keyframe to the next, at least 1.
+         */
+        TemporalEncoder(unsigned int width, unsigned int height, unsigned int keyInterval = TEMPORAL_KEY_INTERVAL);
+
+        /** @brief Closes the stream. */
+        ~TemporalEncoder();
+
+        /**
+         * @brief Creates a stream file, or appends to an existing one.
+         * @returns @p false if the file cannot be opened, or holds a stream of another frame size.
+         */
+        bool open(const std::string &filename);
+
+        /**
+         * @brief Codes a frame at the end of the stream.
+         * @returns @p false if the frame does not have the stream size or cannot be written:
+         *          the stream is left as it was, the next frame is a keyframe.
+         */
+        bool add(const Image *frame, unsigned int number);
+
+        /** @brief Commits the stream to the disk. */
+        bool sync(void);
+
+        /** @brief Returns the number of frames coded since the stream was opened. */
+        unsigned long getNbOfFrames(void);
+
+        /** @brief Returns the number of bytes written since the stream was opened. */
+        unsigned long long getBytesWritten(void);
+
+    private:
+        unsigned int m_width;
+        unsigned int m_height;
+        unsigned int m_keyInterval;
+
+        int m_fd;
+        /** @brief End of the last complete record. */
+        off_t m_end;
+        /** @brief Frames coded since the last keyframe, 0 for a keyframe next. */
+        unsigned int m_sinceKey;
+
+        /** @brief Previous frame, the reference of the residuals. */
+        unsigned char *m_previous;
+        unsigned char *m_residual;
+        /** @brief Record being written: header then coded frame. */
+        unsigned char *m_record;
+        size_t m_recordSize;
+        FrameCodec m_codec;
+
+        unsigned long m_nbOfFrames;
+        unsigned long long m_bytesWritten;
+        pthread_mutex_t m_lock;
+};
+
+/**
+ * @brief Reads the frames of a temporal stream file.
+ * @details The records are listed when the stream is opened, a torn last record is
+ *          ignored. Any frame can be read: it is decoded from the keyframe before it, or
+ *          from the frame read last when reading forward. A decoder object must not be
+ *          shared between threads.
+ */
+class TemporalDecoder {
+
+    public:
+        TemporalDecoder(void);
+
+        ~TemporalDecoder();
+
+        /**
+         * @brief Opens a stream file and lists its records.
+         * @returns @p false if the file is not a temporal stream.
+         */
+        bool open(const std::string &filename);
+
+        unsigned int getWidth(void) const;
+
+        unsigned int getHeight(void) const;
+
+        /** @brief Returns the number of frames of the stream. */
+        size_t getNbOfFrames(void) const;
+
+        /** @brief Returns the record of the frame at @p index in the stream. */
+        const TemporalRecord_s & getRecord(size_t index) const;
+
+        /**
+         * @brief Decodes the frame at @p index in the stream.
+         * @returns @p false if the image does not have the stream size, or if a record is
+         *          corrupted (the pixels do not match their CRC32C).
+         */
+        bool read(size_t index, Image *image);
+
+    private:
+        int m_fd;
+        unsigned int m_width;
+        unsigned int m_height;
+        std::vector<TemporalRecord_s> m_records;
+
+        /** @brief Last decoded frame and its index, -1 if none. */
+        unsigned char *m_current;
+        long m_currentIndex;
+        unsigned char *m_residual;
+        unsigned char *m_payload;
+        size_t m_payloadSize;
+        FrameCodec m_codec;
+
+        /** @brief Decodes a record over @ref m_current, which holds the previous frame. */
+        bool decode(size_t index);
+};
+
+#endif  /* DEF_TEMPORAL_CODEC_HPP */
@@ -0,0 +1,175 @@
+/**
+ * @file tiered_storage.hpp
+ * @brief Tiered frame storage class definition.
+ */
+
+#ifndef DEF_TIERED_STORAGE_HPP
+#define DEF_TIERED_STORAGE_HPP
+
+#include "frame_journal.hpp"
+#include "output_directory.hpp"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <map>
+#include <string>
+#include <vector>
+
+/** @brief Default capacity of the RAM tier, in bytes. */
+#define TIER_DEFAULT_CAPACITY   (256u * 1024u * 1024u)
+
+/**
+ * @brief Frame storage landing frames in a RAM-backed directory first.
+ * @details The write latency of flash storage is high and bursty, and writers stalled on
+ *          it back up into the ring buffer. Writers rather create the frame files in a
+ *          tier directory on a RAM filesystem (e.g. @p /dev/shm) with @ref openFile(), and
+ *          hand them over with @ref add(). A migrator thread moves them to the persistent
+ *          output directory by batches, every @p batchSize frames or @p batchDelay
+ *          milliseconds: the files of a batch are copied in frame order, synchronized as in
+ *          the Flusher, journaled in the FrameJournal, and only then removed from the tier.
+ *          The copy rate can be limited, to leave disk bandwidth to other tasks.
+ *
+ *          The tier is bounded: writers wait in @ref openFile() while it is full, which it
+ *          may exceed by one frame per writer. The frames still in the tier are indexed,
+ *          see @ref locate(). Frames left in the tier by a crash are moved by @ref recover().
+ */
+class TieredStorage {
+
+    public:
+        /**
+         * @brief Opens the tier directory and starts the migrator thread.
+         * @param[in]   tierPath    Tier directory, which must exist.
+         * @param[in]   extension   Extension of the frame files, without the dot.
+         * @param[in]   persistent  Persistent output directory.
+         * @param[in]   journal     Journal of the committed frames.
+         * @param[in]   capacity    Capacity of the tier, in bytes.
+         * @param[in]   batchSize   Number of frames per batch.
+         * @param[in]   batchDelay  Maximum time a frame waits in the tier, in milliseconds.
+         * @param[in]   rate        Maximum copy rate, in bytes per second, or 0 for no limit.
+         */
+        TieredStorage(const std::string &tierPath, const std::string &extension, OutputDirectory *persistent,
+                      FrameJournal *journal, size_t capacity, unsigned int batchSize, unsigned int batchDelay,
+                      double rate = 0.0);
+
+        /**
+         * @brief Migrates the frames left in the tier and stops the migrator thread.
+         */
+        ~TieredStorage();
+
+        /** @brief Returns @p true if the tier directory could be opened. */
+        bool isOpen(void) const;
+
+        /**
+         * @brief Creates the file of a frame in the tier, waiting for room if it is full.
+         * @returns Stream opened for binary writing, or @p NULL on failure.
+         */
+        FILE * openFile(unsigned int frame);
+
+        /**
+         * @brief Hands a written frame file over to the migrator.
+         * @details The stream is closed. A frame whose writes failed is removed from the
+         *          tier rather than migrated, and counted in @ref getFailed().
+         * @param[in]   frame   Frame number.
+         * @param[in]   fp      Stream of the frame file.
+         * @param[in]   written @p false if the frame could not be written.
+         */
+        void add(unsigned int frame, FILE *fp, bool written = true);
+
+        /**
+         * @brief Migrates all the frames of the tier right away, without rate limit,
+         *        and waits for the end of the migration.
+         */
+        void flush(void);
+
+        /**
+         * @brief Returns the path of the file of a frame.
+         * @details The file is in the tier if the frame is still waiting for its migration,
+         *          in the persistent directory otherwise.
+         */
+        std::string locate(unsigned int frame);
+
+        /** @brief Returns the number of frames in the tier. */
+        size_t getBacklog(void);
+
+        /** @brief Returns the number of bytes in the tier. */
+        size_t getUsedBytes(void);
+
+        /** @brief Returns the capacity of the tier, in bytes. */
+        size_t getCapacity(void) const;
+
+        /** @brief Returns the number of frames migrated and committed. */
+        unsigned long getMigrated(void);
+
+        /** @brief Returns the number of frames that could not be written or migrated. */
+        unsigned long getFailed(void);
+
+        /**
+         * @brief Moves the frames left in a tier directory by a crash.
+         * @details Only the files named as the frames of @p persistent are moved.
+         *          The persistent directory is synchronized, but the frames are not
+         *          journaled: FrameJournal::recover() checks them afterwards.
+         * @returns Number of frames moved.
+         */
+        static unsigned int recover(const std::string &tierPath, OutputDirectory *persistent);
+
+    private:
+        /** @brief Frame file of the tier, waiting for its migration. */
+        typedef struct {
+            unsigned int frame;
+            size_t size;
+        }Pending_s;
+
+        std::string m_tierPath;
+        OutputDirectory *m_tier;
+        /** @brief Descriptor of the tier directory, to read and remove the frame files. */
+        int m_tierFd;
+        OutputDirectory *m_persistent;
+        FrameJournal *m_journal;
+        size_t m_capacity;
+        unsigned int m_batchSize;
+        unsigned int m_batchDelay;
+        double m_rate;
+
+        /** @brief Frames waiting for the next batch. */
+        std::vector<Pending_s> m_pending;
+        /** @brief Frames in the tier, waiting or being migrated, with their size. */
+        std::map<unsigned int, size_t> m_index;
+        /** @brief Number of bytes in the tier. */
+        size_t m_used;
+        /** @brief Monotonic time of the oldest pending frame, in seconds. */
+        double m_oldest;
+
+        unsigned long m_added;
+        unsigned long m_processed;
+        unsigned long m_migrated;
+        unsigned long m_failed;
+
+        /** @brief Copy buffer of the migrator. */
+        std::vector<char> m_buffer;
+
+        bool m_flush;
+        bool m_stop;
+        pthread_t m_thread;
+        pthread_mutex_t m_lock;
+        /** @brief Wakes the migrator thread up. */
+        pthread_cond_t m_wakeup;
+        /** @brief Signals room in the tier. */
+        pthread_cond_t m_room;
+        /** @brief Signals the end of a batch. */
+        pthread_cond_t m_done;
+
+        /** @brief Copies, commits and removes a batch of frames. */
+        void migrateBatch(std::vector<Pending_s> &batch);
+
+        /**
+         * @brief Copies a frame file into the persistent directory.
+         * @returns Descriptor of the copy, to be synchronized and closed, or -1 on failure.
+         */
+        static int copyFrame(int dirfd, const char *name, OutputDirectory *persistent, unsigned int frame,
+                             std::vector<char> &buffer, size_t *size);
+
+        /** @brief Migrator thread. */
+        static void * thread(void *arg);
+};
+
+#endif  /* DEF_TIERED_STORAGE_HPP */
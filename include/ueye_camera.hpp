@@ -43,6 +43,19 @@ class UEye_Camera: public Camera {
          */
         virtual void capture(Image *i); 
 
+        /**
+         * @brief Acquires @p count images, triggered one after the other. 
+         * @details The images are registered and the camera is set in software trigger mode once
+         *          for the whole burst. The triggers are spaced by @p interval seconds
+         *          (0: back to back), counted from the first trigger. 
+         * @param[out]  images      Images storing the captured frames, of the size of the AOI. 
+         * @param[in]   count       Number of images to capture. 
+         * @param[in]   interval    Minimum time between two triggers, in seconds. 
+         * @param[out]  timestamps  Trigger times on the monotonic clock, in seconds. May be @p NULL. 
+         * @note The live acquisition must be stopped. 
+         */
+        virtual void captureBurst(Image **images, unsigned int count, double interval, double *timestamps); 
+
         virtual double setFramerate(double framerate);
 
         /**
@@ -87,7 +100,8 @@ class UEye_Camera: public Camera {
 
         /**
          * @brief Returns the pixel clock range of the camera.
-         * @details This function modifies the @p range array parameter. 
+         * @details The range is read from the camera once, at initialization. 
+         *          This function modifies the @p range array parameter. 
          *          Once the function has ended, the first index of the array
          *          holds the minimum pixel clock, the second index holds the 
          *          maximum pixel clock and the third index holds the pixel
@@ -132,23 +146,59 @@ class UEye_Camera: public Camera {
         /**
          * @brief Starts image acquisition. 
          */
-        virtual void start(RingBuffer *ringBuffer, void (*callback)(char *) = NULL); 
+        virtual void start(RingBuffer *ringBuffer, FrameCallback_t callback = NULL); 
+
+        /**
+         * @brief Registers the ring buffer with the camera and starts the event handler. 
+         * @details Most of the start-up time is spent here: prepare ahead of time so that
+         *          @ref start() only has to start the capture. 
+         *          The buffers stay registered across @ref stop() calls, they are only 
+         *          registered again if the ring buffer or its geometry changed. 
+         */
+        virtual void prepare(RingBuffer *ringBuffer, FrameCallback_t callback = NULL); 
 
         /**
          * @brief Stops the image acquisition. 
+         * @details The ring buffer stays registered, see @ref release(). 
          */
         virtual void stop(void);
 
+        /**
+         * @brief Stops the acquisition and unregisters the ring buffer from the camera. 
+         * @details Must be called before the registered ring buffer is freed. 
+         */
+        void release(void); 
+
         HIDS getCameraID(void) const; 
 
     private: 
         HIDS camID; 
         SENSORINFO sensorInfo;
+        unsigned int m_pixelClockRange[3];  /**< @brief Pixel clock range, read once at initialization. */
+        unsigned int m_defaultPixelClock;   /**< @brief Default pixel clock, 0 until read. */
         int *m_memID;                       /**< @brief Pointer to an array of memory ID tags for acquisition. */
+        pixel_t **m_registeredBuffers;      /**< @brief Ring buffer images registered with the camera. */
+        size_t m_registeredSize;            /**< @brief Number of registered images. */
+        unsigned int m_registeredWidth;     /**< @brief Width of the registered images. */
+        unsigned int m_registeredHeight;    /**< @brief Height of the registered images. */
         bool m_stop;                        /**< @brief Specifies that the acquisition should stop. */
+        char **m_batchBuffers;              /**< @brief Frames of the batch being delivered. */
+        uint64_t *m_batchSequences;         /**< @brief Sequence numbers of the batch being delivered. */
+        size_t m_nextSlot;                  /**< @brief First registered image not delivered yet. */
+        uint64_t m_lastSequence;            /**< @brief Sequence number of the last frame delivered. */
+        bool m_sequenceKnown;               /**< @brief A frame was delivered since the acquisition started. */
         UEye_EventThread *acquisitionEventThread;
 
-        /** @brief Callback function for an acquisition event. */
+        /** @brief Checks that @p ringBuffer is the registered one, with the same images. */
+        bool isRegistered(RingBuffer *ringBuffer) const; 
+
+        /**
+         * @brief Callback function for an acquisition event. 
+         * @details Hands every image completed since the previous event to the user callback,
+         *          from the first image not delivered yet to the last completed one. Images
+         *          whose sequence number was already delivered are skipped, the sequence
+         *          numbers missing in between are counted as lost frames. 
+         */
         static void acquisitionCallback(const UEye_Camera *camera); 
 };
 
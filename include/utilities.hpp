@@ -7,6 +7,7 @@
 #define DEF_UTILITIES_H
 
 #include <string>
+#include <stdlib.h>
 
 /**
  * @brief Creates a directory.  
@@ -18,6 +19,14 @@ int createDirectory(const std::string &dirname);
  */
 void string_appendInt(std::string &str, int x);
 
+/**
+ * @brief Writes the given integer @p x in decimal, padded with zeros to @p width digits. 
+ * @details No terminating null character is written. This function does not allocate
+ *          memory and can be used in the acquisition path. 
+ * @returns Pointer to the character following the last digit. 
+ */
+char * formatZeroPadded(char *dst, unsigned int x, unsigned int width); 
+
 /**
  * @brief Returns the extension of the given @p file.
  * @param[in]   filename    Name of the file whose extension must be extracted. 
@@ -26,5 +35,29 @@ void string_appendInt(std::string &str, int x);
  */
 std::string getFileExtension(std::string &filename); 
 
+/**
+ * @brief Returns the amount of memory available to start new processes, in bytes.
+ * @details Reads @p MemAvailable from @p /proc/meminfo, and falls back to the
+ *          free memory reported by @p sysinfo() on older kernels.
+ */
+size_t getAvailableMemory(void); 
+
+/**
+ * @brief Returns the amount of memory the process may lock in RAM, in bytes.
+ * @details Soft limit of @p RLIMIT_MEMLOCK. Returns @p SIZE_MAX if there is no limit. 
+ */
+size_t getLockableMemory(void); 
+
+/**
+ * @brief Returns the amount of memory the process has locked in RAM, in bytes.
+ * @details Reads @p VmLck from @p /proc/self/status, 0 if unknown. 
+ */
+size_t getLockedMemory(void); 
+
+/**
+ * @brief Returns the time elapsed on the monotonic clock, in seconds. 
+ */
+double getMonotonicTime(void); 
+
 #endif  /* DEF_UTILITIES_H */
 
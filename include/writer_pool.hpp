@@ -0,0 +1,129 @@
+/**
+ * @file writer_pool.hpp
+ * @brief Image writer thread pool class definition.
+ */
+
+#ifndef DEF_WRITER_POOL_HPP
+#define DEF_WRITER_POOL_HPP
+
+#include "image.hpp"
+#include <pthread.h>
+
+/** @brief Maximum number of write functions (sinks) of a pool. */
+#define WRITER_POOL_MAX_SINKS   (4u)
+
+/**
+ * @brief Pool of threads writing acquired images to persistent memory.
+ * @details Images are queued by the acquisition callback and written by the pool
+ *          threads with the given write function, so that a slow disk does not
+ *          delay the acquisition events. The queue has a fixed capacity, usually
+ *          the size of the @ref RingBuffer: an image stays in its ring slot until
+ *          it has been written. 
+ *
+ *          Several write functions (sinks) can be registered, e.g. an archive and a 
+ *          quick-look copy. Each queued image is then handed to every sink at once: the 
+ *          sinks run side by side on different threads while the image is still in the 
+ *          cache, so that the outputs cost about the price of the slowest one. 
+ *          The image is reference-counted and its ring slot is only released once
+ *          the last sink is done with it. 
+ */
+class WriterPool {
+
+    public:
+        /**
+         * @brief Starts the writer threads. 
+         * @param[in]   nbOfThreads     Number of writer threads. 
+         * @param[in]   capacity        Maximum number of queued images. 
+         * @param[in]   write           Function writing an image with its frame number. 
+         */
+        WriterPool(unsigned int nbOfThreads, size_t capacity, void (*write)(Image *, unsigned int)); 
+
+        /**
+         * @brief Registers another write function, called for every image submitted afterwards. 
+         * @returns @p false if the pool already has @ref WRITER_POOL_MAX_SINKS sinks. 
+         * @note To be called before the images are submitted. 
+         */
+        bool addSink(void (*write)(Image *, unsigned int)); 
+
+        /** @brief Returns the number of write functions. */
+        unsigned int getNbOfSinks(void) const; 
+
+        /**
+         * @brief Writes the queued images and stops the writer threads. 
+         */
+        ~WriterPool(); 
+
+        /**
+         * @brief Queues an image for writing. 
+         * @returns @p false if the queue is full: the image is not written. 
+         */
+        bool submit(Image *image, unsigned int frame); 
+
+        /**
+         * @brief Returns @p true if the given @p image is queued or being written by any sink. 
+         * @details A ring slot must not be submitted again before it was written. 
+         */
+        bool isPending(const Image *image); 
+
+        /** @brief Returns the number of images queued or being written. */
+        size_t getBacklog(void); 
+
+        /** @brief Returns the maximum number of queued images. */
+        size_t getCapacity(void) const; 
+
+        /** @brief Waits until all the queued images are written. */
+        void drain(void); 
+
+    private:
+        /** @brief Image held by the pool, until all the sinks have written it. */
+        typedef struct {
+            Image *image; 
+            unsigned int frame; 
+            /** @brief Number of sinks that did not write the image yet (0: free entry). */
+            unsigned int references; 
+        }Frame_s; 
+
+        /** @brief Image to write with a given sink. */
+        typedef struct {
+            size_t frame; 
+            unsigned int sink; 
+        }Job_s; 
+
+        /** @brief Images held by the pool. */
+        Frame_s *m_frames; 
+        size_t m_capacity; 
+        /** @brief Number of images held by the pool. */
+        size_t m_held; 
+
+        /** @brief Circular job queue, one job per image and sink. */
+        Job_s *m_queue; 
+        size_t m_queueSize; 
+        /** @brief Index of the oldest queued job. */
+        size_t m_head; 
+        /** @brief Number of queued jobs. */
+        size_t m_count; 
+
+        void (*m_write[WRITER_POOL_MAX_SINKS])(Image *, unsigned int); 
+        unsigned int m_nbOfSinks; 
+
+        unsigned int m_nbOfThreads; 
+        pthread_t *m_threads; 
+        pthread_mutex_t m_lock; 
+        /** @brief Signals a queued job, or the end of the pool. */
+        pthread_cond_t m_available; 
+        /** @brief Signals a written image. */
+        pthread_cond_t m_written; 
+        bool m_stop; 
+
+        /** @brief Writer thread argument. */
+        typedef struct {
+            WriterPool *pool; 
+            unsigned int index; 
+        }ThreadArg_s; 
+        ThreadArg_s *m_args; 
+
+        /** @brief Writer thread. */
+        static void * thread(void *arg); 
+}; 
+
+#endif  /* DEF_WRITER_POOL_HPP */
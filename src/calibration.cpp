@@ -0,0 +1,271 @@
+/**
+ * @file calibration.cpp
+ * @brief On-line frame calibration class implementation.
+ */
+
+#include "calibration.hpp"
+
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+/** @brief The AVX2 implementation can be compiled in. */
+#define CALIBRATION_AVX2
+#endif
+
+/** @brief Corrects @p size pixels: saturating dark subtraction, then gain. */
+static void correctPixels(unsigned char *pixels, const unsigned char *dark, const uint16_t *gain, size_t size) {
+
+    size_t incr = 0;
+
+#ifdef __SSE2__
+    /* The pixels are widened to 16 bits, shifted by 8: the high half of the product
+     * with the gain is the corrected value */
+    const __m128i zero   = _mm_setzero_si128();
+    const __m128i clamp  = _mm_set1_epi16((short) 0xFF00);
+
+    for(; incr + 16 <= size; incr += 16) {
+        __m128i p = _mm_loadu_si128((const __m128i *) (pixels + incr));
+        __m128i d = _mm_loadu_si128((const __m128i *) (dark + incr));
+        __m128i s = _mm_subs_epu8(p, d);
+
+        __m128i lo = _mm_mulhi_epu16(_mm_unpacklo_epi8(zero, s), _mm_loadu_si128((const __m128i *) (gain + incr)));
+        __m128i hi = _mm_mulhi_epu16(_mm_unpackhi_epi8(zero, s), _mm_loadu_si128((const __m128i *) (gain + incr + 8)));
+
+        /* min(x, 255) without SSE4.1, the packing saturates signed values */
+        lo = _mm_subs_epu16(_mm_adds_epu16(lo, clamp), clamp);
+        hi = _mm_subs_epu16(_mm_adds_epu16(hi, clamp), clamp);
+
+        _mm_storeu_si128((__m128i *) (pixels + incr), _mm_packus_epi16(lo, hi));
+    }
+#endif
+
+    for(; incr < size; incr++) {
+        unsigned int s = (pixels[incr] > dark[incr]) ? pixels[incr] - dark[incr] : 0u;
+        unsigned int v = (s * gain[incr]) >> CALIBRATION_GAIN_SHIFT;
+        pixels[incr] = (unsigned char) ((v > 0xFF) ? 0xFF : v);
+    }
+}
+
+#ifdef CALIBRATION_AVX2
+/** @brief AVX2 version of @ref correctPixels(). */
+__attribute__((target("avx2")))
+static void correctPixelsAVX2(unsigned char *pixels, const unsigned char *dark, const uint16_t *gain, size_t size) {
+
+    const __m256i zero  = _mm256_setzero_si256();
+    const __m256i clamp = _mm256_set1_epi16(0xFF);
+    size_t incr = 0;
+
+    for(; incr + 32 <= size; incr += 32) {
+        __m256i p = _mm256_loadu_si256((const __m256i *) (pixels + incr));
+        __m256i d = _mm256_loadu_si256((const __m256i *) (dark + incr));
+        __m256i s = _mm256_subs_epu8(p, d);
+
+        /* Unpacking works within each 128-bit lane: the gains are reordered to match */
+        __m256i g0 = _mm256_loadu_si256((const __m256i *) (gain + incr));
+        __m256i g1 = _mm256_loadu_si256((const __m256i *) (gain + incr + 16));
+
+        __m256i lo = _mm256_mulhi_epu16(_mm256_unpacklo_epi8(zero, s), _mm256_permute2x128_si256(g0, g1, 0x20));
+        __m256i hi = _mm256_mulhi_epu16(_mm256_unpackhi_epi8(zero, s), _mm256_permute2x128_si256(g0, g1, 0x31));
+
+        lo = _mm256_min_epu16(lo, clamp);
+        hi = _mm256_min_epu16(hi, clamp);
+
+        _mm256_storeu_si256((__m256i *) (pixels + incr), _mm256_packus_epi16(lo, hi));
+    }
+
+    correctPixels(pixels + incr, dark + incr, gain + incr, size - incr);
+}
+#endif
+
+/** @brief Reads an 8-bit PGM file of the given size. */
+static bool readPGM(const std::string &path, Image *image) {
+
+    FILE *fp = fopen(path.c_str(), "rb");
+    if(fp == NULL) {
+        return false;
+    }
+
+    PGMHeader_s header;
+    size_t size = (size_t) image->getWidth() * image->getHeight();
+    bool valid = Image::readPGMHeader(fp, &header) && (header.width == image->getWidth()) &&
+                 (header.height == image->getHeight()) && (header.maxValue <= 0xFF) &&
+                 (fread(image->getImageBuffer(), 1, size, fp) == size);
+
+    fclose(fp);
+
+    return valid;
+}
+
+Calibration::Calibration(unsigned int width, unsigned int height) :
+        m_width(width), m_height(height), m_avx2(false) {
+
+    size_t size = (size_t) width * height;
+
+    this->m_dark = new unsigned char[size];
+    this->m_gain = new uint16_t[size];
+
+    memset(this->m_dark, 0, size);
+    for(size_t incr = 0; incr < size; incr++) {
+        this->m_gain[incr] = 1u << CALIBRATION_GAIN_SHIFT;
+    }
+
+#ifdef CALIBRATION_AVX2
+    this->m_avx2 = __builtin_cpu_supports("avx2");
+#endif
+}
+
+Calibration::~Calibration() {
+
+    delete [] this->m_dark;
+    delete [] this->m_gain;
+}
+
+bool Calibration::load(const Image *dark, const Image *flat) {
+
+    size_t size = (size_t) this->m_width * this->m_height;
+
+    if(((dark != NULL) && ((dark->getWidth() != this->m_width) || (dark->getHeight() != this->m_height))) ||
+       ((flat != NULL) && ((flat->getWidth() != this->m_width) || (flat->getHeight() != this->m_height)))) {
+        return false;
+    }
+
+    std::vector<bool> defective(size, false);
+
+    memset(this->m_dark, 0, size);
+    if(dark != NULL) {
+        memcpy(this->m_dark, dark->getImageBuffer(), size);
+
+        unsigned long long sum = 0;
+        for(size_t incr = 0; incr < size; incr++) {
+            sum += this->m_dark[incr];
+        }
+
+        unsigned int threshold = sum / size + CALIBRATION_HOT_LEVEL;
+        for(size_t incr = 0; incr < size; incr++) {
+            defective[incr] = (this->m_dark[incr] > threshold);
+        }
+    }
+
+    for(size_t incr = 0; incr < size; incr++) {
+        this->m_gain[incr] = 1u << CALIBRATION_GAIN_SHIFT;
+    }
+
+    if(flat != NULL) {
+        const unsigned char *pixels = (const unsigned char *) flat->getImageBuffer();
+
+        /* Mean response of the valid pixels */
+        unsigned long long sum = 0;
+        size_t count = 0;
+        for(size_t incr = 0; incr < size; incr++) {
+            if(!defective[incr] && (pixels[incr] > this->m_dark[incr])) {
+                sum += pixels[incr] - this->m_dark[incr];
+                count++;
+            }
+        }
+
+        /* The gains are computed from the exact mean: sum / (count * response) */
+        for(size_t incr = 0; (sum > 0) && (incr < size); incr++) {
+            unsigned long long response = (pixels[incr] > this->m_dark[incr]) ? pixels[incr] - this->m_dark[incr] : 0;
+            unsigned long long scaled   = response * count;
+
+            if((2 * scaled < sum) || (scaled > 2 * sum)) {
+                defective[incr] = true;
+            }
+            else {
+                unsigned long long gain = ((sum << CALIBRATION_GAIN_SHIFT) + scaled / 2) / scaled;
+                this->m_gain[incr] = (uint16_t) ((gain > 0xFFFF) ? 0xFFFF : gain);
+            }
+        }
+    }
+
+    this->listDefects(defective);
+
+    return true;
+}
+
+bool Calibration::load(const std::string &darkFile, const std::string &flatFile) {
+
+    Image *dark = darkFile.empty() ? NULL : new Image(this->m_width, this->m_height);
+    Image *flat = flatFile.empty() ? NULL : new Image(this->m_width, this->m_height);
+
+    bool loaded = ((dark == NULL) || readPGM(darkFile, dark)) &&
+                  ((flat == NULL) || readPGM(flatFile, flat)) &&
+                  this->load(dark, flat);
+
+    delete dark;
+    delete flat;
+
+    return loaded;
+}
+
+bool Calibration::apply(Image *image) const {
+
+    if((image->getWidth() != this->m_width) || (image->getHeight() != this->m_height)) {
+        return false;
+    }
+
+    unsigned char *pixels = (unsigned char *) image->getImageBuffer();
+    size_t size = (size_t) this->m_width * this->m_height;
+
+#ifdef CALIBRATION_AVX2
+    if(this->m_avx2) {
+        correctPixelsAVX2(pixels, this->m_dark, this->m_gain, size);
+    }
+    else
+#endif
+    {
+        correctPixels(pixels, this->m_dark, this->m_gain, size);
+    }
+
+    /* The neighbours are valid pixels, already corrected */
+    for(size_t incr = 0; incr < this->m_defects.size(); incr++) {
+        const Defect_s &defect = this->m_defects[incr];
+        pixels[defect.index] = (unsigned char) ((pixels[defect.left] + pixels[defect.right] + 1) / 2);
+    }
+
+    return true;
+}
+
+size_t Calibration::getNbOfDefects(void) const {
+
+    return this->m_defects.size();
+}
+
+void Calibration::listDefects(const std::vector<bool> &defective) {
+
+    this->m_defects.clear();
+
+    for(unsigned int y = 0; y < this->m_height; y++) {
+
+        size_t row = (size_t) y * this->m_width;
+
+        for(unsigned int x = 0; x < this->m_width; x++) {
+
+            if(!defective[row + x]) {
+                continue;
+            }
+
+            /* Nearest valid pixels on each side, or twice the same one at the row ends */
+            int left  = (int) x - 1;
+            int right = (int) x + 1;
+            while((left >= 0) && defective[row + left]) {
+                left--;
+            }
+            while((right < (int) this->m_width) && defective[row + right]) {
+                right++;
+            }
+
+            if((left < 0) && (right >= (int) this->m_width)) {
+                continue;
+            }
+
+            Defect_s defect;
+            defect.index = row + x;
+            defect.left  = row + ((left >= 0) ? left : right);
+            defect.right = row + ((right < (int) this->m_width) ? right : left);
+            this->m_defects.push_back(defect);
+        }
+    }
+}
@@ -0,0 +1,222 @@
+/**
+ * @file command_scheduler.cpp
+ * @brief Timed command scheduler class implementation.
+ */
+
+#include "command_scheduler.hpp"
+
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/timerfd.h>
+
+CommandScheduler::CommandScheduler(void (*prepare)(char), void (*execute)(char), double leadTime) : 
+        m_prepare(prepare), m_execute(execute), m_leadTime(leadTime), m_lastLateness(0.0), m_stop(false) {
+
+    this->m_timer = timerfd_create(CLOCK_MONOTONIC, 0); 
+    pthread_mutex_init(&this->m_lock, NULL); 
+
+    pthread_create(&this->m_thread, NULL, &thread, this); 
+
+    /* Best effort: requires CAP_SYS_NICE or a real-time rlimit */
+    struct sched_param param; 
+    param.sched_priority = SCHEDULER_PRIORITY; 
+    pthread_setschedparam(this->m_thread, SCHED_FIFO, &param); 
+}
+
+CommandScheduler::~CommandScheduler() {
+
+    pthread_mutex_lock(&this->m_lock); 
+    this->m_stop = true; 
+    this->arm(0.0); 
+    pthread_mutex_unlock(&this->m_lock); 
+
+    pthread_join(this->m_thread, NULL); 
+
+    pthread_mutex_destroy(&this->m_lock); 
+    close(this->m_timer); 
+}
+
+bool CommandScheduler::schedule(char order, clockid_t clock, double time) {
+
+    if((clock != CLOCK_MONOTONIC) && (clock != CLOCK_REALTIME)) {
+        return false; 
+    }
+
+    Entry_s entry; 
+    entry.order    = order; 
+    entry.clock    = clock; 
+    entry.time     = time; 
+    entry.prepared = false; 
+
+    pthread_mutex_lock(&this->m_lock); 
+    this->m_entries.push_back(entry); 
+    this->arm(0.0); 
+    pthread_mutex_unlock(&this->m_lock); 
+
+    return true; 
+}
+
+size_t CommandScheduler::getPending(void) {
+
+    pthread_mutex_lock(&this->m_lock); 
+    size_t pending = this->m_entries.size(); 
+    pthread_mutex_unlock(&this->m_lock); 
+
+    return pending; 
+}
+
+double CommandScheduler::getLastLateness(void) {
+
+    pthread_mutex_lock(&this->m_lock); 
+    double lateness = this->m_lastLateness; 
+    pthread_mutex_unlock(&this->m_lock); 
+
+    return lateness; 
+}
+
+bool CommandScheduler::parse(const char *command, int size, char *order, clockid_t *clock, double *time) {
+
+    char buffer[64]; 
+    char clockName; 
+
+    if((size <= 0) || (size >= (int) sizeof(buffer))) {
+        return false; 
+    }
+
+    memcpy(buffer, command, size); 
+    buffer[size] = '\0'; 
+
+    if(sscanf(buffer, "@%c:%lf:%c", &clockName, time, order) != 3) {
+        return false; 
+    }
+
+    switch(clockName) {
+        case 'M': 
+            *clock = CLOCK_MONOTONIC; 
+            return true; 
+        case 'U': 
+            *clock = CLOCK_REALTIME; 
+            return true; 
+        default: 
+            return false; 
+    }
+}
+
+void CommandScheduler::arm(double time) {
+
+    struct itimerspec spec; 
+    memset(&spec, 0, sizeof(spec)); 
+
+    if(time > 0.0) {
+        spec.it_value.tv_sec  = (time_t) time; 
+        spec.it_value.tv_nsec = (long) ((time - (double) spec.it_value.tv_sec) * 1e9); 
+        if(spec.it_value.tv_nsec > 999999999L) {
+            spec.it_value.tv_nsec = 999999999L; 
+        }
+    }
+
+    /* A zero value would disarm the timer: use the earliest possible time instead */
+    if((time >= 0.0) && (spec.it_value.tv_sec == 0) && (spec.it_value.tv_nsec == 0)) {
+        spec.it_value.tv_nsec = 1; 
+    }
+
+    timerfd_settime(this->m_timer, TFD_TIMER_ABSTIME, &spec, NULL); 
+}
+
+double CommandScheduler::toMonotonic(const Entry_s &entry) {
+
+    if(entry.clock == CLOCK_MONOTONIC) {
+        return entry.time; 
+    }
+
+    /* Converted again at each wakeup, so that UTC steps are followed */
+    return entry.time - now(entry.clock) + now(CLOCK_MONOTONIC); 
+}
+
+double CommandScheduler::now(clockid_t clock) {
+
+    struct timespec ts; 
+    clock_gettime(clock, &ts); 
+
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9; 
+}
+
+void * CommandScheduler::thread(void *arg) {
+
+    CommandScheduler *scheduler = reinterpret_cast<CommandScheduler *>(arg); 
+
+    pthread_mutex_lock(&scheduler->m_lock); 
+
+    while(!scheduler->m_stop) {
+
+        /* Earliest order */
+        size_t next = scheduler->m_entries.size(); 
+        double deadline = 0.0; 
+
+        for(size_t incr = 0; incr < scheduler->m_entries.size(); incr++) {
+            double time = toMonotonic(scheduler->m_entries[incr]); 
+            if((next == scheduler->m_entries.size()) || (time < deadline)) {
+                next     = incr; 
+                deadline = time; 
+            }
+        }
+
+        double current = now(CLOCK_MONOTONIC); 
+
+        if(next < scheduler->m_entries.size()) {
+            Entry_s entry = scheduler->m_entries[next]; 
+
+            if(!entry.prepared && (current >= deadline - scheduler->m_leadTime)) {
+                scheduler->m_entries[next].prepared = true; 
+
+                pthread_mutex_unlock(&scheduler->m_lock); 
+                scheduler->m_prepare(entry.order); 
+                pthread_mutex_lock(&scheduler->m_lock); 
+                continue; 
+            }
+
+            if(entry.prepared && (current >= deadline - SCHEDULER_SPIN)) {
+                scheduler->m_entries.erase(scheduler->m_entries.begin() + next); 
+                pthread_mutex_unlock(&scheduler->m_lock); 
+
+                /* Spin on the order clock itself for the last microseconds */
+                double time; 
+                while((time = now(entry.clock)) < entry.time) 
+                    ;
+
+                scheduler->m_execute(entry.order); 
+
+                pthread_mutex_lock(&scheduler->m_lock); 
+                scheduler->m_lastLateness = time - entry.time; 
+                continue; 
+            }
+
+            double wakeup = entry.prepared ? deadline - SCHEDULER_SPIN : deadline - scheduler->m_leadTime; 
+            if((entry.clock != CLOCK_MONOTONIC) && (wakeup > current + SCHEDULER_MAX_SLEEP)) {
+                wakeup = current + SCHEDULER_MAX_SLEEP; 
+            }
+            scheduler->arm(wakeup); 
+        }
+
+        else {
+            scheduler->arm(-1.0); 
+        }
+
+        pthread_mutex_unlock(&scheduler->m_lock); 
+
+        /* Woken up by the timer, by schedule() or by the destructor */
+        uint64_t expirations; 
+        if(read(scheduler->m_timer, &expirations, sizeof(expirations)) < 0) {
+            expirations = 0; 
+        }
+
+        pthread_mutex_lock(&scheduler->m_lock); 
+    }
+
+    pthread_mutex_unlock(&scheduler->m_lock); 
+
+    return NULL; 
+}
@@ -0,0 +1,255 @@
+/**
+ * @file compressed_ring.cpp
+ * @brief Compressed frame ring class implementation.
+ */
+
+#include "compressed_ring.hpp"
+#include <sys/mman.h>
+#include <string.h>
+#include <algorithm>
+
+CompressedRing::CompressedRing(size_t capacity) :
+        m_capacity(capacity), m_head(0), m_used(0), m_raw(0), m_evicted(0), m_closed(false),
+        m_scratch(NULL), m_scratchSize(0) {
+
+    this->m_arena = new unsigned char[capacity];
+    mlock(this->m_arena, capacity);
+
+    pthread_mutex_init(&this->m_lock, NULL);
+    pthread_cond_init(&this->m_available, NULL);
+    pthread_mutex_init(&this->m_decodeLock, NULL);
+}
+
+CompressedRing::~CompressedRing() {
+
+    pthread_mutex_destroy(&this->m_decodeLock);
+    pthread_cond_destroy(&this->m_available);
+    pthread_mutex_destroy(&this->m_lock);
+
+    munlock(this->m_arena, this->m_capacity);
+    delete [] this->m_arena;
+    delete [] this->m_scratch;
+}
+
+bool CompressedRing::push(const Image *image, unsigned int frame) {
+
+    size_t rawSize = image->getWidth() * image->getHeight();
+
+    if(FrameCodec::bound(rawSize) > this->m_scratchSize) {
+        delete [] this->m_scratch;
+        this->m_scratchSize = FrameCodec::bound(rawSize);
+        this->m_scratch     = new unsigned char[this->m_scratchSize];
+    }
+
+    /* Compress outside of the lock, consumers keep working meanwhile */
+    size_t size = this->m_encoder.compress(image->getImageBuffer(), rawSize,
+                                           this->m_scratch, this->m_scratchSize);
+
+    if((size == 0) || (size > this->m_capacity)) {
+        return false;
+    }
+
+    pthread_mutex_lock(&this->m_lock);
+
+    Entry_s entry;
+    entry.frame  = frame;
+    entry.width  = image->getWidth();
+    entry.height = image->getHeight();
+    entry.offset = this->allocate(size);
+    entry.size   = size;
+
+    memcpy(this->m_arena + entry.offset, this->m_scratch, size);
+    this->m_entries.push_back(entry);
+    this->m_used += size;
+    this->m_raw  += rawSize;
+
+    pthread_cond_signal(&this->m_available);
+    pthread_mutex_unlock(&this->m_lock);
+
+    return true;
+}
+
+bool CompressedRing::pop(Image *image, unsigned int *frame) {
+
+    std::vector<unsigned char> data;
+    bool decoded = false;
+
+    while(!decoded) {
+
+        pthread_mutex_lock(&this->m_lock);
+
+        while(this->m_entries.empty() && !this->m_closed) {
+            pthread_cond_wait(&this->m_available, &this->m_lock);
+        }
+
+        if(this->m_entries.empty()) {
+            pthread_mutex_unlock(&this->m_lock);
+            break;
+        }
+
+        /* The frame leaves the ring with a copy of its data, the arena block can be reused */
+        Entry_s entry = this->m_entries.front();
+        this->copy(entry, data);
+
+        this->m_used -= entry.size;
+        this->m_raw  -= entry.width * entry.height;
+        this->m_entries.pop_front();
+
+        pthread_mutex_unlock(&this->m_lock);
+
+        decoded = this->decode(entry, data, image);
+        *frame  = entry.frame;
+
+        /* A frame that cannot be decoded is lost, just like an evicted one */
+        if(!decoded) {
+            pthread_mutex_lock(&this->m_lock);
+            this->m_evicted++;
+            pthread_mutex_unlock(&this->m_lock);
+        }
+    }
+
+    return decoded;
+}
+
+bool CompressedRing::get(unsigned int frame, Image *image) {
+
+    std::vector<unsigned char> data;
+    Entry_s entry;
+    bool found = false;
+
+    pthread_mutex_lock(&this->m_lock);
+
+    std::deque<Entry_s>::const_iterator iter;
+    iter = std::lower_bound(this->m_entries.begin(), this->m_entries.end(), frame, &isBefore);
+
+    if((iter != this->m_entries.end()) && (iter->frame == frame)) {
+        entry = *iter;
+        this->copy(entry, data);
+        found = true;
+    }
+
+    pthread_mutex_unlock(&this->m_lock);
+
+    return found && this->decode(entry, data, image);
+}
+
+void CompressedRing::close(void) {
+
+    pthread_mutex_lock(&this->m_lock);
+    this->m_closed = true;
+    pthread_cond_broadcast(&this->m_available);
+    pthread_mutex_unlock(&this->m_lock);
+}
+
+size_t CompressedRing::getCount(void) {
+
+    pthread_mutex_lock(&this->m_lock);
+    size_t count = this->m_entries.size();
+    pthread_mutex_unlock(&this->m_lock);
+
+    return count;
+}
+
+size_t CompressedRing::getCapacity(void) const {
+
+    return this->m_capacity;
+}
+
+size_t CompressedRing::getUsedBytes(void) {
+
+    pthread_mutex_lock(&this->m_lock);
+    size_t used = this->m_used;
+    pthread_mutex_unlock(&this->m_lock);
+
+    return used;
+}
+
+unsigned long CompressedRing::getEvicted(void) {
+
+    pthread_mutex_lock(&this->m_lock);
+    unsigned long evicted = this->m_evicted;
+    pthread_mutex_unlock(&this->m_lock);
+
+    return evicted;
+}
+
+double CompressedRing::getCompressionRatio(void) {
+
+    double ratio = 0.0;
+
+    pthread_mutex_lock(&this->m_lock);
+    if(this->m_used > 0) {
+        ratio = (double) this->m_raw / (double) this->m_used;
+    }
+    pthread_mutex_unlock(&this->m_lock);
+
+    return ratio;
+}
+
+size_t CompressedRing::allocate(size_t size) {
+
+    /* The live blocks always form a single circular region, from the oldest
+     * block (tail) to the end of the most recent one (head). */
+    while(true) {
+
+        if(this->m_entries.empty()) {
+            this->m_head = 0;
+        }
+
+        else {
+            size_t tail = this->m_entries.front().offset;
+
+            /* Live region not wrapped: the free space is at the end of the arena */
+            if(tail < this->m_head) {
+                if(this->m_head + size > this->m_capacity) {
+                    /* Not enough room at the end: wrap around, the end of the arena is lost */
+                    this->m_head = 0;
+                    continue;
+                }
+            }
+
+            /* Live region wrapped: the free space lies between head and tail */
+            else if(this->m_head + size > tail) {
+                this->evictOldest();
+                continue;
+            }
+        }
+
+        size_t offset = this->m_head;
+        this->m_head += size;
+
+        return offset;
+    }
+}
+
+void CompressedRing::evictOldest(void) {
+
+    this->m_used -= this->m_entries.front().size;
+    this->m_raw  -= this->m_entries.front().width * this->m_entries.front().height;
+    this->m_entries.pop_front();
+    this->m_evicted++;
+}
+
+bool CompressedRing::isBefore(const Entry_s &entry, unsigned int frame) {
+
+    return entry.frame < frame;
+}
+
+void CompressedRing::copy(const Entry_s &entry, std::vector<unsigned char> &data) const {
+
+    data.assign(this->m_arena + entry.offset, this->m_arena + entry.offset + entry.size);
+}
+
+bool CompressedRing::decode(const Entry_s &entry, const std::vector<unsigned char> &data, Image *image) {
+
+    if((image->getWidth() != entry.width) || (image->getHeight() != entry.height) || data.empty()) {
+        return false;
+    }
+
+    pthread_mutex_lock(&this->m_decodeLock);
+    bool decoded = this->m_decoder.decompress(&data[0], data.size(), image->getImageBuffer(),
+                                              entry.width * entry.height);
+    pthread_mutex_unlock(&this->m_decodeLock);
+
+    return decoded;
+}
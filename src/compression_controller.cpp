@@ -0,0 +1,90 @@
+/**
+ * @file compression_controller.cpp
+ * @brief Adaptive compression level controller class implementation.
+ */
+
+#include "compression_controller.hpp"
+#include <png.h>
+
+CompressionController::CompressionController(int minLevel, int maxLevel) : m_idle(0) {
+
+    pthread_mutex_init(&this->m_lock, NULL); 
+    this->setLimits(minLevel, maxLevel); 
+}
+
+CompressionController::~CompressionController() {
+
+    pthread_mutex_destroy(&this->m_lock); 
+}
+
+void CompressionController::setLimits(int minLevel, int maxLevel) {
+
+    /* zlib levels */
+    minLevel = (minLevel < 0) ? 0 : ((minLevel > 9) ? 9 : minLevel); 
+    maxLevel = (maxLevel < minLevel) ? minLevel : ((maxLevel > 9) ? 9 : maxLevel); 
+
+    pthread_mutex_lock(&this->m_lock); 
+    this->m_minLevel = minLevel; 
+    this->m_maxLevel = maxLevel; 
+    this->m_level    = maxLevel; 
+    this->m_idle     = 0; 
+    pthread_mutex_unlock(&this->m_lock); 
+}
+
+int CompressionController::update(double occupancy) {
+
+    pthread_mutex_lock(&this->m_lock); 
+
+    if(occupancy >= COMPRESSION_CRITICAL_WATERMARK) {
+        this->m_level = this->m_minLevel; 
+        this->m_idle  = 0; 
+    }
+
+    else if(occupancy >= COMPRESSION_HIGH_WATERMARK) {
+        if(this->m_level > this->m_minLevel) {
+            this->m_level--; 
+        }
+        this->m_idle = 0; 
+    }
+
+    else if(occupancy <= COMPRESSION_LOW_WATERMARK) {
+        /* Raise slowly: a single quiet frame does not mean the disk caught up */
+        if(++this->m_idle >= COMPRESSION_RAISE_DELAY) {
+            if(this->m_level < this->m_maxLevel) {
+                this->m_level++; 
+            }
+            this->m_idle = 0; 
+        }
+    }
+
+    else {
+        this->m_idle = 0; 
+    }
+
+    int level = this->m_level; 
+    pthread_mutex_unlock(&this->m_lock); 
+
+    return level; 
+}
+
+int CompressionController::getLevel(void) {
+
+    pthread_mutex_lock(&this->m_lock); 
+    int level = this->m_level; 
+    pthread_mutex_unlock(&this->m_lock); 
+
+    return level; 
+}
+
+int CompressionController::getFilters(int level) {
+
+    if(level <= 2) {
+        return PNG_FILTER_NONE; 
+    }
+
+    if(level <= 5) {
+        return PNG_FILTER_SUB | PNG_FILTER_UP; 
+    }
+
+    return PNG_ALL_FILTERS; 
+}
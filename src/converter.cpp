@@ -0,0 +1,767 @@
+/**
+ * @file converter.cpp
+ * @brief Offline recording converter class implementation.
+ */
+
+#include "converter.hpp"
+#include "utilities.hpp"
+
+#include <png.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <algorithm>
+
+/** @brief Number of digits of the frame numbers in the file names, see OutputDirectory. */
+#define CONVERTER_FRAME_DIGITS  (10u)
+
+/** @brief PNG data being decoded from memory. */
+typedef struct {
+    const unsigned char *data;
+    size_t size;
+    size_t position;
+}PngSource_s;
+
+/** @brief Reads the header of a PGM file held in memory. */
+static bool parsePGM(const unsigned char *data, size_t size, unsigned int *width, unsigned int *height, size_t *offset);
+/** @brief Returns the size of a PNG image held in memory, from its header. */
+static bool parsePNG(const unsigned char *data, size_t size, unsigned int *width, unsigned int *height);
+/** @brief Decodes a PNG image held in memory into @p image. */
+static bool decodePNG(const unsigned char *data, size_t size, Image *image);
+
+Converter::Converter(const std::string &input, const std::string &output, ConvertFormat_e format,
+                     unsigned int nbOfThreads, size_t maxInFlight) :
+        m_input(input), m_output(output), m_format(format), m_nbOfThreads(nbOfThreads),
+        m_width(800u), m_height(600u), m_level(-1), m_archiveInput(false), m_stream(NULL), m_inputFd(-1), m_outputFd(-1),
+        m_workers(NULL), m_maxInFlight(maxInFlight), m_inFlight(0),
+        m_done(0), m_failed(0), m_skipped(0), m_bytesRead(0) {
+
+    if(this->m_nbOfThreads == 0) {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        this->m_nbOfThreads = (cores > 0) ? (unsigned int) cores : 1u;
+    }
+    if(this->m_nbOfThreads > CONVERTER_MAX_THREADS) {
+        this->m_nbOfThreads = CONVERTER_MAX_THREADS;
+    }
+
+    pthread_mutex_init(&this->m_lock, NULL);
+    pthread_cond_init(&this->m_released, NULL);
+}
+
+Converter::~Converter() {
+
+    if(this->m_workers != NULL) {
+        this->wait();
+    }
+
+    if(this->m_inputFd >= 0) {
+        close(this->m_inputFd);
+    }
+    if(this->m_outputFd >= 0) {
+        close(this->m_outputFd);
+    }
+
+    delete this->m_stream;
+
+    pthread_cond_destroy(&this->m_released);
+    pthread_mutex_destroy(&this->m_lock);
+}
+
+void Converter::setGeometry(unsigned int width, unsigned int height) {
+
+    this->m_width  = width;
+    this->m_height = height;
+}
+
+void Converter::setCompression(int level) {
+
+    this->m_level = level;
+}
+
+long Converter::scan(void) {
+
+    struct stat info;
+    if(stat(this->m_input.c_str(), &info) != 0) {
+        return -1;
+    }
+
+    this->m_items.clear();
+    this->m_skipped = 0;
+    this->m_archiveInput = S_ISREG(info.st_mode);
+
+    /* A temporal stream gives its frame size, the other files are raw archives */
+    delete this->m_stream;
+    this->m_stream = NULL;
+    if(this->m_archiveInput) {
+        this->m_stream = new TemporalDecoder();
+
+        if(this->m_stream->open(this->m_input)) {
+            this->m_archiveInput = false;
+            this->m_width  = this->m_stream->getWidth();
+            this->m_height = this->m_stream->getHeight();
+        }
+        else {
+            delete this->m_stream;
+            this->m_stream = NULL;
+        }
+    }
+
+    if(this->m_format == CONVERT_ARCHIVE) {
+        this->m_outputFd = open(this->m_output.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+        if(this->m_outputFd < 0) {
+            return -1;
+        }
+    }
+    else if((this->m_format != CONVERT_MEAN) && !createDirectory(this->m_output)) {
+        return -1;
+    }
+
+    if(this->m_archiveInput) {
+        this->m_inputFd = open(this->m_input.c_str(), O_RDONLY);
+        if((this->m_inputFd < 0) || !this->listRecords()) {
+            return -1;
+        }
+    }
+    else if(this->m_stream != NULL) {
+        for(size_t incr = 0; incr < this->m_stream->getNbOfFrames(); incr++) {
+            Item_s item;
+            item.offset = incr;
+            item.frame  = this->m_stream->getRecord(incr).frame;
+            this->m_items.push_back(item);
+        }
+    }
+    else {
+        this->listFiles("");
+    }
+
+    /* Resume: drop the frames already converted */
+    std::vector<unsigned int> archived;
+    if((this->m_format == CONVERT_ARCHIVE) && !this->listArchived(archived)) {
+        return -1;
+    }
+
+    std::vector<Item_s> items;
+    for(size_t incr = 0; incr < this->m_items.size(); incr++) {
+        const Item_s &item = this->m_items[incr];
+        bool converted;
+
+        if(this->m_format == CONVERT_ARCHIVE) {
+            converted = std::binary_search(archived.begin(), archived.end(), item.frame);
+        }
+        else if(this->m_format == CONVERT_MEAN) {
+            converted = false;
+        }
+        else {
+            converted = (access(this->getOutputPath(item).c_str(), F_OK) == 0);
+        }
+
+        if(converted) {
+            this->m_skipped++;
+        }
+        else {
+            items.push_back(item);
+        }
+    }
+
+    this->m_items.swap(items);
+
+    return (long) this->m_items.size();
+}
+
+void Converter::start(void) {
+
+    this->m_workers = new Worker_s[this->m_nbOfThreads];
+
+    /* Each thread starts with a contiguous range of frames */
+    size_t total = this->m_items.size();
+
+    for(unsigned int incr = 0; incr < this->m_nbOfThreads; incr++) {
+        this->m_workers[incr].converter = this;
+        this->m_workers[incr].begin     = total * incr / this->m_nbOfThreads;
+        this->m_workers[incr].end       = total * (incr + 1) / this->m_nbOfThreads;
+        this->m_workers[incr].sum       = NULL;
+        this->m_workers[incr].decoder   = NULL;
+        if(this->m_format == CONVERT_MEAN) {
+            this->m_workers[incr].sum = new uint32_t[(size_t) this->m_width * this->m_height]();
+        }
+        /* Each thread reads its range forward with its own decoder */
+        if(this->m_stream != NULL) {
+            this->m_workers[incr].decoder = new TemporalDecoder();
+            this->m_workers[incr].decoder->open(this->m_input);
+        }
+        pthread_mutex_init(&this->m_workers[incr].lock, NULL);
+    }
+
+    for(unsigned int incr = 0; incr < this->m_nbOfThreads; incr++) {
+        pthread_create(&this->m_workers[incr].thread, NULL, &thread, &this->m_workers[incr]);
+    }
+}
+
+unsigned long Converter::wait(void) {
+
+    if(this->m_workers == NULL) {
+        return this->m_failed;
+    }
+
+    for(unsigned int incr = 0; incr < this->m_nbOfThreads; incr++) {
+        pthread_join(this->m_workers[incr].thread, NULL);
+        pthread_mutex_destroy(&this->m_workers[incr].lock);
+    }
+
+    if((this->m_format == CONVERT_MEAN) && !this->writeMean()) {
+        this->m_failed += this->m_done;
+        this->m_done    = 0;
+    }
+
+    for(unsigned int incr = 0; incr < this->m_nbOfThreads; incr++) {
+        delete [] this->m_workers[incr].sum;
+        delete this->m_workers[incr].decoder;
+    }
+
+    delete [] this->m_workers;
+    this->m_workers = NULL;
+
+    return this->m_failed;
+}
+
+unsigned long Converter::getTotal(void) const {
+
+    return this->m_items.size();
+}
+
+unsigned long Converter::getDone(void) const {
+
+    return __atomic_load_n(&this->m_done, __ATOMIC_RELAXED);
+}
+
+unsigned long Converter::getFailed(void) const {
+
+    return __atomic_load_n(&this->m_failed, __ATOMIC_RELAXED);
+}
+
+unsigned long Converter::getSkipped(void) const {
+
+    return this->m_skipped;
+}
+
+unsigned long long Converter::getBytesRead(void) const {
+
+    return __atomic_load_n(&this->m_bytesRead, __ATOMIC_RELAXED);
+}
+
+bool Converter::parseFormat(const std::string &name, ConvertFormat_e *format) {
+
+    if((name == "pgm") || (name == "PGM")) {
+        *format = CONVERT_PGM;
+    }
+    else if((name == "png") || (name == "PNG")) {
+        *format = CONVERT_PNG;
+    }
+    else if((name == "raw") || (name == "RAW")) {
+        *format = CONVERT_ARCHIVE;
+    }
+    else if(name == "mean") {
+        *format = CONVERT_MEAN;
+    }
+    else {
+        return false;
+    }
+
+    return true;
+}
+
+void Converter::listFiles(const std::string &relative) {
+
+    std::string path = relative.empty() ? this->m_input : this->m_input + "/" + relative;
+    DIR *dir = opendir(path.c_str());
+
+    if(dir == NULL) {
+        return;
+    }
+
+    struct dirent *entry;
+
+    while((entry = readdir(dir)) != NULL) {
+
+        std::string name = entry->d_name;
+        std::string child = relative.empty() ? name : relative + "/" + name;
+
+        /* Shard subdirectories have numeric names, the output keeps the same layout */
+        if(isdigit(name[0])) {
+            if((this->m_format == CONVERT_PGM) || (this->m_format == CONVERT_PNG)) {
+                createDirectory(this->m_output + "/" + child);
+            }
+            this->listFiles(child);
+        }
+
+        else if((name.compare(0, 5, "image") == 0) && (name.size() > 5) && isdigit(name[5])) {
+            std::string extension = getFileExtension(name);
+            if((extension == "pgm") || (extension == "png")) {
+                Item_s item;
+                item.path   = child;
+                item.offset = 0;
+                item.frame  = strtoul(name.c_str() + 5, NULL, 10);
+                this->m_items.push_back(item);
+            }
+        }
+    }
+
+    closedir(dir);
+}
+
+bool Converter::listRecords(void) {
+
+    struct stat info;
+    if(fstat(this->m_inputFd, &info) != 0) {
+        return false;
+    }
+
+    off_t recordSize = sizeof(uint32_t) + (off_t) this->m_width * this->m_height;
+
+    /* A torn last record is ignored */
+    for(off_t offset = 0; offset + recordSize <= info.st_size; offset += recordSize) {
+        uint32_t frame = 0;
+        if(pread(this->m_inputFd, &frame, sizeof(frame), offset) != sizeof(frame)) {
+            return false;
+        }
+
+        Item_s item;
+        item.offset = offset;
+        item.frame  = frame;
+        this->m_items.push_back(item);
+    }
+
+    return true;
+}
+
+bool Converter::listArchived(std::vector<unsigned int> &frames) {
+
+    struct stat info;
+    if(fstat(this->m_outputFd, &info) != 0) {
+        return false;
+    }
+
+    off_t recordSize = sizeof(uint32_t) + (off_t) this->m_width * this->m_height;
+    off_t complete   = info.st_size - info.st_size % recordSize;
+
+    /* Drop the record torn by an interruption, new ones are appended after the last complete one */
+    if((complete != info.st_size) && (ftruncate(this->m_outputFd, complete) != 0)) {
+        return false;
+    }
+
+    for(off_t offset = 0; offset < complete; offset += recordSize) {
+        uint32_t frame = 0;
+        if(pread(this->m_outputFd, &frame, sizeof(frame), offset) != sizeof(frame)) {
+            return false;
+        }
+        frames.push_back(frame);
+    }
+
+    std::sort(frames.begin(), frames.end());
+
+    return true;
+}
+
+std::string Converter::getOutputPath(const Item_s &item) const {
+
+    /* Archive records are named after their frame number */
+    if(item.path.empty()) {
+        char name[32];
+        snprintf(name, sizeof(name), "/image%0*u", CONVERTER_FRAME_DIGITS, item.frame);
+        return this->m_output + name + ((this->m_format == CONVERT_PNG) ? ".png" : ".pgm");
+    }
+
+    std::string path = this->m_output + "/" + item.path;
+    size_t dot = path.find_last_of('.');
+
+    if((dot != std::string::npos) && (dot > path.find_last_of('/'))) {
+        path.erase(dot);
+    }
+
+    return path + ((this->m_format == CONVERT_PNG) ? ".png" : ".pgm");
+}
+
+bool Converter::take(unsigned int index, size_t *item) {
+
+    Worker_s &self = this->m_workers[index];
+
+    while(true) {
+        pthread_mutex_lock(&self.lock);
+        if(self.begin < self.end) {
+            *item = self.begin++;
+            pthread_mutex_unlock(&self.lock);
+            return true;
+        }
+        pthread_mutex_unlock(&self.lock);
+
+        /* Out of work: steal the second half of the largest remaining range */
+        unsigned int victim = index;
+        size_t largest = 0;
+
+        for(unsigned int incr = 0; incr < this->m_nbOfThreads; incr++) {
+            pthread_mutex_lock(&this->m_workers[incr].lock);
+            size_t remaining = this->m_workers[incr].end - this->m_workers[incr].begin;
+            pthread_mutex_unlock(&this->m_workers[incr].lock);
+
+            if(remaining > largest) {
+                largest = remaining;
+                victim  = incr;
+            }
+        }
+
+        if(largest == 0) {
+            return false;
+        }
+
+        size_t begin = 0;
+        size_t end   = 0;
+
+        pthread_mutex_lock(&this->m_workers[victim].lock);
+        Worker_s &other = this->m_workers[victim];
+        if(other.begin < other.end) {
+            end   = other.end;
+            begin = other.begin + (other.end - other.begin) / 2;
+            other.end = begin;
+        }
+        pthread_mutex_unlock(&this->m_workers[victim].lock);
+
+        /* Only this thread fills its own range */
+        pthread_mutex_lock(&self.lock);
+        self.begin = begin;
+        self.end   = end;
+        pthread_mutex_unlock(&self.lock);
+    }
+}
+
+void Converter::acquire(size_t size) {
+
+    pthread_mutex_lock(&this->m_lock);
+
+    /* A frame larger than the bound is converted alone */
+    while((this->m_inFlight > 0) && (this->m_inFlight + size > this->m_maxInFlight)) {
+        pthread_cond_wait(&this->m_released, &this->m_lock);
+    }
+    this->m_inFlight += size;
+
+    pthread_mutex_unlock(&this->m_lock);
+}
+
+void Converter::release(size_t size) {
+
+    pthread_mutex_lock(&this->m_lock);
+    this->m_inFlight -= size;
+    pthread_cond_broadcast(&this->m_released);
+    pthread_mutex_unlock(&this->m_lock);
+}
+
+bool Converter::convert(const Item_s &item, Worker_s *worker) {
+
+    bool converted = false;
+
+    /* Archive record: read the pixels at once */
+    if(this->m_archiveInput) {
+        size_t size = (size_t) this->m_width * this->m_height;
+        this->acquire(size);
+
+        Image *image = new Image(this->m_width, this->m_height);
+        ssize_t length = pread(this->m_inputFd, image->getImageBuffer(), size, item.offset + sizeof(uint32_t));
+
+        if(length == (ssize_t) size) {
+            __atomic_add_fetch(&this->m_bytesRead, (unsigned long long) size, __ATOMIC_RELAXED);
+            converted = this->write(image, item, worker);
+        }
+
+        delete image;
+        this->release(size);
+
+        return converted;
+    }
+
+    /* Temporal stream: decoded forward from the frame converted last by the thread */
+    if(this->m_stream != NULL) {
+        size_t size = (size_t) this->m_width * this->m_height;
+        this->acquire(size);
+
+        Image *image = new Image(this->m_width, this->m_height);
+        if(worker->decoder->read(item.offset, image)) {
+            const TemporalRecord_s &record = this->m_stream->getRecord(item.offset);
+            __atomic_add_fetch(&this->m_bytesRead, (unsigned long long) record.size, __ATOMIC_RELAXED);
+            converted = this->write(image, item, worker);
+        }
+
+        delete image;
+        this->release(size);
+
+        return converted;
+    }
+
+    std::string path = this->m_input + "/" + item.path;
+    int fd = open(path.c_str(), O_RDONLY);
+    if(fd < 0) {
+        return false;
+    }
+
+    struct stat info;
+    void *map = MAP_FAILED;
+
+    if((fstat(fd, &info) == 0) && (info.st_size > 0)) {
+        map = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+
+    if(map == MAP_FAILED) {
+        return false;
+    }
+
+    madvise(map, info.st_size, MADV_SEQUENTIAL);
+
+    const unsigned char *data = (const unsigned char *) map;
+    size_t size = info.st_size;
+    unsigned int width  = 0;
+    unsigned int height = 0;
+    size_t offset = 0;
+
+    /* PGM pixels are used in place, PNG pixels are decoded next to the mapping */
+    if(parsePGM(data, size, &width, &height, &offset)) {
+        this->acquire(size);
+
+        Image image(width, height, (pixel_t *) (data + offset));
+        converted = this->write(&image, item, worker);
+
+        this->release(size);
+    }
+
+    else if(parsePNG(data, size, &width, &height)) {
+        size_t reserved = size + (size_t) width * height;
+        this->acquire(reserved);
+
+        Image *image = new Image(width, height);
+        if(decodePNG(data, size, image)) {
+            converted = this->write(image, item, worker);
+        }
+
+        delete image;
+        this->release(reserved);
+    }
+
+    if(converted) {
+        __atomic_add_fetch(&this->m_bytesRead, (unsigned long long) size, __ATOMIC_RELAXED);
+    }
+
+    munmap(map, info.st_size);
+
+    return converted;
+}
+
+bool Converter::write(Image *image, const Item_s &item, Worker_s *worker) {
+
+    if(this->m_format == CONVERT_MEAN) {
+        if((image->getWidth() != this->m_width) || (image->getHeight() != this->m_height)) {
+            return false;
+        }
+
+        const unsigned char *pixels = (const unsigned char *) image->getImageBuffer();
+        size_t size = (size_t) this->m_width * this->m_height;
+
+        for(size_t incr = 0; incr < size; incr++) {
+            worker->sum[incr] += pixels[incr];
+        }
+
+        return true;
+    }
+
+    if(this->m_format == CONVERT_ARCHIVE) {
+        if((image->getWidth() != this->m_width) || (image->getHeight() != this->m_height)) {
+            return false;
+        }
+
+        /* One call per record keeps the records whole when several threads append */
+        uint32_t frame = item.frame;
+        struct iovec record[2];
+        record[0].iov_base = &frame;
+        record[0].iov_len  = sizeof(frame);
+        record[1].iov_base = image->getImageBuffer();
+        record[1].iov_len  = (size_t) image->getWidth() * image->getHeight();
+
+        return (writev(this->m_outputFd, record, 2) == (ssize_t) (record[0].iov_len + record[1].iov_len));
+    }
+
+    /* The frame only gets its final name once complete, see scan() */
+    std::string path = this->getOutputPath(item);
+    std::string temporary = path + ".tmp";
+
+    FILE *fp = fopen(temporary.c_str(), "wb");
+    if(fp == NULL) {
+        return false;
+    }
+
+    if(this->m_format == CONVERT_PNG) {
+        image->writeToPNG(fp, NULL, this->m_level);
+    }
+    else {
+        image->writeToPGM(fp);
+    }
+
+    bool written = (fflush(fp) == 0) && !ferror(fp);
+    written = (fclose(fp) == 0) && written;
+
+    if(!written || (rename(temporary.c_str(), path.c_str()) != 0)) {
+        unlink(temporary.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+bool Converter::writeMean(void) {
+
+    if(this->m_done == 0) {
+        return false;
+    }
+
+    size_t size = (size_t) this->m_width * this->m_height;
+    Image mean(this->m_width, this->m_height);
+    unsigned char *pixels = (unsigned char *) mean.getImageBuffer();
+
+    for(size_t incr = 0; incr < size; incr++) {
+        unsigned long long sum = 0;
+        for(unsigned int worker = 0; worker < this->m_nbOfThreads; worker++) {
+            sum += this->m_workers[worker].sum[incr];
+        }
+        pixels[incr] = (unsigned char) ((sum + this->m_done / 2) / this->m_done);
+    }
+
+    std::string temporary = this->m_output + ".tmp";
+
+    if((mean.writeToPGM(temporary.c_str()) == 0) || (rename(temporary.c_str(), this->m_output.c_str()) != 0)) {
+        unlink(temporary.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+void * Converter::thread(void *arg) {
+
+    Worker_s *worker = reinterpret_cast<Worker_s *>(arg);
+    Converter *converter = worker->converter;
+    unsigned int index = worker - converter->m_workers;
+    size_t item = 0;
+
+    while(converter->take(index, &item)) {
+        if(converter->convert(converter->m_items[item], worker)) {
+            __atomic_add_fetch(&converter->m_done, 1, __ATOMIC_RELAXED);
+        }
+        else {
+            __atomic_add_fetch(&converter->m_failed, 1, __ATOMIC_RELAXED);
+        }
+    }
+
+    return NULL;
+}
+
+static bool parsePGM(const unsigned char *data, size_t size, unsigned int *width, unsigned int *height, size_t *offset) {
+
+    PGMHeader_s header;
+
+    /* 8-bit pixels, all in the file */
+    if(!Image::parsePGMHeader(data, size, &header) || (header.maxValue > 0xFF) ||
+       (header.offset + (size_t) header.width * header.height > size)) {
+        return false;
+    }
+
+    *width  = header.width;
+    *height = header.height;
+    *offset = header.offset;
+
+    return true;
+}
+
+static bool parsePNG(const unsigned char *data, size_t size, unsigned int *width, unsigned int *height) {
+
+    /* Signature, then the IHDR chunk: length, type, width and height */
+    if((size < 24) || (png_sig_cmp(data, 0, 8) != 0) || (memcmp(data + 12, "IHDR", 4) != 0)) {
+        return false;
+    }
+
+    *width  = ((unsigned int) data[16] << 24) | ((unsigned int) data[17] << 16) | ((unsigned int) data[18] << 8) | data[19];
+    *height = ((unsigned int) data[20] << 24) | ((unsigned int) data[21] << 16) | ((unsigned int) data[22] << 8) | data[23];
+
+    return true;
+}
+
+/** @brief libpng read function, from memory. */
+static void readPNG(png_structp png_ptr, png_bytep data, png_size_t length) {
+
+    PngSource_s *source = reinterpret_cast<PngSource_s *>(png_get_io_ptr(png_ptr));
+
+    if(source->position + length > source->size) {
+        png_error(png_ptr, "Truncated file");
+    }
+
+    memcpy(data, source->data + source->position, length);
+    source->position += length;
+}
+
+/** @brief libpng error handler: failures are counted, not printed. */
+static void silentError(png_structp png_ptr, png_const_charp message) {
+
+    (void) message;
+    png_longjmp(png_ptr, 1);
+}
+
+/** @brief libpng warning handler. */
+static void silentWarning(png_structp png_ptr, png_const_charp message) {
+
+    (void) png_ptr;
+    (void) message;
+}
+
+static bool decodePNG(const unsigned char *data, size_t size, Image *image) {
+
+    png_structp png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, &silentError, &silentWarning);
+    png_infop info_ptr  = (png_ptr != NULL) ? png_create_info_struct(png_ptr) : NULL;
+
+    if(info_ptr == NULL) {
+        png_destroy_read_struct(&png_ptr, NULL, NULL);
+        return false;
+    }
+
+    PngSource_s source;
+    source.data     = data;
+    source.size     = size;
+    source.position = 0;
+
+    if(setjmp(png_jmpbuf(png_ptr))) {
+        png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+        return false;
+    }
+
+    png_set_read_fn(png_ptr, &source, &readPNG);
+    png_read_info(png_ptr, info_ptr);
+
+    /* Only 8-bit grayscale frames: other depths are brought back to 8 bits */
+    if(png_get_color_type(png_ptr, info_ptr) != PNG_COLOR_TYPE_GRAY) {
+        png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+        return false;
+    }
+    png_set_strip_16(png_ptr);
+    png_set_expand_gray_1_2_4_to_8(png_ptr);
+
+    unsigned int width = image->getWidth();
+    for(unsigned int y = 0; y < image->getHeight(); y++) {
+        png_read_row(png_ptr, (png_bytep) image->getImageBuffer() + (size_t) y * width, NULL);
+    }
+    png_read_end(png_ptr, NULL);
+
+    png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+
+    return true;
+}
@@ -0,0 +1,185 @@
+/**
+ * @file crc32c.cpp
+ * @brief CRC32C (Castagnoli) checksum functions implementation.
+ */
+
+#include "crc32c.hpp"
+#include <pthread.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <nmmintrin.h>
+/** @brief The SSE4.2 implementation can be compiled in. */
+#define CRC32C_HARDWARE
+#endif
+
+/** @brief CRC32C polynomial, reflected. */
+#define CRC32C_POLY     (0x82F63B78u)
+
+/** @brief Size of each of the three streams processed together, in bytes. */
+#define CRC32C_BLOCK    (8192u)
+
+/** @brief Slicing-by-8 tables. */
+static uint32_t s_table[8][256];
+/** @brief x^(2^n) modulo the polynomial, for @ref shift(). */
+static uint32_t s_powers[32];
+/** @brief Shifts a CRC over a whole block of zeros. */
+static uint32_t s_blockShift;
+/** @brief Indicates that the processor has the SSE4.2 @p crc32 instruction. */
+static bool s_hardware = false;
+static pthread_once_t s_once = PTHREAD_ONCE_INIT;
+
+/** @brief Multiplies two polynomials modulo the CRC polynomial (reflected representation). */
+static uint32_t multiply(uint32_t a, uint32_t b) {
+
+    uint32_t product = 0;
+
+    for(uint32_t mask = 1u << 31; mask != 0; mask >>= 1) {
+        if(a & mask) {
+            product ^= b;
+        }
+        b = (b & 1) ? (b >> 1) ^ CRC32C_POLY : b >> 1;
+    }
+
+    return product;
+}
+
+/** @brief Returns x^(8 * size) modulo the CRC polynomial. */
+static uint32_t shift(size_t size) {
+
+    uint32_t power = 1u << 31;
+    unsigned int bit = 3;
+
+    while(size != 0) {
+        if(size & 1) {
+            power = multiply(s_powers[bit & 31], power);
+        }
+        size >>= 1;
+        bit++;
+    }
+
+    return power;
+}
+
+/** @brief Builds the tables and checks the processor features. */
+static void initialize(void) {
+
+    for(uint32_t incr = 0; incr < 256; incr++) {
+        uint32_t crc = incr;
+        for(unsigned int bit = 0; bit < 8; bit++) {
+            crc = (crc & 1) ? (crc >> 1) ^ CRC32C_POLY : crc >> 1;
+        }
+        s_table[0][incr] = crc;
+    }
+
+    for(uint32_t incr = 0; incr < 256; incr++) {
+        for(unsigned int slice = 1; slice < 8; slice++) {
+            s_table[slice][incr] = (s_table[slice - 1][incr] >> 8) ^ s_table[0][s_table[slice - 1][incr] & 0xFF];
+        }
+    }
+
+    /* x^1, then successive squares */
+    s_powers[0] = 1u << 30;
+    for(unsigned int incr = 1; incr < 32; incr++) {
+        s_powers[incr] = multiply(s_powers[incr - 1], s_powers[incr - 1]);
+    }
+    s_blockShift = shift(CRC32C_BLOCK);
+
+#ifdef CRC32C_HARDWARE
+    s_hardware = __builtin_cpu_supports("sse4.2");
+#endif
+}
+
+/** @brief Table implementation, on the raw (not inverted) CRC register. */
+static uint32_t crc32cSoftware(uint32_t crc, const unsigned char *data, size_t size) {
+
+    while((size >= 8)) {
+        uint32_t low  = crc ^ ((uint32_t) data[0] | ((uint32_t) data[1] << 8) |
+                               ((uint32_t) data[2] << 16) | ((uint32_t) data[3] << 24));
+        crc = s_table[7][low & 0xFF] ^ s_table[6][(low >> 8) & 0xFF] ^
+              s_table[5][(low >> 16) & 0xFF] ^ s_table[4][low >> 24] ^
+              s_table[3][data[4]] ^ s_table[2][data[5]] ^ s_table[1][data[6]] ^ s_table[0][data[7]];
+        data += 8;
+        size -= 8;
+    }
+
+    while(size > 0) {
+        crc = (crc >> 8) ^ s_table[0][(crc ^ *data) & 0xFF];
+        data++;
+        size--;
+    }
+
+    return crc;
+}
+
+#ifdef CRC32C_HARDWARE
+/** @brief SSE4.2 implementation, on the raw (not inverted) CRC register. */
+__attribute__((target("sse4.2")))
+static uint32_t crc32cHardware(uint32_t crc, const unsigned char *data, size_t size) {
+
+#ifdef __x86_64__
+    /* The instruction has a latency of 3 cycles but a throughput of 1 per cycle:
+     * three consecutive blocks are processed at once, then combined. */
+    while(size >= 3 * CRC32C_BLOCK) {
+        uint64_t crc0 = crc;
+        uint64_t crc1 = 0;
+        uint64_t crc2 = 0;
+
+        for(size_t incr = 0; incr < CRC32C_BLOCK; incr += 8) {
+            uint64_t word0, word1, word2;
+            memcpy(&word0, data + incr, 8);
+            memcpy(&word1, data + CRC32C_BLOCK + incr, 8);
+            memcpy(&word2, data + 2 * CRC32C_BLOCK + incr, 8);
+            crc0 = _mm_crc32_u64(crc0, word0);
+            crc1 = _mm_crc32_u64(crc1, word1);
+            crc2 = _mm_crc32_u64(crc2, word2);
+        }
+
+        crc = multiply(s_blockShift, (uint32_t) crc0) ^ (uint32_t) crc1;
+        crc = multiply(s_blockShift, crc) ^ (uint32_t) crc2;
+        data += 3 * CRC32C_BLOCK;
+        size -= 3 * CRC32C_BLOCK;
+    }
+
+    uint64_t crc64 = crc;
+    while(size >= 8) {
+        uint64_t word;
+        memcpy(&word, data, 8);
+        crc64 = _mm_crc32_u64(crc64, word);
+        data += 8;
+        size -= 8;
+    }
+    crc = (uint32_t) crc64;
+#endif
+
+    while(size > 0) {
+        crc = _mm_crc32_u8(crc, *data);
+        data++;
+        size--;
+    }
+
+    return crc;
+}
+#endif
+
+uint32_t crc32c(uint32_t crc, const void *data, size_t size) {
+
+    pthread_once(&s_once, &initialize);
+
+    const unsigned char *bytes = (const unsigned char *) data;
+
+#ifdef CRC32C_HARDWARE
+    if(s_hardware) {
+        return ~crc32cHardware(~crc, bytes, size);
+    }
+#endif
+
+    return ~crc32cSoftware(~crc, bytes, size);
+}
+
+uint32_t crc32cCombine(uint32_t crc1, uint32_t crc2, size_t size2) {
+
+    pthread_once(&s_once, &initialize);
+
+    return multiply(shift(size2), crc1) ^ crc2;
+}
@@ -0,0 +1,117 @@
+/**
+ * @file cwis_convert.cpp
+ * @brief CWIS recording conversion tool.
+ * @details Converts a recording (directory of PGM/PNG frames, raw archive or temporal
+ *          stream) to another format, on all cores. An interrupted conversion is resumed by
+ *          running the same command again. The @p mean format averages a recording into a
+ *          calibration master frame.
+ */
+
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "converter.hpp"
+#include "utilities.hpp"
+
+using namespace std;
+
+static void printUsage(const char *name);
+
+int main(int argc, char *argv[]) {
+
+    int opt = 0;
+    unsigned int nbOfThreads = 0;
+    unsigned int width  = 800u;
+    unsigned int height = 600u;
+    int level = -1;
+    size_t maxInFlight = CONVERTER_MAX_IN_FLIGHT;
+    ConvertFormat_e format = CONVERT_PNG;
+
+    /* Command-line arguments parsing */
+    while( (opt = getopt(argc, argv, "f:g:j:L:M:")) != -1) {
+
+        switch (opt) {
+            /* Output format: png, pgm, raw or mean (single averaged frame) */
+            case 'f':
+                if(!Converter::parseFormat(optarg, &format)) {
+                    cerr << "Unknown format: " << optarg << endl;
+                    return EXIT_FAILURE;
+                }
+                break;
+
+            /* Frame size of the raw archives and of the mean frame */
+            case 'g':
+                if(sscanf(optarg, "%ux%u", &width, &height) != 2) {
+                    cerr << "Invalid geometry: " << optarg << endl;
+                    return EXIT_FAILURE;
+                }
+                break;
+
+            /* Number of threads (0: one per core) */
+            case 'j':
+                nbOfThreads = strtoul(optarg, NULL, 10);
+                break;
+
+            /* PNG compression level */
+            case 'L':
+                level = atoi(optarg);
+                break;
+
+            /* Bound of the data held in memory, in MiB */
+            case 'M':
+                maxInFlight = strtoul(optarg, NULL, 10) * 1024u * 1024u;
+                break;
+
+            default:
+                printUsage(argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    if(argc - optind != 2) {
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    Converter converter(argv[optind], argv[optind + 1], format, nbOfThreads, maxInFlight);
+    converter.setGeometry(width, height);
+    converter.setCompression(level);
+
+    if(converter.scan() < 0) {
+        cerr << "Cannot open " << argv[optind] << " or " << argv[optind + 1] << endl;
+        return EXIT_FAILURE;
+    }
+
+    cout << converter.getTotal() << " frames to convert, " << converter.getSkipped() <<
+            " already converted." << endl;
+
+    double start = getMonotonicTime();
+    converter.start();
+
+    /* Progress report, once per second */
+    while(converter.getDone() + converter.getFailed() < converter.getTotal()) {
+        sleep(1);
+
+        double elapsed = getMonotonicTime() - start;
+        unsigned long done = converter.getDone() + converter.getFailed();
+
+        printf("\r%lu/%lu frames, %.1f frames/s, %.1f MB/s", done, converter.getTotal(),
+               done / elapsed, converter.getBytesRead() / elapsed / 1e6);
+        fflush(stdout);
+    }
+
+    unsigned long failed = converter.wait();
+    double elapsed = getMonotonicTime() - start;
+
+    printf("\n%lu frames converted, %lu failed in %.2f s (%.1f frames/s).\n", converter.getDone(),
+           failed, elapsed, (elapsed > 0.0) ? converter.getDone() / elapsed : 0.0);
+
+    return (failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static void printUsage(const char *name) {
+
+    cerr << "Usage: " << name << " [-f png|pgm|raw|mean] [-g WxH] [-j threads] [-L level] [-M MiB] input output" << endl;
+}
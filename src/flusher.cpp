@@ -0,0 +1,204 @@
+/**
+ * @file flusher.cpp
+ * @brief Group commit flusher class implementation.
+ */
+
+#include "flusher.hpp"
+#include "utilities.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+
+Flusher::Flusher(FrameJournal *journal, OutputDirectory *directory, unsigned int groupSize, unsigned int groupDelay) : 
+        m_journal(journal), m_directory(directory), m_groupSize(groupSize), m_groupDelay(groupDelay), 
+        m_oldest(0.0), m_added(0), m_processed(0), m_committed(0), m_failed(0), m_flush(false), m_stop(false) {
+
+    if(this->m_groupSize == 0) {
+        this->m_groupSize = 1; 
+    }
+
+    /* No allocation on the writers side in the steady state */
+    this->m_pending.reserve(2 * this->m_groupSize); 
+
+    pthread_condattr_t attr; 
+    pthread_condattr_init(&attr); 
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC); 
+
+    pthread_mutex_init(&this->m_lock, NULL); 
+    pthread_cond_init(&this->m_wakeup, &attr); 
+    pthread_cond_init(&this->m_done, NULL); 
+    pthread_condattr_destroy(&attr); 
+
+    pthread_create(&this->m_thread, NULL, &thread, this); 
+}
+
+Flusher::~Flusher() {
+
+    pthread_mutex_lock(&this->m_lock); 
+    this->m_stop = true; 
+    pthread_cond_signal(&this->m_wakeup); 
+    pthread_mutex_unlock(&this->m_lock); 
+
+    pthread_join(this->m_thread, NULL); 
+
+    pthread_cond_destroy(&this->m_done); 
+    pthread_cond_destroy(&this->m_wakeup); 
+    pthread_mutex_destroy(&this->m_lock); 
+}
+
+void Flusher::add(unsigned int frame, FILE *fp, bool written) {
+
+    Pending_s pending; 
+    pending.frame   = frame; 
+    pending.fp      = fp; 
+    pending.written = written; 
+
+    pthread_mutex_lock(&this->m_lock); 
+
+    this->m_pending.push_back(pending); 
+    this->m_added++; 
+
+    /* Wake the flusher up to arm the group deadline, or to commit a full group */
+    if(this->m_pending.size() == 1) {
+        this->m_oldest = getMonotonicTime(); 
+        pthread_cond_signal(&this->m_wakeup); 
+    }
+    else if(this->m_pending.size() >= this->m_groupSize) {
+        pthread_cond_signal(&this->m_wakeup); 
+    }
+
+    pthread_mutex_unlock(&this->m_lock); 
+}
+
+void Flusher::commit(void) {
+
+    pthread_mutex_lock(&this->m_lock); 
+
+    unsigned long target = this->m_added; 
+    this->m_flush = true; 
+    pthread_cond_signal(&this->m_wakeup); 
+
+    while(this->m_processed < target) {
+        pthread_cond_wait(&this->m_done, &this->m_lock); 
+    }
+
+    pthread_mutex_unlock(&this->m_lock); 
+}
+
+unsigned long Flusher::getCommitted(void) {
+
+    pthread_mutex_lock(&this->m_lock); 
+    unsigned long committed = this->m_committed; 
+    pthread_mutex_unlock(&this->m_lock); 
+
+    return committed; 
+}
+
+unsigned long Flusher::getFailed(void) {
+
+    pthread_mutex_lock(&this->m_lock); 
+    unsigned long failed = this->m_failed; 
+    pthread_mutex_unlock(&this->m_lock); 
+
+    return failed; 
+}
+
+void Flusher::commitGroup(std::vector<Pending_s> &group) {
+
+    std::vector<unsigned int> frames; 
+    frames.reserve(group.size()); 
+
+    /* Start writeback on every file first, so that the disk sees the whole group at once. 
+     * A failed buffered write (e.g. a full disk) leaves a truncated file, which fdatasync() 
+     * does not report: such a frame is never journaled. */
+    for(size_t incr = 0; incr < group.size(); incr++) {
+        if((fflush(group[incr].fp) != 0) || ferror(group[incr].fp)) {
+            group[incr].written = false; 
+        }
+        else if(group[incr].written) {
+            sync_file_range(fileno(group[incr].fp), 0, 0, SYNC_FILE_RANGE_WRITE); 
+        }
+    }
+
+    for(size_t incr = 0; incr < group.size(); incr++) {
+        if(group[incr].written && (fdatasync(fileno(group[incr].fp)) == 0)) {
+            frames.push_back(group[incr].frame); 
+        }
+        fclose(group[incr].fp); 
+    }
+
+    /* New directory entries must reach the disk too */
+    if(this->m_directory != NULL) {
+        this->m_directory->sync(); 
+    }
+
+    bool journaled = frames.empty() || this->m_journal->append(&frames[0], frames.size()); 
+
+    pthread_mutex_lock(&this->m_lock); 
+    if(journaled) {
+        this->m_committed += frames.size(); 
+        this->m_failed    += group.size() - frames.size(); 
+    }
+    else {
+        this->m_failed    += group.size(); 
+    }
+    this->m_processed += group.size(); 
+    pthread_cond_broadcast(&this->m_done); 
+    pthread_mutex_unlock(&this->m_lock); 
+
+    group.clear(); 
+}
+
+void * Flusher::thread(void *arg) {
+
+    Flusher *flusher = reinterpret_cast<Flusher *>(arg); 
+    std::vector<Pending_s> group; 
+    group.reserve(2 * flusher->m_groupSize); 
+
+    pthread_mutex_lock(&flusher->m_lock); 
+
+    while(true) {
+
+        bool due = !flusher->m_pending.empty() && 
+                   (flusher->m_flush || flusher->m_stop || 
+                    (flusher->m_pending.size() >= flusher->m_groupSize) || 
+                    (getMonotonicTime() - flusher->m_oldest) * 1000.0 >= flusher->m_groupDelay); 
+
+        if(!due) {
+            flusher->m_flush = false; 
+
+            if(flusher->m_stop) {
+                break; 
+            }
+
+            /* Sleep until the group is full or the oldest frame reaches its deadline */
+            if(flusher->m_pending.empty()) {
+                pthread_cond_wait(&flusher->m_wakeup, &flusher->m_lock); 
+            }
+            else {
+                double deadline = flusher->m_oldest + flusher->m_groupDelay / 1000.0; 
+                struct timespec ts; 
+                ts.tv_sec  = (time_t) deadline; 
+                ts.tv_nsec = (long) ((deadline - (double) ts.tv_sec) * 1e9); 
+                if(ts.tv_nsec > 999999999L) {
+                    ts.tv_nsec = 999999999L; 
+                }
+                pthread_cond_timedwait(&flusher->m_wakeup, &flusher->m_lock, &ts); 
+            }
+            continue; 
+        }
+
+        /* Take the whole group, writers keep adding frames meanwhile */
+        group.swap(flusher->m_pending); 
+        pthread_mutex_unlock(&flusher->m_lock); 
+
+        flusher->commitGroup(group); 
+
+        pthread_mutex_lock(&flusher->m_lock); 
+    }
+
+    pthread_mutex_unlock(&flusher->m_lock); 
+
+    return NULL; 
+}
@@ -0,0 +1,114 @@
+/**
+ * @file frame_codec.cpp
+ * @brief Fast lossless frame codec class implementation.
+ */
+
+#include "frame_codec.hpp"
+#include <string.h>
+#include <stdlib.h>
+
+/** @brief zlib compression level: favour speed over ratio. */
+#define CODEC_LEVEL     (1)
+/** @brief zlib memory level (default value). */
+#define CODEC_MEMLEVEL  (8)
+
+/** @brief Frame stored without filter. */
+#define CODEC_FILTER_NONE   (0)
+/** @brief Delta-filtered frame. */
+#define CODEC_FILTER_DELTA  (1)
+
+FrameCodec::FrameCodec(void) : m_scratch(NULL), m_scratchSize(0) {
+
+    memset(&this->m_deflate, 0, sizeof(this->m_deflate));
+    memset(&this->m_inflate, 0, sizeof(this->m_inflate));
+
+    /** @todo Throw an exception if the streams cannot be allocated */
+    deflateInit2(&this->m_deflate, CODEC_LEVEL, Z_DEFLATED, MAX_WBITS, CODEC_MEMLEVEL, Z_RLE);
+    inflateInit(&this->m_inflate);
+}
+
+FrameCodec::~FrameCodec() {
+
+    deflateEnd(&this->m_deflate);
+    inflateEnd(&this->m_inflate);
+    delete [] this->m_scratch;
+}
+
+size_t FrameCodec::bound(size_t size) {
+
+    /* One more byte for the filter type */
+    return compressBound(size) + 1;
+}
+
+size_t FrameCodec::compress(const pixel_t *src, size_t size, unsigned char *dst, size_t capacity) {
+
+    if(capacity < 1) {
+        return 0;
+    }
+
+    if(size > this->m_scratchSize) {
+        delete [] this->m_scratch;
+        this->m_scratch     = new unsigned char[size];
+        this->m_scratchSize = size;
+    }
+
+    /* Delta filter: slowly varying frames turn into runs of small values.
+     * Pure sensor noise compresses better unfiltered, so keep the cheapest
+     * of both according to the sum of absolute values (as PNG encoders do). */
+    const unsigned char *in = (const unsigned char *) src;
+    unsigned char previous  = 0;
+    unsigned long rawCost   = 0;
+    unsigned long deltaCost = 0;
+
+    for(size_t incr = 0; incr < size; incr++) {
+        this->m_scratch[incr] = (unsigned char) (in[incr] - previous);
+        previous = in[incr];
+
+        rawCost   += abs((signed char) in[incr]);
+        deltaCost += abs((signed char) this->m_scratch[incr]);
+    }
+
+    dst[0] = (deltaCost < rawCost) ? CODEC_FILTER_DELTA : CODEC_FILTER_NONE;
+
+    deflateReset(&this->m_deflate);
+    this->m_deflate.next_in   = (dst[0] == CODEC_FILTER_DELTA) ? this->m_scratch : (Bytef *) in;
+    this->m_deflate.avail_in  = size;
+    this->m_deflate.next_out  = dst + 1;
+    this->m_deflate.avail_out = capacity - 1;
+
+    if(deflate(&this->m_deflate, Z_FINISH) != Z_STREAM_END) {
+        return 0;
+    }
+
+    return capacity - this->m_deflate.avail_out;
+}
+
+bool FrameCodec::decompress(const unsigned char *src, size_t srcSize, pixel_t *dst, size_t size) {
+
+    if(srcSize < 1) {
+        return false;
+    }
+
+    inflateReset(&this->m_inflate);
+    this->m_inflate.next_in   = (Bytef *) src + 1;
+    this->m_inflate.avail_in  = srcSize - 1;
+    this->m_inflate.next_out  = (Bytef *) dst;
+    this->m_inflate.avail_out = size;
+
+    if((inflate(&this->m_inflate, Z_FINISH) != Z_STREAM_END) || (this->m_inflate.avail_out != 0)) {
+        return false;
+    }
+
+    /* Undo the delta filter */
+    if(src[0] == CODEC_FILTER_DELTA) {
+        unsigned char *out      = (unsigned char *) dst;
+        unsigned char previous  = 0;
+
+        for(size_t incr = 0; incr < size; incr++) {
+            previous  = (unsigned char) (previous + out[incr]);
+            out[incr] = previous;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,293 @@
+/**
+ * @file frame_journal.cpp
+ * @brief Committed frames journal class implementation.
+ */
+
+#include "frame_journal.hpp"
+#include "image.hpp"
+
+#include <zlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdint.h>
+#include <algorithm>
+
+/** @brief Maximum number of frames in a journal record. */
+#define JOURNAL_MAX_RECORD  (1u << 20)
+
+/** @brief Checks that a frame file was entirely written. */
+static bool isCompleteFrame(int dirfd, const char *name); 
+/** @brief Forces a frame file to the disk. */
+static bool syncFrame(int dirfd, const char *name); 
+
+FrameJournal::FrameJournal(const std::string &filename) {
+
+    this->m_fd = open(filename.c_str(), O_RDWR | O_CREAT | O_APPEND, 0666); 
+
+    if(this->m_fd >= 0) {
+        this->load(); 
+    }
+}
+
+FrameJournal::~FrameJournal() {
+
+    if(this->m_fd >= 0) {
+        close(this->m_fd); 
+    }
+}
+
+bool FrameJournal::isOpen(void) const {
+
+    return (this->m_fd >= 0); 
+}
+
+bool FrameJournal::append(const unsigned int *frames, size_t count) {
+
+    if((this->m_fd < 0) || (count == 0) || (count > JOURNAL_MAX_RECORD)) {
+        return false; 
+    }
+
+    /* Record: number of frames, frame numbers, CRC of both */
+    std::vector<uint32_t> record(count + 2); 
+    record[0] = (uint32_t) count; 
+    for(size_t incr = 0; incr < count; incr++) {
+        record[incr + 1] = frames[incr]; 
+    }
+    record[count + 1] = crc32(0L, (const Bytef *) &record[0], (count + 1) * sizeof(uint32_t)); 
+
+    size_t size = record.size() * sizeof(uint32_t); 
+    if(write(this->m_fd, &record[0], size) != (ssize_t) size) {
+        return false; 
+    }
+
+    if(fdatasync(this->m_fd) != 0) {
+        return false; 
+    }
+
+    for(size_t incr = 0; incr < count; incr++) {
+        this->insert(frames[incr]); 
+    }
+
+    return true; 
+}
+
+bool FrameJournal::isCommitted(unsigned int frame) const {
+
+    return std::binary_search(this->m_frames.begin(), this->m_frames.end(), frame); 
+}
+
+size_t FrameJournal::getCount(void) const {
+
+    return this->m_frames.size(); 
+}
+
+unsigned int FrameJournal::getNextFrame(void) const {
+
+    if(this->m_frames.empty()) {
+        return 0; 
+    }
+
+    return this->m_frames.back() + 1u; 
+}
+
+unsigned int FrameJournal::recover(const std::string &directory) {
+
+    std::vector<unsigned int> complete; 
+    unsigned int removed = 0; 
+
+    int dirfd = open(directory.c_str(), O_RDONLY | O_DIRECTORY); 
+    if(dirfd < 0) {
+        return 0; 
+    }
+
+    this->recoverDirectory(dirfd, complete, removed); 
+    close(dirfd); 
+
+    /* Complete frames written after the last commit are kept */
+    std::sort(complete.begin(), complete.end()); 
+    for(size_t offset = 0; offset < complete.size(); offset += JOURNAL_MAX_RECORD) {
+        size_t count = std::min((size_t) JOURNAL_MAX_RECORD, complete.size() - offset); 
+        this->append(&complete[offset], count); 
+    }
+
+    return removed; 
+}
+
+void FrameJournal::load(void) {
+
+    struct stat info; 
+    if((fstat(this->m_fd, &info) != 0) || (info.st_size == 0)) {
+        return; 
+    }
+
+    std::vector<uint32_t> content((info.st_size + sizeof(uint32_t) - 1) / sizeof(uint32_t)); 
+    ssize_t size = pread(this->m_fd, &content[0], info.st_size, 0); 
+    size_t words = (size > 0) ? (size_t) size / sizeof(uint32_t) : 0; 
+    size_t valid = 0; 
+
+    while(valid < words) {
+        size_t count = content[valid]; 
+
+        if((count == 0) || (count > JOURNAL_MAX_RECORD) || (valid + count + 2 > words)) {
+            break; 
+        }
+
+        uint32_t crc = crc32(0L, (const Bytef *) &content[valid], (count + 1) * sizeof(uint32_t)); 
+        if(crc != content[valid + count + 1]) {
+            break; 
+        }
+
+        for(size_t incr = 1; incr <= count; incr++) {
+            this->insert(content[valid + incr]); 
+        }
+        valid += count + 2; 
+    }
+
+    /* Drop the record torn by a crash, new records are appended after the last valid one */
+    if(valid * sizeof(uint32_t) != (size_t) info.st_size) {
+        if(ftruncate(this->m_fd, valid * sizeof(uint32_t)) == 0) {
+            fdatasync(this->m_fd); 
+        }
+    }
+}
+
+void FrameJournal::insert(unsigned int frame) {
+
+    /* Frames are almost always committed in order */
+    if(this->m_frames.empty() || (this->m_frames.back() < frame)) {
+        this->m_frames.push_back(frame); 
+        return; 
+    }
+
+    std::vector<unsigned int>::iterator iter; 
+    iter = std::lower_bound(this->m_frames.begin(), this->m_frames.end(), frame); 
+
+    if((iter == this->m_frames.end()) || (*iter != frame)) {
+        this->m_frames.insert(iter, frame); 
+    }
+}
+
+void FrameJournal::recoverDirectory(int dirfd, std::vector<unsigned int> &complete, unsigned int &removed) {
+
+    int fd = dup(dirfd); 
+    DIR *dir = fdopendir(fd); 
+
+    if(dir == NULL) {
+        close(fd); 
+        return; 
+    }
+
+    struct dirent *entry; 
+    size_t found = complete.size(); 
+
+    while((entry = readdir(dir)) != NULL) {
+
+        const char *name = entry->d_name; 
+
+        /* Shard subdirectories have numeric names */
+        if(isdigit(name[0])) {
+            int shardfd = openat(dirfd, name, O_RDONLY | O_DIRECTORY); 
+            if(shardfd >= 0) {
+                this->recoverDirectory(shardfd, complete, removed); 
+                close(shardfd); 
+            }
+            continue; 
+        }
+
+        if((strncmp(name, "image", 5) != 0) || !isdigit(name[5])) {
+            continue; 
+        }
+
+        unsigned int frame = strtoul(name + 5, NULL, 10); 
+        if(this->isCommitted(frame)) {
+            continue; 
+        }
+
+        /* A complete frame may still be in the page cache only: it is journaled once on the disk */
+        if(isCompleteFrame(dirfd, name)) {
+            if(syncFrame(dirfd, name)) {
+                complete.push_back(frame); 
+            }
+        }
+
+        else if(unlinkat(dirfd, name, 0) == 0) {
+            removed++; 
+        }
+    }
+
+    closedir(dir); 
+
+    /* So are the directory entries of the frames, and of their shards */
+    if(complete.size() != found) {
+        fsync(dirfd); 
+    }
+}
+
+static bool syncFrame(int dirfd, const char *name) {
+
+    int fd = openat(dirfd, name, O_RDONLY); 
+    if(fd < 0) {
+        return false; 
+    }
+
+    bool synced = (fdatasync(fd) == 0); 
+    close(fd); 
+
+    return synced; 
+}
+
+static bool isCompleteFrame(int dirfd, const char *name) {
+
+    static const unsigned char pngSignature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'}; 
+    static const unsigned char pngEnd[12] = {0, 0, 0, 0, 'I', 'E', 'N', 'D', 0xAE, 0x42, 0x60, 0x82}; 
+    static const unsigned char jpegStart[2] = {0xFF, 0xD8}; 
+    static const unsigned char jpegEnd[2] = {0xFF, 0xD9}; 
+
+    int fd = openat(dirfd, name, O_RDONLY); 
+    if(fd < 0) {
+        return false; 
+    }
+
+    struct stat info; 
+    char header[PGM_HEADER_MAX]; 
+    bool complete = false; 
+    ssize_t length = -1; 
+
+    if(fstat(fd, &info) == 0) {
+        length = pread(fd, header, sizeof(header), 0); 
+    }
+
+    if(length >= 8 && memcmp(header, pngSignature, 8) == 0) {
+        /* A PNG file ends with an IEND chunk */
+        unsigned char trailer[12]; 
+        complete = (info.st_size >= 20) && 
+                   (pread(fd, trailer, 12, info.st_size - 12) == 12) && 
+                   (memcmp(trailer, pngEnd, 12) == 0); 
+    }
+
+    else if(length >= 2 && header[0] == 'P' && header[1] == '5') {
+        /* A PGM file holds exactly width x height pixels after its header */
+        PGMHeader_s pgm; 
+        if(Image::parsePGMHeader((const unsigned char *) header, length, &pgm)) {
+            off_t expected = (off_t) pgm.offset + (off_t) pgm.width * pgm.height * ((pgm.maxValue > 0xFF) ? 2 : 1); 
+            complete = (info.st_size == expected); 
+        }
+    }
+
+    else if(length >= 2 && memcmp(header, jpegStart, 2) == 0) {
+        /* A JPEG file ends with an EOI marker */
+        unsigned char trailer[2]; 
+        complete = (info.st_size >= 4) && 
+                   (pread(fd, trailer, 2, info.st_size - 2) == 2) && 
+                   (memcmp(trailer, jpegEnd, 2) == 0); 
+    }
+
+    /* Unknown formats cannot be checked: they are not trusted */
+
+    close(fd); 
+    return complete; 
+}
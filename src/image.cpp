@@ -4,9 +4,13 @@
  */
 
 #include "image.hpp"
-#include <png.h>
+#include "png_encoder.hpp"
+#include "jpeg_encoder.hpp"
+#include "crc32c.hpp"
 #include <sys/mman.h>
 #include <stdio.h>
+#include <string.h>
+#include <ctype.h>
 
 Image::Image(unsigned int width, unsigned int height) : 
             i_width(width), i_height(height) {
@@ -15,9 +19,14 @@ Image::Image(unsigned int width, unsigned int height) :
     this->i_isBeingWritten = false; 
 
     this->i_buffer = new pixel_t[imageSize];
+    this->i_owner  = true; 
     mlock(this->i_buffer, imageSize); 
 }
 
+Image::Image(unsigned int width, unsigned int height, pixel_t *buffer) : 
+            i_width(width), i_height(height), i_buffer(buffer), i_isBeingWritten(false), i_owner(false) {
+}
+
 pixel_t * Image::getImageBuffer(void) const {
 
     return this->i_buffer; 
@@ -35,100 +44,192 @@ unsigned int Image::getHeight(void) const {
 
 void Image::writeToPNG(const char *filename, char *title) {
 
-    FILE *fp; 
+    /* Open the file */
+    FILE *fp = fopen(filename, "wb");
+    if (fp == NULL) {
+        /** @todo Throw file exception */
+        return; 
+    }
 
-    /* PNG related pointers */
-    png_structp png_ptr; 
-    png_infop info_ptr; 
-    png_bytep row;
+    this->writeToPNG(fp, title); 
+    fclose(fp);
+}
+
+size_t Image::writeToPNG(FILE *fp, char *title, int level, int filters) {
 
     this->i_isBeingWritten = true;
     
-    /* Open the file */
-    fp = fopen(filename, "wb");
+    /* Each writer thread keeps its own encoder and buffers */
+    size_t bytes = PngEncoder::getThreadEncoder()->write(fp, this->i_buffer, this->i_width, this->i_height, 
+                                                         level, filters, title); 
+    
+    this->i_isBeingWritten = false;
+
+    return bytes; 
+}
+
+size_t Image::writeToJPEG(const char *filename, int quality, unsigned int scale) {
+
+    FILE *fp = fopen(filename, "wb"); 
     if (fp == NULL) {
-        /** @todo Throw file exception */
+        return 0; 
     }
 
-    png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
-    if (png_ptr == NULL) {
-        /** @todo Throw PNG write struct exception */
-    }
+    size_t bytes = this->writeToJPEG(fp, quality, scale); 
+    fclose(fp); 
 
-    info_ptr = png_create_info_struct(png_ptr); 
-    if(info_ptr == NULL) {
-        /** @todo Throw PNG info struct exception */
-    }
+    return bytes; 
+}
 
-    if (setjmp(png_jmpbuf(png_ptr))) {
-        /** @todo Throw yet another exception */
-    }
+size_t Image::writeToJPEG(FILE *fp, int quality, unsigned int scale) {
 
-    png_init_io(png_ptr, fp);
+    this->i_isBeingWritten = true; 
 
-    /* Write PNG header: 8-bit colour depth, black and white */
-    png_set_IHDR(png_ptr, info_ptr, this->i_width, this->i_height, 
-                 8, PNG_COLOR_TYPE_GRAY, PNG_INTERLACE_NONE, 
-                 PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT); 
+    size_t bytes = JpegEncoder::getThreadEncoder()->write(fp, this->i_buffer, this->i_width, this->i_height, 
+                                                          quality, scale); 
 
-    if(title != NULL) {
-        png_text title_text; 
-        title_text.compression = PNG_TEXT_COMPRESSION_NONE; 
-        title_text.key = (png_charp) "Title"; 
-        title_text.text = title; 
-        png_set_text(png_ptr, info_ptr, &title_text, 1); 
-    }
+    this->i_isBeingWritten = false; 
 
-    png_write_info(png_ptr, info_ptr); 
-    
-    /* Allocate memory for one row */
-    row = new png_byte[this->i_width];
+    return bytes; 
+}
 
-    /* Write data one row at a time */
-    for(unsigned int y = 0; y < this->i_height; y++) {
+size_t Image::writeToPGM(const char *filename) {
 
-        for(unsigned int x = 0; x < this->i_width; x++) {
-            row[x] = (png_byte) this->i_buffer[y * this->i_width + x]; 
-        }
-        png_write_row(png_ptr, row); 
+    FILE *fp = fopen(filename, "wb"); 
+    if (fp == NULL) {
+        /** @todo Throw file exception */
+        return 0; 
     }
-    
-    png_write_end(png_ptr, NULL);
 
+    size_t bytes = this->writeToPGM(fp); 
     fclose(fp);
-    png_free_data(png_ptr, info_ptr, PNG_FREE_ALL, -1); 
-    png_destroy_write_struct(&png_ptr, (png_infopp) NULL); 
-    delete [] row; 
-    
-    this->i_isBeingWritten = false;
+
+    return bytes; 
 }
 
-size_t Image::writeToPGM(const char *filename) {
+size_t Image::writeToPGM(FILE *fp) {
 
     this->i_isBeingWritten = true;
     
     size_t bytes = 0; 
-    FILE *fp = fopen(filename, "wb"); 
-    if (fp == NULL) {
-        /** @todo Throw file exception */
-    }
     
     /* PGM file header.
      * The P5 indicator on the first line specifies the PGM format.
+     * The comment holds the CRC32C of the pixels, see RecordingVerifier. 
      */
-    bytes += fprintf(fp, "P5\n# COMMENT\n%d %d\n%d\n", 
-                     this->i_width, this->i_height, 0xFF); 
+    uint32_t checksum = crc32c(0, this->i_buffer, this->i_width * this->i_height); 
+    bytes += fprintf(fp, "P5\n# crc32c %08x\n%d %d\n%d\n", 
+                     (unsigned int) checksum, this->i_width, this->i_height, 0xFF); 
 
     /* Write the actual image data */
     bytes += fwrite(this->i_buffer, sizeof(pixel_t), this->i_width * this->i_height, fp); 
 
-    fclose(fp);
-    
     this->i_isBeingWritten = false;
 
     return bytes; 
 }
 
+bool Image::parsePGMHeader(const unsigned char *data, size_t size, PGMHeader_s *header) {
+
+    static const char checksumComment[] = "# crc32c "; 
+
+    unsigned long values[3]; 
+    unsigned int nbOfValues = 0; 
+    size_t incr = 2; 
+
+    if((size < 2) || (data[0] != 'P') || (data[1] != '5')) {
+        return false; 
+    }
+
+    header->hasChecksum = false; 
+    header->checksum    = 0; 
+
+    /* Width, height and maximum value, each preceded by whitespace or comments */
+    while(nbOfValues < 3) {
+        if(incr >= size) {
+            return false; 
+        }
+
+        if(data[incr] == '#') {
+            size_t length = sizeof(checksumComment) - 1; 
+
+            if((incr + length < size) && (memcmp(data + incr, checksumComment, length) == 0) && 
+               isxdigit(data[incr + length])) {
+                uint32_t checksum = 0; 
+                size_t digit = incr + length; 
+
+                for(; (digit < size) && isxdigit(data[digit]); digit++) {
+                    checksum = checksum * 16u + (isdigit(data[digit]) ? data[digit] - '0' : 
+                                                                         (tolower(data[digit]) - 'a' + 10)); 
+                }
+
+                header->hasChecksum = true; 
+                header->checksum    = checksum; 
+            }
+
+            while((incr < size) && (data[incr] != '\n')) {
+                incr++; 
+            }
+        }
+        else if(isspace(data[incr])) {
+            incr++; 
+        }
+        else if(isdigit(data[incr]) && isspace(data[incr - 1])) {
+            values[nbOfValues] = 0; 
+            while((incr < size) && isdigit(data[incr])) {
+                values[nbOfValues] = values[nbOfValues] * 10u + (data[incr] - '0'); 
+                if(values[nbOfValues] > 0xFFFFFFFFul) {
+                    return false; 
+                }
+                incr++; 
+            }
+            nbOfValues++; 
+        }
+        else {
+            return false; 
+        }
+    }
+
+    /* A single whitespace separates the header from the pixels */
+    if((incr >= size) || !isspace(data[incr]) || (values[2] == 0) || (values[2] > 0xFFFF)) {
+        return false; 
+    }
+
+    header->width    = (unsigned int) values[0]; 
+    header->height   = (unsigned int) values[1]; 
+    header->maxValue = (unsigned int) values[2]; 
+    header->offset   = incr + 1; 
+
+    return true; 
+}
+
+bool Image::readPGMHeader(FILE *fp, PGMHeader_s *header) {
+
+    unsigned char data[PGM_HEADER_MAX]; 
+    long start = ftell(fp); 
+    size_t size = fread(data, 1, sizeof(data), fp); 
+
+    if((start < 0) || !parsePGMHeader(data, size, header)) {
+        return false; 
+    }
+
+    return fseek(fp, start + (long) header->offset, SEEK_SET) == 0; 
+}
+
+void Image::moveTo(pixel_t *buffer) {
+
+    unsigned int imageSize = this->i_width * this->i_height; 
+    memcpy(buffer, this->i_buffer, imageSize); 
+
+    if(this->i_owner) {
+        munlock(this->i_buffer, imageSize); 
+        delete [] this->i_buffer; 
+    }
+
+    this->i_buffer = buffer; 
+    this->i_owner  = false; 
+}
+
 bool Image::isBeingWritten(void) {
     
     return this->i_isBeingWritten; 
@@ -136,6 +237,10 @@ bool Image::isBeingWritten(void) {
 
 Image::~Image() {
 
+    if(!this->i_owner) {
+        return; 
+    }
+
     munlock(this->i_buffer, this->i_width * this->i_height); 
     delete [] this->i_buffer; 
 }
@@ -0,0 +1,674 @@
+/**
+ * @file jpeg_encoder.cpp
+ * @brief Grayscale JPEG encoder class implementation.
+ */
+
+#include "jpeg_encoder.hpp"
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+/** @brief The AVX2 implementation can be compiled in. */
+#define JPEG_AVX2
+#endif
+
+/** @brief Fixed-point precision of the DCT constants. */
+#define JPEG_CONST_BITS     (13)
+/** @brief Extra precision kept between the two DCT passes. */
+#define JPEG_PASS1_BITS     (2)
+/** @brief Fixed-point precision of the quantization reciprocals. */
+#define JPEG_RECIPROCAL_BITS    (19)
+
+/** @brief DCT constants of the IJG library, scaled by 2^13. */
+#define FIX_0_298631336     (2446)
+#define FIX_0_390180644     (3196)
+#define FIX_0_541196100     (4433)
+#define FIX_0_765366865     (6270)
+#define FIX_0_899976223     (7373)
+#define FIX_1_175875602     (9633)
+#define FIX_1_501321110     (12299)
+#define FIX_1_847759065     (15137)
+#define FIX_1_961570560     (16069)
+#define FIX_2_053119869     (16819)
+#define FIX_2_562915447     (20995)
+#define FIX_3_072711026     (25172)
+
+/** @brief Luminance quantization table of the JPEG standard (Annex K), in natural order. */
+static const uint8_t s_luminance[64] = {
+    16,  11,  10,  16,  24,  40,  51,  61,
+    12,  12,  14,  19,  26,  58,  60,  55,
+    14,  13,  16,  24,  40,  57,  69,  56,
+    14,  17,  22,  29,  51,  87,  80,  62,
+    18,  22,  37,  56,  68, 109, 103,  77,
+    24,  35,  55,  64,  81, 104, 113,  92,
+    49,  64,  78,  87, 103, 121, 120, 101,
+    72,  92,  95,  98, 112, 100, 103,  99
+};
+
+/** @brief Natural index of each coefficient, in zigzag order. */
+static const uint8_t s_zigzag[64] = {
+     0,  1,  8, 16,  9,  2,  3, 10, 17, 24, 32, 25, 18, 11,  4,  5,
+    12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13,  6,  7, 14, 21, 28,
+    35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+    58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63
+};
+
+/** @brief Luminance DC Huffman table of the JPEG standard: number of codes of each length. */
+static const uint8_t s_dcLengths[16] = {0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0};
+static const uint8_t s_dcValues[12]  = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+
+/** @brief Luminance AC Huffman table of the JPEG standard. */
+static const uint8_t s_acLengths[16] = {0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7D};
+static const uint8_t s_acValues[162] = {
+    0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07,
+    0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xA1, 0x08, 0x23, 0x42, 0xB1, 0xC1, 0x15, 0x52, 0xD1, 0xF0,
+    0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0A, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x25, 0x26, 0x27, 0x28,
+    0x29, 0x2A, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49,
+    0x4A, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69,
+    0x6A, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+    0x8A, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9A, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6, 0xA7,
+    0xA8, 0xA9, 0xAA, 0xB2, 0xB3, 0xB4, 0xB5, 0xB6, 0xB7, 0xB8, 0xB9, 0xBA, 0xC2, 0xC3, 0xC4, 0xC5,
+    0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xD2, 0xD3, 0xD4, 0xD5, 0xD6, 0xD7, 0xD8, 0xD9, 0xDA, 0xE1, 0xE2,
+    0xE3, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8, 0xE9, 0xEA, 0xF1, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8,
+    0xF9, 0xFA
+};
+
+pthread_key_t JpegEncoder::s_key;
+pthread_once_t JpegEncoder::s_once = PTHREAD_ONCE_INIT;
+
+/** @brief Builds the codes of a Huffman table from its code lengths (JPEG standard, Annex C). */
+static void buildCodes(const uint8_t lengths[16], const uint8_t *values, uint16_t *codes, uint8_t *sizes) {
+
+    unsigned int code = 0;
+    unsigned int index = 0;
+
+    for(unsigned int length = 1; length <= 16; length++) {
+        for(unsigned int incr = 0; incr < lengths[length - 1]; incr++) {
+            codes[values[index]] = (uint16_t) code++;
+            sizes[values[index]] = (uint8_t) length;
+            index++;
+        }
+        code <<= 1;
+    }
+}
+
+/** @brief Rounds and shifts right, as the @p DESCALE macro of the IJG library. */
+static inline int32_t descale(int32_t x, int n) {
+
+    return (x + (1 << (n - 1))) >> n;
+}
+
+/**
+ * @brief One pass of the IJG integer DCT (jfdctint), on 8 lanes.
+ * @details @p data holds 8 vectors of 8 lanes: the transform combines the vectors, for
+ *          each lane. The first pass keeps @ref JPEG_PASS1_BITS more bits than the second.
+ */
+static void transformPass(int32_t data[64], bool first) {
+
+    int shift = first ? (JPEG_CONST_BITS - JPEG_PASS1_BITS) : (JPEG_CONST_BITS + JPEG_PASS1_BITS);
+
+    for(unsigned int lane = 0; lane < 8; lane++) {
+        int32_t *d = data + lane;
+
+        int32_t tmp0 = d[0] + d[56];
+        int32_t tmp7 = d[0] - d[56];
+        int32_t tmp1 = d[8] + d[48];
+        int32_t tmp6 = d[8] - d[48];
+        int32_t tmp2 = d[16] + d[40];
+        int32_t tmp5 = d[16] - d[40];
+        int32_t tmp3 = d[24] + d[32];
+        int32_t tmp4 = d[24] - d[32];
+
+        /* Even part */
+        int32_t tmp10 = tmp0 + tmp3;
+        int32_t tmp13 = tmp0 - tmp3;
+        int32_t tmp11 = tmp1 + tmp2;
+        int32_t tmp12 = tmp1 - tmp2;
+
+        if(first) {
+            d[0]  = (tmp10 + tmp11) << JPEG_PASS1_BITS;
+            d[32] = (tmp10 - tmp11) << JPEG_PASS1_BITS;
+        }
+        else {
+            d[0]  = descale(tmp10 + tmp11, JPEG_PASS1_BITS);
+            d[32] = descale(tmp10 - tmp11, JPEG_PASS1_BITS);
+        }
+
+        int32_t z1 = (tmp12 + tmp13) * FIX_0_541196100;
+        d[16] = descale(z1 + tmp13 * FIX_0_765366865, shift);
+        d[48] = descale(z1 - tmp12 * FIX_1_847759065, shift);
+
+        /* Odd part */
+        z1 = tmp4 + tmp7;
+        int32_t z2 = tmp5 + tmp6;
+        int32_t z3 = tmp4 + tmp6;
+        int32_t z4 = tmp5 + tmp7;
+        int32_t z5 = (z3 + z4) * FIX_1_175875602;
+
+        tmp4 *= FIX_0_298631336;
+        tmp5 *= FIX_2_053119869;
+        tmp6 *= FIX_3_072711026;
+        tmp7 *= FIX_1_501321110;
+        z1 *= -FIX_0_899976223;
+        z2 *= -FIX_2_562915447;
+        z3 = z3 * -FIX_1_961570560 + z5;
+        z4 = z4 * -FIX_0_390180644 + z5;
+
+        d[56] = descale(tmp4 + z1 + z3, shift);
+        d[40] = descale(tmp5 + z2 + z4, shift);
+        d[24] = descale(tmp6 + z2 + z3, shift);
+        d[8]  = descale(tmp7 + z1 + z4, shift);
+    }
+}
+
+/** @brief Transposes an 8x8 block in place. */
+static void transpose(int32_t data[64]) {
+
+    for(unsigned int y = 0; y < 8; y++) {
+        for(unsigned int x = y + 1; x < 8; x++) {
+            int32_t swap = data[y * 8 + x];
+            data[y * 8 + x] = data[x * 8 + y];
+            data[x * 8 + y] = swap;
+        }
+    }
+}
+
+/** @brief Quantizes a block: rounded division by the quantizers, through their reciprocals. */
+static void quantize(int32_t block[64], const int32_t reciprocals[64]) {
+
+    for(unsigned int incr = 0; incr < 64; incr++) {
+        int32_t sign = block[incr] >> 31;
+        int32_t magnitude = (block[incr] ^ sign) - sign;
+        int32_t quotient = (magnitude * reciprocals[incr] + (1 << (JPEG_RECIPROCAL_BITS - 1))) >> JPEG_RECIPROCAL_BITS;
+        block[incr] = (quotient ^ sign) - sign;
+    }
+}
+
+#ifdef JPEG_AVX2
+/** @brief Multiplies by a DCT constant. */
+__attribute__((target("avx2")))
+static inline __m256i multiply(__m256i x, int32_t c) {
+
+    return _mm256_mullo_epi32(x, _mm256_set1_epi32(c));
+}
+
+/** @brief AVX2 version of @ref descale(). */
+__attribute__((target("avx2")))
+static inline __m256i descaleAVX2(__m256i x, int n) {
+
+    return _mm256_sra_epi32(_mm256_add_epi32(x, _mm256_set1_epi32(1 << (n - 1))), _mm_cvtsi32_si128(n));
+}
+
+/** @brief AVX2 version of @ref transformPass(): each vector is one row of the block. */
+__attribute__((target("avx2")))
+static void transformPassAVX2(__m256i d[8], bool first) {
+
+    int shift = first ? (JPEG_CONST_BITS - JPEG_PASS1_BITS) : (JPEG_CONST_BITS + JPEG_PASS1_BITS);
+
+    __m256i tmp0 = _mm256_add_epi32(d[0], d[7]);
+    __m256i tmp7 = _mm256_sub_epi32(d[0], d[7]);
+    __m256i tmp1 = _mm256_add_epi32(d[1], d[6]);
+    __m256i tmp6 = _mm256_sub_epi32(d[1], d[6]);
+    __m256i tmp2 = _mm256_add_epi32(d[2], d[5]);
+    __m256i tmp5 = _mm256_sub_epi32(d[2], d[5]);
+    __m256i tmp3 = _mm256_add_epi32(d[3], d[4]);
+    __m256i tmp4 = _mm256_sub_epi32(d[3], d[4]);
+
+    /* Even part */
+    __m256i tmp10 = _mm256_add_epi32(tmp0, tmp3);
+    __m256i tmp13 = _mm256_sub_epi32(tmp0, tmp3);
+    __m256i tmp11 = _mm256_add_epi32(tmp1, tmp2);
+    __m256i tmp12 = _mm256_sub_epi32(tmp1, tmp2);
+
+    if(first) {
+        d[0] = _mm256_slli_epi32(_mm256_add_epi32(tmp10, tmp11), JPEG_PASS1_BITS);
+        d[4] = _mm256_slli_epi32(_mm256_sub_epi32(tmp10, tmp11), JPEG_PASS1_BITS);
+    }
+    else {
+        d[0] = descaleAVX2(_mm256_add_epi32(tmp10, tmp11), JPEG_PASS1_BITS);
+        d[4] = descaleAVX2(_mm256_sub_epi32(tmp10, tmp11), JPEG_PASS1_BITS);
+    }
+
+    __m256i z1 = multiply(_mm256_add_epi32(tmp12, tmp13), FIX_0_541196100);
+    d[2] = descaleAVX2(_mm256_add_epi32(z1, multiply(tmp13, FIX_0_765366865)), shift);
+    d[6] = descaleAVX2(_mm256_sub_epi32(z1, multiply(tmp12, FIX_1_847759065)), shift);
+
+    /* Odd part */
+    z1 = _mm256_add_epi32(tmp4, tmp7);
+    __m256i z2 = _mm256_add_epi32(tmp5, tmp6);
+    __m256i z3 = _mm256_add_epi32(tmp4, tmp6);
+    __m256i z4 = _mm256_add_epi32(tmp5, tmp7);
+    __m256i z5 = multiply(_mm256_add_epi32(z3, z4), FIX_1_175875602);
+
+    tmp4 = multiply(tmp4, FIX_0_298631336);
+    tmp5 = multiply(tmp5, FIX_2_053119869);
+    tmp6 = multiply(tmp6, FIX_3_072711026);
+    tmp7 = multiply(tmp7, FIX_1_501321110);
+    z1 = multiply(z1, -FIX_0_899976223);
+    z2 = multiply(z2, -FIX_2_562915447);
+    z3 = _mm256_add_epi32(multiply(z3, -FIX_1_961570560), z5);
+    z4 = _mm256_add_epi32(multiply(z4, -FIX_0_390180644), z5);
+
+    d[7] = descaleAVX2(_mm256_add_epi32(_mm256_add_epi32(tmp4, z1), z3), shift);
+    d[5] = descaleAVX2(_mm256_add_epi32(_mm256_add_epi32(tmp5, z2), z4), shift);
+    d[3] = descaleAVX2(_mm256_add_epi32(_mm256_add_epi32(tmp6, z2), z3), shift);
+    d[1] = descaleAVX2(_mm256_add_epi32(_mm256_add_epi32(tmp7, z1), z4), shift);
+}
+
+/** @brief Transposes an 8x8 block held in 8 vectors. */
+__attribute__((target("avx2")))
+static void transposeAVX2(__m256i d[8]) {
+
+    __m256i a0 = _mm256_unpacklo_epi32(d[0], d[1]);
+    __m256i a1 = _mm256_unpackhi_epi32(d[0], d[1]);
+    __m256i a2 = _mm256_unpacklo_epi32(d[2], d[3]);
+    __m256i a3 = _mm256_unpackhi_epi32(d[2], d[3]);
+    __m256i a4 = _mm256_unpacklo_epi32(d[4], d[5]);
+    __m256i a5 = _mm256_unpackhi_epi32(d[4], d[5]);
+    __m256i a6 = _mm256_unpacklo_epi32(d[6], d[7]);
+    __m256i a7 = _mm256_unpackhi_epi32(d[6], d[7]);
+
+    __m256i b0 = _mm256_unpacklo_epi64(a0, a2);
+    __m256i b1 = _mm256_unpackhi_epi64(a0, a2);
+    __m256i b2 = _mm256_unpacklo_epi64(a1, a3);
+    __m256i b3 = _mm256_unpackhi_epi64(a1, a3);
+    __m256i b4 = _mm256_unpacklo_epi64(a4, a6);
+    __m256i b5 = _mm256_unpackhi_epi64(a4, a6);
+    __m256i b6 = _mm256_unpacklo_epi64(a5, a7);
+    __m256i b7 = _mm256_unpackhi_epi64(a5, a7);
+
+    d[0] = _mm256_permute2x128_si256(b0, b4, 0x20);
+    d[1] = _mm256_permute2x128_si256(b1, b5, 0x20);
+    d[2] = _mm256_permute2x128_si256(b2, b6, 0x20);
+    d[3] = _mm256_permute2x128_si256(b3, b7, 0x20);
+    d[4] = _mm256_permute2x128_si256(b0, b4, 0x31);
+    d[5] = _mm256_permute2x128_si256(b1, b5, 0x31);
+    d[6] = _mm256_permute2x128_si256(b2, b6, 0x31);
+    d[7] = _mm256_permute2x128_si256(b3, b7, 0x31);
+}
+
+/** @brief AVX2 version of the block transform, quantized if @p reciprocals is not @p NULL. */
+__attribute__((target("avx2")))
+static void transformAVX2(const unsigned char *src, size_t stride, const int32_t *reciprocals, int32_t block[64]) {
+
+    __m256i d[8];
+    __m256i center = _mm256_set1_epi32(128);
+
+    for(unsigned int y = 0; y < 8; y++) {
+        __m128i row = _mm_loadl_epi64((const __m128i *) (src + y * stride));
+        d[y] = _mm256_sub_epi32(_mm256_cvtepu8_epi32(row), center);
+    }
+
+    /* Rows first, as the IJG library: the columns become vectors */
+    transposeAVX2(d);
+    transformPassAVX2(d, true);
+    transposeAVX2(d);
+    transformPassAVX2(d, false);
+
+    for(unsigned int v = 0; v < 8; v++) {
+        if(reciprocals != NULL) {
+            __m256i sign      = _mm256_srai_epi32(d[v], 31);
+            __m256i magnitude = _mm256_abs_epi32(d[v]);
+            __m256i scale     = _mm256_loadu_si256((const __m256i *) (reciprocals + v * 8));
+            __m256i quotient  = _mm256_srai_epi32(_mm256_add_epi32(_mm256_mullo_epi32(magnitude, scale),
+                                                  _mm256_set1_epi32(1 << (JPEG_RECIPROCAL_BITS - 1))),
+                                                  JPEG_RECIPROCAL_BITS);
+            d[v] = _mm256_sub_epi32(_mm256_xor_si256(quotient, sign), sign);
+        }
+        _mm256_storeu_si256((__m256i *) (block + v * 8), d[v]);
+    }
+}
+#endif
+
+/** @brief Indicates that the processor supports AVX2. */
+static bool hasAVX2(void) {
+
+#ifdef JPEG_AVX2
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+/** @brief Block transform, quantized if @p reciprocals is not @p NULL. */
+static void transformBlock(const unsigned char *src, size_t stride, const int32_t *reciprocals, int32_t block[64]) {
+
+#ifdef JPEG_AVX2
+    if(hasAVX2()) {
+        transformAVX2(src, stride, reciprocals, block);
+        return;
+    }
+#endif
+
+    /* Rows first, as the IJG library: the columns become vectors */
+    for(unsigned int y = 0; y < 8; y++) {
+        for(unsigned int x = 0; x < 8; x++) {
+            block[x * 8 + y] = (int32_t) src[y * stride + x] - 128;
+        }
+    }
+
+    transformPass(block, true);
+    transpose(block);
+    transformPass(block, false);
+
+    if(reciprocals != NULL) {
+        quantize(block, reciprocals);
+    }
+}
+
+JpegEncoder::JpegEncoder(void) :
+        m_samples(NULL), m_samplesSize(0), m_output(NULL), m_outputSize(0), m_position(0),
+        m_bits(0), m_nbOfBits(0) {
+
+    memset(this->m_dcCodes, 0, sizeof(this->m_dcCodes));
+    memset(this->m_dcSizes, 0, sizeof(this->m_dcSizes));
+    memset(this->m_acCodes, 0, sizeof(this->m_acCodes));
+    memset(this->m_acSizes, 0, sizeof(this->m_acSizes));
+
+    buildCodes(s_dcLengths, s_dcValues, this->m_dcCodes, this->m_dcSizes);
+    buildCodes(s_acLengths, s_acValues, this->m_acCodes, this->m_acSizes);
+
+    getQuantizers(JPEG_DEFAULT_QUALITY, this->m_quantizers);
+}
+
+JpegEncoder::~JpegEncoder() {
+
+    delete [] this->m_samples;
+    delete [] this->m_output;
+}
+
+size_t JpegEncoder::write(FILE *fp, const pixel_t *pixels, unsigned int width, unsigned int height,
+                          int quality, unsigned int scale) {
+
+    if((scale == 0) || (scale > JPEG_MAX_SCALE) || (width / scale == 0) || (height / scale == 0)) {
+        return 0;
+    }
+
+    unsigned int outWidth  = width / scale;
+    unsigned int outHeight = height / scale;
+    unsigned int padWidth  = (outWidth + 7) & ~7u;
+    unsigned int padHeight = (outHeight + 7) & ~7u;
+
+    const unsigned char *samples = (const unsigned char *) pixels;
+    size_t stride = width;
+
+    /* Reduced or partial blocks: the samples are prepared aside, edges repeated */
+    if((scale > 1) || (padWidth != outWidth) || (padHeight != outHeight)) {
+        size_t size = (size_t) padWidth * padHeight;
+        if(size > this->m_samplesSize) {
+            delete [] this->m_samples;
+            this->m_samples     = new unsigned char[size];
+            this->m_samplesSize = size;
+        }
+
+        unsigned int area = scale * scale;
+
+        for(unsigned int y = 0; y < outHeight; y++) {
+            unsigned char *dst = this->m_samples + (size_t) y * padWidth;
+
+            for(unsigned int x = 0; x < outWidth; x++) {
+                unsigned int sum = 0;
+                for(unsigned int j = 0; j < scale; j++) {
+                    const unsigned char *src = samples + ((size_t) y * scale + j) * width + (size_t) x * scale;
+                    for(unsigned int i = 0; i < scale; i++) {
+                        sum += src[i];
+                    }
+                }
+                dst[x] = (unsigned char) ((sum + area / 2) / area);
+            }
+
+            memset(dst + outWidth, dst[outWidth - 1], padWidth - outWidth);
+        }
+
+        for(unsigned int y = outHeight; y < padHeight; y++) {
+            memcpy(this->m_samples + (size_t) y * padWidth, this->m_samples + (size_t) (outHeight - 1) * padWidth, padWidth);
+        }
+
+        samples = this->m_samples;
+        stride  = padWidth;
+    }
+
+    /* Worst case: every coefficient coded on 27 bits, every byte stuffed */
+    size_t blocks = (size_t) (padWidth / 8) * (padHeight / 8);
+    size_t bound  = blocks * 64 * 27 / 4 + 1024;
+    if(bound > this->m_outputSize) {
+        delete [] this->m_output;
+        this->m_output     = new unsigned char[bound];
+        this->m_outputSize = bound;
+    }
+
+    getQuantizers(quality, this->m_quantizers);
+    for(unsigned int incr = 0; incr < 64; incr++) {
+        /* The DCT output is scaled up by 8 */
+        int32_t divisor = 8 * this->m_quantizers[incr];
+        this->m_reciprocals[incr] = ((1 << JPEG_RECIPROCAL_BITS) + divisor / 2) / divisor;
+    }
+
+    this->m_position = 0;
+    this->m_bits     = 0;
+    this->m_nbOfBits = 0;
+    this->writeHeaders(outWidth, outHeight);
+
+    int32_t block[64];
+    int dc = 0;
+
+    for(unsigned int y = 0; y < padHeight; y += 8) {
+        for(unsigned int x = 0; x < padWidth; x += 8) {
+            transformBlock(samples + (size_t) y * stride + x, stride, this->m_reciprocals, block);
+            this->encodeBlock(block, &dc);
+        }
+    }
+
+    this->flushBits();
+    this->m_output[this->m_position++] = 0xFF;
+    this->m_output[this->m_position++] = 0xD9;
+
+    if(fwrite(this->m_output, 1, this->m_position, fp) != this->m_position) {
+        return 0;
+    }
+
+    return this->m_position;
+}
+
+void JpegEncoder::transform(const unsigned char *src, size_t stride, int32_t coefficients[64]) {
+
+    transformBlock(src, stride, NULL, coefficients);
+}
+
+void JpegEncoder::getQuantizers(int quality, uint16_t table[64]) {
+
+    if(quality < 1) {
+        quality = 1;
+    }
+    if(quality > 100) {
+        quality = 100;
+    }
+
+    /* Scaling of the IJG library */
+    int scale = (quality < 50) ? (5000 / quality) : (200 - 2 * quality);
+
+    for(unsigned int incr = 0; incr < 64; incr++) {
+        int quantizer = (s_luminance[incr] * scale + 50) / 100;
+        table[incr] = (uint16_t) ((quantizer < 1) ? 1 : ((quantizer > 255) ? 255 : quantizer));
+    }
+}
+
+inline void JpegEncoder::putBits(uint32_t bits, unsigned int count) {
+
+    this->m_bits = (this->m_bits << count) | bits;
+    this->m_nbOfBits += count;
+
+    if(this->m_nbOfBits < 32) {
+        return;
+    }
+
+    this->m_nbOfBits -= 32;
+    uint32_t word = (uint32_t) (this->m_bits >> this->m_nbOfBits);
+    unsigned char *dst = this->m_output + this->m_position;
+
+    /* Fast path: no 0xFF byte, which would have to be followed by a stuffed 0x00 */
+    uint32_t inverse = ~word;
+    if(((inverse - 0x01010101u) & ~inverse & 0x80808080u) == 0) {
+        dst[0] = (unsigned char) (word >> 24);
+        dst[1] = (unsigned char) (word >> 16);
+        dst[2] = (unsigned char) (word >> 8);
+        dst[3] = (unsigned char) word;
+        this->m_position += 4;
+        return;
+    }
+
+    for(int shift = 24; shift >= 0; shift -= 8) {
+        unsigned char byte = (unsigned char) (word >> shift);
+        this->m_output[this->m_position++] = byte;
+        if(byte == 0xFF) {
+            this->m_output[this->m_position++] = 0x00;
+        }
+    }
+}
+
+void JpegEncoder::flushBits(void) {
+
+    /* Padding with ones up to a whole byte, then the remaining bytes */
+    unsigned int padding = (8 - this->m_nbOfBits % 8) % 8;
+    this->m_bits = (this->m_bits << padding) | ((1u << padding) - 1);
+    this->m_nbOfBits += padding;
+
+    while(this->m_nbOfBits > 0) {
+        this->m_nbOfBits -= 8;
+        unsigned char byte = (unsigned char) (this->m_bits >> this->m_nbOfBits);
+        this->m_output[this->m_position++] = byte;
+        if(byte == 0xFF) {
+            this->m_output[this->m_position++] = 0x00;
+        }
+    }
+
+    this->m_bits = 0;
+}
+
+void JpegEncoder::encodeBlock(const int32_t *block, int *dc) {
+
+    /* DC: difference with the previous block, category then value bits */
+    int difference = block[0] - *dc;
+    *dc = block[0];
+
+    int magnitude = (difference < 0) ? -difference : difference;
+    unsigned int category = (magnitude == 0) ? 0 : (32 - __builtin_clz(magnitude));
+
+    this->putBits(this->m_dcCodes[category], this->m_dcSizes[category]);
+    if(category > 0) {
+        int bits = (difference < 0) ? (difference - 1) : difference;
+        this->putBits((uint32_t) bits & ((1u << category) - 1), category);
+    }
+
+    /* AC: runs of zeros and values, in zigzag order */
+    unsigned int run = 0;
+
+    for(unsigned int incr = 1; incr < 64; incr++) {
+        int value = block[s_zigzag[incr]];
+
+        if(value == 0) {
+            run++;
+            continue;
+        }
+
+        /* Runs of 16 zeros */
+        while(run > 15) {
+            this->putBits(this->m_acCodes[0xF0], this->m_acSizes[0xF0]);
+            run -= 16;
+        }
+
+        magnitude = (value < 0) ? -value : value;
+        category  = 32 - __builtin_clz(magnitude);
+        unsigned int symbol = (run << 4) | category;
+
+        this->putBits(this->m_acCodes[symbol], this->m_acSizes[symbol]);
+        int bits = (value < 0) ? (value - 1) : value;
+        this->putBits((uint32_t) bits & ((1u << category) - 1), category);
+
+        run = 0;
+    }
+
+    /* End of block */
+    if(run > 0) {
+        this->putBits(this->m_acCodes[0x00], this->m_acSizes[0x00]);
+    }
+}
+
+void JpegEncoder::writeHeaders(unsigned int width, unsigned int height) {
+
+    unsigned char *dst = this->m_output;
+    size_t position = 0;
+
+    /* Start of image, JFIF segment */
+    static const unsigned char header[] = {
+        0xFF, 0xD8,
+        0xFF, 0xE0, 0x00, 0x10, 'J', 'F', 'I', 'F', 0x00, 0x01, 0x01, 0x00, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00
+    };
+    memcpy(dst, header, sizeof(header));
+    position += sizeof(header);
+
+    /* Quantization table, in zigzag order */
+    static const unsigned char quantization[] = {0xFF, 0xDB, 0x00, 0x43, 0x00};
+    memcpy(dst + position, quantization, sizeof(quantization));
+    position += sizeof(quantization);
+    for(unsigned int incr = 0; incr < 64; incr++) {
+        dst[position++] = (unsigned char) this->m_quantizers[s_zigzag[incr]];
+    }
+
+    /* Baseline frame: 8 bits, a single component */
+    unsigned char frame[] = {
+        0xFF, 0xC0, 0x00, 0x0B, 0x08,
+        (unsigned char) (height >> 8), (unsigned char) height, (unsigned char) (width >> 8), (unsigned char) width,
+        0x01, 0x01, 0x11, 0x00
+    };
+    memcpy(dst + position, frame, sizeof(frame));
+    position += sizeof(frame);
+
+    /* Huffman tables */
+    static const unsigned char dcTable[] = {0xFF, 0xC4, 0x00, 0x1F, 0x00};
+    memcpy(dst + position, dcTable, sizeof(dcTable));
+    position += sizeof(dcTable);
+    memcpy(dst + position, s_dcLengths, sizeof(s_dcLengths));
+    position += sizeof(s_dcLengths);
+    memcpy(dst + position, s_dcValues, sizeof(s_dcValues));
+    position += sizeof(s_dcValues);
+
+    static const unsigned char acTable[] = {0xFF, 0xC4, 0x00, 0xB5, 0x10};
+    memcpy(dst + position, acTable, sizeof(acTable));
+    position += sizeof(acTable);
+    memcpy(dst + position, s_acLengths, sizeof(s_acLengths));
+    position += sizeof(s_acLengths);
+    memcpy(dst + position, s_acValues, sizeof(s_acValues));
+    position += sizeof(s_acValues);
+
+    /* Scan of the single component, all the coefficients */
+    static const unsigned char scan[] = {0xFF, 0xDA, 0x00, 0x08, 0x01, 0x01, 0x00, 0x00, 0x3F, 0x00};
+    memcpy(dst + position, scan, sizeof(scan));
+    position += sizeof(scan);
+
+    this->m_position = position;
+}
+
+JpegEncoder * JpegEncoder::getThreadEncoder(void) {
+
+    pthread_once(&s_once, &createKey);
+
+    JpegEncoder *encoder = reinterpret_cast<JpegEncoder *>(pthread_getspecific(s_key));
+
+    if(encoder == NULL) {
+        encoder = new JpegEncoder();
+        pthread_setspecific(s_key, encoder);
+    }
+
+    return encoder;
+}
+
+void JpegEncoder::createKey(void) {
+
+    pthread_key_create(&s_key, &destroy);
+}
+
+void JpegEncoder::destroy(void *encoder) {
+
+    delete reinterpret_cast<JpegEncoder *>(encoder);
+}
@@ -8,22 +8,63 @@
 #include <string.h>
 #include <stdlib.h>
 #include <getopt.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
 
 #include <uEye.h>
 
 #include "utilities.hpp"
 #include "ueye_camera.hpp"
 #include "image.hpp"
+#include "compressed_ring.hpp"
+#include "ring_sizer.hpp"
+#include "output_directory.hpp"
+#include "frame_journal.hpp"
+#include "flusher.hpp"
+#include "tiered_storage.hpp"
+#include "writer_pool.hpp"
+#include "compression_controller.hpp"
+#include "preview.hpp"
+#include "shared_ring.hpp"
+#include "telemetry.hpp"
+#include "command_scheduler.hpp"
+#include "recording_verifier.hpp"
+#include "calibration.hpp"
+#include "temporal_binner.hpp"
+#include "pipeline.hpp"
+#include "pipeline_stages.hpp"
+#include "temporal_codec.hpp"
+#include "jpeg_encoder.hpp"
 #include "pipes/rx_pipe.hpp"
+#include "serial/i2c_bus.hpp"
+#include "serial/rx_thread.hpp"
 #include "exceptions/ueye_exception.hpp"
 
 using namespace std; 
 
 static int displayCameraInformations(void); 
+static int verifyRecording(const char *directory); 
 static int listConnectedCameras(void);
 static void singleAcquisition(const char *filename); 
 static void prepareForAcquisition(void);
+static void createRingBuffer(size_t ringSize); 
+static void * prepareStorage(void *arg); 
+static void prepareOrder(char order); 
+static void executeOrder(char order); 
+static void saveFrames(const FrameBatch_s *batch); 
 static void saveImage(char *buffer); 
+static void storeImage(Image *i, unsigned int frame); 
+static void archiveImage(Image *i, unsigned int frame); 
+static void writeQuicklook(Image *i, unsigned int frame); 
+static WriterPool * createWriters(void); 
+static Calibration * loadCalibration(void); 
+static Pipeline * createPipeline(void); 
+static double getBufferOccupancy(void); 
+static void updateTelemetry(void); 
+static void * drainHistory(void *arg); 
+static bool isBinPending(const Image *output); 
 static inline void setDefaults(void); 
 
 typedef enum {
@@ -34,7 +75,9 @@ typedef enum {
 typedef enum {
     PNG,
     BMP, 
-    PGM
+    PGM, 
+    JPG, 
+    TDC
 }OutputFormat_e; 
 
 typedef struct {
@@ -44,12 +87,61 @@ typedef struct {
     std::string outputDir; 
     bool detectExtension;
     OutputFormat_e format; 
+    size_t historySize; 
+    size_t ringSize; 
+    double framerate; 
+    double burstTolerance; 
+    unsigned int shardSize; 
+    unsigned int commitFrames; 
+    unsigned int commitDelay; 
+    unsigned int nbOfWriters; 
+    int minCompression; 
+    int maxCompression; 
+    unsigned int previewFactor; 
+    double previewRate; 
+    std::string sharedName; 
+    unsigned int telemetryPeriod; 
+    std::string serialPort; 
+    double leadTime; 
+    std::string archiveFile; 
+    std::string darkFile; 
+    std::string flatFile; 
+    unsigned int binFactor; 
+    BinningMode_e binMode; 
+    std::string pipelineFile; 
+    unsigned int quicklookPeriod; 
+    int quicklookQuality; 
+    unsigned int quicklookScale; 
+    std::string tierDir; 
+    size_t tierCapacity; 
+    double migrationRate; 
 }ProgramOptions_s;
 
 typedef struct {
     UEye_Camera *c; 
     RingBuffer *rb;
+    SharedRing *shared; 
+    RingSizer *sizer; 
     RXPipe *rxpipe;
+    I2CBus *bus; 
+    RXThread *rxserial; 
+    OutputDirectory *output; 
+    FrameJournal *journal; 
+    Flusher *flusher; 
+    TieredStorage *tier; 
+    WriterPool *writers; 
+    int archiveFd; 
+    CompressionController *compression; 
+    CompressedRing *history; 
+    Preview *preview; 
+    Calibration *calibration; 
+    TemporalBinner *binner; 
+    Pipeline *pipeline; 
+    TemporalEncoder *encoder; 
+    Telemetry *telemetry; 
+    CommandScheduler *scheduler; 
+    pthread_t drainThread; 
+    bool draining; 
     unsigned int cntr; 
     bool done;
 }CameraParameters_s; 
@@ -74,7 +166,7 @@ int main(int argc, char *argv[]) {
     cout << "Output file: " << programOpts.outputFile << endl; 
 
     /* Command-line arguments parsing */
-    while( (opt = getopt_long(argc, argv, "a:f:lo:i", longOpts, &longIndex)) != -1) {
+    while( (opt = getopt_long(argc, argv, "a:b:c:d:f:lm:n:o:ip:s:w:x:z:r:t:A:D:F:K:L:P:Q:R:T:V:", longOpts, &longIndex)) != -1) {
 
         switch (opt) {
             case 'a':
@@ -82,6 +174,32 @@ int main(int argc, char *argv[]) {
                 programOpts.outputDir = optarg;
                 break; 
 
+            /* Temporal binning: frames per stored frame, followed by :sum to store the sum */
+            case 'b':
+                programOpts.binFactor = strtoul(optarg, NULL, 10); 
+                programOpts.binMode   = (strstr(optarg, ":sum") != NULL) ? BINNING_SUM : BINNING_MEAN; 
+
+                if((programOpts.binFactor == 0) || (programOpts.binFactor > BINNER_MAX_FACTOR)) {
+                    cerr << "Invalid binning factor: " << optarg << endl; 
+                    exit(EXIT_FAILURE); 
+                }
+                break; 
+
+            /* Number of frames per commit to the disk (0: no commits) */
+            case 'c':
+                programOpts.commitFrames = strtoul(optarg, NULL, 10);
+                break; 
+
+            /* Maximum delay before a frame is committed to the disk, in milliseconds */
+            case 'T':
+                programOpts.commitDelay = strtoul(optarg, NULL, 10);
+                break; 
+
+            /* Number of frames per output subdirectory (0: single directory) */
+            case 'd':
+                programOpts.shardSize = strtoul(optarg, NULL, 10);
+                break; 
+
             /* Specify the output format */
             /** @todo Add validity checks */
             case 'f':
@@ -100,12 +218,130 @@ int main(int argc, char *argv[]) {
                 exit(displayCameraInformations()); 
                 break;
 
+            /* Calibration masters: dark.pgm:flat.pgm, either may be left empty */
+            case 'K': {
+                std::string masters = optarg; 
+                size_t colon = masters.find(':'); 
+                programOpts.darkFile = masters.substr(0, colon); 
+                programOpts.flatFile = (colon == std::string::npos) ? "" : masters.substr(colon + 1); 
+                break; 
+            }
+
+            /* Processing stages between the acquisition and the storage, see Pipeline */
+            case 'P':
+                programOpts.pipelineFile = optarg; 
+                break; 
+
+            /* Number of frames of a single acquisition */
+            case 'n':
+                programOpts.nframes = atoi(optarg);
+                break; 
+
+            /* Check the frames of a recording against their checksums and exit */
+            case 'V':
+                exit(verifyRecording(optarg)); 
+                break;
+
             /* Output file specification */
             case 'o':
                 programMode = SINGLE; 
                 programOpts.outputFile = optarg;
                 break; 
                
+            /* Compressed frame buffer size, in MiB */
+            case 'z':
+                programOpts.historySize = strtoul(optarg, NULL, 10) * 1024u * 1024u;
+                break; 
+
+            /* Ring buffer size, in images, or automatic sizing */
+            case 'r':
+                programOpts.ringSize = (strcmp(optarg, "auto") == 0) ? 0u : strtoul(optarg, NULL, 10);
+                break; 
+
+            /* Disk stall duration the ring buffer must absorb, in milliseconds */
+            case 't':
+                programOpts.burstTolerance = strtod(optarg, NULL) / 1000.0;
+                break; 
+
+            /* Acquisition framerate */
+            case 'F':
+                programOpts.framerate = strtod(optarg, NULL);
+                break; 
+
+            /* Number of writer threads */
+            case 'w':
+                programOpts.nbOfWriters = strtoul(optarg, NULL, 10);
+                break; 
+
+            /* PNG compression levels allowed to the adaptive compression (min:max) */
+            case 'L':
+                if(sscanf(optarg, "%d:%d", &programOpts.minCompression, &programOpts.maxCompression) != 2) {
+                    cerr << "Invalid compression levels: " << optarg << endl; 
+                    exit(EXIT_FAILURE); 
+                }
+                break; 
+
+            /* Live preview (downsampling factor:rate in Hz) */
+            case 'p':
+                if(sscanf(optarg, "%u:%lf", &programOpts.previewFactor, &programOpts.previewRate) != 2) {
+                    cerr << "Invalid preview settings: " << optarg << endl; 
+                    exit(EXIT_FAILURE); 
+                }
+                break; 
+
+            /* JPEG quick-look of every Nth stored frame (period[:quality[:scale]]), 
+             * the quality and scale also apply to the jpg output format */
+            case 'Q':
+                if((sscanf(optarg, "%u:%d:%u", &programOpts.quicklookPeriod, &programOpts.quicklookQuality, 
+                           &programOpts.quicklookScale) < 1) || 
+                   (programOpts.quicklookScale == 0) || (programOpts.quicklookScale > JPEG_MAX_SCALE)) {
+                    cerr << "Invalid quick-look settings: " << optarg << endl; 
+                    exit(EXIT_FAILURE); 
+                }
+                break; 
+
+            /* RAM tier the frames land in before their migration to the output directory 
+             * (dir[:capacity in MiB[:migration rate in MB/s]]) */
+            case 'R': {
+                char dir[256]; 
+                unsigned long capacity = programOpts.tierCapacity / (1024u * 1024u); 
+                double rate = 0.0; 
+
+                if((sscanf(optarg, "%255[^:]:%lu:%lf", dir, &capacity, &rate) < 1) || (capacity == 0)) {
+                    cerr << "Invalid tier settings: " << optarg << endl; 
+                    exit(EXIT_FAILURE); 
+                }
+                programOpts.tierDir = dir; 
+                programOpts.tierCapacity = capacity * 1024u * 1024u; 
+                programOpts.migrationRate = rate * 1e6; 
+                break; 
+            }
+
+            /* Export the ring buffer in shared memory, under the given name */
+            case 'x':
+                programOpts.sharedName = optarg;
+                break; 
+
+            /* Telemetry period, in milliseconds (0 disables the telemetry) */
+            case 'm':
+                programOpts.telemetryPeriod = strtoul(optarg, NULL, 10);
+                break; 
+
+            /* Serial command link */
+            case 's':
+                programOpts.serialPort = optarg;
+                break; 
+
+            /* Raw archive of every frame, written along with the selected format */
+            case 'A':
+                programOpts.archiveFile = optarg;
+                break; 
+
+            /* Preparation time of the timed orders, in milliseconds */
+            case 'D':
+                programOpts.leadTime = strtod(optarg, NULL) / 1000.0;
+                break; 
+
             /* Missing argument to an option */
             case ':':
                 cerr << "Invalid option." << endl; 
@@ -145,6 +381,16 @@ int main(int argc, char *argv[]) {
         programOpts.format = BMP; 
     }
 
+    /* Lossy, for quick-looks rather than science frames */
+    else if((programOpts.fileExtension == "jpg") || (programOpts.fileExtension == "jpeg")) {
+        programOpts.format = JPG; 
+    }
+
+    /* Single stream of the frames coded against each other */
+    else if(programOpts.fileExtension == "tdc") {
+        programOpts.format = TDC; 
+    }
+
     else {
         cerr << "Invalid file extension: " << programOpts.fileExtension << "\ncannot specify the output format. " << endl;
         exit(EXIT_FAILURE); 
@@ -161,9 +407,32 @@ int main(int argc, char *argv[]) {
         while(!cp.done)
             ;
         
+        delete cp.scheduler; 
+        delete cp.telemetry; 
+        cp.telemetry = NULL; 
         delete cp.c; 
         delete cp.rxpipe;
+        delete cp.rxserial; 
+        delete cp.bus; 
+        delete cp.preview; 
+        delete cp.calibration; 
+        delete cp.binner; 
+        delete cp.pipeline; 
+        delete cp.writers; 
+        delete cp.encoder; 
+        delete cp.compression; 
         delete cp.rb; 
+        delete cp.shared; 
+        delete cp.sizer; 
+        delete cp.tier; 
+        delete cp.flusher; 
+        delete cp.journal; 
+        delete cp.output; 
+        delete cp.history; 
+
+        if(cp.archiveFd >= 0) {
+            close(cp.archiveFd); 
+        }
     }
 
     else {
@@ -173,13 +442,105 @@ int main(int argc, char *argv[]) {
     exit(EXIT_SUCCESS); 
 }
 
+/** @brief Orders come from the pipe, the serial link and the scheduler. */
+static pthread_mutex_t ordersLock = PTHREAD_MUTEX_INITIALIZER; 
+
 static void orderProcessing(char orders[], int size) {
     
-    switch(orders[size-1]) {
+    /* Timed order, prepared and executed by the scheduler */
+    if(orders[0] == '@') {
+        char order; 
+        clockid_t clock; 
+        double time; 
+
+        if(CommandScheduler::parse(orders, size, &order, &clock, &time) && 
+           cp.scheduler->schedule(order, clock, time)) {
+            std::cout << "Order " << order << " scheduled." << std::endl; 
+        }
+        else {
+            std::cerr << "Invalid timed order." << std::endl; 
+        }
+        return; 
+    }
+
+    /* Binning factor change (B<factor>), from the next stored frame */
+    if(orders[0] == 'B') {
+        std::string factor(orders + 1, size - 1); 
+
+        if((cp.binner != NULL) && cp.binner->setFactor(strtoul(factor.c_str(), NULL, 10))) {
+            std::cout << "Binning factor: " << cp.binner->getFactor() << std::endl; 
+        }
+        else {
+            std::cerr << "Invalid binning order." << std::endl; 
+        }
+        return; 
+    }
+
+    prepareOrder(orders[size-1]); 
+    executeOrder(orders[size-1]); 
+}
+
+static void prepareOrder(char order) {
+
+    pthread_mutex_lock(&ordersLock); 
+
+    if(order == 'G') {
+        /* The order may come from the scheduler at any time: nothing is resized or replaced 
+         * while the camera fills the ring and submits frames, nor before the frames in 
+         * flight are written */
+        cp.c->stop(); 
+        cp.writers->drain(); 
+
+        if(cp.pipeline != NULL) {
+            cp.pipeline->drain(); 
+        }
+
+        /* Adapt the ring buffer to the current write latency and free memory */
+        if(cp.sizer != NULL) {
+            size_t size = cp.sizer->computeSize(cp.rb->getSize()); 
+
+            /* The slots being freed must not stay registered with the camera */
+            if(size != cp.rb->getSize()) {
+                cp.c->release(); 
+                cp.rb->resize(size); 
+            }
+            std::cout << "Ring buffer size: " << cp.rb->getSize() << " images." << std::endl; 
+        }
+
+        /* The writers may hold every ring slot */
+        if(cp.writers->getCapacity() != cp.rb->getSize()) {
+            delete cp.writers; 
+            cp.writers = createWriters(); 
+        }
+
+        if((cp.pipeline != NULL) && (cp.pipeline->getCapacity() < cp.rb->getSize() + PIPELINE_CAPACITY)) {
+            delete cp.pipeline; 
+            cp.pipeline = createPipeline(); 
+        }
+
+        try {
+            cp.c->prepare(cp.rb, &saveFrames); 
+        }
+
+        catch(UEye_Exception const &e) {
+    
+            cerr << "Camera " << e.camera() << ": " << e.what() <<
+                "\nException ID: " << e.id() << endl;
+        }
+    }
+
+    pthread_mutex_unlock(&ordersLock); 
+}
+
+static void executeOrder(char order) {
+
+    pthread_mutex_lock(&ordersLock); 
+
+    switch(order) {
         case 'G':
-            std::cout << "The experiment has STARTED." << std::endl;
             try {
-                cp.c->start(cp.rb, &saveImage); 
+                cp.c->start(cp.rb, &saveFrames); 
+                std::cout << "The experiment has STARTED." << std::endl;
             }
 
             catch(UEye_Exception const &e) {
@@ -188,8 +549,74 @@ static void orderProcessing(char orders[], int size) {
                     "\nException ID: " << e.id() << endl;
             }
             break; 
+        /* Pause: stop the acquisition until the next 'G' order */
+        case 'P':
+            cp.c->stop(); 
+            cp.writers->drain(); 
+
+            if(cp.pipeline != NULL) {
+                cp.pipeline->drain(); 
+            }
+
+            if(cp.preview != NULL) {
+                cp.preview->clear(); 
+            }
+
+            /* Frames after the pause do not belong to the same bin */
+            if(cp.binner != NULL) {
+                cp.binner->restart(); 
+            }
+
+            if(cp.pipeline != NULL) {
+                cp.pipeline->restart(); 
+            }
+            std::cout << "The experiment is PAUSED." << std::endl; 
+
+            if(cp.flusher != NULL) {
+                cp.flusher->commit(); 
+            }
+
+            if(cp.encoder != NULL) {
+                cp.encoder->sync(); 
+            }
+
+            if(cp.sizer != NULL) {
+                cp.sizer->calibrate(programOpts.outputDir); 
+            }
+            break; 
+
         case 'S':
             cp.c->stop(); 
+            cp.writers->drain(); 
+
+            if(cp.pipeline != NULL) {
+                cp.pipeline->drain(); 
+            }
+
+            if(cp.preview != NULL) {
+                cp.preview->clear(); 
+            }
+
+            /* Write the frames still held by the compressed buffer, once: 
+             * the order may come from several sources */
+            if((cp.history != NULL) && cp.draining) {
+                cp.history->close(); 
+                pthread_join(cp.drainThread, NULL); 
+                cp.draining = false; 
+            }
+
+            if(cp.flusher != NULL) {
+                cp.flusher->commit(); 
+            }
+
+            /* Every frame reaches the output directory before the end */
+            if(cp.tier != NULL) {
+                cp.tier->flush(); 
+            }
+
+            if(cp.encoder != NULL) {
+                cp.encoder->sync(); 
+            }
             std::cout << "The experiment is OVER." << std::endl; 
             cp.done = true;
             break;
@@ -197,33 +624,540 @@ static void orderProcessing(char orders[], int size) {
         default:
             break; 
     }
+
+    pthread_mutex_unlock(&ordersLock); 
 }
 
-static void saveImage(char *buffer) {
+static void saveFrames(const FrameBatch_s *batch) {
 
-    std::string filename = programOpts.outputDir + "/image";
-    string_appendInt(filename, cp.cntr);
-    
-    filename += programOpts.fileExtension; 
+    /* Frames overwritten in the camera ring before the event thread could deliver them */
+    if(batch->lost > 0) {
+        std::cout << batch->lost << " frames lost before frame " << batch->sequences[0] << "!" << std::endl; 
+        if(cp.telemetry != NULL) {
+            cp.telemetry->frameDropped((uint32_t) batch->lost); 
+        }
+    }
+
+    /* The camera may run as many frames ahead before the next delivery */
+    if(cp.shared != NULL) {
+        cp.shared->extendGuard(batch->count + 1u); 
+    }
+
+    for(unsigned int incr = 0; incr < batch->count; incr++) {
+        saveImage(batch->buffers[incr]); 
+    }
+}
+
+static void saveImage(char *buffer) {
 
     Image *i = cp.rb->getImageFromBuffer(buffer);
-    if(i->isBeingWritten()) {
+
+    /* Every consumer gets the corrected frame */
+    if(cp.calibration != NULL) {
+        cp.calibration->apply(i); 
+    }
+
+    if(cp.preview != NULL) {
+        cp.preview->offer(i); 
+    }
+
+    if(cp.shared != NULL) {
+        cp.shared->publish(i->getImageBuffer(), cp.cntr); 
+    }
+
+    if(cp.telemetry != NULL) {
+        cp.telemetry->frameAcquired(); 
+    }
+
+    /* Configured processing: the stages store the frames */
+    if(cp.pipeline != NULL) {
+        if(cp.pipeline->isPending(i) || !cp.pipeline->submit(i, cp.cntr, getMonotonicTime())) {
+            std::cout << "Ring buffer overflow!" << std::endl; 
+            if(cp.telemetry != NULL) {
+                cp.telemetry->frameDropped(); 
+            }
+        }
+        cp.cntr++; 
+        updateTelemetry(); 
+        return; 
+    }
+
+    /* Temporal binning: only complete bins are stored */
+    if(cp.binner != NULL) {
+        unsigned long dropped = cp.binner->getDropped(); 
+
+        i = cp.binner->add(i); 
+        if(i == NULL) {
+            /* Every output frame is still held by the writers */
+            if(cp.binner->getDropped() != dropped) {
+                std::cout << "Binned frame " << cp.cntr << " dropped!" << std::endl; 
+                if(cp.telemetry != NULL) {
+                    cp.telemetry->frameDropped(); 
+                }
+                cp.cntr++; 
+            }
+            return; 
+        }
+    }
+
+    /* Frames are compressed right away to release the ring slot, the drain thread stores them */
+    if(cp.history != NULL) {
+        if(!cp.history->push(i, cp.cntr)) {
+            std::cout << "Frame " << cp.cntr << " does not fit in the compressed buffer!" << std::endl; 
+            if(cp.telemetry != NULL) {
+                cp.telemetry->frameDropped(); 
+            }
+        }
+        cp.cntr++; 
+        updateTelemetry(); 
+        return; 
+    }
+
+    /* The slot was overwritten before its previous frame could be written */
+    if(cp.writers->isPending(i) || !cp.writers->submit(i, cp.cntr)) {
         std::cout << "Ring buffer overflow!" << std::endl; 
+        if(cp.telemetry != NULL) {
+            cp.telemetry->frameDropped(); 
+        }
     }
-    i->writeToPGM(filename.c_str()); 
     cp.cntr++; 
+    updateTelemetry(); 
+}
+
+static void storeImage(Image *i, unsigned int frame) {
+
+    double start = getMonotonicTime(); 
+
+    if((programOpts.quicklookPeriod > 0) && (frame % programOpts.quicklookPeriod == 0)) {
+        writeQuicklook(i, frame); 
+    }
+
+    /* Temporal stream: the frames are appended to it in the order they come */
+    if(cp.encoder != NULL) {
+        if(!cp.encoder->add(i, frame)) {
+            std::cerr << "Could not code frame " << frame << std::endl; 
+            if(cp.telemetry != NULL) {
+                cp.telemetry->frameDropped(); 
+            }
+            return; 
+        }
+
+        if(cp.telemetry != NULL) {
+            cp.telemetry->frameStored(getMonotonicTime() - start); 
+            updateTelemetry(); 
+        }
+        return; 
+    }
+
+    /* With a tier, the frame lands in RAM and is migrated later */
+    FILE *fp = (cp.tier != NULL) ? cp.tier->openFile(frame) : cp.output->openFile(frame); 
+
+    if(fp == NULL) {
+        std::cerr << "Could not create " << cp.output->getFilename(frame) << std::endl; 
+        if(cp.telemetry != NULL) {
+            cp.telemetry->frameDropped(); 
+        }
+        return; 
+    }
+
+    size_t bytes = 0; 
+    switch(programOpts.format) {
+        /* Compression effort adapted to the writers backlog */
+        case PNG: {
+            int level = cp.compression->update(getBufferOccupancy()); 
+            bytes = i->writeToPNG(fp, NULL, level, CompressionController::getFilters(level));
+            break; 
+        }
+        case JPG: 
+            bytes = i->writeToJPEG(fp, programOpts.quicklookQuality, programOpts.quicklookScale); 
+            break; 
+        /* BMP is not supported yet, keep the raw data */
+        case PGM: 
+        default: 
+            bytes = i->writeToPGM(fp); 
+            break; 
+    }
+
+    bool written = (bytes > 0) && !ferror(fp); 
+    if(!written) {
+        std::cerr << "Could not write " << cp.output->getFilename(frame) << std::endl; 
+    }
+
+    /* The flusher, or the migrator, closes the file once it is committed to the disk. 
+     * A frame that could not be written is never journaled. */
+    if(cp.tier != NULL) {
+        cp.tier->add(frame, fp, written); 
+    }
+    else if(cp.flusher != NULL) {
+        cp.flusher->add(frame, fp, written); 
+    }
+    else {
+        fclose(fp); 
+    }
+
+    if(cp.telemetry != NULL) {
+        if(written) {
+            cp.telemetry->frameStored(getMonotonicTime() - start); 
+        }
+        else {
+            cp.telemetry->frameDropped(); 
+        }
+        updateTelemetry(); 
+    }
+}
+
+static void archiveImage(Image *i, unsigned int frame) {
+
+    /* Each record is the frame number followed by the raw pixels. Appending both 
+     * with a single call keeps the records whole when several writers archive frames. */
+    struct iovec record[2]; 
+    record[0].iov_base = &frame; 
+    record[0].iov_len  = sizeof(frame); 
+    record[1].iov_base = i->getImageBuffer(); 
+    record[1].iov_len  = i->getWidth() * i->getHeight(); 
+
+    if(writev(cp.archiveFd, record, 2) != (ssize_t) (record[0].iov_len + record[1].iov_len)) {
+        std::cerr << "Could not archive frame " << frame << std::endl; 
+    }
+}
+
+static void writeQuicklook(Image *i, unsigned int frame) {
+
+    /* Written aside and renamed, so that the downlink never sends a partial file */
+    char name[64]; 
+    snprintf(name, sizeof(name), "/quicklooks/image%010u.jpg", frame); 
+    std::string path = programOpts.outputDir + name; 
+    std::string temporary = path + ".tmp"; 
+
+    if((i->writeToJPEG(temporary.c_str(), programOpts.quicklookQuality, programOpts.quicklookScale) == 0) || 
+       (rename(temporary.c_str(), path.c_str()) != 0)) {
+        std::cerr << "Could not write the quick-look of frame " << frame << std::endl; 
+        remove(temporary.c_str()); 
+    }
+}
+
+static WriterPool * createWriters(void) {
+
+    /* The temporal stream codes each frame against the previous one: a single writer keeps them in order */
+    unsigned int nbOfWriters = (cp.encoder != NULL) ? 1u : programOpts.nbOfWriters; 
+
+    /* Each frame is handed to every output at once, the slot is released by the last one */
+    WriterPool *writers = new WriterPool(nbOfWriters, cp.rb->getSize(), &storeImage); 
+
+    if(cp.archiveFd >= 0) {
+        writers->addSink(&archiveImage); 
+    }
+
+    return writers; 
+}
+
+static Calibration * loadCalibration(void) {
+
+    if(programOpts.darkFile.empty() && programOpts.flatFile.empty()) {
+        return NULL; 
+    }
+
+    Calibration *calibration = new Calibration(800u, 600u); 
+
+    if(!calibration->load(programOpts.darkFile, programOpts.flatFile)) {
+        std::cerr << "Could not load the calibration frames " << programOpts.darkFile << " " << 
+                     programOpts.flatFile << std::endl; 
+        delete calibration; 
+        return NULL; 
+    }
+
+    std::cout << "Calibration: " << calibration->getNbOfDefects() << " defective pixels." << std::endl; 
+
+    return calibration; 
+}
+
+static PipelineStage * createStoreStage(const std::string &name, const std::string &input, 
+                                        const Pipeline::Parameters_t &parameters) {
+    (void) parameters; 
+
+    /* The temporal stream codes each frame against the previous one */
+    return new SinkStage(name, input, &storeImage, cp.encoder != NULL); 
+}
+
+static PipelineStage * createArchiveStage(const std::string &name, const std::string &input, 
+                                          const Pipeline::Parameters_t &parameters) {
+    (void) parameters; 
+    return (cp.archiveFd >= 0) ? new SinkStage(name, input, &archiveImage) : NULL; 
+}
+
+static Pipeline * createPipeline(void) {
+
+    /* Every ring slot may be held, along with the images created by the stages. The frames
+     * of a temporal stream keep the acquisition order through a single thread. */
+    unsigned int nbOfThreads = (cp.encoder != NULL) ? 1u : 0u; 
+    Pipeline *pipeline = new Pipeline(nbOfThreads, cp.rb->getSize() + PIPELINE_CAPACITY); 
+
+    registerStandardStages(pipeline); 
+    pipeline->registerType("store", &createStoreStage); 
+    pipeline->registerType("archive", &createArchiveStage); 
+
+    if(!pipeline->load(programOpts.pipelineFile)) {
+        std::cerr << programOpts.pipelineFile << ": " << pipeline->getError() << std::endl; 
+        exit(EXIT_FAILURE); 
+    }
+
+    std::cout << "Pipeline: " << pipeline->getNbOfStages() << " stages." << std::endl; 
+
+    return pipeline; 
+}
+
+static double getBufferOccupancy(void) {
+
+    if(cp.history != NULL) {
+        return (double) cp.history->getUsedBytes() / (double) cp.history->getCapacity(); 
+    }
+
+    if(cp.pipeline != NULL) {
+        return (double) cp.pipeline->getBacklog() / (double) cp.pipeline->getCapacity(); 
+    }
+
+    return (double) cp.writers->getBacklog() / (double) cp.rb->getSize(); 
+}
+
+static void updateTelemetry(void) {
+
+    if(cp.telemetry == NULL) {
+        return; 
+    }
+
+    size_t backlog = (cp.history != NULL) ? cp.history->getCount() : 
+                     (cp.pipeline != NULL) ? cp.pipeline->getBacklog() : cp.writers->getBacklog(); 
+    cp.telemetry->setBuffers(cp.rb->getSize(), getBufferOccupancy(), backlog); 
+}
+
+static bool isBinPending(const Image *output) {
+
+    return cp.writers->isPending(output); 
+}
+
+static void * drainHistory(void *arg) {
+
+    (void) arg; 
+
+    Image *i = new Image(800u, 600u); 
+    unsigned int frame = 0u; 
+
+    while(cp.history->pop(i, &frame)) {
+        storeImage(i, frame); 
+
+        if(cp.archiveFd >= 0) {
+            archiveImage(i, frame); 
+        }
+    }
+
+    if(cp.history->getEvicted() > 0) {
+        std::cout << cp.history->getEvicted() << " frames were lost in the compressed buffer." << std::endl; 
+    }
+
+    delete i; 
+    return NULL; 
+}
+
+static void createRingBuffer(size_t ringSize) {
+
+    /* Other processes read the frames in place, see SharedRing */
+    cp.shared = NULL; 
+    if(!programOpts.sharedName.empty()) {
+        cp.shared = new SharedRing(programOpts.sharedName, 800u, 600u, ringSize); 
+
+        if(!cp.shared->isOpen()) {
+            std::cerr << "Could not create the shared memory " << programOpts.sharedName << std::endl; 
+            delete cp.shared; 
+            cp.shared = NULL; 
+        }
+    }
+
+    if(cp.shared != NULL) {
+        cp.rb = new RingBuffer(cp.shared); 
+    }
+    else {
+        cp.rb = new RingBuffer(800u, 600u, ringSize); 
+    }
+}
+
+static void * prepareStorage(void *arg) {
+
+    (void) arg; 
+
+    /* Automatic sizing: calibrate the write latency of the output directory, 
+     * the ring buffer size also depends on the camera framerate */
+    if(cp.sizer != NULL) {
+        if(cp.sizer->calibrate(programOpts.outputDir) < 0.0) {
+            std::cerr << "Could not calibrate the write latency of " << programOpts.outputDir << std::endl; 
+        }
+    }
+    else {
+        createRingBuffer(programOpts.ringSize); 
+    }
+
+    cp.output = new OutputDirectory(programOpts.outputDir, programOpts.fileExtension, programOpts.shardSize); 
+    if(!cp.output->isOpen()) {
+        std::cerr << "Could not open the output directory " << programOpts.outputDir << std::endl; 
+    }
+
+    /* Frames left in the tier by a crash are moved first, the journal then checks them */
+    if(!programOpts.tierDir.empty()) {
+        if(!createDirectory(programOpts.tierDir)) {
+            std::cerr << "Could not create the tier directory " << programOpts.tierDir << std::endl; 
+        }
+
+        unsigned int moved = TieredStorage::recover(programOpts.tierDir, cp.output); 
+        if(moved > 0) {
+            std::cout << "Recovery: " << moved << " frames moved from the tier." << std::endl; 
+        }
+    }
+
+    /* Remove the frames left partial by a crash, and never overwrite committed frames */
+    cp.journal = new FrameJournal(programOpts.outputDir + "/frames.journal"); 
+    unsigned int removed = cp.journal->recover(programOpts.outputDir); 
+    if(removed > 0) {
+        std::cout << "Recovery: " << removed << " partial frames removed." << std::endl; 
+    }
+    cp.cntr = cp.journal->getNextFrame(); 
+
+    return NULL; 
 }
 
 static void prepareForAcquisition(void) {
 
+    cp.sizer = NULL; 
+    if(programOpts.ringSize == 0) {
+        cp.sizer = new RingSizer(800u, 600u); 
+        cp.sizer->setBurstTolerance(programOpts.burstTolerance); 
+    }
+
+    /* The ring buffer memory is locked and the output directory recovered 
+     * while the camera initializes */
+    pthread_t storageThread; 
+    pthread_create(&storageThread, NULL, &prepareStorage, NULL); 
+
     cp.c  = new UEye_Camera(1);
     cp.c->setAreaOfInterest(0, 0, 800u, 600u);
 
-    cp.rb = new RingBuffer(800u, 600u, 10); 
-    cp.cntr = 0u;
+    if(programOpts.framerate > 0.0) {
+        cp.c->setFramerate(programOpts.framerate); 
+    }
+
+    pthread_join(storageThread, NULL); 
+
+    if(cp.sizer != NULL) {
+        cp.sizer->setFramerate(cp.c->getFramerate()); 
+        createRingBuffer(cp.sizer->computeSize()); 
+    }
+
+    /* The migrator commits the frames by batches of the flusher settings */
+    cp.tier = NULL; 
+    cp.flusher = NULL; 
+    if(!programOpts.tierDir.empty() && (programOpts.format != TDC)) {
+        cp.tier = new TieredStorage(programOpts.tierDir, programOpts.fileExtension, cp.output, cp.journal, 
+                                    programOpts.tierCapacity, 
+                                    (programOpts.commitFrames > 0) ? programOpts.commitFrames : 64u, 
+                                    programOpts.commitDelay, programOpts.migrationRate); 
+
+        if(!cp.tier->isOpen()) {
+            std::cerr << "Could not open the tier directory " << programOpts.tierDir << std::endl; 
+            delete cp.tier; 
+            cp.tier = NULL; 
+        }
+    }
+
+    if((cp.tier == NULL) && (programOpts.commitFrames > 0)) {
+        cp.flusher = new Flusher(cp.journal, cp.output, programOpts.commitFrames, programOpts.commitDelay); 
+    }
+
+    cp.compression = new CompressionController(programOpts.minCompression, programOpts.maxCompression); 
+    cp.archiveFd = -1; 
+    if(!programOpts.archiveFile.empty()) {
+        cp.archiveFd = open(programOpts.archiveFile.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644); 
+
+        if(cp.archiveFd < 0) {
+            std::cerr << "Could not open the archive " << programOpts.archiveFile << std::endl; 
+        }
+    }
+
+    if((programOpts.quicklookPeriod > 0) && !createDirectory(programOpts.outputDir + "/quicklooks")) {
+        std::cerr << "Could not create the quick-look directory" << std::endl; 
+    }
+
+    cp.encoder = NULL; 
+    if(programOpts.format == TDC) {
+        cp.encoder = new TemporalEncoder(800u, 600u); 
+
+        if(!cp.encoder->open(programOpts.outputDir + "/frames.tdc")) {
+            std::cerr << "Could not open the stream " << programOpts.outputDir << "/frames.tdc" << std::endl; 
+            exit(EXIT_FAILURE); 
+        }
+
+        /* The stream frames are not journaled: carry on from the last one appended */
+        TemporalDecoder stream; 
+        if(stream.open(programOpts.outputDir + "/frames.tdc") && (stream.getNbOfFrames() > 0)) {
+            unsigned int next = stream.getRecord(stream.getNbOfFrames() - 1).frame + 1u; 
+            if(next > cp.cntr) {
+                cp.cntr = next; 
+            }
+        }
+    }
+
+    cp.writers = createWriters(); 
+
+    cp.history = NULL; 
+    cp.draining = false; 
+    if(programOpts.historySize > 0) {
+        cp.history = new CompressedRing(programOpts.historySize); 
+        cp.draining = (pthread_create(&cp.drainThread, NULL, &drainHistory, NULL) == 0); 
+    }
+
+    cp.calibration = loadCalibration(); 
+
+    cp.binner = NULL; 
+    if(programOpts.binFactor > 0) {
+        /* Enough output frames for a full writer backlog, the writers hold them until written */
+        cp.binner = new TemporalBinner(800u, 600u, programOpts.binFactor, programOpts.binMode, 
+                                       cp.writers->getCapacity() + 1u); 
+        cp.binner->setPendingCheck(&isBinPending); 
+    }
+
+    cp.pipeline = NULL; 
+    if(!programOpts.pipelineFile.empty()) {
+        cp.pipeline = createPipeline(); 
+    }
+
+    cp.preview = NULL; 
+    if(programOpts.previewFactor > 0) {
+        cp.preview = new Preview(800u, 600u, programOpts.previewFactor, programOpts.previewRate, 
+                                 "/tmp/cwis_preview.pgm"); 
+    }
+
+    /* Status records for the ground segment, the reader may come and go */
+    cp.telemetry = NULL; 
+    if(programOpts.telemetryPeriod > 0) {
+        cp.telemetry = new Telemetry("/tmp/camera_tm.p", programOpts.telemetryPeriod, programOpts.outputDir); 
+        updateTelemetry(); 
+    }
+
+    cp.scheduler = new CommandScheduler(&prepareOrder, &executeOrder, programOpts.leadTime); 
 
     cp.rxpipe = new RXPipe("/tmp/camera_pipe.p", &orderProcessing);
     cp.rxpipe->start(); 
+
+    cp.bus      = NULL; 
+    cp.rxserial = NULL; 
+    if(!programOpts.serialPort.empty()) {
+        cp.bus = new I2CBus(programOpts.serialPort); 
+
+        if(!cp.bus->isOpen()) {
+            std::cerr << "Could not open the serial port " << programOpts.serialPort << std::endl; 
+        }
+        else {
+            cp.rxserial = new RXThread(cp.bus, &orderProcessing); 
+            cp.rxserial->start(); 
+        }
+    }
 }
 
 static int displayCameraInformations(void) {
@@ -234,6 +1168,21 @@ static int displayCameraInformations(void) {
     return EXIT_SUCCESS; 
 }
 
+static int verifyRecording(const char *directory) {
+
+    RecordingVerifier verifier(directory); 
+    unsigned int corrupt = verifier.verify(); 
+
+    for(size_t incr = 0; incr < verifier.getCorrupt().size(); incr++) {
+        cout << "Corrupt: " << verifier.getCorrupt()[incr] << endl; 
+    }
+
+    cout << verifier.getValid() << " valid, " << corrupt << " corrupt, " << 
+            verifier.getUnchecked() << " without checksum." << endl; 
+
+    return (corrupt == 0) ? EXIT_SUCCESS : EXIT_FAILURE; 
+}
+
 static int listConnectedCameras(void) {
 
     UEYE_CAMERA_LIST *camList = NULL;
@@ -281,32 +1230,90 @@ static void singleAcquisition(const char *filename) {
 
     cout << "Frames: " << programOpts.nframes << endl; 
 
-    Image *i = new Image(800u, 600u);
+    unsigned int count = (programOpts.nframes > 1) ? programOpts.nframes : 1u; 
+    /* The framerate option spaces the frames of a burst */
+    double interval = (programOpts.framerate > 0.0) ? 1.0 / programOpts.framerate : 0.0; 
+
+    Image **images      = new Image *[count]; 
+    double *timestamps  = new double[count]; 
+    bool captured       = true; 
+
+    for(unsigned int incr = 0; incr < count; incr++) {
+        images[incr] = new Image(800u, 600u);
+    }
+
     UEye_Camera *c = new UEye_Camera(1);
 
     c->setAreaOfInterest(0, 0, 800, 600);
     try {
-        c->capture(i); 
+        c->captureBurst(images, count, interval, timestamps); 
     }
 
     catch(UEye_Exception const &e) {
         
         cerr << "Camera " << e.camera() << ": " << e.what() <<
                 "\nException ID: " << e.id() << endl;
+        captured = false; 
     }
 
-    switch(programOpts.format) {
-        case PNG: 
-            i->writeToPNG(filename);
-            break; 
-        case PGM: 
-            i->writeToPGM(filename); 
-            break; 
-        default: 
-            break; 
+    Calibration *calibration = captured ? loadCalibration() : NULL; 
+
+    /* The frames of a burst go into a single stream */
+    TemporalEncoder *encoder = NULL; 
+    if(captured && (programOpts.format == TDC)) {
+        encoder = new TemporalEncoder(800u, 600u); 
+
+        if(!encoder->open(filename)) {
+            cerr << "Could not open the stream " << filename << endl; 
+            captured = false; 
+        }
     }
 
-    delete i; 
+    for(unsigned int incr = 0; captured && (incr < count); incr++) {
+
+        if(calibration != NULL) {
+            calibration->apply(images[incr]); 
+        }
+
+        if(encoder != NULL) {
+            encoder->add(images[incr], incr); 
+            continue; 
+        }
+
+        /* Bursts: number the files before their extension (image_3.png) */
+        string name = filename; 
+        if(count > 1) {
+            size_t dot = name.find_last_of('.'); 
+            string suffix = "_"; 
+            string_appendInt(suffix, incr); 
+            name.insert((dot == string::npos) ? name.size() : dot, suffix); 
+
+            cout << name << ": +" << (timestamps[incr] - timestamps[0]) * 1000.0 << " ms" << endl; 
+        }
+
+        switch(programOpts.format) {
+            case PNG: 
+                images[incr]->writeToPNG(name.c_str());
+                break; 
+            case PGM: 
+                images[incr]->writeToPGM(name.c_str()); 
+                break; 
+            case JPG: 
+                images[incr]->writeToJPEG(name.c_str(), programOpts.quicklookQuality, programOpts.quicklookScale); 
+                break; 
+            default: 
+                break; 
+        }
+    }
+
+    for(unsigned int incr = 0; incr < count; incr++) {
+        delete images[incr]; 
+    }
+
+    delete [] images; 
+    delete [] timestamps; 
+    delete encoder; 
+    delete calibration; 
     delete c; 
 
     return; 
@@ -319,6 +1326,34 @@ static inline void setDefaults(void) {
     programOpts.outputDir = "images"; 
     programOpts.detectExtension = false; 
     programOpts.format = PNG; 
+    programOpts.historySize = 0; 
+    programOpts.ringSize = 10; 
+    programOpts.framerate = 0.0; 
+    programOpts.burstTolerance = 0.5; 
+    programOpts.shardSize = 10000u; 
+    programOpts.commitFrames = 64u; 
+    programOpts.commitDelay = 1000u; 
+    programOpts.nbOfWriters = 2u; 
+    programOpts.minCompression = 1; 
+    programOpts.maxCompression = 9; 
+    programOpts.previewFactor = 0u; 
+    programOpts.previewRate = 2.0; 
+    programOpts.sharedName = ""; 
+    programOpts.telemetryPeriod = 500u; 
+    programOpts.serialPort = ""; 
+    programOpts.leadTime = 1.0; 
+    programOpts.archiveFile = ""; 
+    programOpts.darkFile = ""; 
+    programOpts.flatFile = ""; 
+    programOpts.binFactor = 0u; 
+    programOpts.binMode = BINNING_MEAN; 
+    programOpts.pipelineFile = ""; 
+    programOpts.quicklookPeriod = 0u; 
+    programOpts.quicklookQuality = JPEG_DEFAULT_QUALITY; 
+    programOpts.quicklookScale = 1u; 
+    programOpts.tierDir = ""; 
+    programOpts.tierCapacity = TIER_DEFAULT_CAPACITY; 
+    programOpts.migrationRate = 0.0; 
 
     programMode = SINGLE; 
 }
@@ -0,0 +1,267 @@
+/**
+ * @file output_directory.cpp
+ * @brief Frame output directory class implementation.
+ */
+
+#include "output_directory.hpp"
+#include "utilities.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <string.h>
+#include <errno.h>
+
+/** @brief Number of digits of a frame number in a file name. */
+#define OUTPUT_FRAME_DIGITS     (10u)
+/** @brief Number of digits of a shard directory name. */
+#define OUTPUT_SHARD_DIGITS     (6u)
+
+/** @brief File name buffer of the calling thread. */
+static __thread char t_filename[OUTPUT_NAME_MAX]; 
+
+OutputDirectory::OutputDirectory(const std::string &path, const std::string &extension, unsigned int shardSize) : 
+        m_path(path), m_shardSize(shardSize), m_prepared(0), m_target(0), m_stop(false) {
+
+    this->m_extension = "." + extension; 
+    this->m_dirfd = ::open(path.c_str(), O_RDONLY | O_DIRECTORY); 
+
+    for(unsigned int incr = 0; incr < OUTPUT_SHARD_WINDOW; incr++) {
+        this->m_shardFd[incr] = -1; 
+        this->m_shardId[incr] = 0; 
+    }
+
+    pthread_mutex_init(&this->m_lock, NULL); 
+    pthread_cond_init(&this->m_wakeup, NULL); 
+
+    if((this->m_shardSize > 0) && (this->m_dirfd >= 0)) {
+
+        /* The first shard is needed right away, the next ones are created in the background */
+        this->installShard(0, this->createShard(0)); 
+        this->m_prepared = 1; 
+        this->m_target   = OUTPUT_SHARDS_AHEAD; 
+
+        pthread_create(&this->m_thread, NULL, &thread, this); 
+    }
+}
+
+OutputDirectory::~OutputDirectory() {
+
+    if((this->m_shardSize > 0) && (this->m_dirfd >= 0)) {
+        pthread_mutex_lock(&this->m_lock); 
+        this->m_stop = true; 
+        pthread_cond_signal(&this->m_wakeup); 
+        pthread_mutex_unlock(&this->m_lock); 
+
+        pthread_join(this->m_thread, NULL); 
+    }
+
+    for(unsigned int incr = 0; incr < OUTPUT_SHARD_WINDOW; incr++) {
+        if(this->m_shardFd[incr] >= 0) {
+            close(this->m_shardFd[incr]); 
+        }
+    }
+
+    if(this->m_dirfd >= 0) {
+        close(this->m_dirfd); 
+    }
+
+    pthread_cond_destroy(&this->m_wakeup); 
+    pthread_mutex_destroy(&this->m_lock); 
+}
+
+bool OutputDirectory::isOpen(void) const {
+
+    return (this->m_dirfd >= 0); 
+}
+
+const std::string & OutputDirectory::getPath(void) const {
+
+    return this->m_path; 
+}
+
+unsigned int OutputDirectory::getShardSize(void) const {
+
+    return this->m_shardSize; 
+}
+
+const char * OutputDirectory::getFilename(unsigned int frame) const {
+
+    char *c = t_filename; 
+
+    if(this->m_shardSize > 0) {
+        c = formatZeroPadded(c, frame / this->m_shardSize, OUTPUT_SHARD_DIGITS); 
+        *c++ = '/'; 
+    }
+
+    memcpy(c, "image", 5); 
+    c = formatZeroPadded(c + 5, frame, OUTPUT_FRAME_DIGITS); 
+
+    size_t length = this->m_extension.size(); 
+    size_t room   = OUTPUT_NAME_MAX - (size_t) (c - t_filename) - 1u; 
+    if(length > room) {
+        length = room; 
+    }
+    memcpy(c, this->m_extension.c_str(), length); 
+    c[length] = '\0'; 
+
+    return t_filename; 
+}
+
+int OutputDirectory::open(unsigned int frame) {
+
+    const char *filename = this->getFilename(frame); 
+    int dirfd = this->m_dirfd; 
+
+    /* Create the file relative to its shard: no lookup of the shard directory */
+    if(this->m_shardSize > 0) {
+        dirfd     = this->getShard(frame / this->m_shardSize); 
+        filename  = strchr(filename, '/') + 1; 
+    }
+
+    if(dirfd < 0) {
+        return -1; 
+    }
+
+    int fd = openat(dirfd, filename, O_WRONLY | O_CREAT | O_TRUNC, 0666); 
+
+    if(this->m_shardSize > 0) {
+        close(dirfd); 
+    }
+
+    return fd; 
+}
+
+FILE * OutputDirectory::openFile(unsigned int frame) {
+
+    int fd = this->open(frame); 
+
+    if(fd < 0) {
+        return NULL; 
+    }
+
+    FILE *fp = fdopen(fd, "wb"); 
+    if(fp == NULL) {
+        close(fd); 
+    }
+
+    return fp; 
+}
+
+void OutputDirectory::sync(void) {
+
+    int fds[OUTPUT_SHARD_WINDOW]; 
+    unsigned int nbOfFds = 0; 
+
+    /* Shards may be closed by other threads, synchronize copies of their descriptors */
+    pthread_mutex_lock(&this->m_lock); 
+    for(unsigned int incr = 0; incr < OUTPUT_SHARD_WINDOW; incr++) {
+        if(this->m_shardFd[incr] >= 0) {
+            fds[nbOfFds++] = dup(this->m_shardFd[incr]); 
+        }
+    }
+    pthread_mutex_unlock(&this->m_lock); 
+
+    for(unsigned int incr = 0; incr < nbOfFds; incr++) {
+        if(fds[incr] >= 0) {
+            fsync(fds[incr]); 
+            close(fds[incr]); 
+        }
+    }
+
+    if(this->m_dirfd >= 0) {
+        fsync(this->m_dirfd); 
+    }
+}
+
+int OutputDirectory::getShard(unsigned int shard) {
+
+    unsigned int index = shard % OUTPUT_SHARD_WINDOW; 
+
+    pthread_mutex_lock(&this->m_lock); 
+
+    /* The background thread is late: create the shard ourselves */
+    if((this->m_shardFd[index] < 0) || (this->m_shardId[index] != shard)) {
+        this->installShard(shard, this->createShard(shard)); 
+    }
+    /* Frames arrive out of order: the shard may leave the window, and its descriptor be 
+     * closed by another thread, before the file is created. Hand a copy over instead. */
+    int fd = (this->m_shardFd[index] >= 0) ? dup(this->m_shardFd[index]) : -1; 
+
+    /* Keep the next shards ready */
+    if(shard + OUTPUT_SHARDS_AHEAD > this->m_target) {
+        this->m_target = shard + OUTPUT_SHARDS_AHEAD; 
+        if(this->m_prepared < shard + 1) {
+            this->m_prepared = shard + 1; 
+        }
+        pthread_cond_signal(&this->m_wakeup); 
+    }
+
+    pthread_mutex_unlock(&this->m_lock); 
+
+    return fd; 
+}
+
+int OutputDirectory::createShard(unsigned int shard) const {
+
+    char name[OUTPUT_SHARD_DIGITS + 1]; 
+    *formatZeroPadded(name, shard, OUTPUT_SHARD_DIGITS) = '\0'; 
+
+    if((mkdirat(this->m_dirfd, name, 0777) != 0) && (errno != EEXIST)) {
+        return -1; 
+    }
+
+    return openat(this->m_dirfd, name, O_RDONLY | O_DIRECTORY); 
+}
+
+void OutputDirectory::installShard(unsigned int shard, int fd) {
+
+    unsigned int index = shard % OUTPUT_SHARD_WINDOW; 
+
+    /* Another thread was faster */
+    if((this->m_shardFd[index] >= 0) && (this->m_shardId[index] == shard)) {
+        if(fd >= 0) {
+            close(fd); 
+        }
+        return; 
+    }
+
+    /* Writers only use copies of the descriptors, see getShard() */
+    if(this->m_shardFd[index] >= 0) {
+        close(this->m_shardFd[index]); 
+    }
+
+    this->m_shardFd[index] = fd; 
+    this->m_shardId[index] = shard; 
+}
+
+void * OutputDirectory::thread(void *arg) {
+
+    OutputDirectory *dir = reinterpret_cast<OutputDirectory *>(arg); 
+
+    pthread_mutex_lock(&dir->m_lock); 
+
+    while(!dir->m_stop) {
+
+        if(dir->m_prepared > dir->m_target) {
+            pthread_cond_wait(&dir->m_wakeup, &dir->m_lock); 
+            continue; 
+        }
+
+        unsigned int shard = dir->m_prepared; 
+
+        /* Directory creation may be slow, do not block the writers meanwhile */
+        pthread_mutex_unlock(&dir->m_lock); 
+        int fd = dir->createShard(shard); 
+        pthread_mutex_lock(&dir->m_lock); 
+
+        dir->installShard(shard, fd); 
+        if(dir->m_prepared == shard) {
+            dir->m_prepared = shard + 1; 
+        }
+    }
+
+    pthread_mutex_unlock(&dir->m_lock); 
+
+    return NULL; 
+}
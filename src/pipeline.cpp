@@ -0,0 +1,515 @@
+/**
+ * @file pipeline.cpp
+ * @brief Frame-processing pipeline class implementations.
+ */
+
+#include "pipeline.hpp"
+
+#include <unistd.h>
+#include <stdlib.h>
+#include <fstream>
+#include <sstream>
+
+/** @brief Alignment of the scratch blocks. */
+#define PIPELINE_ALIGNMENT  (64u)
+
+PipelineContext::PipelineContext(Pipeline *pipeline) :
+        m_pipeline(pipeline), m_arena(NULL), m_arenaSize(0), m_used(0), m_requested(0) {
+}
+
+PipelineContext::~PipelineContext() {
+
+    this->reset();
+    free(this->m_arena);
+}
+
+void * PipelineContext::allocate(size_t size) {
+
+    size = (size + PIPELINE_ALIGNMENT - 1) & ~((size_t) PIPELINE_ALIGNMENT - 1);
+    this->m_requested += size;
+
+    if(this->m_used + size <= this->m_arenaSize) {
+        void *block = this->m_arena + this->m_used;
+        this->m_used += size;
+        return block;
+    }
+
+    /* The arena is too small for this call: separate block, the arena grows afterwards */
+    void *block = NULL;
+    if(posix_memalign(&block, PIPELINE_ALIGNMENT, size) != 0) {
+        return NULL;
+    }
+
+    this->m_overflow.push_back((unsigned char *) block);
+
+    return block;
+}
+
+Image * PipelineContext::createImage(unsigned int width, unsigned int height) {
+
+    return this->m_pipeline->createImage(this, width, height);
+}
+
+void PipelineContext::reset(void) {
+
+    for(size_t incr = 0; incr < this->m_overflow.size(); incr++) {
+        free(this->m_overflow[incr]);
+    }
+
+    if(!this->m_overflow.empty()) {
+        void *arena = NULL;
+        free(this->m_arena);
+        this->m_arena     = (posix_memalign(&arena, PIPELINE_ALIGNMENT, this->m_requested) == 0) ? (unsigned char *) arena : NULL;
+        this->m_arenaSize = (this->m_arena != NULL) ? this->m_requested : 0;
+    }
+
+    this->m_overflow.clear();
+    this->m_used      = 0;
+    this->m_requested = 0;
+}
+
+Pipeline::Pipeline(unsigned int nbOfThreads, size_t capacity) :
+        m_capacity(capacity), m_held(0), m_nbOfThreads(nbOfThreads), m_stop(false) {
+
+    if(this->m_capacity == 0) {
+        this->m_capacity = 1;
+    }
+    if(this->m_nbOfThreads == 0) {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        this->m_nbOfThreads = (cores > 0) ? (unsigned int) cores : 1u;
+    }
+    if(this->m_nbOfThreads > PIPELINE_MAX_THREADS) {
+        this->m_nbOfThreads = PIPELINE_MAX_THREADS;
+    }
+
+    this->m_slots    = new Slot_s[this->m_capacity];
+    this->m_threads  = new pthread_t[this->m_nbOfThreads];
+    this->m_contexts = new PipelineContext *[this->m_nbOfThreads];
+    this->m_args     = new ThreadArg_s[this->m_nbOfThreads];
+
+    for(size_t incr = 0; incr < this->m_capacity; incr++) {
+        this->m_slots[incr].references = 0;
+        this->m_slots[incr].reserved   = false;
+        this->m_slots[incr].pooled     = false;
+    }
+
+    pthread_mutex_init(&this->m_lock, NULL);
+    pthread_cond_init(&this->m_available, NULL);
+    pthread_cond_init(&this->m_released, NULL);
+
+    for(unsigned int incr = 0; incr < this->m_nbOfThreads; incr++) {
+        this->m_contexts[incr]   = new PipelineContext(this);
+        this->m_args[incr].pipeline = this;
+        this->m_args[incr].index    = incr;
+        pthread_create(&this->m_threads[incr], NULL, &thread, &this->m_args[incr]);
+    }
+}
+
+Pipeline::~Pipeline() {
+
+    this->drain();
+
+    pthread_mutex_lock(&this->m_lock);
+    this->m_stop = true;
+    pthread_cond_broadcast(&this->m_available);
+    pthread_mutex_unlock(&this->m_lock);
+
+    for(unsigned int incr = 0; incr < this->m_nbOfThreads; incr++) {
+        pthread_join(this->m_threads[incr], NULL);
+        delete this->m_contexts[incr];
+    }
+
+    for(size_t incr = 0; incr < this->m_stages.size(); incr++) {
+        delete this->m_stages[incr].stage;
+    }
+
+    for(size_t incr = 0; incr < this->m_pool.size(); incr++) {
+        delete this->m_pool[incr];
+    }
+
+    pthread_cond_destroy(&this->m_released);
+    pthread_cond_destroy(&this->m_available);
+    pthread_mutex_destroy(&this->m_lock);
+
+    delete [] this->m_args;
+    delete [] this->m_contexts;
+    delete [] this->m_threads;
+    delete [] this->m_slots;
+}
+
+void Pipeline::registerType(const std::string &type, Factory_t factory) {
+
+    this->m_factories[type] = factory;
+}
+
+bool Pipeline::addStage(PipelineStage *stage) {
+
+    std::vector<unsigned int> *readers = &this->m_sourceReaders;
+    int input = this->findStage(stage->getInput());
+
+    if((stage->getName() == PIPELINE_SOURCE) || (this->findStage(stage->getName()) >= 0)) {
+        this->m_error = "stage name " + stage->getName() + " already used";
+        delete stage;
+        return false;
+    }
+
+    if(input >= 0) {
+        readers = &this->m_stages[input].readers;
+    }
+    else if(stage->getInput() != PIPELINE_SOURCE) {
+        this->m_error = "unknown input " + stage->getInput() + " of stage " + stage->getName();
+        delete stage;
+        return false;
+    }
+
+    /* A stage modifying its input must be its only reader */
+    bool shared = !readers->empty() && (stage->isInPlace() || this->m_stages[readers->front()].stage->isInPlace());
+    if(shared) {
+        this->m_error = "stage " + stage->getName() + " shares its input with an in-place stage";
+        delete stage;
+        return false;
+    }
+
+    Stage_s entry;
+    entry.stage   = stage;
+    entry.running = 0;
+
+    pthread_mutex_lock(&this->m_lock);
+    readers->push_back(this->m_stages.size());
+    this->m_stages.push_back(entry);
+    pthread_mutex_unlock(&this->m_lock);
+
+    return true;
+}
+
+bool Pipeline::load(const std::string &filename) {
+
+    std::ifstream file(filename.c_str());
+
+    if(!file) {
+        this->m_error = "cannot read " + filename;
+        return false;
+    }
+
+    std::stringstream description;
+    description << file.rdbuf();
+
+    return this->parse(description.str());
+}
+
+bool Pipeline::parse(const std::string &description) {
+
+    std::istringstream lines(description);
+    std::string line;
+    unsigned int number = 0;
+
+    while(std::getline(lines, line)) {
+
+        number++;
+        line = line.substr(0, line.find('#'));
+
+        std::istringstream tokens(line);
+        std::string type, name, input, token;
+
+        if(!(tokens >> type)) {
+            continue;
+        }
+
+        std::ostringstream prefix;
+        prefix << "line " << number << ": ";
+
+        if(!(tokens >> name >> input)) {
+            this->m_error = prefix.str() + "expected a stage type, name and input";
+            return false;
+        }
+
+        Parameters_t parameters;
+        while(tokens >> token) {
+            size_t equal = token.find('=');
+            if(equal == std::string::npos) {
+                this->m_error = prefix.str() + "invalid parameter " + token;
+                return false;
+            }
+            parameters[token.substr(0, equal)] = token.substr(equal + 1);
+        }
+
+        std::map<std::string, Factory_t>::const_iterator factory = this->m_factories.find(type);
+        if(factory == this->m_factories.end()) {
+            this->m_error = prefix.str() + "unknown stage type " + type;
+            return false;
+        }
+
+        PipelineStage *stage = factory->second(name, input, parameters);
+        if(stage == NULL) {
+            this->m_error = prefix.str() + "invalid parameters of stage " + name;
+            return false;
+        }
+
+        if(!this->addStage(stage)) {
+            this->m_error = prefix.str() + this->m_error;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+const std::string & Pipeline::getError(void) const {
+
+    return this->m_error;
+}
+
+unsigned int Pipeline::getNbOfStages(void) const {
+
+    return this->m_stages.size();
+}
+
+bool Pipeline::submit(Image *image, unsigned int frame, double timestamp) {
+
+    pthread_mutex_lock(&this->m_lock);
+
+    long slot = this->reserveSlot();
+    if(slot < 0) {
+        pthread_mutex_unlock(&this->m_lock);
+        return false;
+    }
+
+    PipelineFrame_s acquired;
+    acquired.image     = image;
+    acquired.frame     = frame;
+    acquired.timestamp = timestamp;
+
+    this->m_slots[slot].pooled = false;
+    this->hand(slot, acquired, this->m_sourceReaders);
+
+    pthread_mutex_unlock(&this->m_lock);
+
+    return true;
+}
+
+bool Pipeline::isPending(const Image *image) {
+
+    bool pending = false;
+
+    pthread_mutex_lock(&this->m_lock);
+
+    for(size_t incr = 0; (incr < this->m_capacity) && !pending; incr++) {
+        pending = (this->m_slots[incr].references > 0) && !this->m_slots[incr].pooled &&
+                  (this->m_slots[incr].frame.image == image);
+    }
+
+    pthread_mutex_unlock(&this->m_lock);
+
+    return pending;
+}
+
+size_t Pipeline::getBacklog(void) {
+
+    pthread_mutex_lock(&this->m_lock);
+    size_t backlog = this->m_held;
+    pthread_mutex_unlock(&this->m_lock);
+
+    return backlog;
+}
+
+size_t Pipeline::getCapacity(void) const {
+
+    return this->m_capacity;
+}
+
+void Pipeline::drain(void) {
+
+    pthread_mutex_lock(&this->m_lock);
+
+    while(this->m_held > 0) {
+        pthread_cond_wait(&this->m_released, &this->m_lock);
+    }
+
+    pthread_mutex_unlock(&this->m_lock);
+}
+
+void Pipeline::restart(void) {
+
+    for(size_t incr = 0; incr < this->m_stages.size(); incr++) {
+        this->m_stages[incr].stage->restart();
+    }
+}
+
+int Pipeline::findStage(const std::string &name) const {
+
+    for(size_t incr = 0; incr < this->m_stages.size(); incr++) {
+        if(this->m_stages[incr].stage->getName() == name) {
+            return (int) incr;
+        }
+    }
+
+    return -1;
+}
+
+long Pipeline::reserveSlot(void) {
+
+    if(this->m_held == this->m_capacity) {
+        return -1;
+    }
+
+    /* Slots are released out of order, look for a free one */
+    size_t slot = 0;
+    while((this->m_slots[slot].references > 0) || this->m_slots[slot].reserved) {
+        slot++;
+    }
+
+    this->m_slots[slot].reserved = true;
+    this->m_held++;
+
+    return (long) slot;
+}
+
+void Pipeline::dispatch(size_t slot, const PipelineFrame_s &frame, const std::vector<unsigned int> &readers) {
+
+    Job_s job;
+    job.slot  = slot;
+    job.frame = frame;
+
+    for(size_t incr = 0; incr < readers.size(); incr++) {
+        this->m_stages[readers[incr]].queue.push_back(job);
+        this->m_slots[slot].references++;
+    }
+
+    pthread_cond_broadcast(&this->m_available);
+}
+
+void Pipeline::hand(size_t slot, const PipelineFrame_s &frame, const std::vector<unsigned int> &readers) {
+
+    this->m_slots[slot].reserved    = false;
+    this->m_slots[slot].frame.image = frame.image;
+    this->dispatch(slot, frame, readers);
+
+    /* Nobody reads it */
+    if(this->m_slots[slot].references == 0) {
+        this->freeSlot(slot);
+    }
+}
+
+void Pipeline::release(size_t slot) {
+
+    this->m_slots[slot].references--;
+    if(this->m_slots[slot].references == 0) {
+        this->freeSlot(slot);
+    }
+}
+
+void Pipeline::freeSlot(size_t slot) {
+
+    if(this->m_slots[slot].pooled) {
+        this->m_pool.push_back(this->m_slots[slot].frame.image);
+    }
+
+    this->m_held--;
+    pthread_cond_broadcast(&this->m_released);
+}
+
+Image * Pipeline::createImage(PipelineContext *context, unsigned int width, unsigned int height) {
+
+    pthread_mutex_lock(&this->m_lock);
+
+    long slot = this->reserveSlot();
+    if(slot < 0) {
+        pthread_mutex_unlock(&this->m_lock);
+        return NULL;
+    }
+
+    Image *image = NULL;
+    for(size_t incr = 0; incr < this->m_pool.size(); incr++) {
+        if((this->m_pool[incr]->getWidth() == width) && (this->m_pool[incr]->getHeight() == height)) {
+            image = this->m_pool[incr];
+            this->m_pool[incr] = this->m_pool.back();
+            this->m_pool.pop_back();
+            break;
+        }
+    }
+
+    /* Pool images of other sizes are kept: the stages usually create a single size */
+    if(image == NULL) {
+        image = new Image(width, height);
+    }
+
+    this->m_slots[slot].pooled      = true;
+    this->m_slots[slot].frame.image = image;
+    context->m_created.push_back(slot);
+
+    pthread_mutex_unlock(&this->m_lock);
+
+    return image;
+}
+
+void * Pipeline::thread(void *arg) {
+
+    ThreadArg_s *threadArg = reinterpret_cast<ThreadArg_s *>(arg);
+    Pipeline *pipeline = threadArg->pipeline;
+    PipelineContext *context = pipeline->m_contexts[threadArg->index];
+
+    pthread_mutex_lock(&pipeline->m_lock);
+
+    while(true) {
+
+        /* Stages further down first, so that the frames leave the pipeline early */
+        int index = -1;
+        for(int incr = (int) pipeline->m_stages.size() - 1; (incr >= 0) && (index < 0); incr--) {
+            Stage_s &stage = pipeline->m_stages[incr];
+            if(!stage.queue.empty() && !(stage.stage->isSerial() && (stage.running > 0))) {
+                index = incr;
+            }
+        }
+
+        if(index < 0) {
+            if(pipeline->m_stop) {
+                break;
+            }
+            pthread_cond_wait(&pipeline->m_available, &pipeline->m_lock);
+            continue;
+        }
+
+        Stage_s &stage = pipeline->m_stages[index];
+        Job_s job = stage.queue.front();
+        stage.queue.pop_front();
+        stage.running++;
+
+        PipelineFrame_s frame = job.frame;
+
+        pthread_mutex_unlock(&pipeline->m_lock);
+        bool handed = stage.stage->process(&frame, context);
+        context->reset();
+        pthread_mutex_lock(&pipeline->m_lock);
+
+        stage.running--;
+
+        /* Created images are handed downstream, or go back to the pool */
+        for(size_t incr = 0; incr < context->m_created.size(); incr++) {
+            size_t created = context->m_created[incr];
+
+            if(handed && (frame.image == pipeline->m_slots[created].frame.image)) {
+                pipeline->hand(created, frame, stage.readers);
+            }
+            else {
+                pipeline->m_slots[created].reserved = false;
+                pipeline->freeSlot(created);
+            }
+        }
+
+        /* The input frame goes on: the readers share the slot */
+        if(handed && (frame.image == job.frame.image)) {
+            pipeline->dispatch(job.slot, frame, stage.readers);
+        }
+
+        pipeline->release(job.slot);
+
+        context->m_created.clear();
+
+        /* A serial stage may run again */
+        pthread_cond_broadcast(&pipeline->m_available);
+    }
+
+    pthread_mutex_unlock(&pipeline->m_lock);
+
+    return NULL;
+}
@@ -0,0 +1,274 @@
+/**
+ * @file pipeline_stages.cpp
+ * @brief Standard frame-processing pipeline stages implementations.
+ */
+
+#include "pipeline_stages.hpp"
+
+#include <iostream>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+/** @brief Frame size of the stages when not given. */
+#define STAGE_WIDTH     (800u)
+#define STAGE_HEIGHT    (600u)
+
+/**
+ * @brief Reads an unsigned parameter.
+ * @returns @p false if the parameter is not a number.
+ */
+static bool getParameter(const Pipeline::Parameters_t &parameters, const std::string &key,
+                         unsigned int defaultValue, unsigned int *value) {
+
+    Pipeline::Parameters_t::const_iterator parameter = parameters.find(key);
+
+    if(parameter == parameters.end()) {
+        *value = defaultValue;
+        return true;
+    }
+
+    char *end = NULL;
+    *value = strtoul(parameter->second.c_str(), &end, 10);
+
+    return !parameter->second.empty() && (*end == '\0');
+}
+
+/** @brief Reads a string parameter, empty if not given. */
+static std::string getParameter(const Pipeline::Parameters_t &parameters, const std::string &key) {
+
+    Pipeline::Parameters_t::const_iterator parameter = parameters.find(key);
+
+    return (parameter == parameters.end()) ? "" : parameter->second;
+}
+
+CalibrationStage::CalibrationStage(const std::string &name, const std::string &input, Calibration *calibration) :
+        PipelineStage(name, input), m_calibration(calibration) {
+}
+
+CalibrationStage::~CalibrationStage() {
+
+    delete this->m_calibration;
+}
+
+bool CalibrationStage::process(PipelineFrame_s *frame, PipelineContext *context) {
+
+    (void) context;
+
+    return this->m_calibration->apply(frame->image);
+}
+
+BinningStage::BinningStage(const std::string &name, const std::string &input, TemporalBinner *binner) :
+        PipelineStage(name, input), m_binner(binner) {
+}
+
+BinningStage::~BinningStage() {
+
+    delete this->m_binner;
+}
+
+bool BinningStage::process(PipelineFrame_s *frame, PipelineContext *context) {
+
+    if(!this->m_binner->push(frame->image)) {
+        return false;
+    }
+
+    /* No room for the bin: it is lost, the next one starts anyway */
+    Image *output = context->createImage(frame->image->getWidth(), frame->image->getHeight());
+    if(output == NULL) {
+        return false;
+    }
+
+    this->m_binner->getBin(output);
+
+    /* The frame keeps the number of the frame completing the bin */
+    frame->image = output;
+
+    return true;
+}
+
+void BinningStage::restart(void) {
+
+    this->m_binner->restart();
+}
+
+CropStage::CropStage(const std::string &name, const std::string &input, unsigned int x, unsigned int y,
+                     unsigned int width, unsigned int height) :
+        PipelineStage(name, input), m_x(x), m_y(y), m_width(width), m_height(height) {
+}
+
+bool CropStage::process(PipelineFrame_s *frame, PipelineContext *context) {
+
+    const Image *input = frame->image;
+
+    if((this->m_x + this->m_width > input->getWidth()) || (this->m_y + this->m_height > input->getHeight())) {
+        return false;
+    }
+
+    Image *output = context->createImage(this->m_width, this->m_height);
+    if(output == NULL) {
+        return false;
+    }
+
+    for(unsigned int row = 0; row < this->m_height; row++) {
+        memcpy(output->getImageBuffer() + (size_t) row * this->m_width,
+               input->getImageBuffer() + (size_t) (this->m_y + row) * input->getWidth() + this->m_x,
+               this->m_width);
+    }
+
+    frame->image = output;
+
+    return true;
+}
+
+StatsStage::StatsStage(const std::string &name, const std::string &input, unsigned int period) :
+        PipelineStage(name, input), m_period(period), m_min(0), m_max(0), m_mean(0.0) {
+
+    pthread_mutex_init(&this->m_lock, NULL);
+}
+
+StatsStage::~StatsStage() {
+
+    pthread_mutex_destroy(&this->m_lock);
+}
+
+bool StatsStage::process(PipelineFrame_s *frame, PipelineContext *context) {
+
+    const unsigned char *pixels = (const unsigned char *) frame->image->getImageBuffer();
+    size_t size = (size_t) frame->image->getWidth() * frame->image->getHeight();
+
+    /* Histogram in the scratch arena, the extremes and the mean follow from it */
+    uint32_t *histogram = (uint32_t *) context->allocate(256 * sizeof(uint32_t));
+    if(histogram == NULL) {
+        return true;
+    }
+
+    memset(histogram, 0, 256 * sizeof(uint32_t));
+    for(size_t incr = 0; incr < size; incr++) {
+        histogram[pixels[incr]]++;
+    }
+
+    unsigned int min = 255;
+    unsigned int max = 0;
+    uint64_t sum = 0;
+
+    for(unsigned int value = 0; value < 256; value++) {
+        if(histogram[value] > 0) {
+            min = (value < min) ? value : min;
+            max = value;
+            sum += (uint64_t) histogram[value] * value;
+        }
+    }
+
+    double mean = (size > 0) ? (double) sum / (double) size : 0.0;
+
+    pthread_mutex_lock(&this->m_lock);
+    this->m_min  = min;
+    this->m_max  = max;
+    this->m_mean = mean;
+    pthread_mutex_unlock(&this->m_lock);
+
+    if((this->m_period > 0) && ((frame->frame % this->m_period) == 0)) {
+        std::cout << this->getName() << ": frame " << frame->frame << " min " << min << " max " << max <<
+                     " mean " << mean << std::endl;
+    }
+
+    return true;
+}
+
+void StatsStage::getLast(unsigned int *min, unsigned int *max, double *mean) const {
+
+    pthread_mutex_lock(&this->m_lock);
+    *min  = this->m_min;
+    *max  = this->m_max;
+    *mean = this->m_mean;
+    pthread_mutex_unlock(&this->m_lock);
+}
+
+SinkStage::SinkStage(const std::string &name, const std::string &input, void (*sink)(Image *, unsigned int),
+                     bool serial) :
+        PipelineStage(name, input), m_sink(sink), m_serial(serial) {
+}
+
+bool SinkStage::process(PipelineFrame_s *frame, PipelineContext *context) {
+
+    (void) context;
+
+    this->m_sink(frame->image, frame->frame);
+
+    return true;
+}
+
+static PipelineStage * createCalibrationStage(const std::string &name, const std::string &input,
+                                              const Pipeline::Parameters_t &parameters) {
+
+    unsigned int width, height;
+
+    if(!getParameter(parameters, "width", STAGE_WIDTH, &width) ||
+       !getParameter(parameters, "height", STAGE_HEIGHT, &height)) {
+        return NULL;
+    }
+
+    Calibration *calibration = new Calibration(width, height);
+
+    if(!calibration->load(getParameter(parameters, "dark"), getParameter(parameters, "flat"))) {
+        delete calibration;
+        return NULL;
+    }
+
+    return new CalibrationStage(name, input, calibration);
+}
+
+static PipelineStage * createBinningStage(const std::string &name, const std::string &input,
+                                          const Pipeline::Parameters_t &parameters) {
+
+    unsigned int width, height, factor;
+    std::string mode = getParameter(parameters, "mode");
+
+    if(!getParameter(parameters, "width", STAGE_WIDTH, &width) ||
+       !getParameter(parameters, "height", STAGE_HEIGHT, &height) ||
+       !getParameter(parameters, "factor", 0, &factor) ||
+       (factor == 0) || (factor > BINNER_MAX_FACTOR) ||
+       (!mode.empty() && (mode != "mean") && (mode != "sum"))) {
+        return NULL;
+    }
+
+    /* Bins are written into pooled images, the binner needs no output frame of its own */
+    TemporalBinner *binner = new TemporalBinner(width, height, factor, (mode == "sum") ? BINNING_SUM : BINNING_MEAN, 1);
+
+    return new BinningStage(name, input, binner);
+}
+
+static PipelineStage * createCropStage(const std::string &name, const std::string &input,
+                                       const Pipeline::Parameters_t &parameters) {
+
+    unsigned int x, y, width, height;
+
+    if(!getParameter(parameters, "x", 0, &x) || !getParameter(parameters, "y", 0, &y) ||
+       !getParameter(parameters, "width", 0, &width) || !getParameter(parameters, "height", 0, &height) ||
+       (width == 0) || (height == 0)) {
+        return NULL;
+    }
+
+    return new CropStage(name, input, x, y, width, height);
+}
+
+static PipelineStage * createStatsStage(const std::string &name, const std::string &input,
+                                        const Pipeline::Parameters_t &parameters) {
+
+    unsigned int period;
+
+    if(!getParameter(parameters, "every", STATS_PERIOD, &period)) {
+        return NULL;
+    }
+
+    return new StatsStage(name, input, period);
+}
+
+void registerStandardStages(Pipeline *pipeline) {
+
+    pipeline->registerType("calibrate", &createCalibrationStage);
+    pipeline->registerType("bin", &createBinningStage);
+    pipeline->registerType("crop", &createCropStage);
+    pipeline->registerType("stats", &createStatsStage);
+}
@@ -5,21 +5,95 @@
 
 #include "pipes/tx_pipe.hpp"
 
-TXPipe::TXPipe(const std::string &pipefile) {
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/stat.h>
 
-    this->m_pipe = new std::filebuf; 
-    this->m_pipe->open(pipefile.c_str(), std::ios_base::out); 
+TXPipe::TXPipe(const std::string &pipefile, bool nonBlocking) : 
+        m_pipefile(pipefile), m_fd(-1), m_nonBlocking(nonBlocking) {
+
+    this->connect(); 
 }
 
 TXPipe::~TXPipe() {
 
-    this->m_pipe->close(); 
-    delete this->m_pipe; 
+    if(this->m_fd >= 0) {
+        close(this->m_fd); 
+    }
 }
 
-void TXPipe::send(const char *data, int dataSize) {
+bool TXPipe::isConnected(void) const {
+
+    return this->m_fd >= 0; 
+}
+
+int TXPipe::send(const char *data, int dataSize) {
     
-    this->m_pipe->sputn(data, dataSize);
-    this->m_pipe->pubsync(); 
+    if(!this->connect()) {
+        return -1; 
+    }
+
+    /* A reader that went away raises SIGPIPE in the writing thread: block it and
+     * consume it, the error is reported by write() anyway */
+    sigset_t sigpipe; 
+    sigset_t previous; 
+    sigemptyset(&sigpipe); 
+    sigaddset(&sigpipe, SIGPIPE); 
+    pthread_sigmask(SIG_BLOCK, &sigpipe, &previous); 
+
+    int written = 0; 
+
+    while(written < dataSize) {
+        ssize_t n = write(this->m_fd, data + written, dataSize - written); 
+
+        if(n > 0) {
+            written += n; 
+            continue; 
+        }
+
+        if((n < 0) && (errno == EINTR)) {
+            continue; 
+        }
+
+        if((n < 0) && (errno == EPIPE)) {
+            struct timespec zero = {0, 0}; 
+            sigtimedwait(&sigpipe, NULL, &zero); 
+
+            close(this->m_fd); 
+            this->m_fd = -1; 
+            written = (written > 0) ? written : -1; 
+        }
+
+        /* Pipe full (non-blocking mode) or other error */
+        break; 
+    }
+
+    pthread_sigmask(SIG_SETMASK, &previous, NULL); 
+
+    return written; 
 }
 
+bool TXPipe::connect(void) {
+
+    if(this->m_fd >= 0) {
+        return true; 
+    }
+
+    if(!this->m_nonBlocking) {
+        this->m_fd = open(this->m_pipefile.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644); 
+        return this->m_fd >= 0; 
+    }
+
+    /* Fails with ENXIO as long as nobody reads the pipe */
+    this->m_fd = open(this->m_pipefile.c_str(), O_WRONLY | O_NONBLOCK); 
+
+    if((this->m_fd < 0) && (errno == ENOENT)) {
+        mkfifo(this->m_pipefile.c_str(), 0644); 
+        this->m_fd = open(this->m_pipefile.c_str(), O_WRONLY | O_NONBLOCK); 
+    }
+
+    return this->m_fd >= 0; 
+}
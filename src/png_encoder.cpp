@@ -0,0 +1,370 @@
+/**
+ * @file png_encoder.cpp
+ * @brief Grayscale PNG encoder class implementation.
+ */
+
+#include "png_encoder.hpp"
+#include "crc32c.hpp"
+#include <png.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/** @brief zlib memory level (default value). */
+#define ENCODER_MEMLEVEL    (8)
+
+/** @brief Highest compression level using the run-length strategy. */
+#define ENCODER_RLE_LEVEL   (3)
+
+/** @brief Number of PNG row filters. */
+#define ENCODER_NB_FILTERS  (5)
+
+/** @brief PNG file signature. */
+static const unsigned char s_signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+
+/** @brief @p PNG_FILTER_* flag of each row filter type. */
+static const int s_filterFlags[ENCODER_NB_FILTERS] = {
+    PNG_FILTER_NONE, PNG_FILTER_SUB, PNG_FILTER_UP, PNG_FILTER_AVG, PNG_FILTER_PAETH
+};
+
+pthread_key_t PngEncoder::s_key;
+pthread_once_t PngEncoder::s_once = PTHREAD_ONCE_INIT;
+
+/** @brief Stores @p x in big-endian order. */
+static inline void storeBigEndian(unsigned char *dst, unsigned long x) {
+
+    dst[0] = (unsigned char) (x >> 24);
+    dst[1] = (unsigned char) (x >> 16);
+    dst[2] = (unsigned char) (x >> 8);
+    dst[3] = (unsigned char) x;
+}
+
+/** @brief Paeth predictor of the PNG specification. */
+static inline unsigned char paeth(int a, int b, int c) {
+
+    int pa = abs(b - c);
+    int pb = abs(a - c);
+    int pc = abs(a + b - 2 * c);
+
+    if((pa <= pb) && (pa <= pc)) {
+        return (unsigned char) a;
+    }
+
+    return (unsigned char) ((pb <= pc) ? b : c);
+}
+
+PngEncoder::PngEncoder(void) :
+        m_filtered(NULL), m_filteredSize(0), m_compressed(NULL), m_compressedSize(0),
+        m_candidates(NULL), m_zero(NULL), m_rowSize(0), m_checksum(0) {
+
+    memset(&this->m_deflate, 0, sizeof(this->m_deflate));
+
+    /** @todo Throw an exception if the stream cannot be allocated */
+    deflateInit2(&this->m_deflate, Z_DEFAULT_COMPRESSION, Z_DEFLATED, MAX_WBITS, ENCODER_MEMLEVEL, Z_FILTERED);
+}
+
+PngEncoder::~PngEncoder() {
+
+    deflateEnd(&this->m_deflate);
+    delete [] this->m_filtered;
+    delete [] this->m_compressed;
+    delete [] this->m_candidates;
+    delete [] this->m_zero;
+}
+
+size_t PngEncoder::write(FILE *fp, const pixel_t *pixels, unsigned int width, unsigned int height,
+                         int level, int filters, const char *title) {
+
+    size_t rowSize  = width + 1;
+    size_t dataSize = rowSize * height;
+
+    if((width == 0) || (height == 0)) {
+        return 0;
+    }
+
+    if(filters < 0) {
+        filters = PNG_ALL_FILTERS;
+    }
+    if((filters & PNG_ALL_FILTERS) == 0) {
+        filters = PNG_FILTER_NONE;
+    }
+
+    /* Buffers are only reallocated when the frame size grows */
+    if(dataSize > this->m_filteredSize) {
+        delete [] this->m_filtered;
+        delete [] this->m_compressed;
+        this->m_filteredSize   = dataSize;
+        this->m_filtered       = new unsigned char[dataSize];
+        this->m_compressedSize = deflateBound(&this->m_deflate, dataSize);
+        this->m_compressed     = new unsigned char[this->m_compressedSize];
+    }
+
+    if(width > this->m_rowSize) {
+        delete [] this->m_candidates;
+        delete [] this->m_zero;
+        this->m_rowSize    = width;
+        this->m_candidates = new unsigned char[ENCODER_NB_FILTERS * width];
+        this->m_zero       = new unsigned char[width];
+        memset(this->m_zero, 0, width);
+    }
+
+    /* Filter the rows straight from the frame buffer */
+    const unsigned char *in = (const unsigned char *) pixels;
+    this->m_checksum = crc32c(0, in, (size_t) width * height);
+
+    for(unsigned int y = 0; y < height; y++) {
+
+        const unsigned char *row      = in + (size_t) y * width;
+        const unsigned char *previous = (y > 0) ? row - width : this->m_zero;
+        unsigned char *dst            = this->m_filtered + (size_t) y * rowSize;
+
+        int best = -1;
+        unsigned long bestCost = 0;
+
+        for(int type = 0; type < ENCODER_NB_FILTERS; type++) {
+
+            if((filters & s_filterFlags[type]) == 0) {
+                continue;
+            }
+
+            unsigned char *candidate = this->m_candidates + type * width;
+            unsigned long cost = filterRow((PngRowFilter_e) type, row, previous, width, candidate);
+
+            if((best < 0) || (cost < bestCost)) {
+                best     = type;
+                bestCost = cost;
+            }
+        }
+
+        dst[0] = (unsigned char) best;
+        memcpy(dst + 1, this->m_candidates + best * width, width);
+    }
+
+    /* The whole image is compressed at once */
+    if(level < 0) {
+        level = Z_DEFAULT_COMPRESSION;
+    }
+
+    /* At the fast levels, run-length coding is both faster and tighter on our dark frames */
+    int strategy = (filters == PNG_FILTER_NONE) ? Z_DEFAULT_STRATEGY : Z_FILTERED;
+    if((level > 0) && (level <= ENCODER_RLE_LEVEL)) {
+        strategy = Z_RLE;
+    }
+
+    deflateReset(&this->m_deflate);
+    deflateParams(&this->m_deflate, level, strategy);
+
+    this->m_deflate.next_in   = this->m_filtered;
+    this->m_deflate.avail_in  = dataSize;
+    this->m_deflate.next_out  = this->m_compressed;
+    this->m_deflate.avail_out = this->m_compressedSize;
+
+    if(deflate(&this->m_deflate, Z_FINISH) != Z_STREAM_END) {
+        return 0;
+    }
+
+    size_t compressedSize = this->m_compressedSize - this->m_deflate.avail_out;
+
+    /* Header: 8-bit colour depth, black and white, no interlacing */
+    unsigned char header[13];
+    storeBigEndian(header, width);
+    storeBigEndian(header + 4, height);
+    header[8]  = 8;
+    header[9]  = PNG_COLOR_TYPE_GRAY;
+    header[10] = PNG_COMPRESSION_TYPE_BASE;
+    header[11] = PNG_FILTER_TYPE_BASE;
+    header[12] = PNG_INTERLACE_NONE;
+
+    size_t bytes = fwrite(s_signature, 1, sizeof(s_signature), fp);
+    bytes += writeChunk(fp, "IHDR", header, sizeof(header));
+
+    if(title != NULL) {
+        size_t titleSize  = strlen(title);
+        unsigned char *text = new unsigned char[6 + titleSize];
+        memcpy(text, "Title", 6);
+        memcpy(text + 6, title, titleSize);
+        bytes += writeChunk(fp, "tEXt", text, 6 + titleSize);
+        delete [] text;
+    }
+
+    /* Private chunk: CRC32C of the raw pixels, checked by the RecordingVerifier */
+    unsigned char checksum[4];
+    storeBigEndian(checksum, this->m_checksum);
+    bytes += writeChunk(fp, PNG_CHECKSUM_CHUNK, checksum, sizeof(checksum));
+
+    bytes += writeChunk(fp, "IDAT", this->m_compressed, compressedSize);
+    bytes += writeChunk(fp, "IEND", NULL, 0);
+
+    return bytes;
+}
+
+uint32_t PngEncoder::getChecksum(void) const {
+
+    return this->m_checksum;
+}
+
+unsigned long PngEncoder::filterRow(PngRowFilter_e type, const unsigned char *row,
+                                    const unsigned char *previous, size_t width, unsigned char *dst) {
+
+    size_t x = 0;
+    unsigned long cost = 0;
+
+    /* The first pixel has no left neighbour: its left and upper left pixels are 0 */
+    switch(type) {
+        case PNG_ROW_NONE:
+            memcpy(dst, row, width);
+            break;
+
+        case PNG_ROW_SUB:
+            dst[0] = row[0];
+            x = 1;
+#ifdef __SSE2__
+            for(; x + 16 <= width; x += 16) {
+                __m128i current = _mm_loadu_si128((const __m128i *) (row + x));
+                __m128i left    = _mm_loadu_si128((const __m128i *) (row + x - 1));
+                _mm_storeu_si128((__m128i *) (dst + x), _mm_sub_epi8(current, left));
+            }
+#endif
+            for(; x < width; x++) {
+                dst[x] = (unsigned char) (row[x] - row[x - 1]);
+            }
+            break;
+
+        case PNG_ROW_UP:
+#ifdef __SSE2__
+            for(; x + 16 <= width; x += 16) {
+                __m128i current = _mm_loadu_si128((const __m128i *) (row + x));
+                __m128i up      = _mm_loadu_si128((const __m128i *) (previous + x));
+                _mm_storeu_si128((__m128i *) (dst + x), _mm_sub_epi8(current, up));
+            }
+#endif
+            for(; x < width; x++) {
+                dst[x] = (unsigned char) (row[x] - previous[x]);
+            }
+            break;
+
+        case PNG_ROW_AVG:
+            dst[0] = (unsigned char) (row[0] - (previous[0] >> 1));
+            x = 1;
+#ifdef __SSE2__
+            for(; x + 16 <= width; x += 16) {
+                __m128i current = _mm_loadu_si128((const __m128i *) (row + x));
+                __m128i left    = _mm_loadu_si128((const __m128i *) (row + x - 1));
+                __m128i up      = _mm_loadu_si128((const __m128i *) (previous + x));
+                /* _mm_avg_epu8 rounds up, PNG rounds down */
+                __m128i odd     = _mm_and_si128(_mm_xor_si128(left, up), _mm_set1_epi8(1));
+                __m128i average = _mm_sub_epi8(_mm_avg_epu8(left, up), odd);
+                _mm_storeu_si128((__m128i *) (dst + x), _mm_sub_epi8(current, average));
+            }
+#endif
+            for(; x < width; x++) {
+                dst[x] = (unsigned char) (row[x] - ((row[x - 1] + previous[x]) >> 1));
+            }
+            break;
+
+        case PNG_ROW_PAETH:
+            dst[0] = (unsigned char) (row[0] - previous[0]);
+            x = 1;
+#ifdef __SSE2__
+            {
+                const __m128i zero = _mm_setzero_si128();
+
+                for(; x + 8 <= width; x += 8) {
+                    __m128i a = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *) (row + x - 1)), zero);
+                    __m128i b = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *) (previous + x)), zero);
+                    __m128i c = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *) (previous + x - 1)), zero);
+
+                    __m128i bc = _mm_sub_epi16(b, c);
+                    __m128i ac = _mm_sub_epi16(a, c);
+                    __m128i pa = _mm_max_epi16(bc, _mm_sub_epi16(zero, bc));
+                    __m128i pb = _mm_max_epi16(ac, _mm_sub_epi16(zero, ac));
+                    __m128i pc = _mm_add_epi16(bc, ac);
+                    pc = _mm_max_epi16(pc, _mm_sub_epi16(zero, pc));
+
+                    /* a if pa <= pb and pa <= pc, else b if pb <= pc, else c */
+                    __m128i notA = _mm_or_si128(_mm_cmpgt_epi16(pa, pb), _mm_cmpgt_epi16(pa, pc));
+                    __m128i notB = _mm_cmpgt_epi16(pb, pc);
+                    __m128i bOrC = _mm_or_si128(_mm_andnot_si128(notB, b), _mm_and_si128(notB, c));
+                    __m128i pred = _mm_or_si128(_mm_andnot_si128(notA, a), _mm_and_si128(notA, bOrC));
+
+                    __m128i current = _mm_loadl_epi64((const __m128i *) (row + x));
+                    _mm_storel_epi64((__m128i *) (dst + x), _mm_sub_epi8(current, _mm_packus_epi16(pred, zero)));
+                }
+            }
+#endif
+            for(; x < width; x++) {
+                dst[x] = (unsigned char) (row[x] - paeth(row[x - 1], previous[x], previous[x - 1]));
+            }
+            break;
+    }
+
+    /* Cost: sum of the absolute values, the bytes being taken as signed */
+    x = 0;
+#ifdef __SSE2__
+    {
+        __m128i sum = _mm_setzero_si128();
+
+        for(; x + 16 <= width; x += 16) {
+            __m128i v = _mm_loadu_si128((const __m128i *) (dst + x));
+            __m128i magnitude = _mm_min_epu8(v, _mm_sub_epi8(_mm_setzero_si128(), v));
+            sum = _mm_add_epi64(sum, _mm_sad_epu8(magnitude, _mm_setzero_si128()));
+        }
+
+        cost = (unsigned long) _mm_cvtsi128_si32(sum) + (unsigned long) _mm_cvtsi128_si32(_mm_srli_si128(sum, 8));
+    }
+#endif
+    for(; x < width; x++) {
+        cost += (dst[x] < 128) ? dst[x] : 256 - dst[x];
+    }
+
+    return cost;
+}
+
+size_t PngEncoder::writeChunk(FILE *fp, const char *type, const unsigned char *data, size_t size) {
+
+    unsigned char header[8];
+    unsigned char footer[4];
+
+    storeBigEndian(header, size);
+    memcpy(header + 4, type, 4);
+
+    uLong crc = crc32(0L, header + 4, 4);
+    if(size > 0) {
+        crc = crc32(crc, data, size);
+    }
+    storeBigEndian(footer, crc);
+
+    size_t bytes = fwrite(header, 1, sizeof(header), fp);
+    if(size > 0) {
+        bytes += fwrite(data, 1, size, fp);
+    }
+    bytes += fwrite(footer, 1, sizeof(footer), fp);
+
+    return bytes;
+}
+
+PngEncoder * PngEncoder::getThreadEncoder(void) {
+
+    pthread_once(&s_once, &createKey);
+
+    PngEncoder *encoder = reinterpret_cast<PngEncoder *>(pthread_getspecific(s_key));
+
+    if(encoder == NULL) {
+        encoder = new PngEncoder();
+        pthread_setspecific(s_key, encoder);
+    }
+
+    return encoder;
+}
+
+void PngEncoder::createKey(void) {
+
+    pthread_key_create(&s_key, &destroy);
+}
+
+void PngEncoder::destroy(void *encoder) {
+
+    delete reinterpret_cast<PngEncoder *>(encoder);
+}
@@ -0,0 +1,238 @@
+/**
+ * @file preview.cpp
+ * @brief Live preview class implementation.
+ */
+
+#include "preview.hpp"
+#include "utilities.hpp"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+Preview::Preview(unsigned int width, unsigned int height, unsigned int factor, double rate, 
+                 const std::string &filename) : 
+        m_factor(factor), m_filename(filename), m_latest(NULL), m_sequence(0), m_stop(false) {
+
+    if((this->m_factor != 2) && (this->m_factor != 4) && (this->m_factor != 8)) {
+        this->m_factor = 4; 
+    }
+
+    this->m_width  = width / this->m_factor; 
+    this->m_height = height / this->m_factor; 
+    this->m_period = (rate > 0.0) ? 1.0 / rate : 1.0; 
+
+    this->m_slot    = new unsigned char[this->m_width * this->m_height]; 
+    this->m_scratch = new unsigned char[this->m_width * this->m_height]; 
+    memset(this->m_slot, 0, this->m_width * this->m_height); 
+
+    pthread_condattr_t attr; 
+    pthread_condattr_init(&attr); 
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC); 
+
+    pthread_mutex_init(&this->m_lock, NULL); 
+    pthread_cond_init(&this->m_wakeup, &attr); 
+    pthread_condattr_destroy(&attr); 
+
+    pthread_create(&this->m_thread, NULL, &thread, this); 
+}
+
+Preview::~Preview() {
+
+    pthread_mutex_lock(&this->m_lock); 
+    this->m_stop = true; 
+    pthread_cond_signal(&this->m_wakeup); 
+    pthread_mutex_unlock(&this->m_lock); 
+
+    pthread_join(this->m_thread, NULL); 
+
+    pthread_cond_destroy(&this->m_wakeup); 
+    pthread_mutex_destroy(&this->m_lock); 
+
+    delete [] this->m_slot; 
+    delete [] this->m_scratch; 
+}
+
+void Preview::clear(void) {
+
+    pthread_mutex_lock(&this->m_lock); 
+    __atomic_store_n(&this->m_latest, (const Image *) NULL, __ATOMIC_RELEASE); 
+    pthread_mutex_unlock(&this->m_lock); 
+}
+
+unsigned int Preview::getWidth(void) const {
+
+    return this->m_width; 
+}
+
+unsigned int Preview::getHeight(void) const {
+
+    return this->m_height; 
+}
+
+unsigned long Preview::read(unsigned char *dst) const {
+
+    unsigned long before; 
+    unsigned long after; 
+
+    /* Sequence lock: retry if the preview thread published during the copy */
+    do {
+        before = __atomic_load_n(&this->m_sequence, __ATOMIC_ACQUIRE); 
+        if(before & 1ul) {
+            continue; 
+        }
+
+        memcpy(dst, this->m_slot, this->m_width * this->m_height); 
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE); 
+        after = __atomic_load_n(&this->m_sequence, __ATOMIC_RELAXED); 
+    } while((before & 1ul) || (before != after)); 
+
+    return before / 2; 
+}
+
+void Preview::downsample(const unsigned char *src, unsigned int width, unsigned int height, 
+                         unsigned int factor, unsigned char *dst) {
+
+    unsigned int outWidth  = width / factor; 
+    unsigned int outHeight = height / factor; 
+    unsigned int shift     = (factor == 2) ? 2 : ((factor == 4) ? 4 : 6); 
+    unsigned int round     = (factor * factor) / 2; 
+
+    for(unsigned int y = 0; y < outHeight; y++) {
+
+        const unsigned char *row = src + y * factor * width; 
+        unsigned char *out       = dst + y * outWidth; 
+        unsigned int x           = 0; 
+
+#ifdef __SSE2__
+        /* 16 input columns at a time: sum the rows as 16-bit lanes, then add adjacent
+         * lanes pairwise until each lane holds a whole block (at most 8 x 8 x 255). */
+        const __m128i zero    = _mm_setzero_si128(); 
+        const __m128i ones    = _mm_set1_epi16(1); 
+        const __m128i rounder = _mm_set1_epi16((short) round); 
+        const unsigned int perVector = 16 / factor; 
+
+        for(; x + perVector <= outWidth; x += perVector) {
+
+            __m128i lo = zero; 
+            __m128i hi = zero; 
+
+            for(unsigned int r = 0; r < factor; r++) {
+                __m128i v = _mm_loadu_si128((const __m128i *) (row + r * width + x * factor)); 
+                lo = _mm_add_epi16(lo, _mm_unpacklo_epi8(v, zero)); 
+                hi = _mm_add_epi16(hi, _mm_unpackhi_epi8(v, zero)); 
+            }
+
+            __m128i sums = _mm_packs_epi32(_mm_madd_epi16(lo, ones), _mm_madd_epi16(hi, ones)); 
+            for(unsigned int lanes = factor; lanes > 2; lanes /= 2) {
+                __m128i pairs = _mm_madd_epi16(sums, ones); 
+                sums = _mm_packs_epi32(pairs, pairs); 
+            }
+
+            sums = _mm_srli_epi16(_mm_add_epi16(sums, rounder), shift); 
+
+            unsigned char packed[16]; 
+            _mm_storeu_si128((__m128i *) packed, _mm_packus_epi16(sums, sums)); 
+            memcpy(out + x, packed, perVector); 
+        }
+#endif
+
+        for(; x < outWidth; x++) {
+            unsigned int sum = 0; 
+            for(unsigned int r = 0; r < factor; r++) {
+                for(unsigned int c = 0; c < factor; c++) {
+                    sum += row[r * width + x * factor + c]; 
+                }
+            }
+            out[x] = (unsigned char) ((sum + round) >> shift); 
+        }
+    }
+}
+
+void Preview::publish(void) {
+
+    __atomic_add_fetch(&this->m_sequence, 1, __ATOMIC_RELAXED); 
+    __atomic_thread_fence(__ATOMIC_RELEASE); 
+
+    memcpy(this->m_slot, this->m_scratch, this->m_width * this->m_height); 
+
+    __atomic_add_fetch(&this->m_sequence, 1, __ATOMIC_RELEASE); 
+}
+
+void Preview::writeFile(void) const {
+
+    /* Write aside and rename, so that viewers never see a partial file */
+    std::string temporary = this->m_filename + ".tmp"; 
+    FILE *fp = fopen(temporary.c_str(), "wb"); 
+
+    if(fp == NULL) {
+        return; 
+    }
+
+    fprintf(fp, "P5\n%u %u\n255\n", this->m_width, this->m_height); 
+    size_t written = fwrite(this->m_scratch, 1, this->m_width * this->m_height, fp); 
+
+    if((fclose(fp) == 0) && (written == this->m_width * this->m_height)) {
+        rename(temporary.c_str(), this->m_filename.c_str()); 
+    }
+}
+
+void * Preview::thread(void *arg) {
+
+    Preview *preview = reinterpret_cast<Preview *>(arg); 
+    double deadline = getMonotonicTime(); 
+
+    pthread_mutex_lock(&preview->m_lock); 
+
+    while(!preview->m_stop) {
+
+        deadline += preview->m_period; 
+
+        /* Skip the missed periods rather than catching up */
+        double now = getMonotonicTime(); 
+        if(deadline < now) {
+            deadline = now + preview->m_period; 
+        }
+
+        struct timespec ts; 
+        ts.tv_sec  = (time_t) deadline; 
+        ts.tv_nsec = (long) ((deadline - (double) ts.tv_sec) * 1e9); 
+        if(ts.tv_nsec > 999999999L) {
+            ts.tv_nsec = 999999999L; 
+        }
+
+        while(!preview->m_stop && (getMonotonicTime() < deadline)) {
+            pthread_cond_timedwait(&preview->m_wakeup, &preview->m_lock, &ts); 
+        }
+
+        if(preview->m_stop) {
+            break; 
+        }
+
+        /* Only the latest frame matters: frames offered between two periods are skipped.
+         * The lock is kept during the downsampling, see clear(). */
+        const Image *image = __atomic_load_n(&preview->m_latest, __ATOMIC_ACQUIRE); 
+
+        if((image != NULL) && 
+           (image->getWidth() / preview->m_factor == preview->m_width) && 
+           (image->getHeight() / preview->m_factor == preview->m_height)) {
+
+            Preview::downsample((const unsigned char *) image->getImageBuffer(), image->getWidth(), 
+                                image->getHeight(), preview->m_factor, preview->m_scratch); 
+            preview->publish(); 
+
+            if(!preview->m_filename.empty()) {
+                preview->writeFile(); 
+            }
+        }
+    }
+
+    pthread_mutex_unlock(&preview->m_lock); 
+
+    return NULL; 
+}
@@ -0,0 +1,267 @@
+/**
+ * @file recording_verifier.cpp
+ * @brief Recording integrity verifier class implementation.
+ */
+
+#include "recording_verifier.hpp"
+#include "image.hpp"
+#include "png_encoder.hpp"
+#include "crc32c.hpp"
+
+#include <png.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdio.h>
+#include <algorithm>
+
+/** @brief Maximum number of checking threads. */
+#define VERIFIER_MAX_THREADS    (64u)
+
+/** @brief libpng error handler: the errors are counted, not printed. */
+static void silentError(png_structp png_ptr, png_const_charp message) {
+
+    (void) message;
+    png_longjmp(png_ptr, 1);
+}
+
+/** @brief libpng warning handler. */
+static void silentWarning(png_structp png_ptr, png_const_charp message) {
+
+    (void) png_ptr;
+    (void) message;
+}
+
+RecordingVerifier::RecordingVerifier(const std::string &directory, unsigned int nbOfThreads) :
+        m_directory(directory), m_nbOfThreads(nbOfThreads), m_next(0), m_valid(0), m_unchecked(0) {
+
+    if(this->m_nbOfThreads == 0) {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        this->m_nbOfThreads = (cores > 0) ? (unsigned int) cores : 1u;
+    }
+    if(this->m_nbOfThreads > VERIFIER_MAX_THREADS) {
+        this->m_nbOfThreads = VERIFIER_MAX_THREADS;
+    }
+
+    pthread_mutex_init(&this->m_lock, NULL);
+}
+
+RecordingVerifier::~RecordingVerifier() {
+
+    pthread_mutex_destroy(&this->m_lock);
+}
+
+unsigned int RecordingVerifier::verify(void) {
+
+    this->m_files.clear();
+    this->m_corrupt.clear();
+    this->m_next      = 0;
+    this->m_valid     = 0;
+    this->m_unchecked = 0;
+
+    this->listFiles(this->m_directory);
+
+    pthread_t threads[VERIFIER_MAX_THREADS];
+    unsigned int nbOfThreads = std::min((size_t) this->m_nbOfThreads, std::max(this->m_files.size(), (size_t) 1));
+
+    for(unsigned int incr = 0; incr < nbOfThreads; incr++) {
+        pthread_create(&threads[incr], NULL, &thread, this);
+    }
+
+    for(unsigned int incr = 0; incr < nbOfThreads; incr++) {
+        pthread_join(threads[incr], NULL);
+    }
+
+    std::sort(this->m_corrupt.begin(), this->m_corrupt.end());
+
+    return this->m_corrupt.size();
+}
+
+unsigned int RecordingVerifier::getValid(void) const {
+
+    return this->m_valid;
+}
+
+unsigned int RecordingVerifier::getUnchecked(void) const {
+
+    return this->m_unchecked;
+}
+
+const std::vector<std::string> & RecordingVerifier::getCorrupt(void) const {
+
+    return this->m_corrupt;
+}
+
+VerifyResult_e RecordingVerifier::verifyFile(const std::string &path) {
+
+    FILE *fp = fopen(path.c_str(), "rb");
+    if(fp == NULL) {
+        return VERIFY_CORRUPT;
+    }
+
+    unsigned char signature[8];
+    VerifyResult_e result = VERIFY_UNCHECKED;
+
+    if(fread(signature, 1, sizeof(signature), fp) != sizeof(signature)) {
+        result = VERIFY_CORRUPT;
+    }
+    else if(png_sig_cmp(signature, 0, sizeof(signature)) == 0) {
+        result = verifyPNG(fp);
+    }
+    else if((signature[0] == 'P') && (signature[1] == '5')) {
+        rewind(fp);
+        result = verifyPGM(fp);
+    }
+
+    fclose(fp);
+
+    return result;
+}
+
+void RecordingVerifier::listFiles(const std::string &directory) {
+
+    DIR *dir = opendir(directory.c_str());
+    if(dir == NULL) {
+        return;
+    }
+
+    struct dirent *entry;
+
+    while((entry = readdir(dir)) != NULL) {
+
+        const char *name = entry->d_name;
+
+        /* Shard subdirectories have numeric names */
+        if(isdigit(name[0])) {
+            this->listFiles(directory + "/" + name);
+        }
+
+        else if((strncmp(name, "image", 5) == 0) && isdigit(name[5])) {
+            this->m_files.push_back(directory + "/" + name);
+        }
+    }
+
+    closedir(dir);
+}
+
+void * RecordingVerifier::thread(void *arg) {
+
+    RecordingVerifier *verifier = reinterpret_cast<RecordingVerifier *>(arg);
+
+    while(true) {
+        size_t index = __sync_fetch_and_add(&verifier->m_next, 1);
+        if(index >= verifier->m_files.size()) {
+            break;
+        }
+
+        VerifyResult_e result = verifyFile(verifier->m_files[index]);
+
+        pthread_mutex_lock(&verifier->m_lock);
+        switch(result) {
+            case VERIFY_OK:
+                verifier->m_valid++;
+                break;
+            case VERIFY_UNCHECKED:
+                verifier->m_unchecked++;
+                break;
+            case VERIFY_CORRUPT:
+                verifier->m_corrupt.push_back(verifier->m_files[index]);
+                break;
+        }
+        pthread_mutex_unlock(&verifier->m_lock);
+    }
+
+    return NULL;
+}
+
+VerifyResult_e RecordingVerifier::verifyPNG(FILE *fp) {
+
+    png_structp png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, &silentError, &silentWarning);
+    png_infop info_ptr  = (png_ptr != NULL) ? png_create_info_struct(png_ptr) : NULL;
+
+    if(info_ptr == NULL) {
+        png_destroy_read_struct(&png_ptr, NULL, NULL);
+        return VERIFY_CORRUPT;
+    }
+
+    /* Modified after setjmp(): must be volatile */
+    png_bytep volatile pixels = NULL;
+
+    /* libpng errors (bad chunk CRC, truncated file, zlib error) land here */
+    if(setjmp(png_jmpbuf(png_ptr))) {
+        delete [] pixels;
+        png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+        return VERIFY_CORRUPT;
+    }
+
+    png_init_io(png_ptr, fp);
+    png_set_sig_bytes(png_ptr, 8);
+    png_set_keep_unknown_chunks(png_ptr, PNG_HANDLE_CHUNK_ALWAYS, (png_const_bytep) PNG_CHECKSUM_CHUNK, 1);
+    png_read_info(png_ptr, info_ptr);
+
+    png_uint_32 width  = png_get_image_width(png_ptr, info_ptr);
+    png_uint_32 height = png_get_image_height(png_ptr, info_ptr);
+
+    if((png_get_bit_depth(png_ptr, info_ptr) != 8) || (png_get_color_type(png_ptr, info_ptr) != PNG_COLOR_TYPE_GRAY)) {
+        png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+        return VERIFY_UNCHECKED;
+    }
+
+    /* The checksum chunk comes before the image data */
+    bool found = false;
+    uint32_t expected = 0;
+    png_unknown_chunkp chunks = NULL;
+    int nbOfChunks = png_get_unknown_chunks(png_ptr, info_ptr, &chunks);
+
+    for(int incr = 0; incr < nbOfChunks; incr++) {
+        if((memcmp(chunks[incr].name, PNG_CHECKSUM_CHUNK, 4) == 0) && (chunks[incr].size == 4)) {
+            expected = ((uint32_t) chunks[incr].data[0] << 24) | ((uint32_t) chunks[incr].data[1] << 16) |
+                       ((uint32_t) chunks[incr].data[2] << 8)  |  (uint32_t) chunks[incr].data[3];
+            found = true;
+        }
+    }
+
+    if(!found) {
+        png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+        return VERIFY_UNCHECKED;
+    }
+
+    pixels = new png_byte[(size_t) width * height];
+
+    for(png_uint_32 y = 0; y < height; y++) {
+        png_read_row(png_ptr, pixels + (size_t) y * width, NULL);
+    }
+    png_read_end(png_ptr, NULL);
+
+    uint32_t checksum = crc32c(0, pixels, (size_t) width * height);
+
+    delete [] pixels;
+    png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+
+    return (checksum == expected) ? VERIFY_OK : VERIFY_CORRUPT;
+}
+
+VerifyResult_e RecordingVerifier::verifyPGM(FILE *fp) {
+
+    PGMHeader_s header;
+
+    if(!Image::readPGMHeader(fp, &header)) {
+        return VERIFY_CORRUPT;
+    }
+
+    if(!header.hasChecksum) {
+        return VERIFY_UNCHECKED;
+    }
+    if(header.maxValue > 0xFF) {
+        return VERIFY_UNCHECKED;
+    }
+
+    size_t size = (size_t) header.width * header.height;
+    unsigned char *pixels = new unsigned char[size];
+    bool complete = (fread(pixels, 1, size, fp) == size);
+    uint32_t checksum = crc32c(0, pixels, size);
+    delete [] pixels;
+
+    return (complete && (checksum == header.checksum)) ? VERIFY_OK : VERIFY_CORRUPT;
+}
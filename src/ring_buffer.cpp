@@ -5,13 +5,46 @@
 
 #include "ring_buffer.hpp"
 
-RingBuffer::RingBuffer(unsigned int width, unsigned int height, size_t nbOfImages) :
-        m_size(nbOfImages), m_width(width), m_height(height) {
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
 
+RingBuffer::RingBuffer(unsigned int width, unsigned int height, size_t nbOfImages, unsigned int nbOfThreads) :
+        m_size(nbOfImages), m_width(width), m_height(height), m_shared(NULL), m_arena(NULL), m_arenaSize(0), 
+        m_nbOfThreads(nbOfThreads) {
+
+    if(this->m_nbOfThreads == 0) {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN); 
+        this->m_nbOfThreads = (cores > 0) ? (unsigned int) cores : 1u; 
+    }
+    if(this->m_nbOfThreads > RING_BUFFER_MAX_THREADS) {
+        this->m_nbOfThreads = RING_BUFFER_MAX_THREADS; 
+    }
+
+    size_t stride      = this->getStride(); 
+    this->m_arena      = this->createArena(nbOfImages, &this->m_arenaSize); 
     this->m_imageArray = new Image *[nbOfImages]; 
     
     for(unsigned int incr = 0; incr < nbOfImages; incr++) {
-        this->m_imageArray[incr] = new Image(width, height); 
+        if(this->m_arena != NULL) {
+            this->m_imageArray[incr] = new Image(width, height, (pixel_t *) (this->m_arena + incr * stride)); 
+        }
+        else {
+            this->m_imageArray[incr] = new Image(width, height); 
+        }
+        this->m_bufferToImage[this->m_imageArray[incr]->getImageBuffer()] = 
+                this->m_imageArray[incr];
+    }
+}
+
+RingBuffer::RingBuffer(SharedRing *shared) :
+        m_size(shared->getNbOfSlots()), m_width(shared->getWidth()), m_height(shared->getHeight()), m_shared(shared), 
+        m_arena(NULL), m_arenaSize(0), m_nbOfThreads(0) {
+
+    this->m_imageArray = new Image *[this->m_size]; 
+
+    for(unsigned int incr = 0; incr < this->m_size; incr++) {
+        this->m_imageArray[incr] = new Image(this->m_width, this->m_height, shared->getSlot(incr)); 
         this->m_bufferToImage[this->m_imageArray[incr]->getImageBuffer()] = 
                 this->m_imageArray[incr];
     }
@@ -26,12 +59,77 @@ RingBuffer::~RingBuffer() {
 
     delete [] this->m_imageArray; 
     m_imageArray = NULL; 
+
+    if(this->m_arena != NULL) {
+        munlock(this->m_arena, this->m_arenaSize); 
+        munmap(this->m_arena, this->m_arenaSize); 
+    }
 }
 
 size_t RingBuffer::getSize(void) const {
     return this->m_size; 
 }
 
+size_t RingBuffer::getArenaSize(void) const {
+    return this->m_arenaSize; 
+}
+
+void RingBuffer::resize(size_t nbOfImages) {
+
+    if((nbOfImages == this->m_size) || (this->m_shared != NULL)) {
+        return; 
+    }
+
+    /* The images move into a new arena, locked before the old one is released: 
+     * the ring never relies on unlocked or stale memory */
+    size_t stride    = this->getStride(); 
+    size_t arenaSize = 0; 
+    unsigned char *arena = this->createArena(nbOfImages, &arenaSize); 
+    bool moved = (arena != NULL); 
+
+    Image **imageArray = new Image *[nbOfImages]; 
+    this->m_bufferToImage.clear(); 
+
+    for(unsigned int incr = 0; incr < nbOfImages; incr++) {
+        
+        if(incr < this->m_size) {
+            imageArray[incr] = this->m_imageArray[incr]; 
+            if(moved) {
+                imageArray[incr]->moveTo((pixel_t *) (arena + incr * stride)); 
+            }
+        }
+
+        else if(moved) {
+            imageArray[incr] = new Image(this->m_width, this->m_height, (pixel_t *) (arena + incr * stride)); 
+        }
+
+        else {
+            imageArray[incr] = new Image(this->m_width, this->m_height); 
+        }
+
+        this->m_bufferToImage[imageArray[incr]->getImageBuffer()] = imageArray[incr];
+    }
+
+    for(unsigned int incr = nbOfImages; incr < this->m_size; incr++) {
+        delete this->m_imageArray[incr]; 
+    }
+
+    delete [] this->m_imageArray; 
+    this->m_imageArray = imageArray; 
+    this->m_size = nbOfImages; 
+
+    /* Without a new arena, the kept images still use the old one */
+    if(moved || (nbOfImages == 0)) {
+        if(this->m_arena != NULL) {
+            munlock(this->m_arena, this->m_arenaSize); 
+            munmap(this->m_arena, this->m_arenaSize); 
+        }
+
+        this->m_arena     = arena; 
+        this->m_arenaSize = arenaSize; 
+    }
+}
+
 Image * RingBuffer::at(const size_t index) const {
     
     if(index < this->m_size) {
@@ -59,3 +157,69 @@ Image*& RingBuffer::operator[] (const size_t index) {
     return m_imageArray[index]; 
 }
 
+size_t RingBuffer::getStride(void) const {
+
+    /* Page-aligned images, as in shared memory */
+    size_t page = sysconf(_SC_PAGESIZE); 
+
+    return ((size_t) this->m_width * this->m_height + page - 1) / page * page; 
+}
+
+unsigned char * RingBuffer::createArena(size_t nbOfImages, size_t *size) const {
+
+    size_t stride = this->getStride(); 
+    *size = 0; 
+
+    if(stride * nbOfImages == 0) {
+        return NULL; 
+    }
+
+    void *arena = mmap(NULL, stride * nbOfImages, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0); 
+    if(arena == MAP_FAILED) {
+        return NULL; 
+    }
+
+    unsigned int nbOfThreads = this->m_nbOfThreads; 
+    if(nbOfThreads > nbOfImages) {
+        nbOfThreads = nbOfImages; 
+    }
+
+    /* Whole images per thread */
+    pthread_t threads[RING_BUFFER_MAX_THREADS]; 
+    Chunk_s chunks[RING_BUFFER_MAX_THREADS]; 
+    size_t first = 0; 
+
+    for(unsigned int incr = 0; incr < nbOfThreads; incr++) {
+        size_t count = (nbOfImages - first) / (nbOfThreads - incr); 
+        chunks[incr].start = (unsigned char *) arena + first * stride; 
+        chunks[incr].size  = count * stride; 
+        first += count; 
+
+        pthread_create(&threads[incr], NULL, &lockChunk, &chunks[incr]); 
+    }
+
+    for(unsigned int incr = 0; incr < nbOfThreads; incr++) {
+        pthread_join(threads[incr], NULL); 
+    }
+
+    *size = stride * nbOfImages; 
+
+    return (unsigned char *) arena; 
+}
+
+void * RingBuffer::lockChunk(void *arg) {
+
+    Chunk_s *chunk = reinterpret_cast<Chunk_s *>(arg); 
+
+    /* mlock() faults the pages in. Beyond the lock limit, at least fault them in. */
+    if(mlock(chunk->start, chunk->size) != 0) {
+        size_t page = sysconf(_SC_PAGESIZE); 
+
+        for(size_t offset = 0; offset < chunk->size; offset += page) {
+            chunk->start[offset] = 0; 
+        }
+    }
+
+    return NULL; 
+}
+
@@ -0,0 +1,135 @@
+/**
+ * @file ring_sizer.cpp
+ * @brief Automatic ring buffer sizing class implementation.
+ */
+
+#include "ring_sizer.hpp"
+#include "image.hpp"
+#include "utilities.hpp"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <math.h>
+
+/** @brief Frames being acquired and written, on top of the buffered ones. */
+#define RING_SIZER_MARGIN   (2u)
+
+RingSizer::RingSizer(unsigned int width, unsigned int height) : 
+        m_width(width), m_height(height), m_framerate(0.0), m_writeLatency(0.0), 
+        m_burstTolerance(0.0), m_memoryBudget(0) {
+
+}
+
+double RingSizer::calibrate(const std::string &directory, unsigned int nbOfWrites) {
+
+    Image *i = new Image(this->m_width, this->m_height); 
+    memset(i->getImageBuffer(), 0, this->m_width * this->m_height); 
+
+    double worst = 0.0; 
+
+    for(unsigned int incr = 0; incr < nbOfWrites; incr++) {
+
+        /* Each frame goes to a new file, as during the acquisition */
+        std::string filename = directory + "/.calibration"; 
+        string_appendInt(filename, incr); 
+
+        /* The frame must reach the disk, not only the page cache */
+        double start = getMonotonicTime(); 
+        size_t bytes = 0; 
+        FILE *fp = fopen(filename.c_str(), "wb"); 
+
+        if(fp != NULL) {
+            bytes = i->writeToPGM(fp); 
+            if((fflush(fp) != 0) || (fdatasync(fileno(fp)) != 0)) {
+                bytes = 0; 
+            }
+            fclose(fp); 
+        }
+        double latency = getMonotonicTime() - start; 
+
+        unlink(filename.c_str()); 
+
+        if(bytes < this->m_width * this->m_height) {
+            worst = -1.0; 
+            break; 
+        }
+
+        if(latency > worst) {
+            worst = latency; 
+        }
+    }
+
+    delete i; 
+
+    if(worst >= 0.0) {
+        this->m_writeLatency = worst; 
+    }
+
+    return worst; 
+}
+
+void RingSizer::setWriteLatency(double latency) {
+
+    this->m_writeLatency = latency; 
+}
+
+double RingSizer::getWriteLatency(void) const {
+
+    return this->m_writeLatency; 
+}
+
+void RingSizer::setFramerate(double framerate) {
+
+    this->m_framerate = framerate; 
+}
+
+void RingSizer::setBurstTolerance(double tolerance) {
+
+    this->m_burstTolerance = tolerance; 
+}
+
+void RingSizer::setMemoryBudget(size_t budget) {
+
+    this->m_memoryBudget = budget; 
+}
+
+size_t RingSizer::getMemoryBudget(void) const {
+
+    if(this->m_memoryBudget > 0) {
+        return this->m_memoryBudget; 
+    }
+
+    /* Leave half of the free memory to the writers and to the page cache */
+    size_t budget    = getAvailableMemory() / 2u; 
+    size_t lockable  = getLockableMemory(); 
+
+    /* The memory already locked, the current ring included, counts against the limit */
+    if(lockable != SIZE_MAX) {
+        size_t locked = getLockedMemory(); 
+        lockable = (lockable > locked) ? lockable - locked : 0; 
+    }
+
+    return (lockable < budget) ? lockable : budget; 
+}
+
+size_t RingSizer::computeSize(size_t currentSize) const {
+
+    double buffered = ceil(this->m_framerate * (this->m_writeLatency + this->m_burstTolerance)); 
+    size_t size     = (size_t) buffered + RING_SIZER_MARGIN; 
+
+    size_t frameSize = (size_t) this->m_width * this->m_height; 
+    size_t maxSize   = this->getMemoryBudget() / frameSize; 
+
+    /* A new ring is locked beside the current one: keeping the current ring takes no memory */
+    if(size > maxSize) {
+        size = ((this->m_memoryBudget == 0) && (currentSize > maxSize)) ? currentSize : maxSize; 
+    }
+
+    if(size < RING_SIZER_MIN_SIZE) {
+        size = RING_SIZER_MIN_SIZE; 
+    }
+
+    return size; 
+}
@@ -5,12 +5,94 @@
 
 #include "serial/i2c_bus.hpp"
 
-I2CBus::I2CBus(std::string tty) {
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
 
-    (void) tty;
+I2CBus::I2CBus(std::string tty, speed_t baudrate) {
+
+    this->m_fd = open(tty.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK); 
+
+    if(this->m_fd < 0) {
+        return; 
+    }
+
+    struct termios options; 
+    if(tcgetattr(this->m_fd, &options) != 0) {
+        close(this->m_fd); 
+        this->m_fd = -1; 
+        return; 
+    }
+
+    /* Raw 8N1, reads never wait: the reception thread waits with epoll */
+    cfmakeraw(&options); 
+    options.c_cflag |= CLOCAL | CREAD; 
+    options.c_cflag &= ~(CSTOPB | CRTSCTS); 
+    options.c_iflag &= ~(IXON | IXOFF | IXANY); 
+    options.c_cc[VMIN]  = 0; 
+    options.c_cc[VTIME] = 0; 
+    cfsetispeed(&options, baudrate); 
+    cfsetospeed(&options, baudrate); 
+
+    tcsetattr(this->m_fd, TCSANOW, &options); 
+    tcflush(this->m_fd, TCIFLUSH); 
 }
 
 I2CBus::~I2CBus() {
     
+    if(this->m_fd >= 0) {
+        close(this->m_fd); 
+    }
+}
+
+bool I2CBus::isOpen(void) const {
+
+    return this->m_fd >= 0; 
+}
+
+int I2CBus::getFd(void) const {
+
+    return this->m_fd; 
+}
+
+ssize_t I2CBus::read(unsigned char *data, size_t size) {
+
+    ssize_t n; 
+
+    do {
+        n = ::read(this->m_fd, data, size); 
+    } while((n < 0) && (errno == EINTR)); 
+
+    if((n < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK))) {
+        return 0; 
+    }
+
+    return n; 
 }
 
+ssize_t I2CBus::write(const unsigned char *data, size_t size) {
+
+    size_t written = 0; 
+
+    while(written < size) {
+        ssize_t n = ::write(this->m_fd, data + written, size - written); 
+
+        if(n > 0) {
+            written += n; 
+        }
+
+        else if((n < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK))) {
+            struct pollfd pfd; 
+            pfd.fd     = this->m_fd; 
+            pfd.events = POLLOUT; 
+            poll(&pfd, 1, -1); 
+        }
+
+        else if(!((n < 0) && (errno == EINTR))) {
+            return -1; 
+        }
+    }
+
+    return written; 
+}
@@ -5,11 +5,243 @@
 
 #include "serial/rx_thread.hpp"
 
-RXThread::RXThread(I2CBus bus) : m_bus(bus) {
+#include <unistd.h>
+#include <stdint.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 
+RXThread::RXThread(I2CBus *bus, void (*rxCallback)(char *, int)) : 
+        m_bus(bus), m_callback(rxCallback), m_head(0), m_tail(0), m_frames(0), m_errors(0), 
+        m_running(false) {
+
+    this->m_stopEvent = eventfd(0, EFD_NONBLOCK); 
+    this->m_epoll     = epoll_create(2); 
+
+    struct epoll_event event; 
+    event.events  = EPOLLIN; 
+    event.data.fd = this->m_stopEvent; 
+    epoll_ctl(this->m_epoll, EPOLL_CTL_ADD, this->m_stopEvent, &event); 
+
+    if(this->m_bus->isOpen()) {
+        event.events  = EPOLLIN; 
+        event.data.fd = this->m_bus->getFd(); 
+        epoll_ctl(this->m_epoll, EPOLL_CTL_ADD, this->m_bus->getFd(), &event); 
+    }
 }
 
 RXThread::~RXThread() {
 
+    if(this->m_running) {
+        this->stop(); 
+    }
+
+    close(this->m_epoll); 
+    close(this->m_stopEvent); 
+}
+
+void RXThread::start(void) {
+
+    if(this->m_running) {
+        this->stop(); 
+    }
+
+    this->m_running = true; 
+    pthread_create(&this->m_rxThread, NULL, &thread, this); 
+}
+
+void RXThread::stop(void) {
+
+    if(!this->m_running) {
+        return; 
+    }
+
+    uint64_t one = 1; 
+    if(write(this->m_stopEvent, &one, sizeof(one)) == sizeof(one)) {
+        pthread_join(this->m_rxThread, NULL); 
+    }
+
+    /* Consume the event for the next start */
+    uint64_t count; 
+    if(read(this->m_stopEvent, &count, sizeof(count)) != sizeof(count)) {
+        count = 0; 
+    }
+
+    this->m_running = false; 
+}
+
+unsigned long RXThread::getFrames(void) const {
+
+    return __atomic_load_n(&this->m_frames, __ATOMIC_RELAXED); 
+}
+
+unsigned long RXThread::getErrors(void) const {
+
+    return __atomic_load_n(&this->m_errors, __ATOMIC_RELAXED); 
+}
+
+size_t RXThread::encode(const char *command, size_t size, unsigned char *frame) {
+
+    if((size == 0) || (size > RX_FRAME_MAX_PAYLOAD)) {
+        return 0; 
+    }
+
+    frame[0] = RX_FRAME_START; 
+    frame[1] = (unsigned char) size; 
+
+    for(size_t incr = 0; incr < size; incr++) {
+        frame[2 + incr] = (unsigned char) command[incr]; 
+    }
+
+    frame[2 + size] = checksum(frame + 1, size + 1); 
+
+    return size + RX_FRAME_OVERHEAD; 
 }
 
+unsigned char RXThread::checksum(const unsigned char *data, size_t size, unsigned char crc) {
+
+    for(size_t incr = 0; incr < size; incr++) {
+        crc ^= data[incr]; 
+
+        for(unsigned int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80) ? (unsigned char) ((crc << 1) ^ 0x07) : (unsigned char) (crc << 1); 
+        }
+    }
+
+    return crc; 
+}
+
+bool RXThread::fill(void) {
+
+    /* Read until the tty is empty or the ring is full */
+    while(this->m_head - this->m_tail < RX_RING_SIZE) {
+
+        size_t offset = this->m_head % RX_RING_SIZE; 
+        size_t room   = RX_RING_SIZE - (this->m_head - this->m_tail); 
+
+        if(room > RX_RING_SIZE - offset) {
+            room = RX_RING_SIZE - offset; 
+        }
+
+        ssize_t n = this->m_bus->read(this->m_ring + offset, room); 
+
+        if(n < 0) {
+            return false; 
+        }
+
+        if(n == 0) {
+            break; 
+        }
+
+        this->m_head += n; 
+    }
+
+    return true; 
+}
+
+void RXThread::decode(void) {
+
+    while(this->m_tail != this->m_head) {
+
+        if(this->m_ring[this->m_tail % RX_RING_SIZE] != RX_FRAME_START) {
+            this->m_tail++; 
+            continue; 
+        }
+
+        int size = this->checkFrame(this->m_tail); 
+
+        if(size > 0) {
+            __atomic_add_fetch(&this->m_frames, 1, __ATOMIC_RELAXED); 
+            this->m_callback((char *) this->m_command, size - (int) RX_FRAME_OVERHEAD); 
+            this->m_tail += size; 
+            continue; 
+        }
+
+        if(size == 0) {
+            /* Incomplete: wait for the next bytes, unless a valid frame follows the start */
+            size_t next = this->m_tail + 1; 
+            while((next != this->m_head) && 
+                  ((this->m_ring[next % RX_RING_SIZE] != RX_FRAME_START) || (this->checkFrame(next) <= 0))) {
+                next++; 
+            }
+
+            if(next == this->m_head) {
+                break; 
+            }
+
+            __atomic_add_fetch(&this->m_errors, 1, __ATOMIC_RELAXED); 
+            this->m_tail = next; 
+            continue; 
+        }
+
+        /* False start: scan again from the next byte, nothing else is lost */
+        __atomic_add_fetch(&this->m_errors, 1, __ATOMIC_RELAXED); 
+        this->m_tail++; 
+    }
+}
+
+int RXThread::checkFrame(size_t position) {
+
+    size_t available = this->m_head - position; 
+    if(available < 2) {
+        return 0; 
+    }
+
+    size_t length = this->m_ring[(position + 1) % RX_RING_SIZE]; 
+    if(length == 0) {
+        return -1; 
+    }
+
+    if(available < length + RX_FRAME_OVERHEAD) {
+        return 0; 
+    }
+
+    for(size_t incr = 0; incr < length; incr++) {
+        this->m_command[incr] = this->m_ring[(position + 2 + incr) % RX_RING_SIZE]; 
+    }
+    this->m_command[length] = '\0'; 
+
+    unsigned char size = (unsigned char) length; 
+    unsigned char crc  = checksum(this->m_command, length, checksum(&size, 1)); 
+
+    if(crc != this->m_ring[(position + 2 + length) % RX_RING_SIZE]) {
+        return -1; 
+    }
+
+    return (int) (length + RX_FRAME_OVERHEAD); 
+}
+
+void * RXThread::thread(void *arg) {
+
+    RXThread *rxThread = reinterpret_cast<RXThread *>(arg); 
+    struct epoll_event events[2]; 
+
+    while(true) {
+
+        int nbOfEvents = epoll_wait(rxThread->m_epoll, events, 2, -1); 
+        bool stop = false; 
+
+        for(int incr = 0; incr < nbOfEvents; incr++) {
+
+            if(events[incr].data.fd == rxThread->m_stopEvent) {
+                stop = true; 
+                continue; 
+            }
+
+            /* Level-triggered: bytes left by a full ring wake the thread up again */
+            size_t before = rxThread->m_head; 
+            bool ok = rxThread->fill(); 
+            rxThread->decode(); 
+
+            /* The other end hung up: stop watching the tty rather than spinning */
+            if(!ok || ((events[incr].events & (EPOLLHUP | EPOLLERR)) && (rxThread->m_head == before))) {
+                epoll_ctl(rxThread->m_epoll, EPOLL_CTL_DEL, events[incr].data.fd, NULL); 
+            }
+        }
+
+        if(stop) {
+            break; 
+        }
+    }
+
+    return NULL; 
+}
@@ -0,0 +1,257 @@
+/**
+ * @file shared_ring.cpp
+ * @brief Shared-memory frame ring class implementation.
+ */
+
+#include "shared_ring.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/** @brief Number of attempts of @ref SharedRing::readLatest() before giving up. */
+#define SHARED_RING_RETRIES     (8)
+
+SharedRing::SharedRing(const std::string &name, unsigned int width, unsigned int height, size_t nbOfSlots) : 
+        m_name(name), m_owner(true), m_base(NULL), m_mappedSize(0), m_header(NULL), m_slots(NULL) {
+
+    size_t page       = sysconf(_SC_PAGESIZE); 
+    size_t stride     = ((size_t) width * height + page - 1) / page * page; 
+    size_t dataOffset = (sizeof(SharedRingHeader_s) + nbOfSlots * sizeof(SharedSlot_s) + page - 1) / page * page; 
+    size_t size       = dataOffset + nbOfSlots * stride; 
+
+    /* A previous run may have crashed without removing its object */
+    shm_unlink(name.c_str()); 
+
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644); 
+    if(fd < 0) {
+        return; 
+    }
+
+    if((ftruncate(fd, size) != 0) || !this->map(fd, size, true)) {
+        close(fd); 
+        shm_unlink(name.c_str()); 
+        return; 
+    }
+    close(fd); 
+
+    mlock(this->m_base, this->m_mappedSize); 
+
+    this->m_header->width      = width; 
+    this->m_header->height     = height; 
+    this->m_header->nbOfSlots  = nbOfSlots; 
+    this->m_header->guard      = (nbOfSlots > SHARED_RING_GUARD) ? SHARED_RING_GUARD : nbOfSlots - 1; 
+    this->m_header->slotStride = stride; 
+    this->m_header->dataOffset = dataOffset; 
+    this->m_header->latestSlot = 0; 
+    this->m_header->published  = 0; 
+
+    /* No frame yet: every slot is being written */
+    for(size_t incr = 0; incr < nbOfSlots; incr++) {
+        this->m_slots[incr].sequence = 1; 
+    }
+
+    /* Readers check the magic number last */
+    this->m_header->version = SHARED_RING_VERSION; 
+    __atomic_store_n(&this->m_header->magic, SHARED_RING_MAGIC, __ATOMIC_RELEASE); 
+}
+
+SharedRing::SharedRing(const std::string &name) : 
+        m_name(name), m_owner(false), m_base(NULL), m_mappedSize(0), m_header(NULL), m_slots(NULL) {
+
+    int fd = shm_open(name.c_str(), O_RDONLY, 0); 
+    if(fd < 0) {
+        return; 
+    }
+
+    struct stat st; 
+    if((fstat(fd, &st) != 0) || ((size_t) st.st_size < sizeof(SharedRingHeader_s)) || 
+       !this->map(fd, st.st_size, false)) {
+        close(fd); 
+        return; 
+    }
+    close(fd); 
+
+    const SharedRingHeader_s *header = this->m_header; 
+    bool valid = (__atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) == SHARED_RING_MAGIC) && 
+                 (header->version == SHARED_RING_VERSION) && 
+                 (header->dataOffset + header->nbOfSlots * header->slotStride <= this->m_mappedSize); 
+
+    if(!valid) {
+        munmap(this->m_base, this->m_mappedSize); 
+        this->m_base   = NULL; 
+        this->m_header = NULL; 
+        this->m_slots  = NULL; 
+    }
+}
+
+SharedRing::~SharedRing() {
+
+    if(this->m_base == NULL) {
+        return; 
+    }
+
+    if(this->m_owner) {
+        munlock(this->m_base, this->m_mappedSize); 
+        shm_unlink(this->m_name.c_str()); 
+    }
+    munmap(this->m_base, this->m_mappedSize); 
+}
+
+bool SharedRing::isOpen(void) const {
+
+    return this->m_base != NULL; 
+}
+
+unsigned int SharedRing::getWidth(void) const {
+
+    return this->m_header->width; 
+}
+
+unsigned int SharedRing::getHeight(void) const {
+
+    return this->m_header->height; 
+}
+
+size_t SharedRing::getNbOfSlots(void) const {
+
+    return this->m_header->nbOfSlots; 
+}
+
+pixel_t * SharedRing::getSlot(size_t index) const {
+
+    return (pixel_t *) (this->m_base + this->m_header->dataOffset + index * this->m_header->slotStride); 
+}
+
+void SharedRing::publish(const pixel_t *buffer, uint64_t frame) {
+
+    size_t offset = (const unsigned char *) buffer - (this->m_base + this->m_header->dataOffset); 
+    size_t index  = offset / this->m_header->slotStride; 
+
+    if(index >= this->m_header->nbOfSlots) {
+        return; 
+    }
+
+    /* Sequence lock writer side: odd, update, even */
+    SharedSlot_s *slot = &this->m_slots[index]; 
+    uint64_t sequence  = __atomic_load_n(&slot->sequence, __ATOMIC_RELAXED) | 1u; 
+
+    __atomic_store_n(&slot->sequence, sequence, __ATOMIC_RELAXED); 
+    __atomic_thread_fence(__ATOMIC_RELEASE); 
+
+    struct timespec now; 
+    clock_gettime(CLOCK_MONOTONIC, &now); 
+    slot->frame     = frame; 
+    slot->timestamp = (uint64_t) now.tv_sec * 1000000000u + now.tv_nsec; 
+
+    __atomic_store_n(&slot->sequence, sequence + 1, __ATOMIC_RELEASE); 
+
+    /* The camera is already filling the next slots */
+    for(uint32_t incr = 1; incr <= this->m_header->guard; incr++) {
+        this->markWriting((index + incr) % this->m_header->nbOfSlots); 
+    }
+
+    __atomic_store_n(&this->m_header->latestSlot, index, __ATOMIC_RELEASE); 
+    __atomic_add_fetch(&this->m_header->published, 1, __ATOMIC_RELEASE); 
+}
+
+void SharedRing::extendGuard(size_t guard) {
+
+    if(guard > this->m_header->nbOfSlots - 1) {
+        guard = this->m_header->nbOfSlots - 1; 
+    }
+
+    if(guard > this->m_header->guard) {
+        __atomic_store_n(&this->m_header->guard, (uint32_t) guard, __ATOMIC_RELAXED); 
+    }
+}
+
+size_t SharedRing::getGuard(void) const {
+
+    return __atomic_load_n(&this->m_header->guard, __ATOMIC_RELAXED); 
+}
+
+bool SharedRing::getLatest(size_t *index) const {
+
+    if(__atomic_load_n(&this->m_header->published, __ATOMIC_ACQUIRE) == 0) {
+        return false; 
+    }
+
+    *index = __atomic_load_n(&this->m_header->latestSlot, __ATOMIC_ACQUIRE); 
+
+    return *index < this->m_header->nbOfSlots; 
+}
+
+uint64_t SharedRing::beginRead(size_t index) const {
+
+    uint64_t sequence = __atomic_load_n(&this->m_slots[index].sequence, __ATOMIC_ACQUIRE); 
+
+    return (sequence & 1u) ? 0 : sequence; 
+}
+
+uint64_t SharedRing::getFrame(size_t index) const {
+
+    return this->m_slots[index].frame; 
+}
+
+bool SharedRing::endRead(size_t index, uint64_t sequence) const {
+
+    __atomic_thread_fence(__ATOMIC_ACQUIRE); 
+
+    return __atomic_load_n(&this->m_slots[index].sequence, __ATOMIC_RELAXED) == sequence; 
+}
+
+bool SharedRing::readLatest(pixel_t *dst, uint64_t *frame) const {
+
+    size_t index; 
+
+    for(unsigned int attempt = 0; attempt < SHARED_RING_RETRIES; attempt++) {
+
+        if(!this->getLatest(&index)) {
+            return false; 
+        }
+
+        uint64_t sequence = this->beginRead(index); 
+        if(sequence == 0) {
+            continue; 
+        }
+
+        uint64_t number = this->getFrame(index); 
+        memcpy(dst, this->getSlot(index), (size_t) this->getWidth() * this->getHeight()); 
+
+        if(this->endRead(index, sequence)) {
+            *frame = number; 
+            return true; 
+        }
+    }
+
+    return false; 
+}
+
+void SharedRing::markWriting(size_t index) {
+
+    uint64_t sequence = __atomic_load_n(&this->m_slots[index].sequence, __ATOMIC_RELAXED); 
+
+    if(!(sequence & 1u)) {
+        __atomic_store_n(&this->m_slots[index].sequence, sequence + 1, __ATOMIC_SEQ_CST); 
+    }
+}
+
+bool SharedRing::map(int fd, size_t size, bool writable) {
+
+    void *base = mmap(NULL, size, writable ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, fd, 0); 
+
+    if(base == MAP_FAILED) {
+        return false; 
+    }
+
+    this->m_base       = (unsigned char *) base; 
+    this->m_mappedSize = size; 
+    this->m_header     = (SharedRingHeader_s *) base; 
+    this->m_slots      = (SharedSlot_s *) (this->m_base + sizeof(SharedRingHeader_s)); 
+
+    return true; 
+}
@@ -0,0 +1,225 @@
+/**
+ * @file software_camera.cpp
+ * @brief Software frame source class implementation.
+ */
+
+#include "software_camera.hpp"
+#include "exceptions/camera_exception.hpp"
+
+#include "utilities.hpp"
+
+#include <iostream>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+
+SoftwareCamera::SoftwareCamera(unsigned int width, unsigned int height) : m_width(width), m_height(height),
+        m_nextPattern(0), m_livePeriod(0.0), m_frameCount(0), m_stop(false) {
+
+    this->m_framerate    = 0.0;
+    this->maxWidth       = width;
+    this->maxHeight      = height;
+    this->m_running      = false;
+    this->m_prepared     = false;
+    this->m_ringBuffer   = NULL;
+    this->m_userCallback = NULL;
+    this->m_lostFrames   = 0;
+
+    /* Smooth scene moving from frame to frame, with a few levels of noise */
+    size_t size = (size_t) width * height;
+    uint32_t seed = 12345u;
+
+    this->m_patterns = new unsigned char[SOFTWARE_CAMERA_NB_PATTERNS * size];
+
+    for(unsigned int pattern = 0; pattern < SOFTWARE_CAMERA_NB_PATTERNS; pattern++) {
+        unsigned char *pixels = this->m_patterns + pattern * size;
+
+        for(unsigned int y = 0; y < height; y++) {
+            for(unsigned int x = 0; x < width; x++) {
+                seed = seed * 1664525u + 1013904223u;
+                double scene = 96.0 + 64.0 * sin(x / 37.0 + pattern * 0.3) * cos(y / 29.0);
+                pixels[(size_t) y * width + x] = (unsigned char) (scene + (double) (seed >> 29));
+            }
+        }
+    }
+}
+
+SoftwareCamera::~SoftwareCamera() {
+
+    this->stop();
+
+    delete [] this->m_patterns;
+}
+
+void SoftwareCamera::start(RingBuffer *ringBuffer, FrameCallback_t callback) {
+
+    /* If the camera was already running, stop it */
+    if(this->m_running) {
+        this->stop();
+    }
+
+    this->prepare(ringBuffer, callback);
+
+    this->m_stop    = false;
+    this->m_running = true;
+    pthread_create(&this->m_thread, NULL, &thread, this);
+}
+
+void SoftwareCamera::prepare(RingBuffer *ringBuffer, FrameCallback_t callback) {
+
+    if(this->m_running) {
+        this->stop();
+    }
+
+    this->m_ringBuffer   = ringBuffer;
+    this->m_userCallback = callback;
+    this->m_prepared     = true;
+}
+
+void SoftwareCamera::stop(void) {
+
+    if(!this->m_running) {
+        return;
+    }
+
+    __atomic_store_n(&this->m_stop, true, __ATOMIC_RELAXED);
+    pthread_join(this->m_thread, NULL);
+
+    this->m_running = false;
+}
+
+void SoftwareCamera::capture(Image *i) {
+
+    this->captureBurst(&i, 1, 0.0, NULL);
+}
+
+void SoftwareCamera::captureBurst(Image **images, unsigned int count, double interval, double *timestamps) {
+
+    if(this->m_running) {
+        throw CameraException("Could not capture images during the live acquisition.");
+    }
+
+    double first = getMonotonicTime();
+
+    for(unsigned int incr = 0; incr < count; incr++) {
+        if((images[incr]->getWidth() != this->m_width) || (images[incr]->getHeight() != this->m_height)) {
+            throw CameraException("The image does not have the size of the frames.");
+        }
+
+        /* Triggers spaced from the first one */
+        double trigger = first + incr * interval;
+        while(getMonotonicTime() < trigger) {
+            usleep(100);
+        }
+
+        if(timestamps != NULL) {
+            timestamps[incr] = getMonotonicTime();
+        }
+
+        this->produce(images[incr]->getImageBuffer());
+    }
+}
+
+double SoftwareCamera::setFramerate(double framerate) {
+
+    double period = (framerate > 0.0) ? 1.0 / framerate : 0.0;
+
+    __atomic_store(&this->m_livePeriod, &period, __ATOMIC_RELAXED);
+    this->m_framerate = framerate;
+
+    return framerate;
+}
+
+void SoftwareCamera::setAreaOfInterest(int x, int y, int width, int height) {
+
+    (void) x;
+    (void) y;
+    (void) width;
+    (void) height;
+}
+
+void SoftwareCamera::displayInfo(void) {
+
+    std::cout << "Software camera: " << this->m_width << "x" << this->m_height << ", " <<
+                 this->m_framerate << " frames per second." << std::endl;
+}
+
+unsigned long SoftwareCamera::getFrameCount(void) const {
+
+    return __atomic_load_n(&this->m_frameCount, __ATOMIC_RELAXED);
+}
+
+void SoftwareCamera::produce(pixel_t *pixels) {
+
+    size_t size = (size_t) this->m_width * this->m_height;
+
+    memcpy(pixels, this->m_patterns + this->m_nextPattern * size, size);
+    this->m_nextPattern = (this->m_nextPattern + 1) % SOFTWARE_CAMERA_NB_PATTERNS;
+}
+
+void * SoftwareCamera::thread(void *arg) {
+
+    SoftwareCamera *camera = reinterpret_cast<SoftwareCamera *>(arg);
+    RingBuffer *ringBuffer = camera->m_ringBuffer;
+    size_t slot = 0;
+    uint64_t sequence = 0;
+
+    char *buffer = NULL;
+    FrameBatch_s batch;
+    batch.buffers   = &buffer;
+    batch.sequences = &sequence;
+    batch.count     = 1;
+    batch.lost      = 0;
+
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+
+    while(!__atomic_load_n(&camera->m_stop, __ATOMIC_RELAXED)) {
+
+        Image *image = ringBuffer->at(slot);
+        slot = (slot + 1) % ringBuffer->getSize();
+
+        camera->produce(image->getImageBuffer());
+        if(camera->m_userCallback != NULL) {
+            buffer = image->getImageBuffer();
+            camera->m_userCallback(&batch);
+        }
+        __atomic_add_fetch(&camera->m_frameCount, 1, __ATOMIC_RELAXED);
+
+        double period;
+        __atomic_load(&camera->m_livePeriod, &period, __ATOMIC_RELAXED);
+
+        /* Next acquisition time, a slightly late frame is caught up */
+        long nanoseconds = (long) (period * 1e9);
+        next.tv_sec  += nanoseconds / 1000000000L;
+        next.tv_nsec += nanoseconds % 1000000000L;
+        if(next.tv_nsec >= 1000000000L) {
+            next.tv_sec++;
+            next.tv_nsec -= 1000000000L;
+        }
+
+        sequence++;
+        batch.lost = 0;
+
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+
+        /* More than a period behind: the frames due in the meantime are lost, as on a sensor */
+        long behind = (now.tv_sec - next.tv_sec) * 1000000000L + (now.tv_nsec - next.tv_nsec);
+        if(behind > nanoseconds) {
+            if(nanoseconds > 0) {
+                batch.lost = behind / nanoseconds;
+                sequence  += batch.lost;
+                __atomic_add_fetch(&camera->m_lostFrames, batch.lost, __ATOMIC_RELAXED);
+            }
+            next = now;
+            continue;
+        }
+
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+    }
+
+    return NULL;
+}
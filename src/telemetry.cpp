@@ -0,0 +1,231 @@
+/**
+ * @file telemetry.cpp
+ * @brief Telemetry publisher class implementation.
+ */
+
+#include "telemetry.hpp"
+#include "utilities.hpp"
+
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+#include <time.h>
+#include <sys/statvfs.h>
+#include <zlib.h>
+
+Telemetry::Telemetry(const std::string &pipefile, unsigned int period, const std::string &directory) : 
+        m_period(period), m_directory(directory), m_acquired(0), m_stored(0), m_dropped(0), 
+        m_ringSize(0), m_occupancy(0), m_backlog(0), m_sequence(0), 
+        m_sent(sizeof(TelemetryRecord_s)), m_coalesced(0), m_stop(false) {
+
+    if(this->m_period == 0) {
+        this->m_period = 1; 
+    }
+
+    memset(this->m_latencies, 0, sizeof(this->m_latencies)); 
+    memset(&this->m_pending, 0, sizeof(this->m_pending)); 
+
+    this->m_pipe = new TXPipe(pipefile, true); 
+
+    pthread_condattr_t attr; 
+    pthread_condattr_init(&attr); 
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC); 
+
+    pthread_mutex_init(&this->m_lock, NULL); 
+    pthread_cond_init(&this->m_wakeup, &attr); 
+    pthread_condattr_destroy(&attr); 
+
+    pthread_create(&this->m_thread, NULL, &thread, this); 
+}
+
+Telemetry::~Telemetry() {
+
+    pthread_mutex_lock(&this->m_lock); 
+    this->m_stop = true; 
+    pthread_cond_signal(&this->m_wakeup); 
+    pthread_mutex_unlock(&this->m_lock); 
+
+    pthread_join(this->m_thread, NULL); 
+
+    pthread_cond_destroy(&this->m_wakeup); 
+    pthread_mutex_destroy(&this->m_lock); 
+
+    delete this->m_pipe; 
+}
+
+void Telemetry::frameAcquired(void) {
+
+    __atomic_add_fetch(&this->m_acquired, 1, __ATOMIC_RELAXED); 
+}
+
+void Telemetry::frameStored(double latency) {
+
+    double us = latency * 1e6; 
+    unsigned int bin = 0; 
+
+    if(us >= 1.0) {
+        bin = (unsigned int) (4.0 * log2(us)) + 1; 
+        if(bin >= TELEMETRY_LATENCY_BINS) {
+            bin = TELEMETRY_LATENCY_BINS - 1; 
+        }
+    }
+
+    __atomic_add_fetch(&this->m_latencies[bin], 1, __ATOMIC_RELAXED); 
+    __atomic_add_fetch(&this->m_stored, 1, __ATOMIC_RELAXED); 
+}
+
+void Telemetry::frameDropped(uint32_t count) {
+
+    __atomic_add_fetch(&this->m_dropped, count, __ATOMIC_RELAXED); 
+}
+
+void Telemetry::setBuffers(size_t ringSize, double occupancy, size_t backlog) {
+
+    __atomic_store_n(&this->m_ringSize, (uint32_t) ringSize, __ATOMIC_RELAXED); 
+    __atomic_store_n(&this->m_occupancy, (uint32_t) (occupancy * 1000.0), __ATOMIC_RELAXED); 
+    __atomic_store_n(&this->m_backlog, (uint32_t) backlog, __ATOMIC_RELAXED); 
+}
+
+void Telemetry::sample(TelemetryRecord_s *record) {
+
+    memset(record, 0, sizeof(*record)); 
+
+    record->magic     = TELEMETRY_MAGIC; 
+    record->version   = TELEMETRY_VERSION; 
+    record->size      = sizeof(*record); 
+    record->sequence  = this->m_sequence++; 
+
+    struct timespec now; 
+    clock_gettime(CLOCK_MONOTONIC, &now); 
+    record->timestamp = (uint64_t) now.tv_sec * 1000000000u + now.tv_nsec; 
+
+    record->framesAcquired = __atomic_load_n(&this->m_acquired, __ATOMIC_RELAXED); 
+    record->framesStored   = __atomic_load_n(&this->m_stored, __ATOMIC_RELAXED); 
+    record->framesDropped  = __atomic_load_n(&this->m_dropped, __ATOMIC_RELAXED); 
+    record->ringSize       = __atomic_load_n(&this->m_ringSize, __ATOMIC_RELAXED); 
+    record->ringOccupancy  = __atomic_load_n(&this->m_occupancy, __ATOMIC_RELAXED); 
+    record->writerBacklog  = __atomic_load_n(&this->m_backlog, __ATOMIC_RELAXED); 
+
+    struct statvfs fs; 
+    if(statvfs(this->m_directory.c_str(), &fs) == 0) {
+        record->diskFree = (uint64_t) fs.f_bavail * fs.f_frsize; 
+    }
+
+    /* Latency percentiles over the last period */
+    unsigned long histogram[TELEMETRY_LATENCY_BINS]; 
+    unsigned long total = 0; 
+
+    for(unsigned int bin = 0; bin < TELEMETRY_LATENCY_BINS; bin++) {
+        histogram[bin] = __atomic_exchange_n(&this->m_latencies[bin], 0ul, __ATOMIC_RELAXED); 
+        total += histogram[bin]; 
+    }
+
+    if(total > 0) {
+        const double percentiles[3] = {0.50, 0.90, 0.99}; 
+        uint32_t limits[3] = {0, 0, 0}; 
+        unsigned long cumulated = 0; 
+        unsigned int next = 0; 
+
+        for(unsigned int bin = 0; bin < TELEMETRY_LATENCY_BINS; bin++) {
+            cumulated += histogram[bin]; 
+
+            while((next < 3) && (cumulated >= (unsigned long) ceil(percentiles[next] * total))) {
+                limits[next++] = getBinLimit(bin); 
+            }
+
+            if(histogram[bin] > 0) {
+                record->latencyMax = getBinLimit(bin); 
+            }
+        }
+
+        record->latencyP50 = limits[0]; 
+        record->latencyP90 = limits[1]; 
+        record->latencyP99 = limits[2]; 
+    }
+
+    record->crc = crc32(0L, (const Bytef *) record, offsetof(TelemetryRecord_s, crc)); 
+}
+
+unsigned long Telemetry::getCoalesced(void) const {
+
+    return __atomic_load_n(&this->m_coalesced, __ATOMIC_RELAXED); 
+}
+
+void Telemetry::flush(void) {
+
+    if(this->m_sent >= sizeof(TelemetryRecord_s)) {
+        return; 
+    }
+
+    int written = this->m_pipe->send((const char *) &this->m_pending + this->m_sent, 
+                                     sizeof(TelemetryRecord_s) - this->m_sent); 
+
+    if(written > 0) {
+        this->m_sent += written; 
+    }
+
+    /* The reader went away: the next one starts on a record boundary */
+    else if((written < 0) && (this->m_sent > 0)) {
+        this->m_sent = sizeof(TelemetryRecord_s); 
+    }
+}
+
+uint32_t Telemetry::getBinLimit(unsigned int bin) {
+
+    return (uint32_t) ceil(pow(2.0, bin / 4.0)); 
+}
+
+void * Telemetry::thread(void *arg) {
+
+    Telemetry *telemetry = reinterpret_cast<Telemetry *>(arg); 
+    double deadline = getMonotonicTime(); 
+
+    pthread_mutex_lock(&telemetry->m_lock); 
+
+    while(!telemetry->m_stop) {
+
+        deadline += telemetry->m_period / 1000.0; 
+
+        struct timespec ts; 
+        ts.tv_sec  = (time_t) deadline; 
+        ts.tv_nsec = (long) ((deadline - (double) ts.tv_sec) * 1e9); 
+        if(ts.tv_nsec > 999999999L) {
+            ts.tv_nsec = 999999999L; 
+        }
+
+        while(!telemetry->m_stop && (getMonotonicTime() < deadline)) {
+            pthread_cond_timedwait(&telemetry->m_wakeup, &telemetry->m_lock, &ts); 
+        }
+
+        if(telemetry->m_stop) {
+            break; 
+        }
+
+        pthread_mutex_unlock(&telemetry->m_lock); 
+
+        /* Complete a partially sent record first */
+        telemetry->flush(); 
+
+        if(telemetry->m_sent < sizeof(TelemetryRecord_s)) {
+            __atomic_add_fetch(&telemetry->m_coalesced, 1, __ATOMIC_RELAXED); 
+        }
+
+        /* A record not started yet is replaced by the most recent one */
+        if((telemetry->m_sent == 0) || (telemetry->m_sent == sizeof(TelemetryRecord_s))) {
+            telemetry->sample(&telemetry->m_pending); 
+            telemetry->m_sent = 0; 
+            telemetry->flush(); 
+        }
+
+        /* Skip the missed periods rather than catching up */
+        if(deadline < getMonotonicTime()) {
+            deadline = getMonotonicTime(); 
+        }
+
+        pthread_mutex_lock(&telemetry->m_lock); 
+    }
+
+    pthread_mutex_unlock(&telemetry->m_lock); 
+
+    return NULL; 
+}
@@ -0,0 +1,253 @@
+/**
+ * @file temporal_binner.cpp
+ * @brief Temporal binning class implementation.
+ */
+
+#include "temporal_binner.hpp"
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+/** @brief The AVX2 implementation can be compiled in. */
+#define BINNER_AVX2
+#endif
+
+/** @brief Adds @p size pixels to the sums, or sets the sums for the first frame of a bin. */
+static void accumulate(uint16_t *sum, const unsigned char *pixels, size_t size, bool first) {
+
+    size_t incr = 0;
+
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+
+    for(; incr + 16 <= size; incr += 16) {
+        __m128i p  = _mm_loadu_si128((const __m128i *) (pixels + incr));
+        __m128i lo = _mm_unpacklo_epi8(p, zero);
+        __m128i hi = _mm_unpackhi_epi8(p, zero);
+
+        if(!first) {
+            lo = _mm_add_epi16(lo, _mm_loadu_si128((const __m128i *) (sum + incr)));
+            hi = _mm_add_epi16(hi, _mm_loadu_si128((const __m128i *) (sum + incr + 8)));
+        }
+
+        _mm_storeu_si128((__m128i *) (sum + incr), lo);
+        _mm_storeu_si128((__m128i *) (sum + incr + 8), hi);
+    }
+#endif
+
+    for(; incr < size; incr++) {
+        sum[incr] = first ? pixels[incr] : sum[incr] + pixels[incr];
+    }
+}
+
+#ifdef BINNER_AVX2
+/** @brief AVX2 version of @ref accumulate(). */
+__attribute__((target("avx2")))
+static void accumulateAVX2(uint16_t *sum, const unsigned char *pixels, size_t size, bool first) {
+
+    size_t incr = 0;
+
+    for(; incr + 32 <= size; incr += 32) {
+        __m256i lo = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *) (pixels + incr)));
+        __m256i hi = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *) (pixels + incr + 16)));
+
+        if(!first) {
+            lo = _mm256_add_epi16(lo, _mm256_loadu_si256((const __m256i *) (sum + incr)));
+            hi = _mm256_add_epi16(hi, _mm256_loadu_si256((const __m256i *) (sum + incr + 16)));
+        }
+
+        _mm256_storeu_si256((__m256i *) (sum + incr), lo);
+        _mm256_storeu_si256((__m256i *) (sum + incr + 16), hi);
+    }
+
+    accumulate(sum + incr, pixels + incr, size - incr, first);
+}
+#endif
+
+/** @brief Writes the output pixels from the sums of @p factor frames. */
+static void finish(unsigned char *pixels, const uint16_t *sum, size_t size, unsigned int factor, BinningMode_e mode) {
+
+    size_t incr = 0;
+
+#ifdef __SSE2__
+    const __m128i zero  = _mm_setzero_si128();
+    const __m128i clamp = _mm_set1_epi16((short) 0xFF00);
+
+    /* Mean: (sum + factor / 2 + 0.5) / factor, in single precision. The extra half keeps
+     * the rounding errors away from the integer boundaries (they are below 1e-4). */
+    const __m128 bias    = _mm_set1_ps(factor / 2 + 0.5f);
+    const __m128 inverse = _mm_set1_ps(1.0f / factor);
+
+    for(; incr + 16 <= size; incr += 16) {
+        __m128i lo = _mm_loadu_si128((const __m128i *) (sum + incr));
+        __m128i hi = _mm_loadu_si128((const __m128i *) (sum + incr + 8));
+
+        if(mode == BINNING_MEAN) {
+            __m128i q0 = _mm_cvttps_epi32(_mm_mul_ps(_mm_add_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), bias), inverse));
+            __m128i q1 = _mm_cvttps_epi32(_mm_mul_ps(_mm_add_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), bias), inverse));
+            __m128i q2 = _mm_cvttps_epi32(_mm_mul_ps(_mm_add_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), bias), inverse));
+            __m128i q3 = _mm_cvttps_epi32(_mm_mul_ps(_mm_add_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), bias), inverse));
+            lo = _mm_packs_epi32(q0, q1);
+            hi = _mm_packs_epi32(q2, q3);
+        }
+        else {
+            /* min(x, 255): the packing saturates signed values */
+            lo = _mm_subs_epu16(_mm_adds_epu16(lo, clamp), clamp);
+            hi = _mm_subs_epu16(_mm_adds_epu16(hi, clamp), clamp);
+        }
+
+        _mm_storeu_si128((__m128i *) (pixels + incr), _mm_packus_epi16(lo, hi));
+    }
+#endif
+
+    for(; incr < size; incr++) {
+        if(mode == BINNING_MEAN) {
+            pixels[incr] = (unsigned char) ((sum[incr] + factor / 2) / factor);
+        }
+        else {
+            pixels[incr] = (unsigned char) ((sum[incr] > 0xFF) ? 0xFF : sum[incr]);
+        }
+    }
+}
+
+TemporalBinner::TemporalBinner(unsigned int width, unsigned int height, unsigned int factor,
+                               BinningMode_e mode, unsigned int nbOfOutputs) :
+        m_width(width), m_height(height), m_mode(mode), m_factor(1), m_binFactor(1), m_count(0),
+        m_restart(false), m_nbOfOutputs(nbOfOutputs), m_next(0), m_isPending(NULL), m_dropped(0),
+        m_avx2(false) {
+
+    this->setFactor(factor);
+
+    if(this->m_nbOfOutputs == 0) {
+        this->m_nbOfOutputs = 1;
+    }
+
+    this->m_sum     = new uint16_t[(size_t) width * height];
+    this->m_outputs = new Image *[this->m_nbOfOutputs];
+
+    for(unsigned int incr = 0; incr < this->m_nbOfOutputs; incr++) {
+        this->m_outputs[incr] = new Image(width, height);
+    }
+
+#ifdef BINNER_AVX2
+    this->m_avx2 = __builtin_cpu_supports("avx2");
+#endif
+}
+
+TemporalBinner::~TemporalBinner() {
+
+    for(unsigned int incr = 0; incr < this->m_nbOfOutputs; incr++) {
+        delete this->m_outputs[incr];
+    }
+
+    delete [] this->m_outputs;
+    delete [] this->m_sum;
+}
+
+bool TemporalBinner::setFactor(unsigned int factor) {
+
+    if((factor == 0) || (factor > BINNER_MAX_FACTOR)) {
+        return false;
+    }
+
+    __atomic_store_n(&this->m_factor, factor, __ATOMIC_RELAXED);
+
+    return true;
+}
+
+unsigned int TemporalBinner::getFactor(void) const {
+
+    return __atomic_load_n(&this->m_factor, __ATOMIC_RELAXED);
+}
+
+void TemporalBinner::restart(void) {
+
+    __atomic_store_n(&this->m_restart, true, __ATOMIC_RELAXED);
+}
+
+void TemporalBinner::setPendingCheck(bool (*isPending)(const Image *output)) {
+
+    this->m_isPending = isPending;
+}
+
+Image * TemporalBinner::add(const Image *frame) {
+
+    if(!this->push(frame)) {
+        return NULL;
+    }
+
+    /* Outputs still queued for writing are never overwritten */
+    Image *output = NULL;
+    for(unsigned int incr = 0; (incr < this->m_nbOfOutputs) && (output == NULL); incr++) {
+        Image *candidate = this->m_outputs[this->m_next];
+        this->m_next = (this->m_next + 1) % this->m_nbOfOutputs;
+
+        if((this->m_isPending == NULL) || !this->m_isPending(candidate)) {
+            output = candidate;
+        }
+    }
+
+    if(output == NULL) {
+        this->m_dropped++;
+        return NULL;
+    }
+
+    this->getBin(output);
+
+    return output;
+}
+
+unsigned long TemporalBinner::getDropped(void) const {
+
+    return this->m_dropped;
+}
+
+bool TemporalBinner::push(const Image *frame) {
+
+    if((frame->getWidth() != this->m_width) || (frame->getHeight() != this->m_height)) {
+        return false;
+    }
+
+    if(__atomic_exchange_n(&this->m_restart, false, __ATOMIC_RELAXED)) {
+        this->m_count = 0;
+    }
+
+    /* The factor is only read at the start of a bin */
+    if(this->m_count == 0) {
+        this->m_binFactor = this->getFactor();
+    }
+
+    const unsigned char *pixels = (const unsigned char *) frame->getImageBuffer();
+    size_t size = (size_t) this->m_width * this->m_height;
+
+#ifdef BINNER_AVX2
+    if(this->m_avx2) {
+        accumulateAVX2(this->m_sum, pixels, size, this->m_count == 0);
+    }
+    else
+#endif
+    {
+        accumulate(this->m_sum, pixels, size, this->m_count == 0);
+    }
+
+    this->m_count++;
+    if(this->m_count < this->m_binFactor) {
+        return false;
+    }
+
+    this->m_count = 0;
+
+    return true;
+}
+
+bool TemporalBinner::getBin(Image *output) const {
+
+    if((output->getWidth() != this->m_width) || (output->getHeight() != this->m_height)) {
+        return false;
+    }
+
+    finish((unsigned char *) output->getImageBuffer(), this->m_sum, (size_t) this->m_width * this->m_height,
+           this->m_binFactor, this->m_mode);
+
+    return true;
+}
@@ -0,0 +1,469 @@
+/**
+ * @file temporal_codec.cpp
+ * @brief Lossless inter-frame codec class implementations.
+ */
+
+#include "temporal_codec.hpp"
+#include "crc32c.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+/** @brief The AVX2 implementation can be compiled in. */
+#define TEMPORAL_AVX2
+#endif
+
+/** @brief Header of a stream file. */
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t keyInterval;
+}StreamHeader_s;
+
+/** @brief Header of a frame record. */
+typedef struct {
+    uint32_t frame;
+    uint32_t type;
+    uint32_t size;
+    uint32_t crc;
+}RecordHeader_s;
+
+/** @brief Residual @p current - @p previous of @p size pixels, modulo 256. */
+static void subtract(unsigned char *residual, const unsigned char *current, const unsigned char *previous, size_t size) {
+
+    size_t incr = 0;
+
+#ifdef __SSE2__
+    for(; incr + 16 <= size; incr += 16) {
+        __m128i c = _mm_loadu_si128((const __m128i *) (current + incr));
+        __m128i p = _mm_loadu_si128((const __m128i *) (previous + incr));
+        _mm_storeu_si128((__m128i *) (residual + incr), _mm_sub_epi8(c, p));
+    }
+#endif
+
+    for(; incr < size; incr++) {
+        residual[incr] = (unsigned char) (current[incr] - previous[incr]);
+    }
+}
+
+/** @brief Adds a residual to the previous frame, in place. */
+static void accumulate(unsigned char *frame, const unsigned char *residual, size_t size) {
+
+    size_t incr = 0;
+
+#ifdef __SSE2__
+    for(; incr + 16 <= size; incr += 16) {
+        __m128i f = _mm_loadu_si128((const __m128i *) (frame + incr));
+        __m128i r = _mm_loadu_si128((const __m128i *) (residual + incr));
+        _mm_storeu_si128((__m128i *) (frame + incr), _mm_add_epi8(f, r));
+    }
+#endif
+
+    for(; incr < size; incr++) {
+        frame[incr] = (unsigned char) (frame[incr] + residual[incr]);
+    }
+}
+
+#ifdef TEMPORAL_AVX2
+/** @brief AVX2 version of @ref subtract(). */
+__attribute__((target("avx2")))
+static void subtractAVX2(unsigned char *residual, const unsigned char *current, const unsigned char *previous, size_t size) {
+
+    size_t incr = 0;
+
+    for(; incr + 32 <= size; incr += 32) {
+        __m256i c = _mm256_loadu_si256((const __m256i *) (current + incr));
+        __m256i p = _mm256_loadu_si256((const __m256i *) (previous + incr));
+        _mm256_storeu_si256((__m256i *) (residual + incr), _mm256_sub_epi8(c, p));
+    }
+
+    subtract(residual + incr, current + incr, previous + incr, size - incr);
+}
+
+/** @brief AVX2 version of @ref accumulate(). */
+__attribute__((target("avx2")))
+static void accumulateAVX2(unsigned char *frame, const unsigned char *residual, size_t size) {
+
+    size_t incr = 0;
+
+    for(; incr + 32 <= size; incr += 32) {
+        __m256i f = _mm256_loadu_si256((const __m256i *) (frame + incr));
+        __m256i r = _mm256_loadu_si256((const __m256i *) (residual + incr));
+        _mm256_storeu_si256((__m256i *) (frame + incr), _mm256_add_epi8(f, r));
+    }
+
+    accumulate(frame + incr, residual + incr, size - incr);
+}
+#endif
+
+/** @brief Indicates that the processor supports AVX2. */
+static bool hasAVX2(void) {
+
+#ifdef TEMPORAL_AVX2
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief Lists the complete records of a stream.
+ * @returns Offset of the end of the last complete record.
+ */
+static off_t listRecords(int fd, const StreamHeader_s &header, std::vector<TemporalRecord_s> *records) {
+
+    struct stat info;
+    if(fstat(fd, &info) != 0) {
+        return sizeof(StreamHeader_s);
+    }
+
+    size_t bound  = FrameCodec::bound((size_t) header.width * header.height);
+    off_t  offset = sizeof(StreamHeader_s);
+    bool   first  = true;
+
+    while(offset + (off_t) sizeof(RecordHeader_s) <= info.st_size) {
+        RecordHeader_s record;
+        if(pread(fd, &record, sizeof(record), offset) != sizeof(record)) {
+            break;
+        }
+
+        /* A torn or corrupted record ends the stream, the first one must be a keyframe */
+        off_t end = offset + sizeof(record) + record.size;
+        if((record.type > TEMPORAL_RESIDUAL) || (record.size > bound) || (end > info.st_size) ||
+           (first && (record.type != TEMPORAL_KEYFRAME))) {
+            break;
+        }
+
+        if(records != NULL) {
+            TemporalRecord_s entry;
+            entry.offset = offset;
+            entry.frame  = record.frame;
+            entry.type   = record.type;
+            entry.size   = record.size;
+            entry.crc    = record.crc;
+            records->push_back(entry);
+        }
+
+        first  = false;
+        offset = end;
+    }
+
+    return offset;
+}
+
+TemporalEncoder::TemporalEncoder(unsigned int width, unsigned int height, unsigned int keyInterval) :
+        m_width(width), m_height(height), m_keyInterval(keyInterval), m_fd(-1), m_end(0), m_sinceKey(0),
+        m_nbOfFrames(0), m_bytesWritten(0) {
+
+    if(this->m_keyInterval == 0) {
+        this->m_keyInterval = 1;
+    }
+
+    size_t size = (size_t) width * height;
+    this->m_recordSize = sizeof(RecordHeader_s) + FrameCodec::bound(size);
+
+    this->m_previous = new unsigned char[size];
+    this->m_residual = new unsigned char[size];
+    this->m_record   = new unsigned char[this->m_recordSize];
+
+    pthread_mutex_init(&this->m_lock, NULL);
+}
+
+TemporalEncoder::~TemporalEncoder() {
+
+    if(this->m_fd >= 0) {
+        close(this->m_fd);
+    }
+
+    pthread_mutex_destroy(&this->m_lock);
+
+    delete [] this->m_record;
+    delete [] this->m_residual;
+    delete [] this->m_previous;
+}
+
+bool TemporalEncoder::open(const std::string &filename) {
+
+    int fd = ::open(filename.c_str(), O_RDWR | O_CREAT, 0644);
+    if(fd < 0) {
+        return false;
+    }
+
+    StreamHeader_s header;
+    ssize_t length = pread(fd, &header, sizeof(header), 0);
+    off_t end = sizeof(header);
+
+    /* Existing stream: append after its last complete record */
+    if(length == sizeof(header)) {
+        if((header.magic != TEMPORAL_MAGIC) || (header.version != TEMPORAL_VERSION) ||
+           (header.width != this->m_width) || (header.height != this->m_height)) {
+            close(fd);
+            return false;
+        }
+
+        end = listRecords(fd, header, NULL);
+    }
+    else {
+        header.magic       = TEMPORAL_MAGIC;
+        header.version     = TEMPORAL_VERSION;
+        header.width       = this->m_width;
+        header.height      = this->m_height;
+        header.keyInterval = this->m_keyInterval;
+
+        if(pwrite(fd, &header, sizeof(header), 0) != sizeof(header)) {
+            close(fd);
+            return false;
+        }
+    }
+
+    if(ftruncate(fd, end) != 0) {
+        close(fd);
+        return false;
+    }
+
+    pthread_mutex_lock(&this->m_lock);
+
+    if(this->m_fd >= 0) {
+        close(this->m_fd);
+    }
+
+    this->m_fd       = fd;
+    this->m_end      = end;
+    this->m_sinceKey = 0;
+
+    pthread_mutex_unlock(&this->m_lock);
+
+    return true;
+}
+
+bool TemporalEncoder::add(const Image *frame, unsigned int number) {
+
+    if((frame->getWidth() != this->m_width) || (frame->getHeight() != this->m_height)) {
+        return false;
+    }
+
+    const unsigned char *pixels = (const unsigned char *) frame->getImageBuffer();
+    size_t size = (size_t) this->m_width * this->m_height;
+
+    pthread_mutex_lock(&this->m_lock);
+
+    if(this->m_fd < 0) {
+        pthread_mutex_unlock(&this->m_lock);
+        return false;
+    }
+
+    RecordHeader_s header;
+    header.frame = number;
+    header.type  = (this->m_sinceKey == 0) ? TEMPORAL_KEYFRAME : TEMPORAL_RESIDUAL;
+    header.crc   = crc32c(0, pixels, size);
+
+    const unsigned char *source = pixels;
+    if(header.type == TEMPORAL_RESIDUAL) {
+        if(hasAVX2()) {
+#ifdef TEMPORAL_AVX2
+            subtractAVX2(this->m_residual, pixels, this->m_previous, size);
+#endif
+        }
+        else {
+            subtract(this->m_residual, pixels, this->m_previous, size);
+        }
+        source = this->m_residual;
+    }
+
+    header.size = this->m_codec.compress((const pixel_t *) source, size, this->m_record + sizeof(header),
+                                         this->m_recordSize - sizeof(header));
+    memcpy(this->m_record, &header, sizeof(header));
+
+    size_t length = sizeof(header) + header.size;
+    bool written = (header.size > 0) && (pwrite(this->m_fd, this->m_record, length, this->m_end) == (ssize_t) length);
+
+    if(written) {
+        memcpy(this->m_previous, pixels, size);
+        this->m_end      += length;
+        this->m_sinceKey  = (this->m_sinceKey + 1) % this->m_keyInterval;
+        this->m_nbOfFrames++;
+        this->m_bytesWritten += length;
+    }
+    else {
+        /* Drop what was written of the record: the stream restarts with a keyframe */
+        if(ftruncate(this->m_fd, this->m_end) != 0) {
+            close(this->m_fd);
+            this->m_fd = -1;
+        }
+        this->m_sinceKey = 0;
+    }
+
+    pthread_mutex_unlock(&this->m_lock);
+
+    return written;
+}
+
+bool TemporalEncoder::sync(void) {
+
+    pthread_mutex_lock(&this->m_lock);
+    bool synced = (this->m_fd >= 0) && (fdatasync(this->m_fd) == 0);
+    pthread_mutex_unlock(&this->m_lock);
+
+    return synced;
+}
+
+unsigned long TemporalEncoder::getNbOfFrames(void) {
+
+    pthread_mutex_lock(&this->m_lock);
+    unsigned long frames = this->m_nbOfFrames;
+    pthread_mutex_unlock(&this->m_lock);
+
+    return frames;
+}
+
+unsigned long long TemporalEncoder::getBytesWritten(void) {
+
+    pthread_mutex_lock(&this->m_lock);
+    unsigned long long bytes = this->m_bytesWritten;
+    pthread_mutex_unlock(&this->m_lock);
+
+    return bytes;
+}
+
+TemporalDecoder::TemporalDecoder(void) : m_fd(-1), m_width(0), m_height(0), m_current(NULL), m_currentIndex(-1),
+        m_residual(NULL), m_payload(NULL), m_payloadSize(0) {
+}
+
+TemporalDecoder::~TemporalDecoder() {
+
+    if(this->m_fd >= 0) {
+        close(this->m_fd);
+    }
+
+    delete [] this->m_payload;
+    delete [] this->m_residual;
+    delete [] this->m_current;
+}
+
+bool TemporalDecoder::open(const std::string &filename) {
+
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if(fd < 0) {
+        return false;
+    }
+
+    StreamHeader_s header;
+    if((pread(fd, &header, sizeof(header), 0) != sizeof(header)) || (header.magic != TEMPORAL_MAGIC) ||
+       (header.version != TEMPORAL_VERSION) || (header.width == 0) || (header.height == 0)) {
+        close(fd);
+        return false;
+    }
+
+    if(this->m_fd >= 0) {
+        close(this->m_fd);
+    }
+
+    this->m_fd     = fd;
+    this->m_width  = header.width;
+    this->m_height = header.height;
+
+    this->m_records.clear();
+    listRecords(fd, header, &this->m_records);
+
+    size_t size = (size_t) this->m_width * this->m_height;
+
+    delete [] this->m_current;
+    delete [] this->m_residual;
+    delete [] this->m_payload;
+    this->m_current      = new unsigned char[size];
+    this->m_residual     = new unsigned char[size];
+    this->m_payloadSize  = FrameCodec::bound(size);
+    this->m_payload      = new unsigned char[this->m_payloadSize];
+    this->m_currentIndex = -1;
+
+    return true;
+}
+
+unsigned int TemporalDecoder::getWidth(void) const {
+
+    return this->m_width;
+}
+
+unsigned int TemporalDecoder::getHeight(void) const {
+
+    return this->m_height;
+}
+
+size_t TemporalDecoder::getNbOfFrames(void) const {
+
+    return this->m_records.size();
+}
+
+const TemporalRecord_s & TemporalDecoder::getRecord(size_t index) const {
+
+    return this->m_records[index];
+}
+
+bool TemporalDecoder::read(size_t index, Image *image) {
+
+    if((index >= this->m_records.size()) || (image->getWidth() != this->m_width) ||
+       (image->getHeight() != this->m_height)) {
+        return false;
+    }
+
+    /* Decode from the keyframe, or go on from the frame read last */
+    size_t first = index;
+    while(this->m_records[first].type != TEMPORAL_KEYFRAME) {
+        first--;
+    }
+
+    if((this->m_currentIndex >= (long) first) && (this->m_currentIndex <= (long) index)) {
+        first = this->m_currentIndex + 1;
+    }
+
+    for(size_t incr = first; incr <= index; incr++) {
+        if(!this->decode(incr)) {
+            this->m_currentIndex = -1;
+            return false;
+        }
+        this->m_currentIndex = incr;
+    }
+
+    memcpy(image->getImageBuffer(), this->m_current, (size_t) this->m_width * this->m_height);
+
+    return true;
+}
+
+bool TemporalDecoder::decode(size_t index) {
+
+    const TemporalRecord_s &record = this->m_records[index];
+    size_t size = (size_t) this->m_width * this->m_height;
+
+    if(pread(this->m_fd, this->m_payload, record.size, record.offset + sizeof(RecordHeader_s)) != (ssize_t) record.size) {
+        return false;
+    }
+
+    if(record.type == TEMPORAL_KEYFRAME) {
+        if(!this->m_codec.decompress(this->m_payload, record.size, (pixel_t *) this->m_current, size)) {
+            return false;
+        }
+    }
+    else {
+        /* The residual is decoded next to the previous frame, then added to it */
+        if(!this->m_codec.decompress(this->m_payload, record.size, (pixel_t *) this->m_residual, size)) {
+            return false;
+        }
+
+        if(hasAVX2()) {
+#ifdef TEMPORAL_AVX2
+            accumulateAVX2(this->m_current, this->m_residual, size);
+#endif
+        }
+        else {
+            accumulate(this->m_current, this->m_residual, size);
+        }
+    }
+
+    return (crc32c(0, this->m_current, size) == record.crc);
+}
@@ -0,0 +1,452 @@
+/**
+ * @file tiered_storage.cpp
+ * @brief Tiered frame storage class implementation.
+ */
+
+#include "tiered_storage.hpp"
+#include "utilities.hpp"
+
+#include <algorithm>
+#include <ctype.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+/** @brief Size of the copy buffer, in bytes. */
+#define TIER_COPY_BUFFER    (1024u * 1024u)
+
+TieredStorage::TieredStorage(const std::string &tierPath, const std::string &extension, OutputDirectory *persistent,
+                             FrameJournal *journal, size_t capacity, unsigned int batchSize, unsigned int batchDelay,
+                             double rate) :
+        m_tierPath(tierPath), m_persistent(persistent), m_journal(journal), m_capacity(capacity),
+        m_batchSize(batchSize), m_batchDelay(batchDelay), m_rate(rate), m_used(0), m_oldest(0.0),
+        m_added(0), m_processed(0), m_migrated(0), m_failed(0), m_buffer(TIER_COPY_BUFFER),
+        m_flush(false), m_stop(false) {
+
+    if(this->m_batchSize == 0) {
+        this->m_batchSize = 1;
+    }
+
+    this->m_tier   = new OutputDirectory(tierPath, extension);
+    this->m_tierFd = open(tierPath.c_str(), O_RDONLY | O_DIRECTORY);
+
+    this->m_pending.reserve(2 * this->m_batchSize);
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+
+    pthread_mutex_init(&this->m_lock, NULL);
+    pthread_cond_init(&this->m_wakeup, &attr);
+    pthread_cond_init(&this->m_room, NULL);
+    pthread_cond_init(&this->m_done, NULL);
+    pthread_condattr_destroy(&attr);
+
+    pthread_create(&this->m_thread, NULL, &thread, this);
+}
+
+TieredStorage::~TieredStorage() {
+
+    /* Clean shutdown: nothing is left in the tier */
+    pthread_mutex_lock(&this->m_lock);
+    this->m_stop = true;
+    pthread_cond_signal(&this->m_wakeup);
+    pthread_mutex_unlock(&this->m_lock);
+
+    pthread_join(this->m_thread, NULL);
+
+    pthread_cond_destroy(&this->m_done);
+    pthread_cond_destroy(&this->m_room);
+    pthread_cond_destroy(&this->m_wakeup);
+    pthread_mutex_destroy(&this->m_lock);
+
+    if(this->m_tierFd >= 0) {
+        close(this->m_tierFd);
+    }
+
+    delete this->m_tier;
+}
+
+bool TieredStorage::isOpen(void) const {
+
+    return this->m_tier->isOpen() && (this->m_tierFd >= 0);
+}
+
+FILE * TieredStorage::openFile(unsigned int frame) {
+
+    pthread_mutex_lock(&this->m_lock);
+
+    /* Full tier: the migration frees room, a flush makes it go at full speed */
+    while((this->m_used >= this->m_capacity) && !this->m_index.empty()) {
+        this->m_flush = true;
+        pthread_cond_signal(&this->m_wakeup);
+        pthread_cond_wait(&this->m_room, &this->m_lock);
+    }
+
+    pthread_mutex_unlock(&this->m_lock);
+
+    return this->m_tier->openFile(frame);
+}
+
+void TieredStorage::add(unsigned int frame, FILE *fp, bool written) {
+
+    Pending_s pending;
+    pending.frame = frame;
+    pending.size  = 0;
+
+    /* A failed buffered write (e.g. a full tier) leaves a truncated file */
+    struct stat info;
+    written = written && (fflush(fp) == 0) && !ferror(fp) && (fstat(fileno(fp), &info) == 0);
+    if(written) {
+        pending.size = info.st_size;
+    }
+    fclose(fp);
+
+    if(!written) {
+        unlinkat(this->m_tierFd, this->m_tier->getFilename(frame), 0);
+
+        pthread_mutex_lock(&this->m_lock);
+        this->m_failed++;
+        pthread_mutex_unlock(&this->m_lock);
+        return;
+    }
+
+    pthread_mutex_lock(&this->m_lock);
+
+    this->m_pending.push_back(pending);
+    this->m_index[frame] = pending.size;
+    this->m_used += pending.size;
+    this->m_added++;
+
+    /* Wake the migrator up to arm the batch deadline, or to migrate a full batch */
+    if(this->m_pending.size() == 1) {
+        this->m_oldest = getMonotonicTime();
+        pthread_cond_signal(&this->m_wakeup);
+    }
+    else if(this->m_pending.size() >= this->m_batchSize) {
+        pthread_cond_signal(&this->m_wakeup);
+    }
+
+    pthread_mutex_unlock(&this->m_lock);
+}
+
+void TieredStorage::flush(void) {
+
+    pthread_mutex_lock(&this->m_lock);
+
+    unsigned long target = this->m_added;
+    this->m_flush = true;
+    pthread_cond_signal(&this->m_wakeup);
+
+    while(this->m_processed < target) {
+        pthread_cond_wait(&this->m_done, &this->m_lock);
+    }
+
+    pthread_mutex_unlock(&this->m_lock);
+}
+
+std::string TieredStorage::locate(unsigned int frame) {
+
+    pthread_mutex_lock(&this->m_lock);
+    bool inTier = (this->m_index.find(frame) != this->m_index.end());
+    pthread_mutex_unlock(&this->m_lock);
+
+    if(inTier) {
+        return this->m_tierPath + "/" + this->m_tier->getFilename(frame);
+    }
+
+    return this->m_persistent->getPath() + "/" + this->m_persistent->getFilename(frame);
+}
+
+size_t TieredStorage::getBacklog(void) {
+
+    pthread_mutex_lock(&this->m_lock);
+    size_t backlog = this->m_index.size();
+    pthread_mutex_unlock(&this->m_lock);
+
+    return backlog;
+}
+
+size_t TieredStorage::getUsedBytes(void) {
+
+    pthread_mutex_lock(&this->m_lock);
+    size_t used = this->m_used;
+    pthread_mutex_unlock(&this->m_lock);
+
+    return used;
+}
+
+size_t TieredStorage::getCapacity(void) const {
+
+    return this->m_capacity;
+}
+
+unsigned long TieredStorage::getMigrated(void) {
+
+    pthread_mutex_lock(&this->m_lock);
+    unsigned long migrated = this->m_migrated;
+    pthread_mutex_unlock(&this->m_lock);
+
+    return migrated;
+}
+
+unsigned long TieredStorage::getFailed(void) {
+
+    pthread_mutex_lock(&this->m_lock);
+    unsigned long failed = this->m_failed;
+    pthread_mutex_unlock(&this->m_lock);
+
+    return failed;
+}
+
+unsigned int TieredStorage::recover(const std::string &tierPath, OutputDirectory *persistent) {
+
+    DIR *dir = opendir(tierPath.c_str());
+    if(dir == NULL) {
+        return 0;
+    }
+
+    std::vector<unsigned int> frames;
+    struct dirent *entry;
+
+    while((entry = readdir(dir)) != NULL) {
+        if((strncmp(entry->d_name, "image", 5) != 0) || !isdigit(entry->d_name[5])) {
+            continue;
+        }
+
+        /* Same name as the persistent frame, whatever its shard */
+        unsigned int frame = strtoul(entry->d_name + 5, NULL, 10);
+        const char *expected = persistent->getFilename(frame);
+        const char *slash = strrchr(expected, '/');
+
+        if(strcmp(entry->d_name, (slash != NULL) ? slash + 1 : expected) == 0) {
+            frames.push_back(frame);
+        }
+    }
+
+    int dirfd = open(tierPath.c_str(), O_RDONLY | O_DIRECTORY);
+    std::vector<char> buffer(TIER_COPY_BUFFER);
+    unsigned int moved = 0;
+
+    for(size_t incr = 0; (dirfd >= 0) && (incr < frames.size()); incr++) {
+        const char *expected = persistent->getFilename(frames[incr]);
+        const char *slash = strrchr(expected, '/');
+        std::string name = (slash != NULL) ? slash + 1 : expected;
+
+        size_t size = 0;
+        int fd = copyFrame(dirfd, name.c_str(), persistent, frames[incr], buffer, &size);
+        if(fd < 0) {
+            continue;
+        }
+
+        bool synced = (fdatasync(fd) == 0);
+        close(fd);
+
+        if(synced) {
+            unlinkat(dirfd, name.c_str(), 0);
+            moved++;
+        }
+    }
+
+    if(dirfd >= 0) {
+        close(dirfd);
+    }
+    closedir(dir);
+
+    persistent->sync();
+
+    return moved;
+}
+
+void TieredStorage::migrateBatch(std::vector<Pending_s> &batch) {
+
+    std::vector<unsigned int> order;
+    std::map<unsigned int, int> copies;
+    order.reserve(batch.size());
+
+    for(size_t incr = 0; incr < batch.size(); incr++) {
+        order.push_back(batch[incr].frame);
+    }
+
+    /* Frame order: consecutive files, written sequentially */
+    std::sort(order.begin(), order.end());
+
+    double start = getMonotonicTime();
+    size_t copied = 0;
+
+    for(size_t incr = 0; incr < order.size(); incr++) {
+        size_t size = 0;
+        int fd = copyFrame(this->m_tierFd, this->m_tier->getFilename(order[incr]), this->m_persistent,
+                           order[incr], this->m_buffer, &size);
+        if(fd < 0) {
+            continue;
+        }
+
+        copies[order[incr]] = fd;
+        sync_file_range(fd, 0, 0, SYNC_FILE_RANGE_WRITE);
+        copied += size;
+
+        /* Rate limit, lifted by a flush */
+        pthread_mutex_lock(&this->m_lock);
+        bool limited = (this->m_rate > 0.0) && !this->m_flush && !this->m_stop;
+        pthread_mutex_unlock(&this->m_lock);
+
+        if(limited) {
+            double ahead = copied / this->m_rate - (getMonotonicTime() - start);
+            if(ahead > 0.0) {
+                usleep((useconds_t) (ahead * 1e6));
+            }
+        }
+    }
+
+    std::vector<unsigned int> frames;
+    frames.reserve(copies.size());
+
+    for(std::map<unsigned int, int>::iterator it = copies.begin(); it != copies.end(); ++it) {
+        if(fdatasync(it->second) == 0) {
+            frames.push_back(it->first);
+        }
+        close(it->second);
+    }
+
+    /* New directory entries must reach the disk too */
+    this->m_persistent->sync();
+
+    bool journaled = frames.empty() || this->m_journal->append(&frames[0], frames.size());
+
+    /* The tier copy is only removed once the frame is committed. The frames that could
+     * not be migrated are left in the tier for recover(), out of the index. */
+    if(journaled) {
+        for(size_t incr = 0; incr < frames.size(); incr++) {
+            unlinkat(this->m_tierFd, this->m_tier->getFilename(frames[incr]), 0);
+        }
+    }
+
+    size_t freed = 0;
+
+    pthread_mutex_lock(&this->m_lock);
+
+    for(size_t incr = 0; incr < batch.size(); incr++) {
+        std::map<unsigned int, size_t>::iterator it = this->m_index.find(batch[incr].frame);
+
+        if(it != this->m_index.end()) {
+            freed += it->second;
+            this->m_index.erase(it);
+        }
+    }
+
+    if(journaled) {
+        this->m_migrated += frames.size();
+        this->m_failed   += batch.size() - frames.size();
+    }
+    else {
+        this->m_failed   += batch.size();
+    }
+
+    this->m_used      -= freed;
+    this->m_processed += batch.size();
+    pthread_cond_broadcast(&this->m_room);
+    pthread_cond_broadcast(&this->m_done);
+
+    pthread_mutex_unlock(&this->m_lock);
+
+    batch.clear();
+}
+
+int TieredStorage::copyFrame(int dirfd, const char *name, OutputDirectory *persistent, unsigned int frame,
+                             std::vector<char> &buffer, size_t *size) {
+
+    int src = openat(dirfd, name, O_RDONLY);
+    if(src < 0) {
+        return -1;
+    }
+
+    int dst = persistent->open(frame);
+    if(dst < 0) {
+        close(src);
+        return -1;
+    }
+
+    *size = 0;
+    ssize_t length;
+
+    while((length = read(src, &buffer[0], buffer.size())) > 0) {
+        ssize_t written = 0;
+        while(written < length) {
+            ssize_t result = write(dst, &buffer[written], length - written);
+            if(result <= 0) {
+                close(src);
+                close(dst);
+                return -1;
+            }
+            written += result;
+        }
+        *size += length;
+    }
+
+    close(src);
+
+    if(length < 0) {
+        close(dst);
+        return -1;
+    }
+
+    return dst;
+}
+
+void * TieredStorage::thread(void *arg) {
+
+    TieredStorage *storage = reinterpret_cast<TieredStorage *>(arg);
+    std::vector<Pending_s> batch;
+    batch.reserve(2 * storage->m_batchSize);
+
+    pthread_mutex_lock(&storage->m_lock);
+
+    while(true) {
+
+        bool due = !storage->m_pending.empty() &&
+                   (storage->m_flush || storage->m_stop ||
+                    (storage->m_pending.size() >= storage->m_batchSize) ||
+                    (getMonotonicTime() - storage->m_oldest) * 1000.0 >= storage->m_batchDelay);
+
+        if(!due) {
+            storage->m_flush = false;
+
+            if(storage->m_stop) {
+                break;
+            }
+
+            /* Sleep until the batch is full or the oldest frame reaches its deadline */
+            if(storage->m_pending.empty()) {
+                pthread_cond_wait(&storage->m_wakeup, &storage->m_lock);
+            }
+            else {
+                double deadline = storage->m_oldest + storage->m_batchDelay / 1000.0;
+                struct timespec ts;
+                ts.tv_sec  = (time_t) deadline;
+                ts.tv_nsec = (long) ((deadline - (double) ts.tv_sec) * 1e9);
+                if(ts.tv_nsec > 999999999L) {
+                    ts.tv_nsec = 999999999L;
+                }
+                pthread_cond_timedwait(&storage->m_wakeup, &storage->m_lock, &ts);
+            }
+            continue;
+        }
+
+        /* Take the whole batch, writers keep adding frames meanwhile */
+        batch.swap(storage->m_pending);
+        pthread_mutex_unlock(&storage->m_lock);
+
+        storage->migrateBatch(batch);
+
+        pthread_mutex_lock(&storage->m_lock);
+    }
+
+    pthread_mutex_unlock(&storage->m_lock);
+
+    return NULL;
+}
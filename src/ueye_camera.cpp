@@ -13,10 +13,18 @@
 #include <string>
 #include <iostream>
 #include <stdio.h>
+#include <unistd.h>
 
-UEye_Camera::UEye_Camera(HIDS cameraID) : camID(cameraID), m_stop(false) {
+UEye_Camera::UEye_Camera(HIDS cameraID) : camID(cameraID), m_defaultPixelClock(0), m_memID(NULL), 
+        m_registeredBuffers(NULL), m_registeredSize(0), m_registeredWidth(0), m_registeredHeight(0), 
+        m_stop(false), m_batchBuffers(NULL), m_batchSequences(NULL), m_nextSlot(0), m_lastSequence(0), 
+        m_sequenceKnown(false), acquisitionEventThread(NULL) {
 
-    this->m_running = false; 
+    this->m_running      = false; 
+    this->m_prepared     = false; 
+    this->m_ringBuffer   = NULL; 
+    this->m_userCallback = NULL; 
+    this->m_lostFrames   = 0; 
 
     INT status = 0;
     /* Initialize the camera */
@@ -49,59 +57,117 @@ UEye_Camera::UEye_Camera(HIDS cameraID) : camID(cameraID), m_stop(false) {
         throw UEye_Exception(this->camID, status, msg); 
     }
 
+    /* The pixel clock capabilities do not change: read them once */
+    status = is_PixelClock(this->camID, IS_PIXELCLOCK_CMD_GET_RANGE, 
+                           (void *) this->m_pixelClockRange, sizeof(this->m_pixelClockRange));
+
+    if(status != IS_SUCCESS) {
+        string msg = "Could not retrieve the pixel clock range.";
+        throw UEye_Exception(this->camID, status, msg); 
+    }
+
     /* Set the minimum pixel clock */
     this->setPixelClock(this->getMinimumPixelClock());
+
+    /* Retrieve the resulting framerate */
+    is_SetFrameRate(this->camID, IS_GET_FRAMERATE, &this->m_framerate);
 }
 
 void UEye_Camera::capture(Image *i) {
 
-    int memID = 0; 
-    INT status = is_SetAllocatedImageMem(this->camID, i->getWidth(), i->getHeight(), 8,
-                                         (char *)i->getImageBuffer(), &memID);
+    this->captureBurst(&i, 1, 0.0, NULL); 
+}
 
-    if(status == IS_SUCCESS) {
-        status = is_SetImageMem(this->camID, (char *)i->getImageBuffer(), memID); 
+void UEye_Camera::captureBurst(Image **images, unsigned int count, double interval, double *timestamps) {
+
+    /* The single capture mode would steal the frames of the live acquisition */
+    if(this->m_running) {
+        string msg = "Could not capture images during the live acquisition.";
+        throw UEye_Exception(this->camID, IS_NO_SUCCESS, msg); 
+    }
+
+    int *memID = new int[count]; 
+    unsigned int registered = 0; 
+    INT status = IS_SUCCESS; 
+    string msg; 
+
+    /* Register every image once, before the first trigger */
+    while((registered < count) && (status == IS_SUCCESS)) {
+        status = is_SetAllocatedImageMem(this->camID, images[registered]->getWidth(), images[registered]->getHeight(), 8,
+                                         (char *) images[registered]->getImageBuffer(), &memID[registered]);
+
+        if(status == IS_SUCCESS) {
+            registered++; 
+        }
     }
 
     if(status != IS_SUCCESS) {
-        string msg = "Could not set up the image for single capture mode.";
-        throw UEye_Exception(this->camID, status, msg); 
+        msg = "Could not set up the image for single capture mode.";
     }
 
-   
-    status = is_SetDisplayMode(this->camID, IS_GET_DISPLAY_MODE); 
+    if(status == IS_SUCCESS) {
+        status = is_SetDisplayMode(this->camID, IS_GET_DISPLAY_MODE); 
+
+        if(status != IS_SET_DM_DIB) {
+            cout << "Setting DIB mode." << endl;
+            /* Set the camera in RAM acquisition mode. The image will be directly transferred to RAM. */
+            status = is_SetDisplayMode(this->camID, IS_SET_DM_DIB); 
+            
+            if(status != IS_SUCCESS) {
+                msg = "Could not set the display mode.";
+            }
+        }
+        else {
+            status = IS_SUCCESS; 
+        }
+    }
+
+    if(status == IS_SUCCESS) {
+        /* Put the camera in software trigger mode. */
+        status = is_SetExternalTrigger(this->camID, IS_SET_TRIGGER_SOFTWARE);
 
-    if(status != IS_SET_DM_DIB) {
-        cout << "Setting DIB mode." << endl;
-        /* Set the camera in RAM acquisition mode. The image will be directly transferred to RAM. */
-        status = is_SetDisplayMode(this->camID, IS_SET_DM_DIB); 
-        
         if(status != IS_SUCCESS) {
-            string msg = "Could not set the display mode.";
-            throw UEye_Exception(this->camID, status, msg); 
+            msg = "Could not set trigger mode.";
         }
     }
 
-    /* Put the camera in software trigger mode. */
-    status = is_SetExternalTrigger(this->camID, IS_SET_TRIGGER_SOFTWARE);
+    double origin = getMonotonicTime(); 
 
-    if(status != IS_SUCCESS) {
-        string msg = "Could not set trigger mode.";
-        throw UEye_Exception(this->camID, status, msg); 
+    for(unsigned int incr = 0; (incr < count) && (status == IS_SUCCESS); incr++) {
+
+        /* Triggers are scheduled from the first one, so that delays do not accumulate */
+        double delay = origin + incr * interval - getMonotonicTime(); 
+
+        if(delay > 0.0) {
+            usleep((useconds_t) (delay * 1e6)); 
+        }
+
+        status = is_SetImageMem(this->camID, (char *) images[incr]->getImageBuffer(), memID[incr]); 
+
+        if(timestamps != NULL) {
+            timestamps[incr] = getMonotonicTime(); 
+        }
+
+        /* One-shot acquisition, we wait for the image to be stored in RAM */
+        if(status == IS_SUCCESS) {
+            status = is_FreezeVideo(this->camID, IS_WAIT);
+        }
+
+        if(status != IS_SUCCESS) {
+            msg = "Could not acquire the image.";
+        }
+    }
+    
+    /* Free the images from the uEye SDK */
+    for(unsigned int incr = 0; incr < registered; incr++) {
+        is_FreeImageMem(this->camID, images[incr]->getImageBuffer(), memID[incr]);
     }
 
-    /* One-shot acquisition, we wait for the image to be stored in RAM */
-    status = is_FreezeVideo(this->camID, IS_WAIT);
+    delete [] memID; 
 
     if(status != IS_SUCCESS) {
-        string msg = "Could not acquire the image.";
         throw UEye_Exception(this->camID, status, msg); 
     }
-    
-    /* Free the image from the uEye SDK */
-    status = is_FreeImageMem(this->camID, i->getImageBuffer(), memID);
-
-    return; 
 }
 
 double UEye_Camera::setFramerate(double framerate) {
@@ -171,144 +237,276 @@ void UEye_Camera::setPixelClock(unsigned int pixelClock) {
 
 void UEye_Camera::getPixelClockRange(unsigned int range[]) {
     
-    INT status = is_PixelClock(this->camID, IS_PIXELCLOCK_CMD_GET_RANGE, 
-                               (void *) range, 3 * sizeof(unsigned int));
-
-    (void) status;
+    range[0] = this->m_pixelClockRange[0]; 
+    range[1] = this->m_pixelClockRange[1]; 
+    range[2] = this->m_pixelClockRange[2]; 
 }
 
 unsigned int UEye_Camera::getMinimumPixelClock(void) {
     
-    unsigned int range[3]; 
-    this->getPixelClockRange(range);
-
-    return range[0]; 
+    return this->m_pixelClockRange[0]; 
 }
 
 unsigned int UEye_Camera::getMaximumPixelClock(void) {
     
-    unsigned int range[3]; 
-    this->getPixelClockRange(range);
-
-    return range[1]; 
+    return this->m_pixelClockRange[1]; 
 }
 
 unsigned int UEye_Camera::getPixelClockStep(void) {
     
-    unsigned int range[3]; 
-    this->getPixelClockRange(range);
-
-    return range[2]; 
+    return this->m_pixelClockRange[2]; 
 }
 
 unsigned int UEye_Camera::getDefaultPixelClock(void) {
     
-    unsigned int defaultPixelClock; 
+    if(this->m_defaultPixelClock == 0) {
+        INT status = is_PixelClock(this->camID, IS_PIXELCLOCK_CMD_GET_DEFAULT, 
+                                   (void *) &this->m_defaultPixelClock, sizeof(this->m_defaultPixelClock));
 
-    INT status = is_PixelClock(this->camID, IS_PIXELCLOCK_CMD_GET_DEFAULT, 
-                               (void *) &defaultPixelClock, sizeof(defaultPixelClock));
-
-    (void) status;
+        (void) status;
+    }
 
-    return defaultPixelClock; 
+    return this->m_defaultPixelClock; 
 }
 
-void UEye_Camera::start(RingBuffer *ringBuffer, void (*callback)(char *))  {
+void UEye_Camera::start(RingBuffer *ringBuffer, FrameCallback_t callback)  {
  
     /* If the camera was already running, stop it */
     if(this->m_running) {
         this->stop(); 
     }
 
+    if(!this->m_prepared || !this->isRegistered(ringBuffer) || (callback != this->m_userCallback)) {
+        this->prepare(ringBuffer, callback); 
+    }
+
+    /* The first event of the acquisition only delivers the last image, as a reference */
+    this->m_sequenceKnown = false; 
+
+    /* Start live capture */
+    INT status = is_CaptureVideo(this->camID, IS_DONT_WAIT); 
+
+    if(status != IS_SUCCESS) {
+        string msg = "Could not start live camera acquisition."; 
+        throw UEye_Exception(this->camID, status, msg); 
+    }
+
+    this->m_running = true; 
+    
+    return; 
+}
+
+void UEye_Camera::prepare(RingBuffer *ringBuffer, FrameCallback_t callback) {
+
+    /* The buffers cannot be changed while the camera writes into them */
+    if(this->m_running) {
+        this->stop(); 
+    }
+
+    /* Same buffers as the previous acquisition: nothing to register */
+    if(this->m_prepared && this->isRegistered(ringBuffer)) {
+        this->m_userCallback = callback; 
+        return; 
+    }
+
+    this->release(); 
+
     this->m_ringBuffer   = ringBuffer; 
     this->m_userCallback = callback; 
 
-    /* Set the camera in live acquisition mode */
+    /* Set camera memory buffers */
     INT status  = IS_SUCCESS;
+    size_t size = ringBuffer->getSize(); 
 
-    /* Set camera memory buffers */
-    this->m_memID = new int[ringBuffer->getSize()];  
+    this->m_memID             = new int[size];  
+    this->m_registeredBuffers = new pixel_t *[size]; 
+    this->m_batchBuffers      = new char *[size]; 
+    this->m_batchSequences    = new uint64_t[size]; 
+    this->m_registeredSize    = 0; 
 
-    for(unsigned int incr = 0; incr < ringBuffer->getSize(); incr++) {
+    for(unsigned int incr = 0; incr < size; incr++) {
         status = is_SetAllocatedImageMem(this->camID, ringBuffer->at(incr)->getWidth(), ringBuffer->at(incr)->getHeight(), 8,
                                             ringBuffer->at(incr)->getImageBuffer(), &this->m_memID[incr]);
         
         if(status == IS_SUCCESS) {
-            
+            /* Keep track of the buffer, even if it cannot be added to the sequence, to free it later */
+            this->m_registeredBuffers[incr] = ringBuffer->at(incr)->getImageBuffer(); 
+            this->m_registeredSize = incr + 1; 
+
             status = is_AddToSequence(this->camID, ringBuffer->at(incr)->getImageBuffer(), this->m_memID[incr]);  
         }
 
         if(status != IS_SUCCESS) {
+            this->m_prepared = true; 
+            this->release(); 
+
             string msg = "Could not set up the buffer for stream acquisition.";
             throw UEye_Exception(this->camID, status, msg); 
         }
     }
+
+    this->m_registeredWidth  = (size > 0) ? ringBuffer->at(0)->getWidth()  : 0; 
+    this->m_registeredHeight = (size > 0) ? ringBuffer->at(0)->getHeight() : 0; 
     
     /* Install event handler threads */
     /** @todo Add status related event handlers */
     acquisitionEventThread = new UEye_EventThread(this, IS_SET_EVENT_FRAME, &UEye_Camera::acquisitionCallback);
     acquisitionEventThread->start();
 
-    /* Start live capture */
-    status = is_CaptureVideo(this->camID, IS_DONT_WAIT); 
-
-    if(status != IS_SUCCESS) {
-        string msg = "Could not start live camera acquisition."; 
-        throw UEye_Exception(this->camID, status, msg); 
-    }
-
-    this->m_running = true; 
-    
-    return; 
+    this->m_prepared = true; 
 }
 
 void UEye_Camera::stop(void) {
 
-    /* Stop live acquisition */
+    /* Nothing to do if the acquisition was not started (or already paused) */
+    if(!this->m_running) {
+        return; 
+    }
+
+    /* Stop live acquisition, the buffers stay registered for the next start */
     INT status = IS_NO_SUCCESS;
     while(status != IS_SUCCESS) {
         status = is_StopLiveVideo(this->camID, IS_WAIT); 
     }
 
     this->m_running = false; 
+}
+
+void UEye_Camera::release(void) {
+
+    if(this->m_running) {
+        this->stop(); 
+    }
+
+    if(!this->m_prepared) {
+        return; 
+    }
+
+    this->m_prepared = false; 
    
     /* Clear image sequence from the camera memory */
     is_ClearSequence(this->camID); 
 
-    for(unsigned int incr; incr < this->m_ringBuffer->getSize(); incr++) {
+    for(unsigned int incr = 0; incr < this->m_registeredSize; incr++) {
 
-        is_FreeImageMem(this->camID, this->m_ringBuffer->at(incr)->getImageBuffer(), this->m_memID[incr]); 
+        is_FreeImageMem(this->camID, this->m_registeredBuffers[incr], this->m_memID[incr]); 
     }
     
     /* Stop the event handler threads */
-    acquisitionEventThread->stop(); 
+    if(acquisitionEventThread != NULL) {
+        acquisitionEventThread->stop(); 
+        delete acquisitionEventThread; 
+        acquisitionEventThread = NULL; 
+    }
    
     /* Free allocated memory */
-    delete acquisitionEventThread; 
     delete [] this->m_memID; 
+    delete [] this->m_registeredBuffers; 
+    delete [] this->m_batchBuffers; 
+    delete [] this->m_batchSequences; 
+
+    this->m_memID             = NULL; 
+    this->m_registeredBuffers = NULL; 
+    this->m_batchBuffers      = NULL; 
+    this->m_batchSequences    = NULL; 
+    this->m_registeredSize    = 0; 
+}
+
+bool UEye_Camera::isRegistered(RingBuffer *ringBuffer) const {
+
+    if((ringBuffer != this->m_ringBuffer) || (ringBuffer->getSize() != this->m_registeredSize)) {
+        return false; 
+    }
+
+    /* A resized ring keeps some of its images: compare every buffer */
+    for(unsigned int incr = 0; incr < this->m_registeredSize; incr++) {
+        
+        Image *image = ringBuffer->at(incr); 
+
+        if((image->getImageBuffer() != this->m_registeredBuffers[incr]) || 
+           (image->getWidth()  != this->m_registeredWidth) || 
+           (image->getHeight() != this->m_registeredHeight)) {
+            return false; 
+        }
+    }
+
+    return true; 
 }
 
 void UEye_Camera::acquisitionCallback(const UEye_Camera *camera) {
 
-    static int cntr = 0; 
-    /** @todo Implement callback to a user-defined function */
-    std::cout << "Image " << cntr << " acquired." << std::endl; 
-    cntr++;
-    
-    if(camera->m_userCallback != NULL) {
-        INT dummy   = 0; 
-        char *pLast = NULL; 
-        char *pCur  = NULL; 
-        if(is_GetActSeqBuf(camera->camID, &dummy, &pCur, &pLast) == IS_SUCCESS) {
-            if(pLast != NULL) {
-                camera->m_userCallback(pLast); 
+    /* The event thread only holds a const camera, the delivery state belongs to it */
+    UEye_Camera *self = const_cast<UEye_Camera *>(camera); 
+
+    INT dummy   = 0; 
+    char *pLast = NULL; 
+    char *pCur  = NULL; 
+
+    if((self->m_userCallback == NULL) || (self->m_registeredSize == 0) || 
+       (is_GetActSeqBuf(self->camID, &dummy, &pCur, &pLast) != IS_SUCCESS) || (pLast == NULL)) {
+        return; 
+    }
+
+    size_t last = 0; 
+    while((last < self->m_registeredSize) && (self->m_registeredBuffers[last] != pLast)) {
+        last++; 
+    }
+
+    if(last == self->m_registeredSize) {
+        return; 
+    }
+
+    /* Images completed since the previous event, in acquisition order */
+    size_t slot = self->m_sequenceKnown ? self->m_nextSlot : last; 
+    FrameBatch_s batch; 
+    batch.buffers   = self->m_batchBuffers; 
+    batch.sequences = self->m_batchSequences; 
+    batch.count     = 0; 
+    batch.lost      = 0; 
+
+    while(true) {
+        UEYEIMAGEINFO info; 
+        uint64_t sequence = self->m_lastSequence + 1; 
+
+        if(is_GetImageInfo(self->camID, self->m_memID[slot], &info, sizeof(info)) == IS_SUCCESS) {
+            sequence = info.u64FrameNumber; 
+        }
+
+        /* Already delivered: the camera did not write this image again yet */
+        if(!self->m_sequenceKnown || (sequence > self->m_lastSequence)) {
+            if(self->m_sequenceKnown) {
+                batch.lost += sequence - self->m_lastSequence - 1; 
             }
+
+            batch.buffers[batch.count]   = self->m_registeredBuffers[slot]; 
+            batch.sequences[batch.count] = sequence; 
+            batch.count++; 
+
+            self->m_lastSequence  = sequence; 
+            self->m_sequenceKnown = true; 
         }
+
+        if(slot == last) {
+            break; 
+        }
+        slot = (slot + 1) % self->m_registeredSize; 
+    }
+
+    self->m_nextSlot = (last + 1) % self->m_registeredSize; 
+
+    if(batch.lost > 0) {
+        __atomic_add_fetch(&self->m_lostFrames, batch.lost, __ATOMIC_RELAXED); 
+    }
+
+    if(batch.count > 0) {
+        self->m_userCallback(&batch); 
     }
 }
 
 UEye_Camera::~UEye_Camera() {
 
+    this->release(); 
+
     INT status = is_ExitCamera(this->camID);
     (void) status;
 }
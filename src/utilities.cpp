@@ -7,6 +7,10 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <sys/stat.h>
+#include <sys/resource.h>
+#include <sys/sysinfo.h>
+#include <stdint.h>
+#include <time.h>
 #include <errno.h>
 #include <string.h>
 
@@ -47,6 +51,28 @@ void string_appendInt(std::string &str, int x) {
     return; 
 }
 
+char * formatZeroPadded(char *dst, unsigned int x, unsigned int width) {
+
+    char digits[10]; 
+    unsigned int nbOfDigits = 0; 
+
+    do {
+        digits[nbOfDigits++] = '0' + (x % 10u); 
+        x /= 10u; 
+    } while(x > 0); 
+
+    while(width > nbOfDigits) {
+        *dst++ = '0'; 
+        width--; 
+    }
+
+    while(nbOfDigits > 0) {
+        *dst++ = digits[--nbOfDigits]; 
+    }
+
+    return dst; 
+}
+
 std::string getFileExtension(std::string &filename) {
     
     size_t index = filename.rfind('.', filename.length()); 
@@ -59,3 +85,70 @@ std::string getFileExtension(std::string &filename) {
     return ""; 
 }
 
+
+size_t getAvailableMemory(void) {
+
+    size_t available = 0; 
+    char line[128]; 
+
+    FILE *fp = fopen("/proc/meminfo", "r"); 
+    if(fp != NULL) {
+        unsigned long kB = 0; 
+        while(fgets(line, sizeof(line), fp) != NULL) {
+            if(sscanf(line, "MemAvailable: %lu kB", &kB) == 1) {
+                available = (size_t) kB * 1024u; 
+                break; 
+            }
+        }
+        fclose(fp); 
+    }
+
+    /* Kernels older than 3.14 do not provide MemAvailable */
+    if(available == 0) {
+        struct sysinfo info; 
+        if(sysinfo(&info) == 0) {
+            available = (size_t) (info.freeram + info.bufferram) * info.mem_unit; 
+        }
+    }
+
+    return available; 
+}
+
+size_t getLockableMemory(void) {
+
+    struct rlimit limit; 
+
+    if((getrlimit(RLIMIT_MEMLOCK, &limit) != 0) || (limit.rlim_cur == RLIM_INFINITY)) {
+        return SIZE_MAX; 
+    }
+
+    return (size_t) limit.rlim_cur; 
+}
+
+size_t getLockedMemory(void) {
+
+    size_t locked = 0; 
+    char line[128]; 
+
+    FILE *fp = fopen("/proc/self/status", "r"); 
+    if(fp != NULL) {
+        unsigned long kB = 0; 
+        while(fgets(line, sizeof(line), fp) != NULL) {
+            if(sscanf(line, "VmLck: %lu kB", &kB) == 1) {
+                locked = (size_t) kB * 1024u; 
+                break; 
+            }
+        }
+        fclose(fp); 
+    }
+
+    return locked; 
+}
+
+double getMonotonicTime(void) {
+
+    struct timespec now; 
+    clock_gettime(CLOCK_MONOTONIC, &now); 
+
+    return (double) now.tv_sec + (double) now.tv_nsec * 1e-9; 
+}
@@ -0,0 +1,196 @@
+/**
+ * @file writer_pool.cpp
+ * @brief Image writer thread pool class implementation.
+ */
+
+#include "writer_pool.hpp"
+
+WriterPool::WriterPool(unsigned int nbOfThreads, size_t capacity, void (*write)(Image *, unsigned int)) : 
+        m_capacity(capacity), m_held(0), m_head(0), m_count(0), m_nbOfSinks(1), 
+        m_nbOfThreads(nbOfThreads), m_stop(false) {
+
+    if(this->m_capacity == 0) {
+        this->m_capacity = 1; 
+    }
+    if(this->m_nbOfThreads == 0) {
+        this->m_nbOfThreads = 1; 
+    }
+
+    this->m_write[0]  = write; 
+    this->m_queueSize = this->m_capacity * WRITER_POOL_MAX_SINKS; 
+
+    this->m_frames  = new Frame_s[this->m_capacity]; 
+    this->m_queue   = new Job_s[this->m_queueSize]; 
+    this->m_threads = new pthread_t[this->m_nbOfThreads]; 
+    this->m_args    = new ThreadArg_s[this->m_nbOfThreads]; 
+
+    pthread_mutex_init(&this->m_lock, NULL); 
+    pthread_cond_init(&this->m_available, NULL); 
+    pthread_cond_init(&this->m_written, NULL); 
+
+    for(size_t incr = 0; incr < this->m_capacity; incr++) {
+        this->m_frames[incr].references = 0; 
+    }
+
+    for(unsigned int incr = 0; incr < this->m_nbOfThreads; incr++) {
+        this->m_args[incr].pool  = this; 
+        this->m_args[incr].index = incr; 
+        pthread_create(&this->m_threads[incr], NULL, &thread, &this->m_args[incr]); 
+    }
+}
+
+WriterPool::~WriterPool() {
+
+    pthread_mutex_lock(&this->m_lock); 
+    this->m_stop = true; 
+    pthread_cond_broadcast(&this->m_available); 
+    pthread_mutex_unlock(&this->m_lock); 
+
+    for(unsigned int incr = 0; incr < this->m_nbOfThreads; incr++) {
+        pthread_join(this->m_threads[incr], NULL); 
+    }
+
+    pthread_cond_destroy(&this->m_written); 
+    pthread_cond_destroy(&this->m_available); 
+    pthread_mutex_destroy(&this->m_lock); 
+
+    delete [] this->m_args; 
+    delete [] this->m_threads; 
+    delete [] this->m_queue; 
+    delete [] this->m_frames; 
+}
+
+bool WriterPool::addSink(void (*write)(Image *, unsigned int)) {
+
+    pthread_mutex_lock(&this->m_lock); 
+
+    bool added = (this->m_nbOfSinks < WRITER_POOL_MAX_SINKS); 
+    if(added) {
+        this->m_write[this->m_nbOfSinks] = write; 
+        this->m_nbOfSinks++; 
+    }
+
+    pthread_mutex_unlock(&this->m_lock); 
+
+    return added; 
+}
+
+unsigned int WriterPool::getNbOfSinks(void) const {
+
+    return this->m_nbOfSinks; 
+}
+
+bool WriterPool::submit(Image *image, unsigned int frame) {
+
+    pthread_mutex_lock(&this->m_lock); 
+
+    if(this->m_held == this->m_capacity) {
+        pthread_mutex_unlock(&this->m_lock); 
+        return false; 
+    }
+
+    /* Entries are released out of order, look for a free one */
+    size_t index = 0; 
+    while(this->m_frames[index].references > 0) {
+        index++; 
+    }
+
+    this->m_frames[index].image      = image; 
+    this->m_frames[index].frame      = frame; 
+    this->m_frames[index].references = this->m_nbOfSinks; 
+    this->m_held++; 
+
+    /* The jobs of an image are queued together, so that the sinks read it at the same time */
+    for(unsigned int incr = 0; incr < this->m_nbOfSinks; incr++) {
+        Job_s &job = this->m_queue[(this->m_head + this->m_count) % this->m_queueSize]; 
+        job.frame = index; 
+        job.sink  = incr; 
+        this->m_count++; 
+    }
+
+    pthread_cond_broadcast(&this->m_available); 
+    pthread_mutex_unlock(&this->m_lock); 
+
+    return true; 
+}
+
+bool WriterPool::isPending(const Image *image) {
+
+    bool pending = false; 
+
+    pthread_mutex_lock(&this->m_lock); 
+
+    for(size_t incr = 0; (incr < this->m_capacity) && !pending; incr++) {
+        pending = (this->m_frames[incr].references > 0) && (this->m_frames[incr].image == image); 
+    }
+
+    pthread_mutex_unlock(&this->m_lock); 
+
+    return pending; 
+}
+
+size_t WriterPool::getBacklog(void) {
+
+    pthread_mutex_lock(&this->m_lock); 
+    size_t backlog = this->m_held; 
+    pthread_mutex_unlock(&this->m_lock); 
+
+    return backlog; 
+}
+
+size_t WriterPool::getCapacity(void) const {
+
+    return this->m_capacity; 
+}
+
+void WriterPool::drain(void) {
+
+    pthread_mutex_lock(&this->m_lock); 
+
+    while(this->m_held > 0) {
+        pthread_cond_wait(&this->m_written, &this->m_lock); 
+    }
+
+    pthread_mutex_unlock(&this->m_lock); 
+}
+
+void * WriterPool::thread(void *arg) {
+
+    ThreadArg_s *threadArg = reinterpret_cast<ThreadArg_s *>(arg); 
+    WriterPool *pool = threadArg->pool; 
+
+    pthread_mutex_lock(&pool->m_lock); 
+
+    while(true) {
+
+        while((pool->m_count == 0) && !pool->m_stop) {
+            pthread_cond_wait(&pool->m_available, &pool->m_lock); 
+        }
+
+        /* The queued images are written before the pool stops */
+        if(pool->m_count == 0) {
+            break; 
+        }
+
+        Job_s job = pool->m_queue[pool->m_head]; 
+        pool->m_head = (pool->m_head + 1) % pool->m_queueSize; 
+        pool->m_count--; 
+
+        Frame_s &frame = pool->m_frames[job.frame]; 
+
+        pthread_mutex_unlock(&pool->m_lock); 
+        pool->m_write[job.sink](frame.image, frame.frame); 
+        pthread_mutex_lock(&pool->m_lock); 
+
+        /* The last sink releases the image */
+        frame.references--; 
+        if(frame.references == 0) {
+            pool->m_held--; 
+            pthread_cond_broadcast(&pool->m_written); 
+        }
+    }
+
+    pthread_mutex_unlock(&pool->m_lock); 
+
+    return NULL; 
+}
@@ -0,0 +1,406 @@
+/**
+ * @file main.cpp
+ * @brief Sustained-throughput soak benchmark of the acquisition-to-disk path.
+ * @details A software camera feeds the ring buffer through the acquisition callback,
+ *          the writer pool stores the frames with the flusher, as in the application.
+ *          For each output format and ring size, the frame rate is raised step by step
+ *          until frames are dropped. Each step appends a line to a CSV file:
+ *
+ *          @code
+ *          label,format,ring,rate,acquired,stored,dropped,lost,backlog,p50_ms,p95_ms,p99_ms,max_ms,cpu_us_per_frame,rss_mb,sustained
+ *          @endcode
+ *
+ *          The latency of a frame runs from the acquisition callback to the end of its
+ *          file write. The CPU time per frame counts every thread of the process. A step
+ *          is sustained when no frame was dropped by the writers or lost by the camera,
+ *          and the writers did not hold the whole ring at its end. The label tells the
+ *          builds apart.
+ *
+ *          The frames are stored by a copy of the application store path, for the PGM, PNG
+ *          and JPEG formats. The RAM tier, the processing pipeline and the temporal stream
+ *          (TDC) are not exercised.
+ */
+
+#include "software_camera.hpp"
+#include "ring_buffer.hpp"
+#include "output_directory.hpp"
+#include "frame_journal.hpp"
+#include "flusher.hpp"
+#include "writer_pool.hpp"
+#include "compression_controller.hpp"
+#include "jpeg_encoder.hpp"
+#include "utilities.hpp"
+
+#include <iostream>
+#include <sstream>
+#include <fstream>
+#include <algorithm>
+#include <vector>
+#include <string>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <ftw.h>
+#include <pthread.h>
+#include <sys/resource.h>
+
+/** @brief Number of acquisition times kept, indexed by frame number. */
+#define SOAK_TIMES  (65536u)
+
+typedef struct {
+    std::string resultsFile;
+    std::string outputDir;
+    std::string label;
+    std::vector<std::string> formats;
+    std::vector<size_t> ringSizes;
+    double startRate;
+    double growth;
+    double maxRate;
+    double stepDuration;
+    unsigned int nbOfWriters;
+    unsigned int commitFrames;
+}SoakOptions_s;
+
+/** @brief Measurements of a ramp step. */
+typedef struct {
+    unsigned long acquired;
+    unsigned long stored;
+    unsigned long dropped;
+    std::vector<double> latencies;
+}Step_s;
+
+typedef struct {
+    RingBuffer *rb;
+    OutputDirectory *output;
+    FrameJournal *journal;
+    Flusher *flusher;
+    WriterPool *writers;
+    CompressionController *compression;
+    std::string format;
+    unsigned int cntr;
+    double acquiredAt[SOAK_TIMES];
+    Step_s step;
+    pthread_mutex_t lock;
+}Soak_s;
+
+static SoakOptions_s options;
+static Soak_s soak;
+
+/** @brief Acquisition callback: submits the frames, as the application does. */
+static void onFrames(const FrameBatch_s *batch) {
+
+    double now = getMonotonicTime();
+    unsigned long dropped = 0;
+
+    for(unsigned int incr = 0; incr < batch->count; incr++) {
+        Image *i = soak.rb->getImageFromBuffer(batch->buffers[incr]);
+        unsigned int frame = soak.cntr++;
+
+        soak.acquiredAt[frame % SOAK_TIMES] = now;
+        dropped += (soak.writers->isPending(i) || !soak.writers->submit(i, frame)) ? 1 : 0;
+    }
+
+    pthread_mutex_lock(&soak.lock);
+    soak.step.acquired += batch->count;
+    soak.step.dropped  += dropped;
+    pthread_mutex_unlock(&soak.lock);
+}
+
+/** @brief Writer function: stores the frame, as the application does. */
+static void storeFrame(Image *i, unsigned int frame) {
+
+    FILE *fp = soak.output->openFile(frame);
+
+    if(fp == NULL) {
+        std::cerr << "Could not create " << soak.output->getFilename(frame) << std::endl;
+        return;
+    }
+
+    size_t bytes = 0;
+    if(soak.format == "png") {
+        int level = soak.compression->update((double) soak.writers->getBacklog() / (double) soak.rb->getSize());
+        bytes = i->writeToPNG(fp, NULL, level, CompressionController::getFilters(level));
+    }
+    else if(soak.format == "jpg") {
+        bytes = i->writeToJPEG(fp, JPEG_DEFAULT_QUALITY, 1u);
+    }
+    else {
+        bytes = i->writeToPGM(fp);
+    }
+
+    bool written = (bytes > 0) && !ferror(fp);
+    if(!written) {
+        std::cerr << "Could not write " << soak.output->getFilename(frame) << std::endl;
+    }
+
+    if(soak.flusher != NULL) {
+        soak.flusher->add(frame, fp, written);
+    }
+    else {
+        fclose(fp);
+    }
+
+    double latency = getMonotonicTime() - soak.acquiredAt[frame % SOAK_TIMES];
+
+    pthread_mutex_lock(&soak.lock);
+    soak.step.stored++;
+    soak.step.latencies.push_back(latency);
+    pthread_mutex_unlock(&soak.lock);
+}
+
+/** @brief Returns the CPU time used by the process, in seconds. */
+static double getCPUTime(void) {
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec * 1e-6 + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec * 1e-6;
+}
+
+/** @brief Returns the resident memory of the process, in megabytes. */
+static double getResidentMemory(void) {
+
+    unsigned long size = 0;
+    unsigned long resident = 0;
+    FILE *fp = fopen("/proc/self/statm", "r");
+
+    if(fp != NULL) {
+        if(fscanf(fp, "%lu %lu", &size, &resident) != 2) {
+            resident = 0;
+        }
+        fclose(fp);
+    }
+
+    return (double) resident * sysconf(_SC_PAGESIZE) / (1024.0 * 1024.0);
+}
+
+/** @brief Returns the given percentile of sorted values, in milliseconds. */
+static double getPercentile(const std::vector<double> &sorted, double percentile) {
+
+    if(sorted.empty()) {
+        return 0.0;
+    }
+
+    size_t index = (size_t) (percentile / 100.0 * (sorted.size() - 1) + 0.5);
+
+    return sorted[index] * 1000.0;
+}
+
+static int removeEntry(const char *path, const struct stat *sb, int type, struct FTW *ftwbuf) {
+
+    (void) sb;
+    (void) type;
+    (void) ftwbuf;
+
+    return remove(path);
+}
+
+/** @brief Removes the frames of a run. */
+static void removeDirectory(const std::string &path) {
+
+    nftw(path.c_str(), &removeEntry, 16, FTW_DEPTH | FTW_PHYS);
+}
+
+/**
+ * @brief Runs the frame rate ramp for one format and ring size.
+ * @returns The highest sustained frame rate, 0 if none.
+ */
+static double runRamp(SoftwareCamera *camera, const std::string &format, size_t ringSize, std::ofstream &results) {
+
+    std::ostringstream path;
+    path << options.outputDir << "/" << format << "_" << ringSize;
+
+    removeDirectory(path.str());
+    if(!createDirectory(path.str())) {
+        return 0.0;
+    }
+
+    soak.format      = format;
+    soak.rb          = new RingBuffer(800u, 600u, ringSize);
+    soak.output      = new OutputDirectory(path.str(), format, 10000u);
+    soak.journal     = new FrameJournal(path.str() + "/frames.journal");
+    soak.flusher     = (options.commitFrames > 0) ? new Flusher(soak.journal, soak.output, options.commitFrames, 1000u) : NULL;
+    soak.compression = new CompressionController();
+    soak.writers     = new WriterPool(options.nbOfWriters, ringSize, &storeFrame);
+    soak.cntr        = 0;
+
+    double sustained = 0.0;
+    double rate = options.startRate;
+
+    camera->setFramerate(rate);
+    camera->start(soak.rb, &onFrames);
+
+    while(rate <= options.maxRate) {
+
+        camera->setFramerate(rate);
+
+        pthread_mutex_lock(&soak.lock);
+        soak.step.acquired = 0;
+        soak.step.stored   = 0;
+        soak.step.dropped  = 0;
+        soak.step.latencies.clear();
+        pthread_mutex_unlock(&soak.lock);
+
+        uint64_t lost = camera->getLostFrames();
+        double cpu = getCPUTime();
+
+        usleep((useconds_t) (options.stepDuration * 1e6));
+
+        cpu  = getCPUTime() - cpu;
+        lost = camera->getLostFrames() - lost;
+        size_t backlog = soak.writers->getBacklog();
+
+        pthread_mutex_lock(&soak.lock);
+        Step_s step = soak.step;
+        pthread_mutex_unlock(&soak.lock);
+
+        std::sort(step.latencies.begin(), step.latencies.end());
+
+        bool ok = (step.dropped == 0) && (lost == 0) && (backlog < ringSize);
+
+        results << options.label << "," << format << "," << ringSize << "," << rate << "," << step.acquired << "," <<
+                   step.stored << "," << step.dropped << "," << lost << "," << backlog << "," <<
+                   getPercentile(step.latencies, 50.0) << "," << getPercentile(step.latencies, 95.0) << "," <<
+                   getPercentile(step.latencies, 99.0) << "," << getPercentile(step.latencies, 100.0) << "," <<
+                   ((step.stored > 0) ? cpu * 1e6 / step.stored : 0.0) << "," << getResidentMemory() << "," <<
+                   (ok ? 1 : 0) << std::endl;
+
+        std::cout << format << ", ring " << ringSize << ": " << rate << " frames/s, " << step.dropped <<
+                     " dropped, " << lost << " lost, p99 " << getPercentile(step.latencies, 99.0) << " ms" << std::endl;
+
+        if(!ok) {
+            break;
+        }
+
+        sustained = rate;
+        rate *= options.growth;
+    }
+
+    camera->stop();
+
+    delete soak.writers;
+    delete soak.flusher;
+    delete soak.journal;
+    delete soak.output;
+    delete soak.compression;
+    delete soak.rb;
+
+    removeDirectory(path.str());
+
+    return sustained;
+}
+
+/** @brief Splits a comma-separated list. */
+static std::vector<std::string> split(const std::string &list) {
+
+    std::vector<std::string> items;
+    std::istringstream stream(list);
+    std::string item;
+
+    while(std::getline(stream, item, ',')) {
+        if(!item.empty()) {
+            items.push_back(item);
+        }
+    }
+
+    return items;
+}
+
+static void usage(const char *name) {
+
+    std::cerr << "Usage: " << name << " [-o results.csv] [-d directory] [-l label] [-f pgm,png,jpg] [-r 8,32,128]\n"
+                 "       [-s start rate] [-g growth] [-m max rate] [-t step seconds] [-w writers] [-c commit frames]" << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+
+    options.resultsFile  = "soak_results.csv";
+    options.outputDir    = "soak_frames";
+    options.label        = "";
+    options.formats      = split("pgm,png");
+    options.startRate    = 20.0;
+    options.growth       = 1.25;
+    options.maxRate      = 5000.0;
+    options.stepDuration = 5.0;
+    options.nbOfWriters  = 2u;
+    options.commitFrames = 64u;
+
+    std::vector<std::string> ringSizes = split("8,32,128");
+    int opt;
+
+    while((opt = getopt(argc, argv, "c:d:f:g:l:m:o:r:s:t:w:")) != -1) {
+        switch(opt) {
+            case 'c': options.commitFrames = strtoul(optarg, NULL, 10); break;
+            case 'd': options.outputDir    = optarg; break;
+            case 'f': options.formats      = split(optarg); break;
+            case 'g': options.growth       = strtod(optarg, NULL); break;
+            case 'l': options.label        = optarg; break;
+            case 'm': options.maxRate      = strtod(optarg, NULL); break;
+            case 'o': options.resultsFile  = optarg; break;
+            case 'r': ringSizes            = split(optarg); break;
+            case 's': options.startRate    = strtod(optarg, NULL); break;
+            case 't': options.stepDuration = strtod(optarg, NULL); break;
+            case 'w': options.nbOfWriters  = strtoul(optarg, NULL, 10); break;
+            default:
+                usage(argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    for(size_t incr = 0; incr < ringSizes.size(); incr++) {
+        options.ringSizes.push_back(strtoul(ringSizes[incr].c_str(), NULL, 10));
+    }
+
+    /* Only the formats stored by storeFrame(), the file extension is the format name */
+    for(size_t incr = 0; incr < options.formats.size(); incr++) {
+        const std::string &format = options.formats[incr];
+
+        if((format != "pgm") && (format != "png") && (format != "jpg")) {
+            std::cerr << "Unsupported format: " << format << std::endl;
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if((options.growth <= 1.0) || (options.startRate <= 0.0) || (options.nbOfWriters == 0)) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if(!createDirectory(options.outputDir)) {
+        return EXIT_FAILURE;
+    }
+
+    /* Results of several builds go in the same file */
+    bool header = (access(options.resultsFile.c_str(), F_OK) != 0);
+    std::ofstream results(options.resultsFile.c_str(), std::ios::app);
+
+    if(!results) {
+        std::cerr << "Could not open " << options.resultsFile << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if(header) {
+        results << "label,format,ring,rate,acquired,stored,dropped,lost,backlog,p50_ms,p95_ms,p99_ms,max_ms,"
+                   "cpu_us_per_frame,rss_mb,sustained" << std::endl;
+    }
+
+    pthread_mutex_init(&soak.lock, NULL);
+    SoftwareCamera camera(800u, 600u);
+    std::ostringstream summary;
+
+    for(size_t format = 0; format < options.formats.size(); format++) {
+        for(size_t ring = 0; ring < options.ringSizes.size(); ring++) {
+            double rate = runRamp(&camera, options.formats[format], options.ringSizes[ring], results);
+            summary << options.formats[format] << ", ring " << options.ringSizes[ring] << ": " << rate <<
+                       " frames/s without drop" << std::endl;
+        }
+    }
+
+    pthread_mutex_destroy(&soak.lock);
+
+    std::cout << summary.str();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,161 @@
+/**
+ * @file calibration_test.cpp
+ * @brief Calibration class unit tests.
+ * @addtogroup unit_tests
+ * @{
+ */
+
+#include "calibration.hpp"
+#include "image.hpp"
+#include "gtest/gtest.h"
+
+#include <unistd.h>
+#include <stdlib.h>
+
+/** @brief Width of the test frames, not a multiple of the vector sizes. */
+#define TEST_WIDTH  (67u)
+/** @brief Height of the test frames. */
+#define TEST_HEIGHT (13u)
+
+/**
+ * @brief Fixture class for the Calibration class tests.
+ */
+class CalibrationTest : public testing::Test {
+
+    protected:
+        /** @brief Fills a frame with a constant value. */
+        static void fill(Image *image, unsigned char value) {
+
+            for(unsigned int incr = 0; incr < image->getWidth() * image->getHeight(); incr++) {
+                image->getImageBuffer()[incr] = (pixel_t) value;
+            }
+        }
+
+        /** @brief Returns a pixel of a frame. */
+        static unsigned int at(const Image &image, unsigned int x, unsigned int y) {
+            return (unsigned char) image.getImageBuffer()[y * image.getWidth() + x];
+        }
+};
+
+/**
+ * @brief Tests that a calibration without masters leaves the frames unchanged.
+ */
+TEST_F(CalibrationTest, Identity) {
+
+    Calibration calibration(TEST_WIDTH, TEST_HEIGHT);
+    Image frame(TEST_WIDTH, TEST_HEIGHT);
+    Image copy(TEST_WIDTH, TEST_HEIGHT);
+
+    for(unsigned int incr = 0; incr < TEST_WIDTH * TEST_HEIGHT; incr++) {
+        frame.getImageBuffer()[incr] = copy.getImageBuffer()[incr] = (pixel_t) (incr * 7);
+    }
+
+    ASSERT_TRUE(calibration.load(NULL, NULL));
+    ASSERT_TRUE(calibration.apply(&frame));
+    EXPECT_EQ(calibration.getNbOfDefects(), 0u);
+
+    for(unsigned int incr = 0; incr < TEST_WIDTH * TEST_HEIGHT; incr++) {
+        ASSERT_EQ(frame.getImageBuffer()[incr], copy.getImageBuffer()[incr]) << "Pixel " << incr;
+    }
+}
+
+/**
+ * @brief Tests the saturating dark subtraction and the flat-field gain on every pixel.
+ */
+TEST_F(CalibrationTest, DarkAndFlat) {
+
+    Calibration calibration(TEST_WIDTH, TEST_HEIGHT);
+    Image dark(TEST_WIDTH, TEST_HEIGHT);
+    Image flat(TEST_WIDTH, TEST_HEIGHT);
+    Image frame(TEST_WIDTH, TEST_HEIGHT);
+
+    /* Half of the columns respond 100 above the dark level, the other half 200 */
+    fill(&dark, 10);
+    for(unsigned int y = 0; y < TEST_HEIGHT; y++) {
+        for(unsigned int x = 0; x < TEST_WIDTH; x++) {
+            flat.getImageBuffer()[y * TEST_WIDTH + x] = (pixel_t) ((x % 2) ? 210 : 110);
+            frame.getImageBuffer()[y * TEST_WIDTH + x] = (pixel_t) ((x + 3 * y) * 5);
+        }
+    }
+
+    ASSERT_TRUE(calibration.load(&dark, &flat));
+    EXPECT_EQ(calibration.getNbOfDefects(), 0u);
+
+    /* Gain: mean response over pixel response, rounded */
+    unsigned int sum = (TEST_WIDTH / 2) * 200 + (TEST_WIDTH - TEST_WIDTH / 2) * 100;
+    unsigned int gains[2] = {((sum << 8) + TEST_WIDTH * 50) / (TEST_WIDTH * 100),
+                             ((sum << 8) + TEST_WIDTH * 100) / (TEST_WIDTH * 200)};
+
+    ASSERT_TRUE(calibration.apply(&frame));
+
+    for(unsigned int y = 0; y < TEST_HEIGHT; y++) {
+        for(unsigned int x = 0; x < TEST_WIDTH; x++) {
+            unsigned int raw = ((x + 3 * y) * 5) & 0xFF;
+            unsigned int expected = ((raw > 10) ? raw - 10 : 0) * gains[x % 2] >> 8;
+            ASSERT_EQ(at(frame, x, y), (expected > 255) ? 255u : expected) << "Pixel " << x << ", " << y;
+        }
+    }
+}
+
+/**
+ * @brief Tests the replacement of the defective pixels.
+ */
+TEST_F(CalibrationTest, Defects) {
+
+    Calibration calibration(TEST_WIDTH, TEST_HEIGHT);
+    Image dark(TEST_WIDTH, TEST_HEIGHT);
+    Image flat(TEST_WIDTH, TEST_HEIGHT);
+    Image frame(TEST_WIDTH, TEST_HEIGHT);
+
+    /* A hot pixel, a dead pixel and a hot pixel at the end of a row */
+    fill(&dark, 0);
+    fill(&flat, 100);
+    dark.getImageBuffer()[2 * TEST_WIDTH + 10] = (pixel_t) 200;
+    flat.getImageBuffer()[5 * TEST_WIDTH + 20] = (pixel_t) 20;
+    dark.getImageBuffer()[7 * TEST_WIDTH + TEST_WIDTH - 1] = (pixel_t) 100;
+
+    ASSERT_TRUE(calibration.load(&dark, &flat));
+    EXPECT_EQ(calibration.getNbOfDefects(), 3u);
+
+    for(unsigned int y = 0; y < TEST_HEIGHT; y++) {
+        for(unsigned int x = 0; x < TEST_WIDTH; x++) {
+            frame.getImageBuffer()[y * TEST_WIDTH + x] = (pixel_t) (x * 2);
+        }
+    }
+    frame.getImageBuffer()[2 * TEST_WIDTH + 10] = (pixel_t) 255;
+
+    ASSERT_TRUE(calibration.apply(&frame));
+
+    EXPECT_EQ(at(frame, 10, 2), 20u);
+    EXPECT_EQ(at(frame, 20, 5), 40u);
+    EXPECT_EQ(at(frame, TEST_WIDTH - 1, 7), (TEST_WIDTH - 2) * 2);
+    EXPECT_EQ(at(frame, 11, 2), 22u);
+}
+
+/**
+ * @brief Tests the masters read from PGM files.
+ */
+TEST_F(CalibrationTest, Files) {
+
+    Calibration calibration(TEST_WIDTH, TEST_HEIGHT);
+    Image dark(TEST_WIDTH, TEST_HEIGHT);
+    Image frame(TEST_WIDTH, TEST_HEIGHT);
+
+    fill(&dark, 30);
+    fill(&frame, 100);
+    ASSERT_GT(dark.writeToPGM("dark.pgm"), 0u);
+
+    EXPECT_FALSE(calibration.load("dark.pgm", "missing.pgm"));
+    ASSERT_TRUE(calibration.load("dark.pgm", ""));
+    ASSERT_TRUE(calibration.apply(&frame));
+    EXPECT_EQ(at(frame, 5, 5), 70u);
+
+    /* Masters and frames must have the same size */
+    Calibration other(TEST_WIDTH + 1, TEST_HEIGHT);
+    EXPECT_FALSE(other.load("dark.pgm", ""));
+    EXPECT_FALSE(other.apply(&frame));
+
+    unlink("dark.pgm");
+}
+
+/** @} */
@@ -0,0 +1,136 @@
+/**
+ * @file command_scheduler_test.cpp
+ * @brief CommandScheduler class unit tests.
+ * @addtogroup unit_tests
+ * @{
+ */
+
+#include "command_scheduler.hpp"
+#include "gtest/gtest.h"
+#include <string.h>
+#include <unistd.h>
+#include <string>
+
+/** @brief Preparation time used by the tests, in seconds. */
+#define LEAD_TIME   (0.05)
+
+/** @brief Sequence of calls, 'p' for a preparation and 'x' for an execution, followed by the order. */
+static std::string calls; 
+/** @brief CLOCK_MONOTONIC time of the last preparation and execution. */
+static double preparedAt; 
+static double executedAt; 
+static pthread_mutex_t callsLock = PTHREAD_MUTEX_INITIALIZER; 
+
+/** @brief Returns the time of a clock, in seconds. */
+static double now(clockid_t clock) {
+
+    struct timespec ts; 
+    clock_gettime(clock, &ts); 
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9; 
+}
+
+static void prepare(char order) {
+
+    pthread_mutex_lock(&callsLock); 
+    calls += 'p'; 
+    calls += order; 
+    preparedAt = now(CLOCK_MONOTONIC); 
+    pthread_mutex_unlock(&callsLock); 
+}
+
+static void execute(char order) {
+
+    pthread_mutex_lock(&callsLock); 
+    calls += 'x'; 
+    calls += order; 
+    executedAt = now(CLOCK_MONOTONIC); 
+    pthread_mutex_unlock(&callsLock); 
+}
+
+/** @brief Waits until the scheduler has no pending order. */
+static bool waitIdle(CommandScheduler &scheduler) {
+
+    for(unsigned int incr = 0; incr < 200; incr++) {
+        if(scheduler.getPending() == 0) {
+            usleep(1000); 
+            return true; 
+        }
+        usleep(5000); 
+    }
+    return false; 
+}
+
+/**
+ * @brief Tests that an order is prepared ahead and executed on time, on CLOCK_MONOTONIC. 
+ */
+TEST(CommandSchedulerTest, Monotonic) {
+
+    CommandScheduler scheduler(&prepare, &execute, LEAD_TIME); 
+    calls.clear(); 
+
+    double deadline = now(CLOCK_MONOTONIC) + 0.2; 
+    ASSERT_TRUE(scheduler.schedule('G', CLOCK_MONOTONIC, deadline)); 
+    EXPECT_EQ(scheduler.getPending(), 1u); 
+
+    ASSERT_TRUE(waitIdle(scheduler)); 
+    EXPECT_EQ(calls, "pGxG"); 
+
+    /* Prepared at the lead time, executed at the deadline and never early */
+    EXPECT_GE(preparedAt, deadline - LEAD_TIME); 
+    EXPECT_LT(preparedAt, deadline - LEAD_TIME / 2); 
+    EXPECT_GE(executedAt, deadline); 
+    EXPECT_GE(scheduler.getLastLateness(), 0.0); 
+    EXPECT_LT(scheduler.getLastLateness(), 0.001); 
+}
+
+/**
+ * @brief Tests UTC deadlines, the execution order, and late orders. 
+ */
+TEST(CommandSchedulerTest, UTC) {
+
+    CommandScheduler scheduler(&prepare, &execute, LEAD_TIME); 
+    calls.clear(); 
+
+    double utc = now(CLOCK_REALTIME); 
+    ASSERT_TRUE(scheduler.schedule('S', CLOCK_REALTIME, utc + 0.2)); 
+    ASSERT_TRUE(scheduler.schedule('G', CLOCK_REALTIME, utc + 0.1)); 
+
+    ASSERT_TRUE(waitIdle(scheduler)); 
+    EXPECT_EQ(calls, "pGxGpSxS"); 
+    EXPECT_LT(scheduler.getLastLateness(), 0.001); 
+
+    /* Already late: executed right away */
+    calls.clear(); 
+    ASSERT_TRUE(scheduler.schedule('P', CLOCK_MONOTONIC, now(CLOCK_MONOTONIC) - 1.0)); 
+    ASSERT_TRUE(waitIdle(scheduler)); 
+    EXPECT_EQ(calls, "pPxP"); 
+
+    EXPECT_FALSE(scheduler.schedule('G', CLOCK_PROCESS_CPUTIME_ID, 0.0)); 
+}
+
+/**
+ * @brief Tests the timed order syntax. 
+ */
+TEST(CommandSchedulerTest, Parse) {
+
+    char order; 
+    clockid_t clock; 
+    double time; 
+
+    const char *monotonic = "@M:1234.000050:G"; 
+    ASSERT_TRUE(CommandScheduler::parse(monotonic, strlen(monotonic), &order, &clock, &time)); 
+    EXPECT_EQ(order, 'G'); 
+    EXPECT_EQ(clock, CLOCK_MONOTONIC); 
+    EXPECT_DOUBLE_EQ(time, 1234.00005); 
+
+    const char *utc = "@U:1700000000.5:S"; 
+    ASSERT_TRUE(CommandScheduler::parse(utc, strlen(utc), &order, &clock, &time)); 
+    EXPECT_EQ(order, 'S'); 
+    EXPECT_EQ(clock, CLOCK_REALTIME); 
+
+    const char *invalid = "@X:12:G"; 
+    EXPECT_FALSE(CommandScheduler::parse(invalid, strlen(invalid), &order, &clock, &time)); 
+    EXPECT_FALSE(CommandScheduler::parse("G", 1, &order, &clock, &time)); 
+}
+
+/** @} */
@@ -0,0 +1,153 @@
+/**
+ * @file compressed_ring_test.cpp
+ * @brief CompressedRing class unit tests.
+ * @addtogroup unit_tests
+ * @{
+ */
+
+#include "compressed_ring.hpp"
+#include "gtest/gtest.h"
+#include <stdlib.h>
+#include <string.h>
+
+/** @brief Width of the test images. */
+#define IMAGE_WIDTH     (800u)
+/** @brief Height of the test images. */
+#define IMAGE_HEIGHT    (600u)
+/** @brief Size of the compressed frame arena. */
+#define ARENA_SIZE      (4u * IMAGE_WIDTH * IMAGE_HEIGHT)
+
+/**
+ * @brief Fixture class for the CompressedRing class tests.
+ */
+class CompressedRingTest : public testing::Test {
+
+    protected:
+        /** @brief Sets up the fixture class. */
+        virtual void SetUp() {
+
+            cr_  = new CompressedRing(ARENA_SIZE);
+            in_  = new Image(IMAGE_WIDTH, IMAGE_HEIGHT);
+            out_ = new Image(IMAGE_WIDTH, IMAGE_HEIGHT);
+        }
+
+        /** @brief Tears down the fixture class. */
+        virtual void TearDown() {
+            delete cr_;
+            delete in_;
+            delete out_;
+        }
+
+        /** @brief Fills the input image with a dark frame with sparse noise. */
+        void darkFrame(unsigned int seed) {
+
+            char *buffer = in_->getImageBuffer();
+            srand(seed);
+
+            for(unsigned int incr = 0; incr < IMAGE_WIDTH * IMAGE_HEIGHT; incr++) {
+                buffer[incr] = (rand() & 0x03) ? 0 : (char) (rand() & 0x0F);
+            }
+        }
+
+    /** @brief Test compressed ring object. */
+    CompressedRing *cr_;
+    /** @brief Image pushed in the ring. */
+    Image *in_;
+    /** @brief Image read from the ring. */
+    Image *out_;
+};
+
+/**
+ * @brief Tests that frames are restored losslessly, in order.
+ */
+TEST_F(CompressedRingTest, PushPop) {
+
+    unsigned int frame = 0;
+
+    for(unsigned int incr = 0; incr < 3; incr++) {
+        darkFrame(incr);
+        ASSERT_TRUE(cr_->push(in_, incr));
+    }
+    EXPECT_EQ(cr_->getCount(), 3u);
+
+    for(unsigned int incr = 0; incr < 3; incr++) {
+        darkFrame(incr);
+        ASSERT_TRUE(cr_->pop(out_, &frame));
+        EXPECT_EQ(frame, incr);
+        EXPECT_EQ(memcmp(in_->getImageBuffer(), out_->getImageBuffer(), IMAGE_WIDTH * IMAGE_HEIGHT), 0);
+    }
+
+    EXPECT_EQ(cr_->getCount(), 0u);
+    EXPECT_EQ(cr_->getUsedBytes(), 0u);
+}
+
+/**
+ * @brief Tests that dark frames take much less room than raw frames.
+ */
+TEST_F(CompressedRingTest, CompressionRatio) {
+
+    darkFrame(0);
+    ASSERT_TRUE(cr_->push(in_, 0));
+
+    EXPECT_GT(cr_->getCompressionRatio(), 3.0);
+}
+
+/**
+ * @brief Tests that the oldest frames are evicted when the arena is full,
+ *        and that the remaining ones can still be read on demand.
+ */
+TEST_F(CompressedRingTest, Eviction) {
+
+    const unsigned int nbOfFrames = 100;
+
+    for(unsigned int incr = 0; incr < nbOfFrames; incr++) {
+        darkFrame(incr);
+        ASSERT_TRUE(cr_->push(in_, incr));
+        ASSERT_LE(cr_->getUsedBytes(), cr_->getCapacity());
+    }
+
+    size_t count = cr_->getCount();
+    EXPECT_GT(count, 4u);
+    EXPECT_LT(count, nbOfFrames);
+    EXPECT_EQ(cr_->getEvicted(), nbOfFrames - count);
+
+    /* Evicted frame */
+    EXPECT_FALSE(cr_->get(0, out_));
+
+    /* Most recent frames */
+    for(unsigned int incr = nbOfFrames - count; incr < nbOfFrames; incr++) {
+        darkFrame(incr);
+        ASSERT_TRUE(cr_->get(incr, out_));
+        EXPECT_EQ(memcmp(in_->getImageBuffer(), out_->getImageBuffer(), IMAGE_WIDTH * IMAGE_HEIGHT), 0);
+    }
+}
+
+/**
+ * @brief Tests that a closed ring can be drained and then stops waiting.
+ */
+TEST_F(CompressedRingTest, Close) {
+
+    unsigned int frame = 0;
+
+    darkFrame(0);
+    ASSERT_TRUE(cr_->push(in_, 42));
+    cr_->close();
+
+    EXPECT_TRUE(cr_->pop(out_, &frame));
+    EXPECT_EQ(frame, 42u);
+    EXPECT_FALSE(cr_->pop(out_, &frame));
+}
+
+/**
+ * @brief Tests that an image of the wrong size is rejected.
+ */
+TEST_F(CompressedRingTest, WrongSize) {
+
+    Image small(IMAGE_WIDTH / 2, IMAGE_HEIGHT / 2);
+
+    darkFrame(0);
+    ASSERT_TRUE(cr_->push(in_, 0));
+    EXPECT_FALSE(cr_->get(0, &small));
+}
+
+/** @} */
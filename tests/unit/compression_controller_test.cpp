@@ -0,0 +1,75 @@
+/**
+ * @file compression_controller_test.cpp
+ * @brief CompressionController class unit tests.
+ * @addtogroup unit_tests
+ * @{
+ */
+
+#include "compression_controller.hpp"
+#include "gtest/gtest.h"
+
+#include <png.h>
+
+/**
+ * @brief Tests that the level drops with the backlog, down to the minimum level. 
+ */
+TEST(CompressionControllerTest, Drop) {
+
+    CompressionController cc(2, 8); 
+    EXPECT_EQ(cc.getLevel(), 8); 
+
+    /* Between the watermarks: hold */
+    EXPECT_EQ(cc.update(0.3), 8); 
+
+    EXPECT_EQ(cc.update(0.6), 7); 
+    EXPECT_EQ(cc.update(0.6), 6); 
+
+    /* Critical backlog: fastest level at once */
+    EXPECT_EQ(cc.update(0.9), 2); 
+    EXPECT_EQ(cc.update(1.0), 2); 
+}
+
+/**
+ * @brief Tests that the level rises slowly when the writers are idle. 
+ */
+TEST(CompressionControllerTest, Raise) {
+
+    CompressionController cc(1, 3); 
+    cc.update(1.0); 
+    ASSERT_EQ(cc.getLevel(), 1); 
+
+    for(unsigned int incr = 1; incr < COMPRESSION_RAISE_DELAY; incr++) {
+        EXPECT_EQ(cc.update(0.0), 1); 
+    }
+    EXPECT_EQ(cc.update(0.0), 2); 
+
+    /* A busier frame restarts the delay */
+    cc.update(0.3); 
+    for(unsigned int incr = 1; incr < COMPRESSION_RAISE_DELAY; incr++) {
+        cc.update(0.0); 
+    }
+    EXPECT_EQ(cc.getLevel(), 2); 
+
+    for(unsigned int incr = 0; incr < 10 * COMPRESSION_RAISE_DELAY; incr++) {
+        cc.update(0.0); 
+    }
+    EXPECT_EQ(cc.getLevel(), 3); 
+}
+
+/**
+ * @brief Tests the limits and the PNG filters. 
+ */
+TEST(CompressionControllerTest, Limits) {
+
+    CompressionController cc(-4, 42); 
+    EXPECT_EQ(cc.getLevel(), 9); 
+    EXPECT_EQ(cc.update(1.0), 0); 
+
+    cc.setLimits(5, 3); 
+    EXPECT_EQ(cc.update(1.0), 5); 
+
+    EXPECT_EQ(CompressionController::getFilters(0), PNG_FILTER_NONE); 
+    EXPECT_EQ(CompressionController::getFilters(9), PNG_ALL_FILTERS); 
+}
+
+/** @} */
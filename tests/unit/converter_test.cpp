@@ -0,0 +1,223 @@
+/**
+ * @file converter_test.cpp
+ * @brief Converter class unit tests.
+ * @addtogroup unit_tests
+ * @{
+ */
+
+#include "converter.hpp"
+#include "recording_verifier.hpp"
+#include "temporal_codec.hpp"
+#include "image.hpp"
+#include "gtest/gtest.h"
+
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+
+/**
+ * @brief Fixture class for the Converter class tests.
+ */
+class ConverterTest : public testing::Test {
+
+    protected:
+        /** @brief Writes a PGM recording of six frames, in a directory and a shard. */
+        virtual void SetUp() {
+
+            ASSERT_EQ(system("rm -rf convertDir"), 0);
+            ASSERT_EQ(mkdir("convertDir", 0777), 0);
+            ASSERT_EQ(mkdir("convertDir/input", 0777), 0);
+            ASSERT_EQ(mkdir("convertDir/input/000000", 0777), 0);
+
+            for(unsigned int frame = 0; frame < 6; frame++) {
+                Image image(64, 48);
+                fill(&image, frame);
+
+                char path[64];
+                snprintf(path, sizeof(path), "convertDir/input/%simage%010u.pgm", (frame < 4) ? "000000/" : "", frame);
+                ASSERT_GT(image.writeToPGM(path), 0u);
+            }
+        }
+
+        /** @brief Removes the recordings. */
+        virtual void TearDown() {
+            ASSERT_EQ(system("rm -rf convertDir"), 0);
+        }
+
+        /** @brief Fills a frame with a pattern depending on its number. */
+        static void fill(Image *image, unsigned int frame) {
+
+            for(unsigned int incr = 0; incr < 64 * 48; incr++) {
+                image->getImageBuffer()[incr] = (pixel_t) (incr * 7 + frame * 31);
+            }
+        }
+};
+
+/**
+ * @brief Tests the conversion of a PGM recording to PNG, and its resumption.
+ */
+TEST_F(ConverterTest, ToPNG) {
+
+    Converter converter("convertDir/input", "convertDir/png", CONVERT_PNG, 3);
+
+    ASSERT_EQ(converter.scan(), 6);
+    converter.start();
+    EXPECT_EQ(converter.wait(), 0u);
+    EXPECT_EQ(converter.getDone(), 6u);
+
+    /* Same layout, checksums carried over */
+    EXPECT_EQ(access("convertDir/png/000000/image0000000003.png", F_OK), 0);
+    EXPECT_EQ(access("convertDir/png/image0000000005.png", F_OK), 0);
+
+    RecordingVerifier verifier("convertDir/png");
+    EXPECT_EQ(verifier.verify(), 0u);
+    EXPECT_EQ(verifier.getValid(), 6u);
+
+    /* An interrupted conversion only converts the missing frames */
+    ASSERT_EQ(unlink("convertDir/png/image0000000004.png"), 0);
+
+    Converter resumed("convertDir/input", "convertDir/png", CONVERT_PNG, 3);
+    ASSERT_EQ(resumed.scan(), 1);
+    EXPECT_EQ(resumed.getSkipped(), 5u);
+    resumed.start();
+    EXPECT_EQ(resumed.wait(), 0u);
+    EXPECT_EQ(access("convertDir/png/image0000000004.png", F_OK), 0);
+}
+
+/**
+ * @brief Tests a round trip through a raw archive.
+ */
+TEST_F(ConverterTest, Archive) {
+
+    Converter archiver("convertDir/input", "convertDir/frames.raw", CONVERT_ARCHIVE, 4);
+    archiver.setGeometry(64, 48);
+
+    ASSERT_EQ(archiver.scan(), 6);
+    archiver.start();
+    EXPECT_EQ(archiver.wait(), 0u);
+
+    struct stat info;
+    ASSERT_EQ(stat("convertDir/frames.raw", &info), 0);
+    EXPECT_EQ(info.st_size, 6 * (4 + 64 * 48));
+
+    /* A torn record is dropped and converted again */
+    ASSERT_EQ(truncate("convertDir/frames.raw", info.st_size - 100), 0);
+
+    Converter resumed("convertDir/input", "convertDir/frames.raw", CONVERT_ARCHIVE, 4);
+    resumed.setGeometry(64, 48);
+    ASSERT_EQ(resumed.scan(), 1);
+    resumed.start();
+    EXPECT_EQ(resumed.wait(), 0u);
+
+    /* Back to PGM frames, named after the frame numbers */
+    Converter extractor("convertDir/frames.raw", "convertDir/pgm", CONVERT_PGM, 2);
+    extractor.setGeometry(64, 48);
+
+    ASSERT_EQ(extractor.scan(), 6);
+    extractor.start();
+    EXPECT_EQ(extractor.wait(), 0u);
+
+    for(unsigned int frame = 0; frame < 6; frame++) {
+        char path[64];
+        snprintf(path, sizeof(path), "convertDir/pgm/image%010u.pgm", frame);
+
+        FILE *fp = fopen(path, "rb");
+        ASSERT_TRUE(fp != NULL);
+        unsigned char file[4096];
+        size_t size = fread(file, 1, sizeof(file), fp);
+        fclose(fp);
+
+        Image expected(64, 48);
+        fill(&expected, frame);
+        ASSERT_GT(size, 64u * 48u);
+        EXPECT_EQ(memcmp(file + size - 64 * 48, expected.getImageBuffer(), 64 * 48), 0);
+    }
+}
+
+/**
+ * @brief Tests the averaging of a recording into a single frame.
+ */
+TEST_F(ConverterTest, Mean) {
+
+    Converter converter("convertDir/input", "convertDir/mean.pgm", CONVERT_MEAN, 3);
+    converter.setGeometry(64, 48);
+
+    ASSERT_EQ(converter.scan(), 6);
+    converter.start();
+    EXPECT_EQ(converter.wait(), 0u);
+
+    FILE *fp = fopen("convertDir/mean.pgm", "rb");
+    ASSERT_TRUE(fp != NULL);
+    unsigned char file[4096];
+    size_t size = fread(file, 1, sizeof(file), fp);
+    fclose(fp);
+    ASSERT_GT(size, 64u * 48u);
+
+    const unsigned char *mean = file + size - 64 * 48;
+    for(unsigned int incr = 0; incr < 64 * 48; incr++) {
+        unsigned int sum = 0;
+        for(unsigned int frame = 0; frame < 6; frame++) {
+            sum += (unsigned char) (incr * 7 + frame * 31);
+        }
+        ASSERT_EQ(mean[incr], (sum + 3) / 6) << "Pixel " << incr;
+    }
+}
+
+/**
+ * @brief Tests that a small memory bound does not block the conversion.
+ */
+TEST_F(ConverterTest, Bounded) {
+
+    Converter converter("convertDir/input", "convertDir/png", CONVERT_PNG, 4, 1024);
+
+    ASSERT_EQ(converter.scan(), 6);
+    converter.start();
+    EXPECT_EQ(converter.wait(), 0u);
+    EXPECT_EQ(converter.getDone(), 6u);
+}
+
+/**
+ * @brief Tests the extraction of a temporal stream, shared between threads.
+ */
+TEST_F(ConverterTest, Stream) {
+
+    TemporalEncoder encoder(64, 48, 4);
+    ASSERT_TRUE(encoder.open("convertDir/frames.tdc"));
+
+    Image image(64, 48);
+    for(unsigned int frame = 0; frame < 30; frame++) {
+        fill(&image, frame);
+        ASSERT_TRUE(encoder.add(&image, frame + 1000));
+    }
+
+    /* The frame size comes from the stream */
+    Converter converter("convertDir/frames.tdc", "convertDir/frames.raw", CONVERT_ARCHIVE, 3);
+    ASSERT_EQ(converter.scan(), 30);
+    converter.start();
+    EXPECT_EQ(converter.wait(), 0u);
+
+    std::vector<unsigned char> found(30, 0);
+    int fd = open("convertDir/frames.raw", O_RDONLY);
+    ASSERT_GE(fd, 0);
+
+    uint32_t frame;
+    while(read(fd, &frame, sizeof(frame)) == sizeof(frame)) {
+        ASSERT_EQ(read(fd, image.getImageBuffer(), 64 * 48), 64 * 48);
+        ASSERT_GE(frame, 1000u);
+        ASSERT_LT(frame, 1030u);
+
+        Image expected(64, 48);
+        fill(&expected, frame - 1000);
+        EXPECT_EQ(memcmp(image.getImageBuffer(), expected.getImageBuffer(), 64 * 48), 0);
+        found[frame - 1000]++;
+    }
+    close(fd);
+
+    for(unsigned int incr = 0; incr < 30; incr++) {
+        EXPECT_EQ(found[incr], 1u) << "Frame " << incr;
+    }
+}
+
+/** @} */
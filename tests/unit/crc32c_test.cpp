@@ -0,0 +1,79 @@
+/**
+ * @file crc32c_test.cpp
+ * @brief CRC32C functions unit tests.
+ * @addtogroup unit_tests
+ * @{
+ */
+
+#include "crc32c.hpp"
+#include "gtest/gtest.h"
+#include <stdlib.h>
+#include <string.h>
+
+/** @brief Size of the test buffer, large enough for the interleaved streams. */
+#define BUFFER_SIZE     (100003u)
+
+/** @brief Bitwise reference implementation. */
+static uint32_t reference(const unsigned char *data, size_t size) {
+
+    uint32_t crc = 0xFFFFFFFFu; 
+
+    for(size_t incr = 0; incr < size; incr++) {
+        crc ^= data[incr]; 
+        for(unsigned int bit = 0; bit < 8; bit++) {
+            crc = (crc & 1) ? (crc >> 1) ^ 0x82F63B78u : crc >> 1; 
+        }
+    }
+
+    return ~crc; 
+}
+
+/**
+ * @brief Tests the check value of the CRC catalogue.
+ */
+TEST(Crc32cTest, CheckValue) {
+
+    EXPECT_EQ(crc32c(0, "123456789", 9), 0xE3069283u); 
+    EXPECT_EQ(crc32c(0, "", 0), 0u); 
+}
+
+/**
+ * @brief Tests a large buffer against the reference, in one or several calls.
+ */
+TEST(Crc32cTest, Reference) {
+
+    unsigned char *buffer = new unsigned char[BUFFER_SIZE]; 
+    srand(0); 
+    for(unsigned int incr = 0; incr < BUFFER_SIZE; incr++) {
+        buffer[incr] = (unsigned char) rand(); 
+    }
+
+    uint32_t expected = reference(buffer, BUFFER_SIZE); 
+    EXPECT_EQ(crc32c(0, buffer, BUFFER_SIZE), expected); 
+
+    /* Chained calls over unaligned pieces */
+    uint32_t crc = crc32c(0, buffer, 13); 
+    crc = crc32c(crc, buffer + 13, 50000); 
+    crc = crc32c(crc, buffer + 50013, BUFFER_SIZE - 50013); 
+    EXPECT_EQ(crc, expected); 
+
+    delete [] buffer; 
+}
+
+/**
+ * @brief Tests that the CRCs of two blocks combine into the CRC of both. 
+ */
+TEST(Crc32cTest, Combine) {
+
+    unsigned char buffer[1000]; 
+    for(unsigned int incr = 0; incr < sizeof(buffer); incr++) {
+        buffer[incr] = (unsigned char) (incr * 7); 
+    }
+
+    uint32_t first  = crc32c(0, buffer, 321); 
+    uint32_t second = crc32c(0, buffer + 321, sizeof(buffer) - 321); 
+
+    EXPECT_EQ(crc32cCombine(first, second, sizeof(buffer) - 321), crc32c(0, buffer, sizeof(buffer))); 
+}
+
+/** @} */
@@ -0,0 +1,131 @@
+/**
+ * @file flusher_test.cpp
+ * @brief Flusher class unit tests.
+ * @addtogroup unit_tests
+ * @{
+ */
+
+#include "flusher.hpp"
+#include "utilities.hpp"
+#include "gtest/gtest.h"
+
+#include <unistd.h>
+
+/**
+ * @brief Fixture class for the Flusher class tests. 
+ */
+class FlusherTest : public testing::Test {
+
+    protected:
+        /** @brief Sets up the fixture class. */
+        virtual void SetUp() {
+            ASSERT_TRUE(createDirectory("flushDir")); 
+            unlink("flushDir/frames.journal"); 
+
+            journal_ = new FrameJournal("flushDir/frames.journal"); 
+            dir_     = new OutputDirectory("flushDir", "raw"); 
+        }
+
+        /** @brief Tears down the fixture class. */
+        virtual void TearDown() {
+            delete dir_; 
+            delete journal_; 
+        }
+
+        /** @brief Writes a small frame file and hands it over to the flusher. */
+        void addFrame(Flusher &flusher, unsigned int frame) {
+            FILE *fp = dir_->openFile(frame); 
+            ASSERT_NE(fp, (FILE *) NULL); 
+            fputs("frame", fp); 
+            flusher.add(frame, fp); 
+        }
+
+    FrameJournal *journal_; 
+    OutputDirectory *dir_; 
+}; 
+
+/**
+ * @brief Tests that a group is committed as soon as it is full. 
+ */
+TEST_F(FlusherTest, GroupSize) {
+
+    Flusher flusher(journal_, dir_, 4u, 60000u); 
+
+    for(unsigned int frame = 0; frame < 4; frame++) {
+        addFrame(flusher, frame); 
+    }
+
+    for(unsigned int incr = 0; (incr < 500) && (flusher.getCommitted() < 4); incr++) {
+        usleep(10000); 
+    }
+    EXPECT_EQ(flusher.getCommitted(), 4u); 
+    EXPECT_EQ(flusher.getFailed(), 0u); 
+}
+
+/**
+ * @brief Tests that an incomplete group is committed after the group delay. 
+ */
+TEST_F(FlusherTest, GroupDelay) {
+
+    Flusher flusher(journal_, dir_, 1000u, 20u); 
+
+    addFrame(flusher, 7); 
+    for(unsigned int incr = 0; (incr < 500) && (flusher.getCommitted() < 1); incr++) {
+        usleep(10000); 
+    }
+    EXPECT_EQ(flusher.getCommitted(), 1u); 
+}
+
+/**
+ * @brief Tests forced commits and the journal content. 
+ */
+TEST_F(FlusherTest, Commit) {
+
+    {
+        Flusher flusher(journal_, dir_, 1000u, 60000u); 
+
+        addFrame(flusher, 0); 
+        addFrame(flusher, 1); 
+        flusher.commit(); 
+        EXPECT_EQ(flusher.getCommitted(), 2u); 
+
+        /* Pending frames are committed on destruction */
+        addFrame(flusher, 2); 
+    }
+
+    EXPECT_TRUE(journal_->isCommitted(0)); 
+    EXPECT_TRUE(journal_->isCommitted(2)); 
+
+    FrameJournal reloaded("flushDir/frames.journal"); 
+    EXPECT_EQ(reloaded.getNextFrame(), 3u); 
+}
+
+/**
+ * @brief Tests that the frames with failed writes are not journaled. 
+ */
+TEST_F(FlusherTest, Failed) {
+
+    Flusher flusher(journal_, dir_, 1000u, 60000u); 
+
+    addFrame(flusher, 0); 
+
+    /* Writes to a read-only stream fail */
+    FILE *fp = fopen((std::string("flushDir/") + dir_->getFilename(0)).c_str(), "rb"); 
+    ASSERT_NE(fp, (FILE *) NULL); 
+    fputs("frame", fp); 
+    flusher.add(1, fp); 
+
+    /* The writer reported an error */
+    fp = dir_->openFile(2); 
+    ASSERT_NE(fp, (FILE *) NULL); 
+    flusher.add(2, fp, false); 
+
+    flusher.commit(); 
+    EXPECT_EQ(flusher.getCommitted(), 1u); 
+    EXPECT_EQ(flusher.getFailed(), 2u); 
+    EXPECT_TRUE(journal_->isCommitted(0)); 
+    EXPECT_FALSE(journal_->isCommitted(1)); 
+    EXPECT_FALSE(journal_->isCommitted(2)); 
+}
+
+/** @} */
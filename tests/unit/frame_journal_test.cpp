@@ -0,0 +1,134 @@
+/**
+ * @file frame_journal_test.cpp
+ * @brief FrameJournal class unit tests.
+ * @addtogroup unit_tests
+ * @{
+ */
+
+#include "frame_journal.hpp"
+#include "image.hpp"
+#include "utilities.hpp"
+#include "gtest/gtest.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+#include <stdio.h>
+
+/** @brief Journal file used by the tests. */
+#define JOURNAL_FILE    "journalDir/frames.journal"
+
+/**
+ * @brief Fixture class for the FrameJournal class tests. 
+ */
+class FrameJournalTest : public testing::Test {
+
+    protected:
+        /** @brief Sets up the fixture class. */
+        virtual void SetUp() {
+            ASSERT_TRUE(createDirectory("journalDir")); 
+            unlink(JOURNAL_FILE); 
+        }
+}; 
+
+/**
+ * @brief Tests that committed frames are found again when the journal is reopened. 
+ */
+TEST_F(FrameJournalTest, Reload) {
+
+    unsigned int group1[] = {0, 1, 2}; 
+    unsigned int group2[] = {4, 3}; 
+
+    {
+        FrameJournal journal(JOURNAL_FILE); 
+        ASSERT_TRUE(journal.isOpen()); 
+        EXPECT_EQ(journal.getNextFrame(), 0u); 
+        ASSERT_TRUE(journal.append(group1, 3)); 
+        ASSERT_TRUE(journal.append(group2, 2)); 
+    }
+
+    FrameJournal journal(JOURNAL_FILE); 
+    EXPECT_EQ(journal.getCount(), 5u); 
+    EXPECT_EQ(journal.getNextFrame(), 5u); 
+    EXPECT_TRUE(journal.isCommitted(3)); 
+    EXPECT_FALSE(journal.isCommitted(5)); 
+}
+
+/**
+ * @brief Tests that a record torn by a crash is dropped. 
+ */
+TEST_F(FrameJournalTest, TornRecord) {
+
+    unsigned int group1[] = {10, 11}; 
+    unsigned int group2[] = {12, 13}; 
+    struct stat info; 
+
+    {
+        FrameJournal journal(JOURNAL_FILE); 
+        ASSERT_TRUE(journal.append(group1, 2)); 
+        ASSERT_TRUE(journal.append(group2, 2)); 
+    }
+
+    /* Cut the last record in the middle */
+    ASSERT_EQ(stat(JOURNAL_FILE, &info), 0); 
+    ASSERT_EQ(truncate(JOURNAL_FILE, info.st_size - 6), 0); 
+
+    {
+        FrameJournal journal(JOURNAL_FILE); 
+        EXPECT_EQ(journal.getCount(), 2u); 
+        EXPECT_EQ(journal.getNextFrame(), 12u); 
+        ASSERT_TRUE(journal.append(group2, 2)); 
+    }
+
+    FrameJournal journal(JOURNAL_FILE); 
+    EXPECT_EQ(journal.getCount(), 4u); 
+}
+
+/**
+ * @brief Tests that recovery keeps complete frames and removes partial ones. 
+ */
+TEST_F(FrameJournalTest, Recovery) {
+
+    Image i(64u, 48u); 
+    struct stat info; 
+    unsigned int committed[] = {0}; 
+
+    ASSERT_TRUE(createDirectory("journalDir/000000")); 
+    ASSERT_GT(i.writeToPGM("journalDir/000000/image0000000000.pgm"), 0u); 
+    ASSERT_GT(i.writeToPGM("journalDir/000000/image0000000001.pgm"), 0u); 
+    ASSERT_GT(i.writeToPGM("journalDir/000000/image0000000002.pgm"), 0u); 
+    i.writeToPNG("journalDir/000000/image0000000003.png"); 
+    ASSERT_GT(i.writeToJPEG("journalDir/000000/image0000000004.jpg"), 0u); 
+    ASSERT_GT(i.writeToJPEG("journalDir/000000/image0000000005.jpg"), 0u); 
+
+    /* Unknown formats cannot be checked */
+    FILE *fp = fopen("journalDir/000000/image0000000006.raw", "w"); 
+    ASSERT_TRUE(fp != NULL); 
+    fputs("frame", fp); 
+    fclose(fp); 
+
+    /* Frames 2, 3 and 5 were being written during the crash */
+    ASSERT_EQ(truncate("journalDir/000000/image0000000002.pgm", 1000), 0); 
+    ASSERT_EQ(stat("journalDir/000000/image0000000003.png", &info), 0); 
+    ASSERT_EQ(truncate("journalDir/000000/image0000000003.png", info.st_size - 1), 0); 
+    ASSERT_EQ(stat("journalDir/000000/image0000000005.jpg", &info), 0); 
+    ASSERT_EQ(truncate("journalDir/000000/image0000000005.jpg", info.st_size / 2), 0); 
+
+    FrameJournal journal(JOURNAL_FILE); 
+    ASSERT_TRUE(journal.append(committed, 1)); 
+
+    EXPECT_EQ(journal.recover("journalDir"), 4u); 
+    EXPECT_TRUE(journal.isCommitted(1)); 
+    EXPECT_FALSE(journal.isCommitted(2)); 
+    EXPECT_TRUE(journal.isCommitted(4)); 
+    EXPECT_FALSE(journal.isCommitted(5)); 
+    EXPECT_EQ(journal.getNextFrame(), 5u); 
+
+    EXPECT_EQ(stat("journalDir/000000/image0000000001.pgm", &info), 0); 
+    EXPECT_NE(stat("journalDir/000000/image0000000002.pgm", &info), 0); 
+    EXPECT_NE(stat("journalDir/000000/image0000000003.png", &info), 0); 
+    EXPECT_EQ(stat("journalDir/000000/image0000000004.jpg", &info), 0); 
+    EXPECT_NE(stat("journalDir/000000/image0000000005.jpg", &info), 0); 
+    EXPECT_NE(stat("journalDir/000000/image0000000006.raw", &info), 0); 
+}
+
+/** @} */
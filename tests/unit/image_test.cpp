@@ -11,6 +11,8 @@
 #include <png.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <string>
 
 /** @brief Width of the test image. */
 #define IMAGE_WIDTH     (800u)
@@ -138,6 +140,72 @@ TEST_F(ImageTest, SaveAsPNG) {
     png_destroy_read_struct(&png_ptr, (png_infopp) NULL, (png_infopp) NULL); 
 }
 
+/**
+ * @brief Tests the PNG compression level and filters. 
+ */
+TEST_F(ImageTest, PNGCompression) {
+
+    /* Smooth image, random data does not compress */
+    char *buffer = i_->getImageBuffer(); 
+    for(unsigned int r = 0; r < IMAGE_HEIGHT; r++) {
+        for(unsigned int c = 0; c < IMAGE_WIDTH; c++) {
+            buffer[(r * IMAGE_WIDTH) + c] = (char) ((r + c) & 0xFF); 
+        }
+    }
+
+    FILE *fp = fopen("ImageFast.png", "wb"); 
+    ASSERT_NE(fp, (FILE *) NULL); 
+    i_->writeToPNG(fp, NULL, 0, PNG_FILTER_NONE); 
+    long fastSize = ftell(fp); 
+    fclose(fp); 
+
+    fp = fopen("ImageBest.png", "wb"); 
+    ASSERT_NE(fp, (FILE *) NULL); 
+    i_->writeToPNG(fp, NULL, 9, PNG_ALL_FILTERS); 
+    long bestSize = ftell(fp); 
+    fclose(fp); 
+
+    /* Level 0 stores the raw data */
+    EXPECT_GT(fastSize, (long) (IMAGE_WIDTH * IMAGE_HEIGHT)); 
+    EXPECT_LT(bestSize, fastSize / 10); 
+}
+
+/**
+ * @brief Tests that the PGM header parser reads back the header written by the image. 
+ */
+TEST_F(ImageTest, PGMHeader) {
+
+    FILE *fp = fopen("ImageTest.pgm", "w+b"); 
+    ASSERT_NE(fp, (FILE *) NULL); 
+    size_t bytes = i_->writeToPGM(fp); 
+    rewind(fp); 
+
+    PGMHeader_s header; 
+    ASSERT_TRUE(Image::readPGMHeader(fp, &header)); 
+    EXPECT_EQ(header.width, IMAGE_WIDTH); 
+    EXPECT_EQ(header.height, IMAGE_HEIGHT); 
+    EXPECT_EQ(header.maxValue, 255u); 
+    EXPECT_EQ(header.offset + IMAGE_WIDTH * IMAGE_HEIGHT, bytes); 
+    EXPECT_EQ(ftell(fp), (long) header.offset); 
+    EXPECT_TRUE(header.hasChecksum); 
+    fclose(fp); 
+
+    /* Comments anywhere between the values, however long */
+    std::string text = "P5 # " + std::string(200, 'x') + "\n4\n# crc32c 0000abcd\n 2 #\n255\n"; 
+    ASSERT_TRUE(Image::parsePGMHeader((const unsigned char *) text.c_str(), text.size(), &header)); 
+    EXPECT_EQ(header.width, 4u); 
+    EXPECT_EQ(header.height, 2u); 
+    EXPECT_EQ(header.offset, text.size()); 
+    EXPECT_TRUE(header.hasChecksum); 
+    EXPECT_EQ(header.checksum, 0xABCDu); 
+
+    /* Truncated or invalid headers */
+    const char *invalid[4] = {"P5\n4 2\n255", "P6\n4 2\n255\n", "P54 2\n255\n", "P5\n4 x2\n255\n"}; 
+    for(unsigned int incr = 0; incr < 4; incr++) {
+        EXPECT_FALSE(Image::parsePGMHeader((const unsigned char *) invalid[incr], strlen(invalid[incr]), &header)); 
+    }
+}
+
 /**
  * @brief Main unit tests control function. 
  * @details Launches the unit tests and controls the output formats. 
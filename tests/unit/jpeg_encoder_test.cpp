@@ -0,0 +1,184 @@
+/**
+ * @file jpeg_encoder_test.cpp
+ * @brief JpegEncoder class unit tests.
+ * @addtogroup unit_tests
+ * @{
+ */
+
+#include "jpeg_encoder.hpp"
+#include "png_encoder.hpp"
+#include "gtest/gtest.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** @brief Width of the test frames, not a multiple of the block size. */
+#define FRAME_WIDTH     (203u)
+/** @brief Height of the test frames. */
+#define FRAME_HEIGHT    (61u)
+/** @brief Test JPEG file. */
+#define FRAME_FILE      "JpegEncoderTest.jpg"
+
+/**
+ * @brief Fixture class for the JpegEncoder class tests.
+ */
+class JpegEncoderTest : public testing::Test {
+
+    protected:
+        /** @brief Fills the frame with a smooth scene and a little noise. */
+        virtual void SetUp() {
+
+            srand(0);
+            for(unsigned int y = 0; y < FRAME_HEIGHT; y++) {
+                for(unsigned int x = 0; x < FRAME_WIDTH; x++) {
+                    frame_[y * FRAME_WIDTH + x] = (pixel_t) (128 + 90 * sin(x / 13.0) * cos(y / 9.0) + (rand() % 6));
+                }
+            }
+        }
+
+        virtual void TearDown() {
+            remove(FRAME_FILE);
+        }
+
+        /** @brief Writes the frame and reads the file back. */
+        size_t encode(int quality, unsigned int scale) {
+
+            FILE *fp = fopen(FRAME_FILE, "wb");
+            size_t size = encoder_.write(fp, frame_, FRAME_WIDTH, FRAME_HEIGHT, quality, scale);
+            fclose(fp);
+
+            fp = fopen(FRAME_FILE, "rb");
+            file_.assign(size, 0);
+            EXPECT_EQ(fread(&file_[0], 1, size, fp), size);
+            fclose(fp);
+
+            return size;
+        }
+
+        /** @brief Returns the position of the first marker of a type, or 0 if none. */
+        size_t find(unsigned char marker) const {
+
+            for(size_t incr = 0; incr + 1 < file_.size(); incr++) {
+                if((file_[incr] == 0xFF) && (file_[incr + 1] == marker)) {
+                    return incr;
+                }
+            }
+
+            return 0;
+        }
+
+        JpegEncoder encoder_;
+        pixel_t frame_[FRAME_WIDTH * FRAME_HEIGHT];
+        std::vector<unsigned char> file_;
+};
+
+/**
+ * @brief Compares the integer DCT with a floating point one.
+ */
+TEST_F(JpegEncoderTest, Transform) {
+
+    unsigned char block[3][64];
+    for(unsigned int incr = 0; incr < 64; incr++) {
+        block[0][incr] = (unsigned char) (rand() % 256);
+        block[1][incr] = (((incr / 8) + incr) % 2 == 0) ? 255 : 0;
+        block[2][incr] = 255;
+    }
+
+    for(unsigned int test = 0; test < 3; test++) {
+        int32_t coefficients[64];
+        JpegEncoder::transform(block[test], 8, coefficients);
+
+        for(unsigned int v = 0; v < 8; v++) {
+            for(unsigned int u = 0; u < 8; u++) {
+                double sum = 0.0;
+                for(unsigned int y = 0; y < 8; y++) {
+                    for(unsigned int x = 0; x < 8; x++) {
+                        sum += (block[test][y * 8 + x] - 128.0) * cos((2 * x + 1) * u * M_PI / 16.0) *
+                               cos((2 * y + 1) * v * M_PI / 16.0);
+                    }
+                }
+
+                /* Orthonormal DCT, scaled up by 8 */
+                double expected = sum * ((u == 0) ? M_SQRT1_2 : 1.0) * ((v == 0) ? M_SQRT1_2 : 1.0) * 2.0;
+                EXPECT_NEAR(coefficients[v * 8 + u], expected, 2.0) << "Block " << test << ", (" << u << ", " << v << ")";
+            }
+        }
+    }
+}
+
+/**
+ * @brief Tests the quality scaling of the quantization table.
+ */
+TEST_F(JpegEncoderTest, Quantizers) {
+
+    uint16_t table[64];
+
+    JpegEncoder::getQuantizers(50, table);
+    EXPECT_EQ(table[0], 16u);
+    EXPECT_EQ(table[63], 99u);
+
+    JpegEncoder::getQuantizers(100, table);
+    for(unsigned int incr = 0; incr < 64; incr++) {
+        EXPECT_EQ(table[incr], 1u);
+    }
+
+    JpegEncoder::getQuantizers(-5, table);
+    EXPECT_EQ(table[0], 255u);
+}
+
+/**
+ * @brief Tests the file structure: markers, size of the frame, byte stuffing.
+ */
+TEST_F(JpegEncoderTest, Structure) {
+
+    unsigned int scales[] = {1, 3};
+
+    for(unsigned int test = 0; test < 2; test++) {
+        ASSERT_GT(encode(JPEG_DEFAULT_QUALITY, scales[test]), 0u);
+
+        EXPECT_EQ(file_[0], 0xFF);
+        EXPECT_EQ(file_[1], 0xD8);
+        EXPECT_EQ(file_[file_.size() - 2], 0xFF);
+        EXPECT_EQ(file_[file_.size() - 1], 0xD9);
+
+        size_t frame = find(0xC0);
+        ASSERT_GT(frame, 0u);
+        EXPECT_EQ(file_[frame + 5] * 256 + file_[frame + 6], FRAME_HEIGHT / scales[test]);
+        EXPECT_EQ(file_[frame + 7] * 256 + file_[frame + 8], FRAME_WIDTH / scales[test]);
+
+        /* In the entropy coded data, 0xFF is always followed by a stuffed 0x00 */
+        size_t scan = find(0xDA);
+        ASSERT_GT(scan, 0u);
+        for(size_t incr = scan + 10; incr + 2 < file_.size(); incr++) {
+            if(file_[incr] == 0xFF) {
+                EXPECT_EQ(file_[++incr], 0x00);
+            }
+        }
+    }
+
+    FILE *fp = fopen(FRAME_FILE, "wb");
+    EXPECT_EQ(encoder_.write(fp, frame_, FRAME_WIDTH, FRAME_HEIGHT, 75, 0), 0u);
+    EXPECT_EQ(encoder_.write(fp, frame_, FRAME_WIDTH, FRAME_HEIGHT, 75, JPEG_MAX_SCALE + 1), 0u);
+    fclose(fp);
+}
+
+/**
+ * @brief Tests that the quick-looks are much smaller than the PNG frames.
+ */
+TEST_F(JpegEncoderTest, Size) {
+
+    FILE *fp = fopen(FRAME_FILE, "wb");
+    PngEncoder png;
+    size_t reference = png.write(fp, frame_, FRAME_WIDTH, FRAME_HEIGHT);
+    fclose(fp);
+
+    size_t full = encode(JPEG_DEFAULT_QUALITY, 1);
+    size_t low  = encode(50, 1);
+    size_t half = encode(JPEG_DEFAULT_QUALITY, 2);
+
+    EXPECT_LT(full, reference / 2);
+    EXPECT_LT(low, full);
+    EXPECT_LT(half, reference / 6);
+}
+
+/** @} */
@@ -0,0 +1,136 @@
+/**
+ * @file output_directory_test.cpp
+ * @brief OutputDirectory class unit tests.
+ * @addtogroup unit_tests
+ * @{
+ */
+
+#include "output_directory.hpp"
+#include "utilities.hpp"
+#include "gtest/gtest.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @brief Tests the file names in a single output directory. 
+ */
+TEST(OutputDirectoryTest, Flat) {
+
+    ASSERT_TRUE(createDirectory("flatDir")); 
+    OutputDirectory dir("flatDir", "pgm"); 
+    ASSERT_TRUE(dir.isOpen()); 
+
+    EXPECT_STREQ(dir.getFilename(0), "image0000000000.pgm"); 
+    EXPECT_STREQ(dir.getFilename(4294967295u), "image4294967295.pgm"); 
+
+    FILE *fp = dir.openFile(42); 
+    ASSERT_NE(fp, (FILE *) NULL); 
+    fclose(fp); 
+
+    struct stat info; 
+    EXPECT_EQ(stat("flatDir/image0000000042.pgm", &info), 0); 
+    unlink("flatDir/image0000000042.pgm"); 
+}
+
+/**
+ * @brief Tests that frames are spread over shard subdirectories, 
+ *        which are created ahead of time. 
+ */
+TEST(OutputDirectoryTest, Sharded) {
+
+    ASSERT_TRUE(createDirectory("shardDir")); 
+    OutputDirectory dir("shardDir", "png", 100u); 
+    ASSERT_TRUE(dir.isOpen()); 
+
+    EXPECT_STREQ(dir.getFilename(99), "000000/image0000000099.png"); 
+    EXPECT_STREQ(dir.getFilename(1234), "000012/image0000001234.png"); 
+
+    for(unsigned int frame = 0; frame < 250; frame += 50) {
+        int fd = dir.open(frame); 
+        ASSERT_GE(fd, 0); 
+        close(fd); 
+    }
+
+    struct stat info; 
+    EXPECT_EQ(stat("shardDir/000000/image0000000050.png", &info), 0); 
+    EXPECT_EQ(stat("shardDir/000002/image0000000200.png", &info), 0); 
+
+    /* Frames far ahead of the prepared shards */
+    int fd = dir.open(100000u); 
+    ASSERT_GE(fd, 0); 
+    close(fd); 
+    EXPECT_EQ(stat("shardDir/001000/image0000100000.png", &info), 0); 
+
+    /* Next shards are created by the background thread */
+    for(unsigned int incr = 0; (incr < 100) && (stat("shardDir/001002", &info) != 0); incr++) {
+        usleep(10000); 
+    }
+    EXPECT_EQ(stat("shardDir/001002", &info), 0); 
+    EXPECT_TRUE(S_ISDIR(info.st_mode)); 
+}
+
+/** @brief Output directory and first frame of an @ref OutOfOrder test thread. */
+typedef struct {
+    OutputDirectory *dir; 
+    unsigned int first; 
+}OrderThread_s; 
+
+/** @brief Creates every fourth frame, the odd threads going backwards. */
+static void * createFrames(void *arg) {
+
+    OrderThread_s *order = reinterpret_cast<OrderThread_s *>(arg); 
+
+    for(unsigned int incr = 0; incr < 32; incr++) {
+        unsigned int index = (order->first % 2) ? 31 - incr : incr; 
+        int fd = order->dir->open(index * 4 + order->first); 
+        if(fd >= 0) {
+            close(fd); 
+        }
+    }
+
+    return NULL; 
+}
+
+/**
+ * @brief Tests that frames far out of order land in their shards, while the shards 
+ *        go in and out of the window. 
+ */
+TEST(OutputDirectoryTest, OutOfOrder) {
+
+    ASSERT_TRUE(createDirectory("shardDir")); 
+    ASSERT_TRUE(createDirectory("shardDir/order")); 
+    OutputDirectory dir("shardDir/order", "raw", 1u); 
+
+    pthread_t threads[4]; 
+    OrderThread_s orders[4]; 
+
+    for(unsigned int incr = 0; incr < 4; incr++) {
+        orders[incr].dir   = &dir; 
+        orders[incr].first = incr; 
+        pthread_create(&threads[incr], NULL, &createFrames, &orders[incr]); 
+    }
+
+    for(unsigned int incr = 0; incr < 4; incr++) {
+        pthread_join(threads[incr], NULL); 
+    }
+
+    struct stat info; 
+    for(unsigned int frame = 0; frame < 128; frame++) {
+        EXPECT_EQ(stat((std::string("shardDir/order/") + dir.getFilename(frame)).c_str(), &info), 0); 
+    }
+}
+
+/**
+ * @brief Tests that a missing output directory is reported. 
+ */
+TEST(OutputDirectoryTest, Missing) {
+
+    OutputDirectory dir("missingDir", "pgm", 10u); 
+
+    EXPECT_FALSE(dir.isOpen()); 
+    EXPECT_LT(dir.open(0), 0); 
+    EXPECT_EQ(dir.openFile(0), (FILE *) NULL); 
+}
+
+/** @} */
@@ -0,0 +1,206 @@
+/**
+ * @file pipeline_stages_test.cpp
+ * @brief Standard pipeline stages unit tests.
+ * @addtogroup unit_tests
+ * @{
+ */
+
+#include "pipeline_stages.hpp"
+#include "gtest/gtest.h"
+
+#include <string.h>
+
+/** @brief Frames received by @ref collect(). */
+static std::vector<Image *> s_collected;
+/** @brief Frame numbers received by @ref collect(). */
+static std::vector<unsigned int> s_frames;
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/** @brief Sink keeping a copy of the frames. */
+static void collect(Image *image, unsigned int frame) {
+
+    Image *copy = new Image(image->getWidth(), image->getHeight());
+    memcpy(copy->getImageBuffer(), image->getImageBuffer(), image->getWidth() * image->getHeight());
+
+    pthread_mutex_lock(&s_lock);
+    s_collected.push_back(copy);
+    s_frames.push_back(frame);
+    pthread_mutex_unlock(&s_lock);
+}
+
+/** @brief Deletes the collected frames. */
+static void clearCollected(void) {
+
+    for(size_t incr = 0; incr < s_collected.size(); incr++) {
+        delete s_collected[incr];
+    }
+
+    s_collected.clear();
+    s_frames.clear();
+}
+
+/** @brief Sink stage factory for the tests. */
+static PipelineStage * createCollectStage(const std::string &name, const std::string &input,
+                                          const Pipeline::Parameters_t &parameters) {
+    (void) parameters;
+    return new SinkStage(name, input, &collect);
+}
+
+/** @brief Creates a pipeline with the standard stages and the @p collect sink. */
+static Pipeline * createPipeline(const std::string &description) {
+
+    Pipeline *pipeline = new Pipeline(2, 8);
+
+    registerStandardStages(pipeline);
+    pipeline->registerType("collect", &createCollectStage);
+
+    if(!pipeline->parse(description)) {
+        ADD_FAILURE() << pipeline->getError();
+    }
+
+    return pipeline;
+}
+
+/**
+ * @brief Tests the region of interest.
+ */
+TEST(PipelineStagesTest, Crop) {
+
+    Image frame(16, 8);
+    for(unsigned int incr = 0; incr < 16 * 8; incr++) {
+        frame.getImageBuffer()[incr] = (pixel_t) incr;
+    }
+
+    clearCollected();
+    Pipeline *pipeline = createPipeline("crop roi source x=3 y=2 width=5 height=4\n"
+                                        "collect out roi\n");
+    ASSERT_TRUE(pipeline->submit(&frame, 7, 0.0));
+    pipeline->drain();
+
+    ASSERT_EQ(s_collected.size(), 1u);
+    ASSERT_EQ(s_collected[0]->getWidth(), 5u);
+    ASSERT_EQ(s_collected[0]->getHeight(), 4u);
+    EXPECT_EQ(s_frames[0], 7u);
+
+    for(unsigned int y = 0; y < 4; y++) {
+        for(unsigned int x = 0; x < 5; x++) {
+            EXPECT_EQ(s_collected[0]->getImageBuffer()[y * 5 + x], (pixel_t) ((y + 2) * 16 + x + 3));
+        }
+    }
+
+    /* The region does not fit in the frame */
+    Image small(4, 4);
+    ASSERT_TRUE(pipeline->submit(&small, 8, 0.0));
+    pipeline->drain();
+    EXPECT_EQ(s_collected.size(), 1u);
+
+    delete pipeline;
+    clearCollected();
+}
+
+/**
+ * @brief Tests the binning stage: one frame every N, numbered as the last frame of its bin.
+ */
+TEST(PipelineStagesTest, Binning) {
+
+    Image frame(8, 8);
+
+    clearCollected();
+    Pipeline *pipeline = createPipeline("bin binned source factor=3 width=8 height=8\n"
+                                        "collect out binned\n");
+
+    for(unsigned int incr = 0; incr < 9; incr++) {
+        memset(frame.getImageBuffer(), (int) (incr * 10), 8 * 8);
+        ASSERT_TRUE(pipeline->submit(&frame, incr, 0.0));
+        pipeline->drain();
+    }
+
+    ASSERT_EQ(s_collected.size(), 3u);
+    for(unsigned int incr = 0; incr < 3; incr++) {
+        EXPECT_EQ(s_frames[incr], incr * 3u + 2u);
+        EXPECT_EQ((unsigned char) s_collected[incr]->getImageBuffer()[0], 10u + incr * 30u);
+    }
+
+    /* A restart drops the partial bin */
+    ASSERT_TRUE(pipeline->submit(&frame, 9, 0.0));
+    pipeline->drain();
+    pipeline->restart();
+
+    for(unsigned int incr = 10; incr < 13; incr++) {
+        ASSERT_TRUE(pipeline->submit(&frame, incr, 0.0));
+        pipeline->drain();
+    }
+
+    ASSERT_EQ(s_collected.size(), 4u);
+    EXPECT_EQ(s_frames[3], 12u);
+
+    delete pipeline;
+    clearCollected();
+
+    Pipeline invalid(1);
+    registerStandardStages(&invalid);
+    EXPECT_FALSE(invalid.parse("bin binned source"));
+    EXPECT_FALSE(invalid.parse("bin binned source factor=2 mode=median"));
+    EXPECT_FALSE(invalid.parse("crop roi source width=10"));
+}
+
+/**
+ * @brief Tests the statistics, computed on the frames corrected in place.
+ */
+TEST(PipelineStagesTest, Stats) {
+
+    Image frame(16, 16);
+    for(unsigned int incr = 0; incr < 16 * 16; incr++) {
+        frame.getImageBuffer()[incr] = (pixel_t) incr;
+    }
+
+    StatsStage *stats = new StatsStage("stats", "corrected", 0);
+
+    Pipeline pipeline(2, 4);
+    registerStandardStages(&pipeline);
+    ASSERT_TRUE(pipeline.parse("calibrate corrected source width=16 height=16"));
+    ASSERT_TRUE(pipeline.addStage(stats));
+
+    ASSERT_TRUE(pipeline.submit(&frame, 0, 0.0));
+    pipeline.drain();
+
+    unsigned int min, max;
+    double mean;
+    stats->getLast(&min, &max, &mean);
+    EXPECT_EQ(min, 0u);
+    EXPECT_EQ(max, 255u);
+    EXPECT_DOUBLE_EQ(mean, 127.5);
+
+    EXPECT_FALSE(pipeline.parse("calibrate other source dark=missing.pgm"));
+}
+
+/**
+ * @brief Tests that a serial sink gets the frames in order from a single thread pipeline.
+ */
+TEST(PipelineStagesTest, SerialSink) {
+
+    Image frame(8, 8);
+    memset(frame.getImageBuffer(), 0, 8 * 8);
+
+    EXPECT_FALSE(SinkStage("sink", "source", &collect).isSerial());
+
+    clearCollected();
+    Pipeline pipeline(1, 64);
+    registerStandardStages(&pipeline);
+    ASSERT_TRUE(pipeline.parse("crop roi source width=4 height=4"));
+    ASSERT_TRUE(pipeline.addStage(new SinkStage("out", "roi", &collect, true)));
+
+    for(unsigned int incr = 0; incr < 32; incr++) {
+        ASSERT_TRUE(pipeline.submit(&frame, incr, 0.0));
+    }
+    pipeline.drain();
+
+    ASSERT_EQ(s_frames.size(), 32u);
+    for(unsigned int incr = 0; incr < 32; incr++) {
+        EXPECT_EQ(s_frames[incr], incr);
+    }
+
+    clearCollected();
+}
+
+/** @} */
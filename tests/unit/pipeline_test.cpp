@@ -0,0 +1,331 @@
+/**
+ * @file pipeline_test.cpp
+ * @brief Pipeline class unit tests.
+ * @addtogroup unit_tests
+ * @{
+ */
+
+#include "pipeline.hpp"
+#include "gtest/gtest.h"
+
+#include <pthread.h>
+#include <unistd.h>
+#include <string.h>
+
+/** @brief Stage counting the frames it sees, which may wait for a gate. */
+class CountingStage : public PipelineStage {
+
+    public:
+        CountingStage(const std::string &name, const std::string &input, bool serial = false) :
+                PipelineStage(name, input), m_serial(serial), m_count(0), m_frameSum(0), m_running(0),
+                m_maxRunning(0), m_ordered(true), m_last(0), m_closed(false) {
+            pthread_mutex_init(&this->m_lock, NULL);
+            pthread_cond_init(&this->m_gate, NULL);
+        }
+
+        ~CountingStage() {
+            pthread_cond_destroy(&this->m_gate);
+            pthread_mutex_destroy(&this->m_lock);
+        }
+
+        virtual bool process(PipelineFrame_s *frame, PipelineContext *context) {
+
+            /* Scratch memory is usable and aligned */
+            unsigned char *scratch = (unsigned char *) context->allocate(1000);
+            if((scratch == NULL) || (((size_t) scratch % 64) != 0)) {
+                return false;
+            }
+            memset(scratch, 0, 1000);
+
+            pthread_mutex_lock(&this->m_lock);
+            while(this->m_closed) {
+                pthread_cond_wait(&this->m_gate, &this->m_lock);
+            }
+            this->m_running++;
+            this->m_maxRunning = (this->m_running > this->m_maxRunning) ? this->m_running : this->m_maxRunning;
+            this->m_ordered    = this->m_ordered && ((this->m_count == 0) || (frame->frame > this->m_last));
+            this->m_last       = frame->frame;
+            pthread_mutex_unlock(&this->m_lock);
+
+            usleep(2000);
+
+            pthread_mutex_lock(&this->m_lock);
+            this->m_running--;
+            this->m_count++;
+            this->m_frameSum += frame->frame;
+            pthread_mutex_unlock(&this->m_lock);
+
+            return true;
+        }
+
+        virtual bool isSerial(void) const {
+            return this->m_serial;
+        }
+
+        /** @brief Holds the frames reaching the stage. */
+        void close(void) {
+            pthread_mutex_lock(&this->m_lock);
+            this->m_closed = true;
+            pthread_mutex_unlock(&this->m_lock);
+        }
+
+        void open(void) {
+            pthread_mutex_lock(&this->m_lock);
+            this->m_closed = false;
+            pthread_cond_broadcast(&this->m_gate);
+            pthread_mutex_unlock(&this->m_lock);
+        }
+
+        bool m_serial;
+        unsigned int m_count;
+        unsigned int m_frameSum;
+        unsigned int m_running;
+        unsigned int m_maxRunning;
+        bool m_ordered;
+        unsigned int m_last;
+
+    private:
+        bool m_closed;
+        pthread_mutex_t m_lock;
+        pthread_cond_t m_gate;
+};
+
+/** @brief Stage modifying its input. */
+class InvertStage : public PipelineStage {
+
+    public:
+        InvertStage(const std::string &name, const std::string &input) : PipelineStage(name, input) {}
+
+        virtual bool process(PipelineFrame_s *frame, PipelineContext *context) {
+            (void) context;
+            size_t size = (size_t) frame->image->getWidth() * frame->image->getHeight();
+            for(size_t incr = 0; incr < size; incr++) {
+                frame->image->getImageBuffer()[incr] = (pixel_t) ~frame->image->getImageBuffer()[incr];
+            }
+            return true;
+        }
+
+        virtual bool isInPlace(void) const {
+            return true;
+        }
+};
+
+/** @brief Stage handing the left half of its frames, or nothing for odd frames. */
+class HalfStage : public PipelineStage {
+
+    public:
+        HalfStage(const std::string &name, const std::string &input) : PipelineStage(name, input) {}
+
+        virtual bool process(PipelineFrame_s *frame, PipelineContext *context) {
+
+            unsigned int width = frame->image->getWidth() / 2;
+            Image *half = context->createImage(width, frame->image->getHeight());
+            if(half == NULL) {
+                return false;
+            }
+
+            for(unsigned int row = 0; row < frame->image->getHeight(); row++) {
+                memcpy(half->getImageBuffer() + row * width, frame->image->getImageBuffer() + row * 2 * width, width);
+            }
+
+            frame->image = half;
+            return (frame->frame % 2) == 0;
+        }
+};
+
+/** @brief Stage checking the size and the first pixel of its frames. */
+class CheckStage : public PipelineStage {
+
+    public:
+        CheckStage(const std::string &name, const std::string &input, unsigned int width, pixel_t value) :
+                PipelineStage(name, input), m_width(width), m_value(value), m_valid(0), m_invalid(0) {}
+
+        virtual bool process(PipelineFrame_s *frame, PipelineContext *context) {
+            (void) context;
+            bool valid = (frame->image->getWidth() == this->m_width) && (frame->image->getImageBuffer()[0] == this->m_value);
+            __atomic_add_fetch(valid ? &this->m_valid : &this->m_invalid, 1u, __ATOMIC_RELAXED);
+            return true;
+        }
+
+        unsigned int m_width;
+        pixel_t m_value;
+        unsigned int m_valid;
+        unsigned int m_invalid;
+};
+
+/** @brief Factory of the counting stages. */
+static PipelineStage * createCountingStage(const std::string &name, const std::string &input,
+                                           const Pipeline::Parameters_t &parameters) {
+
+    Pipeline::Parameters_t::const_iterator serial = parameters.find("serial");
+
+    if((serial != parameters.end()) && (serial->second != "yes") && (serial->second != "no")) {
+        return NULL;
+    }
+
+    return new CountingStage(name, input, (serial != parameters.end()) && (serial->second == "yes"));
+}
+
+/**
+ * @brief Tests that every reader of a stage sees every frame, and that the slots are released.
+ */
+TEST(PipelineTest, FanOut) {
+
+    Image images[4] = {Image(8, 8), Image(8, 8), Image(8, 8), Image(8, 8)};
+    CountingStage *first  = new CountingStage("first", PIPELINE_SOURCE);
+    CountingStage *second = new CountingStage("second", PIPELINE_SOURCE);
+    CountingStage *third  = new CountingStage("third", "first");
+
+    Pipeline pipeline(4, 4);
+    ASSERT_TRUE(pipeline.addStage(first));
+    ASSERT_TRUE(pipeline.addStage(second));
+    ASSERT_TRUE(pipeline.addStage(third));
+    EXPECT_EQ(pipeline.getNbOfStages(), 3u);
+
+    unsigned int frameSum = 0;
+    for(unsigned int incr = 0; incr < 40; incr++) {
+        while(pipeline.isPending(&images[incr % 4])) {
+            usleep(100);
+        }
+        ASSERT_TRUE(pipeline.submit(&images[incr % 4], incr, 0.0));
+        frameSum += incr;
+    }
+
+    pipeline.drain();
+    EXPECT_EQ(pipeline.getBacklog(), 0u);
+    EXPECT_FALSE(pipeline.isPending(&images[0]));
+
+    EXPECT_EQ(first->m_count, 40u);
+    EXPECT_EQ(second->m_count, 40u);
+    EXPECT_EQ(third->m_count, 40u);
+    EXPECT_EQ(third->m_frameSum, frameSum);
+}
+
+/**
+ * @brief Tests that the frames are held until the stages are done, within the capacity.
+ */
+TEST(PipelineTest, Capacity) {
+
+    Image images[3] = {Image(8, 8), Image(8, 8), Image(8, 8)};
+    CountingStage *stage = new CountingStage("count", PIPELINE_SOURCE);
+
+    Pipeline pipeline(2, 2);
+    ASSERT_TRUE(pipeline.addStage(stage));
+    EXPECT_EQ(pipeline.getCapacity(), 2u);
+
+    stage->close();
+    EXPECT_TRUE(pipeline.submit(&images[0], 0, 0.0));
+    EXPECT_TRUE(pipeline.submit(&images[1], 1, 0.0));
+    EXPECT_FALSE(pipeline.submit(&images[2], 2, 0.0));
+    EXPECT_TRUE(pipeline.isPending(&images[0]));
+    EXPECT_FALSE(pipeline.isPending(&images[2]));
+    EXPECT_EQ(pipeline.getBacklog(), 2u);
+
+    stage->open();
+    pipeline.drain();
+    EXPECT_EQ(stage->m_count, 2u);
+    EXPECT_TRUE(pipeline.submit(&images[2], 2, 0.0));
+}
+
+/**
+ * @brief Tests that a serial stage processes one frame at a time, in order.
+ */
+TEST(PipelineTest, Serial) {
+
+    Image image(8, 8);
+    CountingStage *serial   = new CountingStage("serial", PIPELINE_SOURCE, true);
+    CountingStage *parallel = new CountingStage("parallel", "serial");
+
+    Pipeline pipeline(4, 16);
+    ASSERT_TRUE(pipeline.addStage(serial));
+    ASSERT_TRUE(pipeline.addStage(parallel));
+
+    for(unsigned int incr = 0; incr < 16; incr++) {
+        ASSERT_TRUE(pipeline.submit(&image, incr, 0.0));
+    }
+
+    pipeline.drain();
+    EXPECT_EQ(serial->m_count, 16u);
+    EXPECT_EQ(serial->m_maxRunning, 1u);
+    EXPECT_TRUE(serial->m_ordered);
+    EXPECT_EQ(parallel->m_count, 16u);
+}
+
+/**
+ * @brief Tests the images created by a stage, in-place stages and dropped frames.
+ */
+TEST(PipelineTest, Created) {
+
+    Image image(8, 4);
+    memset(image.getImageBuffer(), 0x0F, 8 * 4);
+
+    CheckStage *check = new CheckStage("check", "half", 4, (pixel_t) 0xF0);
+
+    Pipeline pipeline(3, 4);
+    ASSERT_TRUE(pipeline.addStage(new InvertStage("invert", PIPELINE_SOURCE)));
+    ASSERT_TRUE(pipeline.addStage(new HalfStage("half", "invert")));
+    ASSERT_TRUE(pipeline.addStage(check));
+
+    /* The frame is inverted in place then handed again, odd frames are dropped by the half stage */
+    for(unsigned int incr = 0; incr < 10; incr++) {
+        ASSERT_TRUE(pipeline.submit(&image, incr, 0.0));
+        pipeline.drain();
+        memset(image.getImageBuffer(), 0x0F, 8 * 4);
+    }
+
+    EXPECT_EQ(check->m_valid, 5u);
+    EXPECT_EQ(check->m_invalid, 0u);
+    EXPECT_EQ(pipeline.getBacklog(), 0u);
+}
+
+/**
+ * @brief Tests the stage graph checks.
+ */
+TEST(PipelineTest, Stages) {
+
+    Pipeline pipeline(1);
+
+    ASSERT_TRUE(pipeline.addStage(new CountingStage("count", PIPELINE_SOURCE)));
+    EXPECT_FALSE(pipeline.addStage(new CountingStage("count", PIPELINE_SOURCE)));
+    EXPECT_FALSE(pipeline.addStage(new CountingStage(PIPELINE_SOURCE, PIPELINE_SOURCE)));
+    EXPECT_FALSE(pipeline.addStage(new CountingStage("other", "missing")));
+
+    /* An in-place stage must be the only reader of its input */
+    EXPECT_FALSE(pipeline.addStage(new InvertStage("invert", PIPELINE_SOURCE)));
+    ASSERT_TRUE(pipeline.addStage(new InvertStage("invert", "count")));
+    EXPECT_FALSE(pipeline.addStage(new CountingStage("other", "count")));
+    EXPECT_TRUE(pipeline.addStage(new CountingStage("other", "invert")));
+
+    EXPECT_EQ(pipeline.getNbOfStages(), 3u);
+}
+
+/**
+ * @brief Tests the pipeline descriptions.
+ */
+TEST(PipelineTest, Parse) {
+
+    Pipeline pipeline(1);
+    pipeline.registerType("count", &createCountingStage);
+
+    EXPECT_TRUE(pipeline.parse("# type name input\n"
+                               "\n"
+                               "count   first   source  serial=yes  # comment\n"
+                               "count   second  first\n"));
+    EXPECT_EQ(pipeline.getNbOfStages(), 2u);
+
+    EXPECT_FALSE(pipeline.parse("count third"));
+    EXPECT_EQ(pipeline.getError().find("line 1"), 0u);
+
+    EXPECT_FALSE(pipeline.parse("\nresize third source"));
+    EXPECT_EQ(pipeline.getError(), "line 2: unknown stage type resize");
+
+    EXPECT_FALSE(pipeline.parse("count third source serial"));
+    EXPECT_FALSE(pipeline.parse("count third source serial=maybe"));
+    EXPECT_FALSE(pipeline.parse("count third missing"));
+    EXPECT_FALSE(pipeline.parse("count first source"));
+    EXPECT_FALSE(pipeline.load("missing.pipeline"));
+
+    EXPECT_EQ(pipeline.getNbOfStages(), 2u);
+}
+
+/** @} */
@@ -0,0 +1,151 @@
+/**
+ * @file png_encoder_test.cpp
+ * @brief PngEncoder class unit tests.
+ * @addtogroup unit_tests
+ * @{
+ */
+
+#include "png_encoder.hpp"
+#include "gtest/gtest.h"
+#include <png.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** @brief Width of the test frames, not a multiple of the SIMD width. */
+#define FRAME_WIDTH     (203u)
+/** @brief Height of the test frames. */
+#define FRAME_HEIGHT    (61u)
+/** @brief Test PNG file. */
+#define FRAME_FILE      "PngEncoderTest.png"
+
+/**
+ * @brief Fixture class for the PngEncoder class tests.
+ */
+class PngEncoderTest : public testing::Test {
+
+    protected:
+        /** @brief Fills the frame with a noisy gradient. */
+        virtual void SetUp() {
+
+            srand(0);
+            for(unsigned int y = 0; y < FRAME_HEIGHT; y++) {
+                for(unsigned int x = 0; x < FRAME_WIDTH; x++) {
+                    frame_[y * FRAME_WIDTH + x] = (pixel_t) (x + 2 * y + (rand() % 16));
+                }
+            }
+        }
+
+        /** @brief Writes the frame and reads it back with libpng. */
+        void roundTrip(int level, int filters) {
+
+            FILE *fp = fopen(FRAME_FILE, "wb");
+            ASSERT_NE(fp, (FILE *) NULL);
+            EXPECT_GT(encoder_.write(fp, frame_, FRAME_WIDTH, FRAME_HEIGHT, level, filters, (char *) "Test"), 0u);
+            fclose(fp);
+
+            fp = fopen(FRAME_FILE, "rb");
+            ASSERT_NE(fp, (FILE *) NULL);
+
+            png_structp png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+            png_infop info_ptr  = png_create_info_struct(png_ptr);
+            png_init_io(png_ptr, fp);
+            png_read_info(png_ptr, info_ptr);
+
+            EXPECT_EQ(png_get_image_width(png_ptr, info_ptr), FRAME_WIDTH);
+            EXPECT_EQ(png_get_image_height(png_ptr, info_ptr), FRAME_HEIGHT);
+            EXPECT_EQ(png_get_bit_depth(png_ptr, info_ptr), 8);
+            EXPECT_EQ(png_get_color_type(png_ptr, info_ptr), PNG_COLOR_TYPE_GRAY);
+
+            unsigned char row[FRAME_WIDTH];
+            for(unsigned int y = 0; y < FRAME_HEIGHT; y++) {
+                png_read_row(png_ptr, row, NULL);
+                ASSERT_EQ(memcmp(row, frame_ + y * FRAME_WIDTH, FRAME_WIDTH), 0) << "Row " << y;
+            }
+
+            png_read_end(png_ptr, info_ptr);
+
+            png_textp text = NULL;
+            ASSERT_EQ(png_get_text(png_ptr, info_ptr, &text, NULL), 1);
+            EXPECT_STREQ(text[0].key, "Title");
+            EXPECT_STREQ(text[0].text, "Test");
+
+            png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+            fclose(fp);
+        }
+
+    /** @brief Test encoder. */
+    PngEncoder encoder_;
+    /** @brief Test frame. */
+    pixel_t frame_[FRAME_WIDTH * FRAME_HEIGHT];
+};
+
+/**
+ * @brief Tests that libpng decodes the frames, whatever the filters and level.
+ */
+TEST_F(PngEncoderTest, RoundTrip) {
+
+    const int filters[] = {PNG_FILTER_NONE, PNG_FILTER_SUB, PNG_FILTER_UP, PNG_FILTER_AVG,
+                           PNG_FILTER_PAETH, PNG_FILTER_SUB | PNG_FILTER_UP, -1};
+
+    for(unsigned int incr = 0; incr < sizeof(filters) / sizeof(filters[0]); incr++) {
+        roundTrip(1, filters[incr]);
+    }
+
+    roundTrip(0, -1);
+    roundTrip(9, -1);
+}
+
+/**
+ * @brief Tests the row filters against the definitions of the PNG specification.
+ */
+TEST_F(PngEncoderTest, Filters) {
+
+    const unsigned char *row      = (const unsigned char *) frame_ + FRAME_WIDTH;
+    const unsigned char *previous = (const unsigned char *) frame_;
+    unsigned char filtered[FRAME_WIDTH];
+
+    for(int type = PNG_ROW_NONE; type <= PNG_ROW_PAETH; type++) {
+
+        unsigned long cost = PngEncoder::filterRow((PngRowFilter_e) type, row, previous, FRAME_WIDTH, filtered);
+        unsigned long expectedCost = 0;
+
+        for(unsigned int x = 0; x < FRAME_WIDTH; x++) {
+            int a = (x > 0) ? row[x - 1] : 0;
+            int b = previous[x];
+            int c = (x > 0) ? previous[x - 1] : 0;
+            int predictor = 0;
+
+            switch(type) {
+                case PNG_ROW_SUB:   predictor = a;              break;
+                case PNG_ROW_UP:    predictor = b;              break;
+                case PNG_ROW_AVG:   predictor = (a + b) / 2;    break;
+                case PNG_ROW_PAETH: {
+                    int p = a + b - c;
+                    predictor = ((abs(p - a) <= abs(p - b)) && (abs(p - a) <= abs(p - c))) ? a :
+                                (abs(p - b) <= abs(p - c)) ? b : c;
+                    break;
+                }
+                default: break;
+            }
+
+            unsigned char expected = (unsigned char) (row[x] - predictor);
+            ASSERT_EQ(filtered[x], expected) << "Filter " << type << ", pixel " << x;
+            expectedCost += abs((signed char) expected);
+        }
+
+        EXPECT_EQ(cost, expectedCost);
+    }
+}
+
+/**
+ * @brief Tests that each thread gets its own encoder.
+ */
+TEST_F(PngEncoderTest, ThreadEncoder) {
+
+    PngEncoder *encoder = PngEncoder::getThreadEncoder();
+
+    EXPECT_NE(encoder, (PngEncoder *) NULL);
+    EXPECT_EQ(PngEncoder::getThreadEncoder(), encoder);
+}
+
+/** @} */
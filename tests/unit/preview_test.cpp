@@ -0,0 +1,106 @@
+/**
+ * @file preview_test.cpp
+ * @brief Preview class unit tests.
+ * @addtogroup unit_tests
+ * @{
+ */
+
+#include "preview.hpp"
+#include "gtest/gtest.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/** @brief Width of the test images (not a multiple of 16, to test the scalar tail). */
+#define IMAGE_WIDTH     (808u)
+/** @brief Height of the test images. */
+#define IMAGE_HEIGHT    (600u)
+
+/**
+ * @brief Reference box filter.
+ */
+static void referenceDownsample(const unsigned char *src, unsigned int factor, unsigned char *dst) {
+
+    unsigned int outWidth = IMAGE_WIDTH / factor; 
+
+    for(unsigned int y = 0; y < IMAGE_HEIGHT / factor; y++) {
+        for(unsigned int x = 0; x < outWidth; x++) {
+            unsigned int sum = 0; 
+            for(unsigned int r = 0; r < factor; r++) {
+                for(unsigned int c = 0; c < factor; c++) {
+                    sum += src[(y * factor + r) * IMAGE_WIDTH + x * factor + c]; 
+                }
+            }
+            dst[y * outWidth + x] = (unsigned char) ((sum + factor * factor / 2) / (factor * factor)); 
+        }
+    }
+}
+
+/**
+ * @brief Tests that the vectorized box filter matches the reference, for every factor.
+ */
+TEST(PreviewTest, Downsample) {
+
+    unsigned char *src = new unsigned char[IMAGE_WIDTH * IMAGE_HEIGHT]; 
+    unsigned char *out = new unsigned char[IMAGE_WIDTH * IMAGE_HEIGHT]; 
+    unsigned char *ref = new unsigned char[IMAGE_WIDTH * IMAGE_HEIGHT]; 
+
+    srand(0); 
+    for(unsigned int incr = 0; incr < IMAGE_WIDTH * IMAGE_HEIGHT; incr++) {
+        src[incr] = (unsigned char) rand(); 
+    }
+
+    for(unsigned int factor = 2; factor <= 8; factor *= 2) {
+        size_t size = (IMAGE_WIDTH / factor) * (IMAGE_HEIGHT / factor); 
+
+        Preview::downsample(src, IMAGE_WIDTH, IMAGE_HEIGHT, factor, out); 
+        referenceDownsample(src, factor, ref); 
+        EXPECT_EQ(memcmp(out, ref, size), 0) << "Factor " << factor; 
+    }
+
+    /* Saturated blocks must not overflow */
+    memset(src, 0xFF, IMAGE_WIDTH * IMAGE_HEIGHT); 
+    Preview::downsample(src, IMAGE_WIDTH, IMAGE_HEIGHT, 8, out); 
+    EXPECT_EQ(out[0], 0xFF); 
+    EXPECT_EQ(out[(IMAGE_WIDTH / 8) * (IMAGE_HEIGHT / 8) - 1], 0xFF); 
+
+    delete [] src; 
+    delete [] out; 
+    delete [] ref; 
+}
+
+/**
+ * @brief Tests that the latest offered frame is published at the preview rate.
+ */
+TEST(PreviewTest, Publish) {
+
+    Image image(IMAGE_WIDTH, IMAGE_HEIGHT); 
+    memset(image.getImageBuffer(), 100, IMAGE_WIDTH * IMAGE_HEIGHT); 
+
+    Preview preview(IMAGE_WIDTH, IMAGE_HEIGHT, 4, 50.0); 
+    ASSERT_EQ(preview.getWidth(), IMAGE_WIDTH / 4); 
+    ASSERT_EQ(preview.getHeight(), IMAGE_HEIGHT / 4); 
+
+    unsigned char *out = new unsigned char[preview.getWidth() * preview.getHeight()]; 
+
+    /* Nothing offered yet */
+    usleep(50000); 
+    EXPECT_EQ(preview.read(out), 0ul); 
+
+    preview.offer(&image); 
+    usleep(100000); 
+
+    EXPECT_GT(preview.read(out), 0ul); 
+    EXPECT_EQ(out[0], 100); 
+    EXPECT_EQ(out[preview.getWidth() * preview.getHeight() - 1], 100); 
+
+    /* No new preview once the frame is withdrawn */
+    preview.clear(); 
+    unsigned long sequence = preview.read(out); 
+    usleep(50000); 
+    EXPECT_EQ(preview.read(out), sequence); 
+
+    delete [] out; 
+}
+
+/** @} */
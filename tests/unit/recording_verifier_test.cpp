@@ -0,0 +1,106 @@
+/**
+ * @file recording_verifier_test.cpp
+ * @brief RecordingVerifier class unit tests.
+ * @addtogroup unit_tests
+ * @{
+ */
+
+#include "recording_verifier.hpp"
+#include "image.hpp"
+#include "gtest/gtest.h"
+
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+
+/**
+ * @brief Fixture class for the RecordingVerifier class tests.
+ */
+class RecordingVerifierTest : public testing::Test {
+
+    protected:
+        /** @brief Writes a recording of four frames, in a directory and a shard. */
+        virtual void SetUp() {
+
+            ASSERT_EQ(system("rm -rf verifyDir"), 0); 
+            ASSERT_EQ(mkdir("verifyDir", 0777), 0); 
+            ASSERT_EQ(mkdir("verifyDir/000000", 0777), 0); 
+
+            Image image(64, 48); 
+            for(unsigned int incr = 0; incr < 64 * 48; incr++) {
+                image.getImageBuffer()[incr] = (pixel_t) (incr * 13); 
+            }
+
+            image.writeToPNG("verifyDir/000000/image0000000000.png"); 
+            image.writeToPNG("verifyDir/000000/image0000000001.png"); 
+            ASSERT_GT(image.writeToPGM("verifyDir/000000/image0000000002.pgm"), 0u); 
+            ASSERT_GT(image.writeToPGM("verifyDir/image0000000003.pgm"), 0u); 
+        }
+
+        /** @brief Removes the recording. */
+        virtual void TearDown() {
+            ASSERT_EQ(system("rm -rf verifyDir"), 0); 
+        }
+
+        /** @brief Flips a byte of a file, @p offset bytes before its end. */
+        void corrupt(const char *path, off_t offset) {
+
+            int fd = open(path, O_RDWR); 
+            ASSERT_GE(fd, 0); 
+
+            off_t size = lseek(fd, 0, SEEK_END); 
+            unsigned char byte = 0; 
+            ASSERT_EQ(pread(fd, &byte, 1, size - offset), 1); 
+            byte ^= 0x01; 
+            ASSERT_EQ(pwrite(fd, &byte, 1, size - offset), 1); 
+            close(fd); 
+        }
+};
+
+/**
+ * @brief Tests that an intact recording is valid.
+ */
+TEST_F(RecordingVerifierTest, Valid) {
+
+    RecordingVerifier verifier("verifyDir", 2); 
+
+    EXPECT_EQ(verifier.verify(), 0u); 
+    EXPECT_EQ(verifier.getValid(), 4u); 
+    EXPECT_EQ(verifier.getUnchecked(), 0u); 
+}
+
+/**
+ * @brief Tests that corrupt frames are found, whatever their format.
+ */
+TEST_F(RecordingVerifierTest, Corrupt) {
+
+    /* A pixel of the PGM frame, the compressed data of the PNG frame */
+    corrupt("verifyDir/000000/image0000000002.pgm", 100); 
+    corrupt("verifyDir/000000/image0000000001.png", 30); 
+
+    RecordingVerifier verifier("verifyDir"); 
+
+    EXPECT_EQ(verifier.verify(), 2u); 
+    EXPECT_EQ(verifier.getValid(), 2u); 
+    ASSERT_EQ(verifier.getCorrupt().size(), 2u); 
+    EXPECT_EQ(verifier.getCorrupt()[0], "verifyDir/000000/image0000000001.png"); 
+    EXPECT_EQ(verifier.getCorrupt()[1], "verifyDir/000000/image0000000002.pgm"); 
+}
+
+/**
+ * @brief Tests that frames without checksum are reported as such.
+ */
+TEST_F(RecordingVerifierTest, Unchecked) {
+
+    FILE *fp = fopen("verifyDir/image0000000004.pgm", "wb"); 
+    ASSERT_NE(fp, (FILE *) NULL); 
+    fprintf(fp, "P5\n# COMMENT\n2 2\n255\nabcd"); 
+    fclose(fp); 
+
+    EXPECT_EQ(RecordingVerifier::verifyFile("verifyDir/image0000000004.pgm"), VERIFY_UNCHECKED); 
+    EXPECT_EQ(RecordingVerifier::verifyFile("verifyDir/image0000000003.pgm"), VERIFY_OK); 
+}
+
+/** @} */
@@ -6,8 +6,11 @@
  */
 
 #include "ring_buffer.hpp"
+#include "utilities.hpp"
 #include "gtest/gtest.h"
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 
 /** @brief Size of the ring buffer. */
 #define RING_BUFFER_SIZE    (27u)
@@ -73,5 +76,92 @@ TEST_F(RingBufferTest, MemoryBuffers) {
     }
 }
 
+/**
+ * @brief Tests that the ring buffer can grow and shrink, keeping its images. 
+ */
+TEST_F(RingBufferTest, Resize) {
+
+    Image *first = rb_->at(0); 
+
+    rb_->resize(2 * RING_BUFFER_SIZE); 
+    ASSERT_EQ(rb_->getSize(), 2 * RING_BUFFER_SIZE); 
+    EXPECT_EQ(rb_->at(0), first); 
+
+    for(unsigned int incr = 0; incr < rb_->getSize(); incr++) {
+        ASSERT_NE(rb_->at(incr), (Image *) NULL); 
+        EXPECT_EQ(rb_->getImageFromBuffer(rb_->at(incr)->getImageBuffer()), rb_->at(incr)); 
+    }
+
+    rb_->resize(1); 
+    ASSERT_EQ(rb_->getSize(), 1u); 
+    EXPECT_EQ(rb_->at(0), first); 
+    EXPECT_EQ(rb_->at(1), (Image *) NULL); 
+    EXPECT_EQ(rb_->getImageFromBuffer(first->getImageBuffer()), first); 
+}
+
+/**
+ * @brief Tests that a resized ring buffer moves into a new locked arena and releases the old one. 
+ */
+TEST(RingBufferArenaTest, Resize) {
+
+    size_t page   = sysconf(_SC_PAGESIZE); 
+    size_t stride = (IMAGE_WIDTH * IMAGE_HEIGHT + page - 1) / page * page; 
+    size_t before = getLockedMemory(); 
+
+    RingBuffer rb(IMAGE_WIDTH, IMAGE_HEIGHT, 4); 
+    ASSERT_EQ(rb.getArenaSize(), 4 * stride); 
+
+    /* The lock limit may be too low for the arena, which is then only faulted in */
+    bool locked = (getLockedMemory() - before == rb.getArenaSize()); 
+
+    memset(rb.at(3)->getImageBuffer(), 3, IMAGE_WIDTH * IMAGE_HEIGHT); 
+
+    rb.resize(8); 
+    EXPECT_EQ(rb.getArenaSize(), 8 * stride); 
+    if(locked) {
+        EXPECT_EQ(getLockedMemory() - before, rb.getArenaSize()); 
+    }
+    EXPECT_EQ(rb.at(3)->getImageBuffer()[IMAGE_WIDTH * IMAGE_HEIGHT - 1], 3); 
+    EXPECT_EQ(rb.getImageFromBuffer(rb.at(3)->getImageBuffer()), rb.at(3)); 
+
+    /* Consecutive slots of a single arena */
+    for(unsigned int incr = 1; incr < rb.getSize(); incr++) {
+        EXPECT_EQ(rb.at(incr)->getImageBuffer(), rb.at(0)->getImageBuffer() + incr * stride); 
+    }
+
+    rb.resize(2); 
+    EXPECT_EQ(rb.getArenaSize(), 2 * stride); 
+    if(locked) {
+        EXPECT_EQ(getLockedMemory() - before, rb.getArenaSize()); 
+    }
+}
+
+/**
+ * @brief Tests that the images locked in parallel are distinct, page-aligned and writable, 
+ *        whatever the number of threads. 
+ */
+TEST(RingBufferLockTest, ParallelLock) {
+
+    size_t page = sysconf(_SC_PAGESIZE); 
+    const unsigned int nbOfThreads[3] = {1u, 3u, 0u}; 
+
+    for(unsigned int test = 0; test < 3; test++) {
+        RingBuffer rb(IMAGE_WIDTH, IMAGE_HEIGHT, RING_BUFFER_SIZE, nbOfThreads[test]); 
+        ASSERT_EQ(rb.getSize(), RING_BUFFER_SIZE); 
+
+        for(unsigned int incr = 0; incr < RING_BUFFER_SIZE; incr++) {
+            pixel_t *buffer = rb.at(incr)->getImageBuffer(); 
+            EXPECT_EQ((size_t) buffer % page, 0u); 
+            memset(buffer, (int) incr, IMAGE_WIDTH * IMAGE_HEIGHT); 
+        }
+
+        for(unsigned int incr = 0; incr < RING_BUFFER_SIZE; incr++) {
+            const pixel_t *buffer = rb.at(incr)->getImageBuffer(); 
+            EXPECT_EQ(buffer[0], (pixel_t) incr); 
+            EXPECT_EQ(buffer[IMAGE_WIDTH * IMAGE_HEIGHT - 1], (pixel_t) incr); 
+        }
+    }
+}
+
 /** @} */
 
@@ -0,0 +1,73 @@
+/**
+ * @file ring_sizer_test.cpp
+ * @brief RingSizer class unit tests.
+ * @addtogroup unit_tests
+ * @{
+ */
+
+#include "ring_sizer.hpp"
+#include "utilities.hpp"
+#include "gtest/gtest.h"
+
+/** @brief Width of the frames. */
+#define IMAGE_WIDTH         (800u)
+/** @brief Height of the frames. */
+#define IMAGE_HEIGHT        (600u)
+/** @brief Size of a frame, in bytes. */
+#define IMAGE_SIZE          (IMAGE_WIDTH * IMAGE_HEIGHT)
+
+/**
+ * @brief Tests the ring size computed from the frame rate, latency and burst tolerance. 
+ */
+TEST(RingSizerTest, Size) {
+
+    RingSizer rs(IMAGE_WIDTH, IMAGE_HEIGHT); 
+    rs.setMemoryBudget(1000u * IMAGE_SIZE); 
+
+    /* 100 fps, 20 ms per write, 500 ms stalls: 52 frames, plus 2 */
+    rs.setFramerate(100.0); 
+    rs.setWriteLatency(0.020); 
+    rs.setBurstTolerance(0.5); 
+    EXPECT_EQ(rs.computeSize(), 54u); 
+
+    /* Slow acquisition: the minimum size is used */
+    rs.setFramerate(1.0); 
+    rs.setBurstTolerance(0.0); 
+    EXPECT_EQ(rs.computeSize(), RING_SIZER_MIN_SIZE); 
+}
+
+/**
+ * @brief Tests that the ring size is bounded by the memory budget. 
+ */
+TEST(RingSizerTest, MemoryBudget) {
+
+    RingSizer rs(IMAGE_WIDTH, IMAGE_HEIGHT); 
+    rs.setFramerate(1000.0); 
+    rs.setWriteLatency(0.1); 
+    rs.setBurstTolerance(10.0); 
+
+    rs.setMemoryBudget(20u * IMAGE_SIZE + 1u); 
+    EXPECT_EQ(rs.computeSize(), 20u); 
+
+    /* Automatic budget */
+    rs.setMemoryBudget(0); 
+    EXPECT_GT(rs.getMemoryBudget(), 0u); 
+    EXPECT_LE(rs.getMemoryBudget(), getLockableMemory()); 
+    EXPECT_LE(rs.computeSize() * IMAGE_SIZE, rs.getMemoryBudget() + RING_SIZER_MIN_SIZE * IMAGE_SIZE); 
+}
+
+/**
+ * @brief Tests the write latency calibration. 
+ */
+TEST(RingSizerTest, Calibration) {
+
+    RingSizer rs(IMAGE_WIDTH, IMAGE_HEIGHT); 
+
+    ASSERT_TRUE(createDirectory("testDir")); 
+    EXPECT_GT(rs.calibrate("testDir", 4u), 0.0); 
+    EXPECT_GT(rs.getWriteLatency(), 0.0); 
+
+    EXPECT_LT(rs.calibrate("missingDir", 1u), 0.0); 
+}
+
+/** @} */
@@ -0,0 +1,180 @@
+/**
+ * @file rx_thread_test.cpp
+ * @brief RXThread class unit tests, over a pseudo-terminal pair.
+ * @addtogroup unit_tests
+ * @{
+ */
+
+#include "serial/rx_thread.hpp"
+#include "gtest/gtest.h"
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+/** @brief Commands received by the callback. */
+static std::vector<std::string> commands; 
+static pthread_mutex_t commandsLock = PTHREAD_MUTEX_INITIALIZER; 
+
+/** @brief Records a received command. */
+static void rxCallback(char *data, int dataSize) {
+
+    pthread_mutex_lock(&commandsLock); 
+    commands.push_back(std::string(data, dataSize)); 
+    pthread_mutex_unlock(&commandsLock); 
+}
+
+/**
+ * @brief Fixture class for the RXThread class tests. 
+ * @details The test writes to the pseudo-terminal master, the reception thread reads
+ *          the slave, as it would read the serial port. 
+ */
+class RXThreadTest : public testing::Test {
+
+    protected:
+        /** @brief Sets up the fixture class. */
+        virtual void SetUp() {
+
+            commands.clear(); 
+
+            master_ = posix_openpt(O_RDWR | O_NOCTTY); 
+            ASSERT_GE(master_, 0); 
+            ASSERT_EQ(grantpt(master_), 0); 
+            ASSERT_EQ(unlockpt(master_), 0); 
+
+            bus_ = new I2CBus(ptsname(master_)); 
+            rx_  = new RXThread(bus_, &rxCallback); 
+            rx_->start(); 
+        }
+
+        /** @brief Tears down the fixture class. */
+        virtual void TearDown() {
+            delete rx_; 
+            delete bus_; 
+            close(master_); 
+        }
+
+        /** @brief Sends raw bytes on the link. */
+        void send(const unsigned char *data, size_t size) {
+            ASSERT_EQ(write(master_, data, size), (ssize_t) size); 
+        }
+
+        /** @brief Waits for @p count commands. */
+        bool waitFor(size_t count) {
+            for(unsigned int incr = 0; incr < 200; incr++) {
+                pthread_mutex_lock(&commandsLock); 
+                size_t received = commands.size(); 
+                pthread_mutex_unlock(&commandsLock); 
+
+                if(received >= count) {
+                    return true; 
+                }
+                usleep(5000); 
+            }
+            return false; 
+        }
+
+    /** @brief Pseudo-terminal master (ground side). */
+    int master_; 
+    I2CBus *bus_; 
+    RXThread *rx_; 
+};
+
+/**
+ * @brief Tests the reception of a single command. 
+ */
+TEST_F(RXThreadTest, Command) {
+
+    unsigned char frame[RX_FRAME_MAX_PAYLOAD + RX_FRAME_OVERHEAD]; 
+
+    ASSERT_TRUE(bus_->isOpen()); 
+    size_t size = RXThread::encode("G", 1, frame); 
+    ASSERT_EQ(size, 1u + RX_FRAME_OVERHEAD); 
+
+    send(frame, size); 
+    ASSERT_TRUE(waitFor(1)); 
+    EXPECT_EQ(commands[0], "G"); 
+    EXPECT_EQ(rx_->getFrames(), 1u); 
+    EXPECT_EQ(rx_->getErrors(), 0u); 
+}
+
+/**
+ * @brief Tests that a burst of commands, split across writes and mixed with line noise
+ *        and corrupted frames, is decoded in order. 
+ */
+TEST_F(RXThreadTest, Burst) {
+
+    unsigned char stream[1024]; 
+    size_t size = 0; 
+
+    /* Line noise */
+    stream[size++] = 0x00; 
+    stream[size++] = 0xFF; 
+
+    size += RXThread::encode("first", 5, stream + size); 
+
+    /* Corrupted checksum */
+    size += RXThread::encode("bad", 3, stream + size); 
+    stream[size - 1] ^= 0x01; 
+
+    size += RXThread::encode("second", 6, stream + size); 
+    size += RXThread::encode("S", 1, stream + size); 
+
+    /* The last frame arrives in two parts */
+    send(stream, size - 2); 
+    usleep(20000); 
+    send(stream + size - 2, 2); 
+
+    ASSERT_TRUE(waitFor(3)); 
+    EXPECT_EQ(commands.size(), 3u); 
+    EXPECT_EQ(commands[0], "first"); 
+    EXPECT_EQ(commands[1], "second"); 
+    EXPECT_EQ(commands[2], "S"); 
+    EXPECT_EQ(rx_->getErrors(), 1u); 
+}
+
+/**
+ * @brief Tests that a false start marker with a large length does not swallow the 
+ *        commands behind it. 
+ */
+TEST_F(RXThreadTest, FalseStart) {
+
+    unsigned char stream[1024]; 
+    size_t size = 0; 
+
+    /* Start marker in line noise, announcing the largest command */
+    stream[size++] = RX_FRAME_START; 
+    stream[size++] = 0xFF; 
+
+    size += RXThread::encode("G", 1, stream + size); 
+    size += RXThread::encode("P", 1, stream + size); 
+
+    send(stream, size); 
+
+    /* Nothing else is sent: the commands are decoded anyway */
+    ASSERT_TRUE(waitFor(2)); 
+    EXPECT_EQ(commands[0], "G"); 
+    EXPECT_EQ(commands[1], "P"); 
+    EXPECT_EQ(rx_->getErrors(), 1u); 
+}
+
+/**
+ * @brief Tests the framing limits. 
+ */
+TEST(RXThreadFrameTest, Encode) {
+
+    unsigned char frame[RX_FRAME_MAX_PAYLOAD + RX_FRAME_OVERHEAD + 1]; 
+    char command[RX_FRAME_MAX_PAYLOAD + 1]; 
+    memset(command, 'x', sizeof(command)); 
+
+    EXPECT_EQ(RXThread::encode(command, 0, frame), 0u); 
+    EXPECT_EQ(RXThread::encode(command, RX_FRAME_MAX_PAYLOAD + 1, frame), 0u); 
+    EXPECT_EQ(RXThread::encode(command, RX_FRAME_MAX_PAYLOAD, frame), RX_FRAME_MAX_PAYLOAD + RX_FRAME_OVERHEAD); 
+
+    /* CRC-8/SMBUS check value */
+    EXPECT_EQ(RXThread::checksum((const unsigned char *) "123456789", 9), 0xF4); 
+}
+
+/** @} */
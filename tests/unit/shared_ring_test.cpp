@@ -0,0 +1,155 @@
+/**
+ * @file shared_ring_test.cpp
+ * @brief SharedRing class unit tests.
+ * @addtogroup unit_tests
+ * @{
+ */
+
+#include "shared_ring.hpp"
+#include "ring_buffer.hpp"
+#include "gtest/gtest.h"
+#include <string.h>
+#include <unistd.h>
+#include <sstream>
+
+/** @brief Width of the test images. */
+#define IMAGE_WIDTH     (800u)
+/** @brief Height of the test images. */
+#define IMAGE_HEIGHT    (600u)
+/** @brief Number of frames in the test ring. */
+#define NB_OF_SLOTS     (5u)
+
+/**
+ * @brief Fixture class for the SharedRing class tests. 
+ * @details The reader maps the shared memory separately, as another process would. 
+ */
+class SharedRingTest : public testing::Test {
+
+    protected:
+        /** @brief Sets up the fixture class. */
+        virtual void SetUp() {
+
+            std::ostringstream name; 
+            name << "/cwis_test_" << getpid(); 
+
+            producer_ = new SharedRing(name.str(), IMAGE_WIDTH, IMAGE_HEIGHT, NB_OF_SLOTS); 
+            reader_   = new SharedRing(name.str()); 
+            rb_       = new RingBuffer(producer_); 
+        }
+
+        /** @brief Tears down the fixture class. */
+        virtual void TearDown() {
+            delete rb_; 
+            delete reader_; 
+            delete producer_; 
+        }
+
+        /** @brief Fills a ring buffer image as the camera would, and publishes it. */
+        void acquire(size_t index, uint64_t frame) {
+            memset(rb_->at(index)->getImageBuffer(), (int) frame, IMAGE_WIDTH * IMAGE_HEIGHT); 
+            producer_->publish(rb_->at(index)->getImageBuffer(), frame); 
+        }
+
+    /** @brief Acquisition side. */
+    SharedRing *producer_; 
+    /** @brief Consumer side. */
+    SharedRing *reader_; 
+    /** @brief Ring buffer placed in shared memory. */
+    RingBuffer *rb_; 
+};
+
+/**
+ * @brief Tests that the reader sees the geometry and the frames written by the producer. 
+ */
+TEST_F(SharedRingTest, ZeroCopy) {
+
+    ASSERT_TRUE(producer_->isOpen()); 
+    ASSERT_TRUE(reader_->isOpen()); 
+    EXPECT_EQ(reader_->getWidth(), IMAGE_WIDTH); 
+    EXPECT_EQ(reader_->getHeight(), IMAGE_HEIGHT); 
+    EXPECT_EQ(reader_->getNbOfSlots(), NB_OF_SLOTS); 
+    EXPECT_EQ(rb_->getSize(), NB_OF_SLOTS); 
+
+    /* The ring buffer images live in the shared memory */
+    EXPECT_EQ(rb_->at(2)->getImageBuffer(), producer_->getSlot(2)); 
+    EXPECT_EQ(rb_->getImageFromBuffer(producer_->getSlot(3)), rb_->at(3)); 
+
+    Image out(IMAGE_WIDTH, IMAGE_HEIGHT); 
+    uint64_t frame = 0; 
+    EXPECT_FALSE(reader_->readLatest(out.getImageBuffer(), &frame)); 
+
+    for(uint64_t incr = 0; incr < 7; incr++) {
+        acquire(incr % NB_OF_SLOTS, incr); 
+    }
+
+    ASSERT_TRUE(reader_->readLatest(out.getImageBuffer(), &frame)); 
+    EXPECT_EQ(frame, 6u); 
+    EXPECT_EQ(out.getImageBuffer()[0], 6); 
+    EXPECT_EQ(out.getImageBuffer()[IMAGE_WIDTH * IMAGE_HEIGHT - 1], 6); 
+}
+
+/**
+ * @brief Tests that a read overlapping the reuse of its slot is detected. 
+ */
+TEST_F(SharedRingTest, TornRead) {
+
+    size_t slot = 0; 
+
+    acquire(0, 0); 
+    ASSERT_TRUE(reader_->getLatest(&slot)); 
+    EXPECT_EQ(slot, 0u); 
+
+    uint64_t sequence = reader_->beginRead(slot); 
+    ASSERT_NE(sequence, 0u); 
+    EXPECT_EQ(reader_->getFrame(slot), 0u); 
+    EXPECT_TRUE(reader_->endRead(slot, sequence)); 
+
+    /* The camera walks the ring: slot 0 is soon to be overwritten */
+    sequence = reader_->beginRead(slot); 
+    for(uint64_t incr = 1; incr < NB_OF_SLOTS - SHARED_RING_GUARD + 1; incr++) {
+        acquire(incr, incr); 
+    }
+    EXPECT_FALSE(reader_->endRead(slot, sequence)); 
+
+    /* Slots the camera may be writing cannot be read */
+    EXPECT_EQ(reader_->beginRead(0), 0u); 
+}
+
+/**
+ * @brief Tests that the guard covers the frames the camera completes between two callbacks. 
+ */
+TEST_F(SharedRingTest, Guard) {
+
+    for(uint64_t incr = 0; incr < NB_OF_SLOTS; incr++) {
+        acquire(incr, incr); 
+    }
+    EXPECT_EQ(reader_->getGuard(), SHARED_RING_GUARD); 
+    EXPECT_NE(reader_->beginRead(2), 0u); 
+    EXPECT_NE(reader_->beginRead(3), 0u); 
+
+    /* Batches of 2 frames: the camera may be 3 slots ahead */
+    producer_->extendGuard(3); 
+    acquire(0, NB_OF_SLOTS); 
+    EXPECT_EQ(reader_->getGuard(), 3u); 
+    EXPECT_EQ(reader_->beginRead(1), 0u); 
+    EXPECT_EQ(reader_->beginRead(2), 0u); 
+    EXPECT_EQ(reader_->beginRead(3), 0u); 
+    EXPECT_NE(reader_->beginRead(4), 0u); 
+
+    /* The guard only grows, up to the slots but the latest one */
+    producer_->extendGuard(1); 
+    EXPECT_EQ(reader_->getGuard(), 3u); 
+    producer_->extendGuard(100); 
+    EXPECT_EQ(reader_->getGuard(), NB_OF_SLOTS - 1); 
+}
+
+/**
+ * @brief Tests that a reader cannot attach to a missing object. 
+ */
+TEST(SharedRingAttachTest, Missing) {
+
+    SharedRing reader("/cwis_test_missing"); 
+    EXPECT_FALSE(reader.isOpen()); 
+}
+
+/** @} */
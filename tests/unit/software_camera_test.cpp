@@ -0,0 +1,99 @@
+/**
+ * @file software_camera_test.cpp
+ * @brief SoftwareCamera class unit tests.
+ * @addtogroup unit_tests
+ * @{
+ */
+
+#include "software_camera.hpp"
+#include "exceptions/camera_exception.hpp"
+#include "gtest/gtest.h"
+
+#include <string.h>
+#include <unistd.h>
+
+/** @brief Ring buffer of the live acquisition test. */
+static RingBuffer *s_ring = NULL;
+/** @brief Number of frames received by @ref onFrames(). */
+static unsigned int s_received = 0;
+/** @brief Number of frames received in another slot than the next one. */
+static unsigned int s_outOfSequence = 0;
+/** @brief Next expected sequence number. */
+static uint64_t s_sequence = 0;
+
+/** @brief Acquisition callback checking that the slots and the sequence numbers follow each other. */
+static void onFrames(const FrameBatch_s *batch) {
+
+    for(unsigned int incr = 0; incr < batch->count; incr++) {
+        s_sequence += (incr == 0) ? batch->lost : 0;
+
+        if((batch->buffers[incr] != s_ring->at(s_received % s_ring->getSize())->getImageBuffer()) ||
+           (batch->sequences[incr] != s_sequence)) {
+            s_outOfSequence++;
+        }
+        s_received++;
+        s_sequence++;
+    }
+}
+
+/**
+ * @brief Tests the live acquisition into a ring buffer, at the requested frame rate.
+ */
+TEST(SoftwareCameraTest, Live) {
+
+    SoftwareCamera camera(16, 8);
+    RingBuffer ring(16, 8, 3, 1);
+    s_ring          = &ring;
+    s_received      = 0;
+    s_outOfSequence = 0;
+    s_sequence      = 0;
+
+    EXPECT_EQ(camera.setFramerate(200.0), 200.0);
+    camera.start(&ring, &onFrames);
+    usleep(250000);
+    camera.stop();
+
+    unsigned long count = camera.getFrameCount();
+    EXPECT_EQ(count, s_received);
+    EXPECT_EQ(s_outOfSequence, 0u);
+    EXPECT_GT(count, 25u);
+    EXPECT_LT(count, 75u);
+
+    /* No frame after the stop */
+    usleep(20000);
+    EXPECT_EQ(camera.getFrameCount(), count);
+}
+
+/**
+ * @brief Tests the single captures.
+ */
+TEST(SoftwareCameraTest, Capture) {
+
+    SoftwareCamera camera(16, 8);
+    Image first(16, 8);
+    Image second(16, 8);
+    Image other(8, 8);
+
+    camera.capture(&first);
+    camera.capture(&second);
+    EXPECT_NE(memcmp(first.getImageBuffer(), second.getImageBuffer(), 16 * 8), 0);
+
+    EXPECT_THROW(camera.capture(&other), CameraException);
+
+    /* The synthetic frames come back in turn */
+    Image *images[SOFTWARE_CAMERA_NB_PATTERNS - 1];
+    for(unsigned int incr = 0; incr < SOFTWARE_CAMERA_NB_PATTERNS - 1; incr++) {
+        images[incr] = new Image(16, 8);
+    }
+
+    double timestamps[SOFTWARE_CAMERA_NB_PATTERNS - 1];
+    camera.captureBurst(images, SOFTWARE_CAMERA_NB_PATTERNS - 1, 0.001, timestamps);
+    EXPECT_GE(timestamps[SOFTWARE_CAMERA_NB_PATTERNS - 2] - timestamps[0], 0.001 * (SOFTWARE_CAMERA_NB_PATTERNS - 2));
+    EXPECT_EQ(memcmp(first.getImageBuffer(), images[SOFTWARE_CAMERA_NB_PATTERNS - 2]->getImageBuffer(), 16 * 8), 0);
+
+    for(unsigned int incr = 0; incr < SOFTWARE_CAMERA_NB_PATTERNS - 1; incr++) {
+        delete images[incr];
+    }
+}
+
+/** @} */
@@ -0,0 +1,94 @@
+/**
+ * @file telemetry_test.cpp
+ * @brief Telemetry class unit tests.
+ * @addtogroup unit_tests
+ * @{
+ */
+
+#include "telemetry.hpp"
+#include "gtest/gtest.h"
+#include <stddef.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <zlib.h>
+
+/** @brief Telemetry pipe used by the tests. */
+#define TELEMETRY_PIPE  "telemetryPipe"
+
+/**
+ * @brief Tests the content of a record. 
+ */
+TEST(TelemetryTest, Sample) {
+
+    Telemetry telemetry(TELEMETRY_PIPE, 10000, "."); 
+    TelemetryRecord_s record; 
+
+    for(unsigned int incr = 0; incr < 100; incr++) {
+        telemetry.frameAcquired(); 
+        /* 1 ms, except for 10 frames at 100 ms */
+        telemetry.frameStored((incr % 10 == 9) ? 0.1 : 0.001); 
+    }
+    telemetry.frameDropped(); 
+    telemetry.setBuffers(10, 0.25, 3); 
+
+    telemetry.sample(&record); 
+
+    EXPECT_EQ(record.magic, TELEMETRY_MAGIC); 
+    EXPECT_EQ(record.size, sizeof(TelemetryRecord_s)); 
+    EXPECT_EQ(record.framesAcquired, 100u); 
+    EXPECT_EQ(record.framesStored, 100u); 
+    EXPECT_EQ(record.framesDropped, 1u); 
+    EXPECT_EQ(record.ringSize, 10u); 
+    EXPECT_EQ(record.ringOccupancy, 250u); 
+    EXPECT_EQ(record.writerBacklog, 3u); 
+    EXPECT_GT(record.diskFree, 0u); 
+    EXPECT_EQ(record.crc, crc32(0L, (const Bytef *) &record, offsetof(TelemetryRecord_s, crc))); 
+
+    /* Bins are a quarter of an octave wide */
+    EXPECT_GE(record.latencyP50, 1000u); 
+    EXPECT_LE(record.latencyP50, 1200u); 
+    EXPECT_GE(record.latencyP99, 100000u); 
+    EXPECT_LE(record.latencyP99, 120000u); 
+    EXPECT_EQ(record.latencyMax, record.latencyP99); 
+
+    /* Latencies are reported over a single period */
+    telemetry.sample(&record); 
+    EXPECT_EQ(record.latencyMax, 0u); 
+    EXPECT_EQ(record.framesStored, 100u); 
+    EXPECT_EQ(record.sequence, 1u); 
+}
+
+/**
+ * @brief Tests that records are coalesced while nobody reads them, and that a reader
+ *        receives whole records. 
+ */
+TEST(TelemetryTest, Publish) {
+
+    unlink(TELEMETRY_PIPE); 
+    Telemetry telemetry(TELEMETRY_PIPE, 10, "."); 
+
+    /* No reader: the publisher must not block */
+    usleep(100000); 
+    EXPECT_GT(telemetry.getCoalesced(), 0u); 
+
+    int fd = open(TELEMETRY_PIPE, O_RDONLY | O_NONBLOCK); 
+    ASSERT_GE(fd, 0); 
+    usleep(100000); 
+
+    TelemetryRecord_s records[4]; 
+    ssize_t size = read(fd, records, sizeof(records)); 
+    ASSERT_GE(size, (ssize_t) sizeof(TelemetryRecord_s)); 
+    EXPECT_EQ(size % sizeof(TelemetryRecord_s), 0u); 
+
+    for(unsigned int incr = 0; incr < size / sizeof(TelemetryRecord_s); incr++) {
+        EXPECT_EQ(records[incr].magic, TELEMETRY_MAGIC); 
+        if(incr > 0) {
+            EXPECT_EQ(records[incr].sequence, records[incr - 1].sequence + 1); 
+        }
+    }
+
+    close(fd); 
+    unlink(TELEMETRY_PIPE); 
+}
+
+/** @} */
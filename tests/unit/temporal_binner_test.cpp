@@ -0,0 +1,176 @@
+/**
+ * @file temporal_binner_test.cpp
+ * @brief TemporalBinner class unit tests.
+ * @addtogroup unit_tests
+ * @{
+ */
+
+#include "temporal_binner.hpp"
+#include "image.hpp"
+#include "gtest/gtest.h"
+
+#include <string.h>
+
+/** @brief Width of the test frames, not a multiple of the vector sizes. */
+#define TEST_WIDTH  (75u)
+/** @brief Height of the test frames. */
+#define TEST_HEIGHT (9u)
+
+/** @brief Value of a pixel of a test frame. */
+static unsigned char pixelValue(unsigned int pixel, unsigned int frame) {
+    return (unsigned char) (pixel * 11 + frame * 97);
+}
+
+/** @brief Fills a test frame. */
+static void fill(Image *image, unsigned int frame) {
+
+    for(unsigned int incr = 0; incr < TEST_WIDTH * TEST_HEIGHT; incr++) {
+        image->getImageBuffer()[incr] = (pixel_t) pixelValue(incr, frame);
+    }
+}
+
+/** @brief Output frame held by the writers in the Pending test. */
+static const Image *heldOutput = NULL;
+
+/** @brief Pending check of the Pending test. */
+static bool isHeld(const Image *output) {
+    return output == heldOutput;
+}
+
+/**
+ * @brief Tests that the mean of each bin is output every N frames.
+ */
+TEST(TemporalBinnerTest, Mean) {
+
+    TemporalBinner binner(TEST_WIDTH, TEST_HEIGHT, 3);
+    Image frame(TEST_WIDTH, TEST_HEIGHT);
+
+    for(unsigned int incr = 0; incr < 9; incr++) {
+        fill(&frame, incr);
+        Image *output = binner.add(&frame);
+
+        if((incr % 3) != 2) {
+            EXPECT_TRUE(output == NULL);
+            continue;
+        }
+
+        ASSERT_TRUE(output != NULL);
+        for(unsigned int pixel = 0; pixel < TEST_WIDTH * TEST_HEIGHT; pixel++) {
+            unsigned int sum = pixelValue(pixel, incr) + pixelValue(pixel, incr - 1) + pixelValue(pixel, incr - 2);
+            ASSERT_EQ((unsigned char) output->getImageBuffer()[pixel], (sum + 1) / 3) << "Pixel " << pixel;
+        }
+    }
+}
+
+/**
+ * @brief Tests the rounding of the mean at the largest factor.
+ */
+TEST(TemporalBinnerTest, MaxFactor) {
+
+    TemporalBinner binner(TEST_WIDTH, TEST_HEIGHT, BINNER_MAX_FACTOR);
+    Image frame(TEST_WIDTH, TEST_HEIGHT);
+    Image *output = NULL;
+
+    /* Each pixel sees a different number of saturated frames */
+    for(unsigned int incr = 0; incr < BINNER_MAX_FACTOR; incr++) {
+        for(unsigned int pixel = 0; pixel < TEST_WIDTH * TEST_HEIGHT; pixel++) {
+            frame.getImageBuffer()[pixel] = (pixel_t) ((incr < pixel % (BINNER_MAX_FACTOR + 1)) ? 0xFF : 0);
+        }
+        output = binner.add(&frame);
+    }
+
+    ASSERT_TRUE(output != NULL);
+    for(unsigned int pixel = 0; pixel < TEST_WIDTH * TEST_HEIGHT; pixel++) {
+        unsigned int sum = 0xFF * (pixel % (BINNER_MAX_FACTOR + 1));
+        ASSERT_EQ((unsigned char) output->getImageBuffer()[pixel],
+                  (sum + BINNER_MAX_FACTOR / 2) / BINNER_MAX_FACTOR) << "Pixel " << pixel;
+    }
+}
+
+/**
+ * @brief Tests the saturated sum.
+ */
+TEST(TemporalBinnerTest, Sum) {
+
+    TemporalBinner binner(TEST_WIDTH, TEST_HEIGHT, 2, BINNING_SUM);
+    Image frame(TEST_WIDTH, TEST_HEIGHT);
+
+    fill(&frame, 0);
+    EXPECT_TRUE(binner.add(&frame) == NULL);
+    fill(&frame, 1);
+    Image *output = binner.add(&frame);
+
+    ASSERT_TRUE(output != NULL);
+    for(unsigned int pixel = 0; pixel < TEST_WIDTH * TEST_HEIGHT; pixel++) {
+        unsigned int sum = pixelValue(pixel, 0) + pixelValue(pixel, 1);
+        ASSERT_EQ((unsigned char) output->getImageBuffer()[pixel], (sum > 255) ? 255u : sum) << "Pixel " << pixel;
+    }
+}
+
+/**
+ * @brief Tests the factor changes and restarts.
+ */
+TEST(TemporalBinnerTest, Factor) {
+
+    TemporalBinner binner(TEST_WIDTH, TEST_HEIGHT, 2, BINNING_MEAN, 2);
+    Image frame(TEST_WIDTH, TEST_HEIGHT);
+    fill(&frame, 0);
+
+    EXPECT_FALSE(binner.setFactor(0));
+    EXPECT_FALSE(binner.setFactor(BINNER_MAX_FACTOR + 1));
+
+    /* The new factor applies from the next bin */
+    EXPECT_TRUE(binner.add(&frame) == NULL);
+    EXPECT_TRUE(binner.setFactor(3));
+    Image *first = binner.add(&frame);
+    EXPECT_TRUE(first != NULL);
+
+    EXPECT_TRUE(binner.add(&frame) == NULL);
+    EXPECT_TRUE(binner.add(&frame) == NULL);
+
+    /* A restart drops the partial bin */
+    binner.restart();
+    EXPECT_TRUE(binner.add(&frame) == NULL);
+    EXPECT_TRUE(binner.add(&frame) == NULL);
+    Image *second = binner.add(&frame);
+    ASSERT_TRUE(second != NULL);
+    EXPECT_NE(first, second);
+
+    /* Output frames are used in turn */
+    binner.setFactor(1);
+    EXPECT_EQ(binner.add(&frame), first);
+    EXPECT_EQ(binner.add(&frame), second);
+    EXPECT_EQ(memcmp(first->getImageBuffer(), frame.getImageBuffer(), TEST_WIDTH * TEST_HEIGHT), 0);
+}
+
+/**
+ * @brief Tests that the outputs still in use are not overwritten.
+ */
+TEST(TemporalBinnerTest, Pending) {
+
+    TemporalBinner binner(TEST_WIDTH, TEST_HEIGHT, 1, BINNING_MEAN, 2);
+    Image frame(TEST_WIDTH, TEST_HEIGHT);
+    fill(&frame, 0);
+
+    binner.setPendingCheck(&isHeld);
+    Image *first = binner.add(&frame);
+    ASSERT_TRUE(first != NULL);
+
+    /* The held output is skipped, every bin goes to the other one */
+    heldOutput = first;
+    Image *second = binner.add(&frame);
+    EXPECT_NE(second, first);
+    EXPECT_EQ(binner.add(&frame), second);
+
+    /* No free output: the bin is dropped */
+    TemporalBinner single(TEST_WIDTH, TEST_HEIGHT, 1, BINNING_MEAN, 1);
+    single.setPendingCheck(&isHeld);
+    heldOutput = single.add(&frame);
+    EXPECT_TRUE(single.add(&frame) == NULL);
+    EXPECT_EQ(single.getDropped(), 1u);
+    EXPECT_EQ(binner.getDropped(), 0u);
+
+    heldOutput = NULL;
+}
+
+/** @} */
@@ -0,0 +1,218 @@
+/**
+ * @file temporal_codec_test.cpp
+ * @brief TemporalEncoder and TemporalDecoder classes unit tests.
+ * @addtogroup unit_tests
+ * @{
+ */
+
+#include "temporal_codec.hpp"
+#include "frame_codec.hpp"
+#include "image.hpp"
+#include "gtest/gtest.h"
+
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+
+/** @brief Frame width, odd to exercise the ends of the SIMD loops. */
+#define TEST_WIDTH  (67u)
+#define TEST_HEIGHT (41u)
+
+/**
+ * @brief Fixture class for the temporal codec tests.
+ */
+class TemporalCodecTest : public testing::Test {
+
+    protected:
+        virtual void SetUp() {
+            ASSERT_EQ(system("rm -rf temporalDir"), 0);
+            ASSERT_EQ(mkdir("temporalDir", 0777), 0);
+        }
+
+        virtual void TearDown() {
+            ASSERT_EQ(system("rm -rf temporalDir"), 0);
+        }
+
+        /** @brief Fills a frame with a fixed textured scene, a moving spot and a few flickering pixels. */
+        static void fill(Image *image, unsigned int frame) {
+
+            uint32_t texture = 12345u;
+            uint32_t noise   = frame * 2654435761u;
+
+            for(unsigned int y = 0; y < TEST_HEIGHT; y++) {
+                for(unsigned int x = 0; x < TEST_WIDTH; x++) {
+                    texture = texture * 1664525u + 1013904223u;
+                    noise   = noise * 1664525u + 1013904223u;
+
+                    unsigned int pixel = texture >> 24;
+                    if((x - frame % (TEST_WIDTH - 8) < 8) && (y >= 16) && (y < 24)) {
+                        pixel = 255;
+                    }
+                    if((noise >> 26) == 0) {
+                        pixel ^= 1;
+                    }
+                    image->getImageBuffer()[y * TEST_WIDTH + x] = (pixel_t) pixel;
+                }
+            }
+        }
+
+        /** @brief Indicates that a frame was decoded as it was written. */
+        static bool matches(const Image *image, unsigned int frame) {
+
+            Image expected(TEST_WIDTH, TEST_HEIGHT);
+            fill(&expected, frame);
+
+            return (memcmp(image->getImageBuffer(), expected.getImageBuffer(), TEST_WIDTH * TEST_HEIGHT) == 0);
+        }
+
+        /** @brief Writes @p count frames, numbered from @p first, into a stream. */
+        static void write(const char *filename, unsigned int first, unsigned int count, unsigned int keyInterval) {
+
+            TemporalEncoder encoder(TEST_WIDTH, TEST_HEIGHT, keyInterval);
+            ASSERT_TRUE(encoder.open(filename));
+
+            Image image(TEST_WIDTH, TEST_HEIGHT);
+            for(unsigned int frame = first; frame < first + count; frame++) {
+                fill(&image, frame);
+                ASSERT_TRUE(encoder.add(&image, frame));
+            }
+
+            EXPECT_EQ(encoder.getNbOfFrames(), count);
+            EXPECT_TRUE(encoder.sync());
+        }
+};
+
+/**
+ * @brief Tests the lossless decoding of a stream, read forward then in any order.
+ */
+TEST_F(TemporalCodecTest, RoundTrip) {
+
+    write("temporalDir/frames.tdc", 100, 70, 8);
+
+    TemporalDecoder decoder;
+    ASSERT_TRUE(decoder.open("temporalDir/frames.tdc"));
+    EXPECT_EQ(decoder.getWidth(), TEST_WIDTH);
+    EXPECT_EQ(decoder.getHeight(), TEST_HEIGHT);
+    ASSERT_EQ(decoder.getNbOfFrames(), 70u);
+
+    Image image(TEST_WIDTH, TEST_HEIGHT);
+    for(size_t incr = 0; incr < 70; incr++) {
+        EXPECT_EQ(decoder.getRecord(incr).frame, 100 + incr);
+        EXPECT_EQ(decoder.getRecord(incr).type, (incr % 8 == 0) ? TEMPORAL_KEYFRAME : TEMPORAL_RESIDUAL);
+        ASSERT_TRUE(decoder.read(incr, &image));
+        EXPECT_TRUE(matches(&image, 100 + incr));
+    }
+
+    /* Random access: backwards, and jumping over keyframes */
+    size_t order[] = {69, 3, 17, 16, 0, 47, 48, 31, 9};
+    for(size_t incr = 0; incr < sizeof(order) / sizeof(order[0]); incr++) {
+        ASSERT_TRUE(decoder.read(order[incr], &image));
+        EXPECT_TRUE(matches(&image, 100 + order[incr]));
+    }
+
+    Image other(TEST_WIDTH + 1, TEST_HEIGHT);
+    EXPECT_FALSE(decoder.read(0, &other));
+    EXPECT_FALSE(decoder.read(70, &image));
+    EXPECT_FALSE(decoder.open("temporalDir/missing.tdc"));
+}
+
+/**
+ * @brief Tests the append to an existing stream, after a torn record.
+ */
+TEST_F(TemporalCodecTest, Append) {
+
+    write("temporalDir/frames.tdc", 0, 10, 4);
+
+    /* Interrupted write: part of a record */
+    int fd = open("temporalDir/frames.tdc", O_WRONLY | O_APPEND);
+    ASSERT_GE(fd, 0);
+    unsigned char torn[24] = {10, 0, 0, 0, 1, 0, 0, 0, 200, 0, 0, 0};
+    ASSERT_EQ(::write(fd, torn, sizeof(torn)), (ssize_t) sizeof(torn));
+    close(fd);
+
+    TemporalDecoder decoder;
+    ASSERT_TRUE(decoder.open("temporalDir/frames.tdc"));
+    EXPECT_EQ(decoder.getNbOfFrames(), 10u);
+
+    /* Appending starts with a keyframe, after the last complete record */
+    write("temporalDir/frames.tdc", 10, 5, 4);
+
+    ASSERT_TRUE(decoder.open("temporalDir/frames.tdc"));
+    ASSERT_EQ(decoder.getNbOfFrames(), 15u);
+    EXPECT_EQ(decoder.getRecord(10).type, TEMPORAL_KEYFRAME);
+
+    Image image(TEST_WIDTH, TEST_HEIGHT);
+    for(size_t incr = 0; incr < 15; incr++) {
+        ASSERT_TRUE(decoder.read(incr, &image));
+        EXPECT_TRUE(matches(&image, incr));
+    }
+
+    /* Frames of another size are refused */
+    TemporalEncoder encoder(TEST_WIDTH, TEST_HEIGHT + 1);
+    EXPECT_FALSE(encoder.open("temporalDir/frames.tdc"));
+
+    TemporalEncoder same(TEST_WIDTH, TEST_HEIGHT);
+    ASSERT_TRUE(same.open("temporalDir/frames.tdc"));
+    Image other(TEST_WIDTH, TEST_HEIGHT + 1);
+    EXPECT_FALSE(same.add(&other, 15));
+}
+
+/**
+ * @brief Tests the detection of a corrupted record.
+ */
+TEST_F(TemporalCodecTest, Corruption) {
+
+    write("temporalDir/frames.tdc", 0, 8, 8);
+
+    TemporalDecoder decoder;
+    ASSERT_TRUE(decoder.open("temporalDir/frames.tdc"));
+    ASSERT_EQ(decoder.getNbOfFrames(), 8u);
+
+    /* Flip a bit of the coded residual of frame 5 */
+    const TemporalRecord_s record = decoder.getRecord(5);
+    int fd = open("temporalDir/frames.tdc", O_RDWR);
+    ASSERT_GE(fd, 0);
+    unsigned char byte;
+    off_t position = record.offset + 16 + record.size / 2;
+    ASSERT_EQ(pread(fd, &byte, 1, position), 1);
+    byte ^= 0x10;
+    ASSERT_EQ(pwrite(fd, &byte, 1, position), 1);
+    close(fd);
+
+    ASSERT_TRUE(decoder.open("temporalDir/frames.tdc"));
+
+    Image image(TEST_WIDTH, TEST_HEIGHT);
+    EXPECT_FALSE(decoder.read(5, &image));
+    EXPECT_FALSE(decoder.read(7, &image));
+
+    ASSERT_TRUE(decoder.read(4, &image));
+    EXPECT_TRUE(matches(&image, 4));
+}
+
+/**
+ * @brief Tests that slowly changing frames code smaller than independently.
+ */
+TEST_F(TemporalCodecTest, Ratio) {
+
+    write("temporalDir/frames.tdc", 0, 64, TEMPORAL_KEY_INTERVAL);
+
+    FrameCodec codec;
+    Image image(TEST_WIDTH, TEST_HEIGHT);
+    unsigned char *output = new unsigned char[FrameCodec::bound(TEST_WIDTH * TEST_HEIGHT)];
+    size_t independent = 0;
+
+    for(unsigned int frame = 0; frame < 64; frame++) {
+        fill(&image, frame);
+        independent += codec.compress(image.getImageBuffer(), TEST_WIDTH * TEST_HEIGHT, output,
+                                      FrameCodec::bound(TEST_WIDTH * TEST_HEIGHT));
+    }
+    delete [] output;
+
+    struct stat info;
+    ASSERT_EQ(stat("temporalDir/frames.tdc", &info), 0);
+    EXPECT_LT((size_t) info.st_size, independent * 3 / 4);
+}
+
+/** @} */
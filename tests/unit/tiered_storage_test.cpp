@@ -0,0 +1,215 @@
+/**
+ * @file tiered_storage_test.cpp
+ * @brief TieredStorage class unit tests.
+ * @addtogroup unit_tests
+ * @{
+ */
+
+#include "tiered_storage.hpp"
+#include "utilities.hpp"
+#include "gtest/gtest.h"
+
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/** @brief Content of the test frames. */
+#define FRAME_CONTENT   "frame"
+
+/**
+ * @brief Fixture class for the TieredStorage class tests.
+ */
+class TieredStorageTest : public testing::Test {
+
+    protected:
+        /** @brief Sets up the fixture class. */
+        virtual void SetUp() {
+            ASSERT_TRUE(createDirectory("tierDir"));
+            ASSERT_TRUE(createDirectory("tierDir/ram"));
+            ASSERT_TRUE(createDirectory("tierDir/disk"));
+            unlink("tierDir/disk/frames.journal");
+
+            journal_ = new FrameJournal("tierDir/disk/frames.journal");
+            dir_     = new OutputDirectory("tierDir/disk", "raw", 4u);
+        }
+
+        /** @brief Tears down the fixture class. */
+        virtual void TearDown() {
+            delete dir_;
+            delete journal_;
+        }
+
+        /** @brief Writes a small frame file in the tier and hands it over. */
+        void addFrame(TieredStorage &storage, unsigned int frame) {
+            FILE *fp = storage.openFile(frame);
+            ASSERT_NE(fp, (FILE *) NULL);
+            fputs(FRAME_CONTENT, fp);
+            storage.add(frame, fp);
+        }
+
+        /** @brief Returns @p true if a file exists. */
+        static bool exists(const std::string &path) {
+            struct stat info;
+            return stat(path.c_str(), &info) == 0;
+        }
+
+        FrameJournal *journal_;
+        OutputDirectory *dir_;
+};
+
+/**
+ * @brief Tests that a full batch is migrated, committed and removed from the tier.
+ */
+TEST_F(TieredStorageTest, Batch) {
+
+    TieredStorage storage("tierDir/ram", "raw", dir_, journal_, TIER_DEFAULT_CAPACITY, 4u, 60000u);
+    OutputDirectory tier("tierDir/ram", "raw");
+    ASSERT_TRUE(storage.isOpen());
+
+    for(unsigned int frame = 0; frame < 4; frame++) {
+        addFrame(storage, frame);
+    }
+
+    for(unsigned int incr = 0; (incr < 500) && (storage.getMigrated() < 4); incr++) {
+        usleep(10000);
+    }
+    EXPECT_EQ(storage.getMigrated(), 4u);
+    EXPECT_EQ(storage.getFailed(), 0u);
+    EXPECT_EQ(storage.getBacklog(), 0u);
+    EXPECT_EQ(storage.getUsedBytes(), 0u);
+
+    for(unsigned int frame = 0; frame < 4; frame++) {
+        EXPECT_TRUE(journal_->isCommitted(frame));
+        EXPECT_TRUE(exists(storage.locate(frame)));
+        EXPECT_FALSE(exists(std::string("tierDir/ram/") + tier.getFilename(frame)));
+    }
+}
+
+/**
+ * @brief Tests the index of the frames still in the tier, and the flush.
+ */
+TEST_F(TieredStorageTest, Locate) {
+
+    TieredStorage storage("tierDir/ram", "raw", dir_, journal_, TIER_DEFAULT_CAPACITY, 1000u, 60000u);
+
+    addFrame(storage, 5);
+    EXPECT_EQ(storage.getBacklog(), 1u);
+    EXPECT_EQ(storage.getUsedBytes(), strlen(FRAME_CONTENT));
+
+    std::string tiered = storage.locate(5);
+    EXPECT_EQ(tiered.compare(0, 12, "tierDir/ram/"), 0);
+    EXPECT_TRUE(exists(tiered));
+    EXPECT_FALSE(journal_->isCommitted(5));
+
+    storage.flush();
+    EXPECT_EQ(storage.getBacklog(), 0u);
+    EXPECT_TRUE(journal_->isCommitted(5));
+    EXPECT_FALSE(exists(tiered));
+
+    std::string persistent = storage.locate(5);
+    EXPECT_EQ(persistent, std::string("tierDir/disk/") + dir_->getFilename(5));
+    EXPECT_TRUE(exists(persistent));
+}
+
+/**
+ * @brief Tests that the writers wait for room in a full tier.
+ */
+TEST_F(TieredStorageTest, Capacity) {
+
+    /* One frame fills the tier, each frame waits for the migration of the previous one */
+    TieredStorage storage("tierDir/ram", "raw", dir_, journal_, 1u, 1000u, 60000u);
+
+    for(unsigned int frame = 0; frame < 8; frame++) {
+        addFrame(storage, frame);
+        EXPECT_LE(storage.getUsedBytes(), strlen(FRAME_CONTENT));
+    }
+
+    storage.flush();
+    EXPECT_EQ(storage.getMigrated(), 8u);
+    EXPECT_EQ(journal_->getNextFrame(), 8u);
+}
+
+/**
+ * @brief Tests that the frames with failed writes are removed instead of migrated.
+ */
+TEST_F(TieredStorageTest, Failed) {
+
+    TieredStorage storage("tierDir/ram", "raw", dir_, journal_, TIER_DEFAULT_CAPACITY, 1000u, 60000u);
+    OutputDirectory tier("tierDir/ram", "raw");
+
+    addFrame(storage, 20);
+
+    /* Writes to a read-only stream fail */
+    FILE *fp = storage.openFile(21);
+    ASSERT_NE(fp, (FILE *) NULL);
+    fclose(fp);
+    fp = fopen((std::string("tierDir/ram/") + tier.getFilename(21)).c_str(), "rb");
+    ASSERT_NE(fp, (FILE *) NULL);
+    fputs(FRAME_CONTENT, fp);
+    storage.add(21, fp);
+
+    /* The writer reported an error */
+    fp = storage.openFile(22);
+    ASSERT_NE(fp, (FILE *) NULL);
+    storage.add(22, fp, false);
+
+    EXPECT_EQ(storage.getBacklog(), 1u);
+    EXPECT_EQ(storage.getFailed(), 2u);
+    EXPECT_FALSE(exists(std::string("tierDir/ram/") + tier.getFilename(21)));
+    EXPECT_FALSE(exists(std::string("tierDir/ram/") + tier.getFilename(22)));
+
+    storage.flush();
+    EXPECT_TRUE(journal_->isCommitted(20));
+    EXPECT_FALSE(journal_->isCommitted(21));
+    EXPECT_FALSE(journal_->isCommitted(22));
+    EXPECT_FALSE(exists(std::string("tierDir/disk/") + dir_->getFilename(21)));
+}
+
+/**
+ * @brief Tests that the frames are migrated on destruction, even with a rate limit.
+ */
+TEST_F(TieredStorageTest, Destruction) {
+
+    {
+        TieredStorage storage("tierDir/ram", "raw", dir_, journal_, TIER_DEFAULT_CAPACITY, 1000u, 60000u, 1.0);
+
+        addFrame(storage, 0);
+        addFrame(storage, 1);
+    }
+
+    EXPECT_TRUE(journal_->isCommitted(0));
+    EXPECT_TRUE(journal_->isCommitted(1));
+}
+
+/**
+ * @brief Tests the recovery of the frames left in the tier.
+ */
+TEST_F(TieredStorageTest, Recover) {
+
+    OutputDirectory tier("tierDir/ram", "raw");
+
+    for(unsigned int frame = 10; frame < 13; frame++) {
+        FILE *fp = tier.openFile(frame);
+        ASSERT_NE(fp, (FILE *) NULL);
+        fputs(FRAME_CONTENT, fp);
+        fclose(fp);
+    }
+
+    /* Other files are left alone */
+    FILE *fp = fopen("tierDir/ram/notes.txt", "w");
+    ASSERT_NE(fp, (FILE *) NULL);
+    fclose(fp);
+
+    EXPECT_EQ(TieredStorage::recover("tierDir/ram", dir_), 3u);
+    EXPECT_TRUE(exists("tierDir/ram/notes.txt"));
+
+    for(unsigned int frame = 10; frame < 13; frame++) {
+        EXPECT_FALSE(exists(std::string("tierDir/ram/") + tier.getFilename(frame)));
+        EXPECT_TRUE(exists(std::string("tierDir/disk/") + dir_->getFilename(frame)));
+    }
+
+    EXPECT_EQ(TieredStorage::recover("tierDir/ram", dir_), 0u);
+    unlink("tierDir/ram/notes.txt");
+}
+
+/** @} */
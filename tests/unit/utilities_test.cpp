@@ -46,5 +46,23 @@ TEST(FileExtensionTest, NonAsciiCharacters) {
     EXPECT_STREQ(getFileExtension(file).c_str(), "pdf"); 
 }
 
+/**
+ * @brief Tests the @ref formatZeroPadded() function. 
+ */
+TEST(FormatTest, ZeroPadded) {
+
+    char buffer[16]; 
+
+    *formatZeroPadded(buffer, 42, 6) = '\0'; 
+    EXPECT_STREQ(buffer, "000042"); 
+
+    *formatZeroPadded(buffer, 0, 1) = '\0'; 
+    EXPECT_STREQ(buffer, "0"); 
+
+    /* Numbers wider than the padding are not truncated */
+    *formatZeroPadded(buffer, 1234567, 3) = '\0'; 
+    EXPECT_STREQ(buffer, "1234567"); 
+}
+
 /** @} */
 
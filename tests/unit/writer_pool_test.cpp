@@ -0,0 +1,133 @@
+/**
+ * @file writer_pool_test.cpp
+ * @brief WriterPool class unit tests.
+ * @addtogroup unit_tests
+ * @{
+ */
+
+#include "writer_pool.hpp"
+#include "gtest/gtest.h"
+
+#include <pthread.h>
+#include <unistd.h>
+
+/** @brief Number of images written by @ref slowWrite(). */
+static unsigned int s_written = 0; 
+/** @brief Sum of the frame numbers written by @ref slowWrite(). */
+static unsigned int s_frameSum = 0; 
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER; 
+
+/** @brief Write function simulating a slow disk. */
+static void slowWrite(Image *image, unsigned int frame) {
+
+    (void) image; 
+    usleep(20000); 
+
+    pthread_mutex_lock(&s_lock); 
+    s_written++; 
+    s_frameSum += frame; 
+    pthread_mutex_unlock(&s_lock); 
+}
+
+/**
+ * @brief Tests that every queued image is written, and that the queue is bounded. 
+ */
+TEST(WriterPoolTest, Write) {
+
+    Image images[4] = {Image(8, 8), Image(8, 8), Image(8, 8), Image(8, 8)}; 
+    s_written  = 0; 
+    s_frameSum = 0; 
+
+    WriterPool pool(2, 3, &slowWrite); 
+    EXPECT_EQ(pool.getCapacity(), 3u); 
+
+    for(unsigned int incr = 0; incr < 3; incr++) {
+        ASSERT_TRUE(pool.submit(&images[incr], incr + 1)); 
+    }
+    EXPECT_GT(pool.getBacklog(), 0u); 
+    EXPECT_TRUE(pool.isPending(&images[0])); 
+    EXPECT_FALSE(pool.isPending(&images[3])); 
+
+    pool.drain(); 
+    EXPECT_EQ(pool.getBacklog(), 0u); 
+    EXPECT_EQ(s_written, 3u); 
+    EXPECT_EQ(s_frameSum, 6u); 
+    EXPECT_FALSE(pool.isPending(&images[0])); 
+
+    /* Full queue: the images are refused */
+    unsigned int accepted = 0; 
+    for(unsigned int incr = 0; incr < 20; incr++) {
+        accepted += pool.submit(&images[incr % 4], incr) ? 1 : 0; 
+    }
+    EXPECT_LT(accepted, 20u); 
+}
+
+/**
+ * @brief Tests that the queued images are written when the pool is destroyed. 
+ */
+TEST(WriterPoolTest, Destruction) {
+
+    Image image(8, 8); 
+    s_written = 0; 
+
+    {
+        WriterPool pool(1, 4, &slowWrite); 
+        for(unsigned int incr = 0; incr < 4; incr++) {
+            ASSERT_TRUE(pool.submit(&image, incr)); 
+        }
+    }
+
+    EXPECT_EQ(s_written, 4u); 
+}
+
+/** @brief Number of images written by @ref fastWrite(). */
+static unsigned int s_fastWritten = 0; 
+
+/** @brief Write function of a cheap sink. */
+static void fastWrite(Image *image, unsigned int frame) {
+
+    (void) image; 
+    (void) frame; 
+
+    pthread_mutex_lock(&s_lock); 
+    s_fastWritten++; 
+    pthread_mutex_unlock(&s_lock); 
+}
+
+/**
+ * @brief Tests that every sink writes every image, and that an image is held until 
+ *        the slowest sink is done. 
+ */
+TEST(WriterPoolTest, FanOut) {
+
+    Image images[2] = {Image(8, 8), Image(8, 8)}; 
+    s_written     = 0; 
+    s_fastWritten = 0; 
+
+    WriterPool pool(3, 2, &slowWrite); 
+    ASSERT_TRUE(pool.addSink(&fastWrite)); 
+    EXPECT_EQ(pool.getNbOfSinks(), 2u); 
+
+    ASSERT_TRUE(pool.submit(&images[0], 0)); 
+    ASSERT_TRUE(pool.submit(&images[1], 1)); 
+    /* The capacity is counted in images, not in jobs */
+    EXPECT_FALSE(pool.submit(&images[1], 2)); 
+
+    /* The fast sink is done long before the slow one */
+    usleep(10000); 
+    EXPECT_EQ(s_fastWritten, 2u); 
+    EXPECT_TRUE(pool.isPending(&images[0])); 
+    EXPECT_EQ(pool.getBacklog(), 2u); 
+
+    pool.drain(); 
+    EXPECT_EQ(s_written, 2u); 
+    EXPECT_FALSE(pool.isPending(&images[0])); 
+    EXPECT_FALSE(pool.isPending(&images[1])); 
+
+    /* Too many sinks */
+    EXPECT_TRUE(pool.addSink(&fastWrite)); 
+    EXPECT_TRUE(pool.addSink(&fastWrite)); 
+    EXPECT_FALSE(pool.addSink(&fastWrite)); 
+}
+
+/** @} */